@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "adaptive-scheduler.h"
+#include "ladder-scheduler.h"
+#include "pairing-heap-scheduler.h"
+#include "map-scheduler.h"
+#include "object-factory.h"
+#include "uinteger.h"
+#include "double.h"
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::AdaptiveScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AdaptiveScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (AdaptiveScheduler);
+
+TypeId
+AdaptiveScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::AdaptiveScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<AdaptiveScheduler> ()
+    .AddAttribute ("SamplingPeriod",
+                   "The number of operations between two choices of the scheduler.",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&AdaptiveScheduler::m_samplingPeriod),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("LargeQueueSize",
+                   "The number of pending events above which the LadderScheduler is used.",
+                   UintegerValue (20000),
+                   MakeUintegerAccessor (&AdaptiveScheduler::m_largeQueueSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RemoveRatio",
+                   "The ratio of Remove to Insert calls above which the MapScheduler is used.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&AdaptiveScheduler::m_removeRatio),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+AdaptiveScheduler::AdaptiveScheduler ()
+  : m_size (0),
+    m_operations (0),
+    m_inserts (0),
+    m_removes (0),
+    m_migrations (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_scheduler = CreateObject<PairingHeapScheduler> ();
+}
+
+AdaptiveScheduler::~AdaptiveScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+AdaptiveScheduler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_scheduler = 0;
+  Scheduler::DoDispose ();
+}
+
+TypeId
+AdaptiveScheduler::GetCurrentSchedulerType (void) const
+{
+  return m_scheduler->GetInstanceTypeId ();
+}
+
+uint32_t
+AdaptiveScheduler::GetMigrations (void) const
+{
+  return m_migrations;
+}
+
+void
+AdaptiveScheduler::Sample (void)
+{
+  m_operations++;
+  if (m_operations < m_samplingPeriod)
+    {
+      return;
+    }
+
+  TypeId current = m_scheduler->GetInstanceTypeId ();
+  TypeId tid;
+  if (m_removes > m_removeRatio * m_inserts)
+    {
+      tid = MapScheduler::GetTypeId ();
+    }
+  else if (m_size > m_largeQueueSize
+           || (current == LadderScheduler::GetTypeId () && m_size > m_largeQueueSize / 4))
+    {
+      tid = LadderScheduler::GetTypeId ();
+    }
+  else
+    {
+      tid = PairingHeapScheduler::GetTypeId ();
+    }
+  if (tid != current)
+    {
+      Migrate (tid);
+    }
+  m_operations = 0;
+  m_inserts = 0;
+  m_removes = 0;
+}
+
+void
+AdaptiveScheduler::Migrate (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid.GetName () << m_size);
+  NS_LOG_INFO ("moving " << m_size << " events from " <<
+               m_scheduler->GetInstanceTypeId ().GetName () << " to " << tid.GetName ());
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  while (!m_scheduler->IsEmpty ())
+    {
+      scheduler->Insert (m_scheduler->RemoveNext ());
+    }
+  m_scheduler = scheduler;
+  m_migrations++;
+}
+
+void
+AdaptiveScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  m_scheduler->Insert (ev);
+  m_size++;
+  m_inserts++;
+  Sample ();
+}
+
+bool
+AdaptiveScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+AdaptiveScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_scheduler->PeekNext ();
+}
+
+Scheduler::Event
+AdaptiveScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  Scheduler::Event next = m_scheduler->RemoveNext ();
+  m_size--;
+  Sample ();
+  return next;
+}
+
+void
+AdaptiveScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  m_scheduler->Remove (ev);
+  m_size--;
+  m_removes++;
+  Sample ();
+}
+
+} // namespace ns3
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ADAPTIVE_SCHEDULER_H
+#define ADAPTIVE_SCHEDULER_H
+
+#include "scheduler.h"
+#include "ptr.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::AdaptiveScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief an event scheduler which picks its data structure at runtime
+ *
+ * This "auto" scheduler delegates to another scheduler, and watches
+ * the number of pending events and the proportion of Remove calls.
+ * Every \c SamplingPeriod operations, it picks:
+ *  - a MapScheduler if more than \c RemoveRatio of the inserted
+ *    events were removed with Remove, since it is the only scheduler
+ *    which does not need a search to remove an arbitrary event,
+ *  - a LadderScheduler if more than \c LargeQueueSize events are
+ *    pending, since it handles large queues in constant time,
+ *  - a PairingHeapScheduler otherwise.
+ *
+ * Switching back from the LadderScheduler only happens once the queue
+ * has shrunk to a quarter of \c LargeQueueSize, to avoid migrating
+ * back and forth.  When the choice changes, all the pending events are
+ * moved to the new scheduler.
+ */
+class AdaptiveScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  AdaptiveScheduler ();
+  /** Destructor. */
+  virtual ~AdaptiveScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+  /**
+   * Get the scheduler currently in use.
+   *
+   * \returns The TypeId of the current scheduler.
+   */
+  TypeId GetCurrentSchedulerType (void) const;
+  /**
+   * Get the number of times the events have been moved to a
+   * different scheduler.
+   *
+   * \returns The number of migrations.
+   */
+  uint32_t GetMigrations (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** Count an operation, and pick the best scheduler periodically. */
+  void Sample (void);
+  /**
+   * Move all the events to a new scheduler.
+   *
+   * \param [in] tid The TypeId of the new scheduler.
+   */
+  void Migrate (TypeId tid);
+
+  /** The scheduler which holds the events. */
+  Ptr<Scheduler> m_scheduler;
+  /** The number of pending events. */
+  uint32_t m_size;
+  /** The number of operations in the current period. */
+  uint32_t m_operations;
+  /** The number of Insert calls in the current period. */
+  uint32_t m_inserts;
+  /** The number of Remove calls in the current period. */
+  uint32_t m_removes;
+  /** The number of migrations. */
+  uint32_t m_migrations;
+  /** The number of operations between two choices. */
+  uint32_t m_samplingPeriod;
+  /** The queue size above which the LadderScheduler is used. */
+  uint32_t m_largeQueueSize;
+  /** The ratio of removals above which the MapScheduler is used. */
+  double m_removeRatio;
+};
+
+} // namespace ns3
+
+#endif /* ADAPTIVE_SCHEDULER_H */
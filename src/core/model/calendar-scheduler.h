@@ -22,6 +22,7 @@
 #define CALENDAR_SCHEDULER_H
 
 #include "scheduler.h"
+#include "event-pool.h"
 #include <stdint.h>
 #include <list>
 
@@ -131,7 +132,7 @@ private:
   void DoInsert (const Scheduler::Event &ev);
 
   /** Calendar bucket type: a list of Events. */
-  typedef std::list<Scheduler::Event> Bucket;
+  typedef std::list<Scheduler::Event, EventPoolAllocator<Scheduler::Event> > Bucket;
   
   /** Array of buckets. */
   Bucket *m_buckets;
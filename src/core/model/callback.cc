@@ -19,6 +19,7 @@
  */
 
 #include "callback.h"
+#include "event-pool.h"
 #include "log.h"
 
 /**
@@ -74,6 +75,18 @@ CallbackValue::DeserializeFromString (std::string value, Ptr<const AttributeChec
 
 ATTRIBUTE_CHECKER_IMPLEMENT (Callback);
 
+void *
+CallbackImplBase::operator new (std::size_t size)
+{
+  return EventPool::Allocate (size);
+}
+
+void
+CallbackImplBase::operator delete (void *p, std::size_t size)
+{
+  EventPool::Deallocate (p, size);
+}
+
 } // namespace ns3
 
 #if (__GNUC__ >= 3)
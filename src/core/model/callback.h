@@ -28,6 +28,7 @@
 #include "attribute.h"
 #include "attribute-helper.h"
 #include "simple-ref-count.h"
+#include <cstddef>
 #include <typeinfo>
 
 /**
@@ -135,12 +136,29 @@ struct CallbackTraits<T *>
  * \ingroup callbackimpl
  * Abstract base class for CallbackImpl
  * Provides reference counting and equality test.
+ *
+ * The implementations are small, and are allocated from the
+ * EventPool, like the events, rather than from the heap.
  */
 class CallbackImplBase : public SimpleRefCount<CallbackImplBase>
 {
 public:
   /** Virtual destructor */
   virtual ~CallbackImplBase () {}
+  /**
+   * Allocate a Callback implementation from the EventPool.
+   *
+   * \param [in] size The size of the implementation.
+   * \returns The memory for the implementation.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release a Callback implementation to the EventPool.
+   *
+   * \param [in] p The implementation.
+   * \param [in] size The size of the most derived class.
+   */
+  static void operator delete (void *p, std::size_t size);
   /**
    * Equality test
    *
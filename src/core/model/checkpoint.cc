@@ -0,0 +1,313 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "checkpoint.h"
+#include "simulator.h"
+#include "simulator-impl.h"
+#include "rng-seed-manager.h"
+#include "rng-stream.h"
+#include "abort.h"
+#include "log.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#if defined (__unix__) || defined (__APPLE__)
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define CHECKPOINT_FORK 1
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Checkpoint");
+
+namespace {
+
+/** The first line of the checkpoints. */
+const char *MAGIC = "ns-3-checkpoint 1";
+
+/**
+ * Get the registered Objects.
+ *
+ * \returns The registered Objects.
+ */
+std::vector<Ptr<Object> > *
+GetObjects (void)
+{
+  static std::vector<Ptr<Object> > objects;
+  return &objects;
+}
+
+#ifdef CHECKPOINT_FORK
+/**
+ * Wait for a replication to exit.
+ *
+ * \param [in] pid The process id of the replication.
+ */
+void
+WaitReplication (pid_t pid)
+{
+  int status = 0;
+  waitpid (pid, &status, 0);
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      NS_LOG_WARN ("Checkpoint: replication " << pid << " failed with status " << status);
+    }
+}
+#endif /* CHECKPOINT_FORK */
+
+/**
+ * Read a keyword, and abort if it is not the expected one.
+ *
+ * \param [in,out] is The input stream.
+ * \param [in] expected The expected keyword.
+ */
+void
+Expect (std::istream &is, std::string expected)
+{
+  std::string keyword;
+  is >> keyword;
+  NS_ABORT_MSG_UNLESS (is && keyword == expected,
+                       "Checkpoint: expected \"" << expected << "\", found \"" << keyword << "\"");
+}
+
+} // unnamed namespace
+
+void
+Checkpoint::Register (Ptr<Object> object)
+{
+  NS_LOG_FUNCTION (object);
+  std::vector<Ptr<Object> > *objects = GetObjects ();
+  if (objects->empty ())
+    {
+      Simulator::ScheduleDestroy (&Checkpoint::Clear);
+    }
+  objects->push_back (object);
+}
+
+void
+Checkpoint::Clear (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetObjects ()->clear ();
+}
+
+void
+Checkpoint::Save (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  os << MAGIC << std::endl;
+  os << "time " << Simulator::Now ().GetTimeStep ()
+     << " " << Time::GetResolution () << std::endl;
+
+  std::vector<RngStream *> streams = RngStream::GetStreams ();
+  os << "rng " << RngSeedManager::GetSeed ()
+     << " " << RngSeedManager::GetRun ()
+     << " " << RngSeedManager::PeekNextStreamIndex ()
+     << " " << streams.size () << std::endl;
+  for (std::vector<RngStream *>::const_iterator i = streams.begin (); i != streams.end (); ++i)
+    {
+      uint32_t state[6];
+      (*i)->GetState (state);
+      os << (*i)->GetStream ();
+      for (int j = 0; j < 6; j++)
+        {
+          os << " " << state[j];
+        }
+      os << std::endl;
+    }
+
+  std::vector<Ptr<Object> > *objects = GetObjects ();
+  os << "objects " << objects->size () << std::endl;
+  for (std::vector<Ptr<Object> >::const_iterator i = objects->begin (); i != objects->end (); ++i)
+    {
+      std::ostringstream state;
+      (*i)->Serialize (state);
+      os << state.str ().size () << std::endl << state.str ();
+    }
+  NS_LOG_INFO ("saved " << streams.size () << " streams and "
+               << objects->size () << " objects at " << Simulator::Now ());
+}
+
+void
+Checkpoint::Save (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::ofstream os (filename.c_str (), std::ios::binary);
+  NS_ABORT_MSG_UNLESS (os.is_open (), "Checkpoint: can't open file " << filename);
+  Save (os);
+}
+
+void
+Checkpoint::Restore (std::istream &is)
+{
+  NS_LOG_FUNCTION (&is);
+  std::string magic;
+  std::getline (is, magic);
+  NS_ABORT_MSG_UNLESS (magic == MAGIC, "Checkpoint: not a checkpoint");
+
+  Expect (is, "time");
+  int64_t ts = 0;
+  int resolution = 0;
+  is >> ts >> resolution;
+  NS_ABORT_MSG_UNLESS (resolution == Time::GetResolution (),
+                       "Checkpoint: saved with another time resolution");
+  Time time = TimeStep (ts);
+  std::vector<Ptr<Object> > *objects = GetObjects ();
+  NS_ABORT_MSG_IF (objects->empty (),
+                   "Checkpoint: no Object registered to schedule the events again");
+  NS_ABORT_MSG_IF (time < Simulator::Now (), "Checkpoint: can't go back to " << time);
+  Simulator::GetImplementation ()->FastForward (time);
+
+  Expect (is, "rng");
+  uint32_t seed = 0;
+  uint64_t run = 0;
+  uint64_t next = 0;
+  uint32_t n = 0;
+  is >> seed >> run >> next >> n;
+  NS_ABORT_MSG_UNLESS (seed == RngSeedManager::GetSeed (),
+                       "Checkpoint: saved with RngSeed " << seed);
+  NS_ABORT_MSG_IF (RngSeedManager::GetRun () < run,
+                   "Checkpoint: saved with a larger RngRun " << run);
+  uint64_t jump = RngSeedManager::GetRun () - run;
+  RngSeedManager::SetNextStreamIndex (std::max (next, RngSeedManager::PeekNextStreamIndex ()));
+
+  std::multimap<uint64_t, RngStream *> live;
+  std::vector<RngStream *> streams = RngStream::GetStreams ();
+  for (std::vector<RngStream *>::const_iterator i = streams.begin (); i != streams.end (); ++i)
+    {
+      live.insert (std::make_pair ((*i)->GetStream (), *i));
+    }
+  uint32_t missing = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint64_t stream = 0;
+      uint32_t state[6];
+      is >> stream;
+      for (int j = 0; j < 6; j++)
+        {
+          is >> state[j];
+        }
+      NS_ABORT_MSG_UNLESS (is, "Checkpoint: truncated random number streams");
+      std::multimap<uint64_t, RngStream *>::iterator found = live.find (stream);
+      if (found == live.end ())
+        {
+          missing++;
+          continue;
+        }
+      found->second->SetState (state);
+      found->second->AdvanceSubstreams (jump);
+      live.erase (found);
+    }
+  if (missing != 0 || !live.empty ())
+    {
+      NS_LOG_WARN ("Checkpoint: " << missing << " saved streams not found, "
+                   << live.size () << " streams not saved");
+    }
+
+  Expect (is, "objects");
+  is >> n;
+  NS_ABORT_MSG_UNLESS (is && n == objects->size (),
+                       "Checkpoint: saved " << n << " objects, "
+                       << objects->size () << " registered");
+  for (std::vector<Ptr<Object> >::const_iterator i = objects->begin (); i != objects->end (); ++i)
+    {
+      std::size_t size = 0;
+      is >> size;
+      is.ignore ();
+      std::string state (size, 0);
+      is.read (&state[0], size);
+      NS_ABORT_MSG_UNLESS (is, "Checkpoint: truncated object state");
+      std::istringstream stateStream (state);
+      (*i)->Deserialize (stateStream);
+    }
+  NS_ABORT_MSG_IF (Simulator::IsFinished (),
+                   "Checkpoint: the registered Objects scheduled no event; "
+                   "use Checkpoint::Fork to replicate Objects without DoDeserialize");
+  NS_LOG_INFO ("restored " << streams.size () << " streams and "
+               << objects->size () << " objects at " << Simulator::Now ());
+}
+
+void
+Checkpoint::Restore (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  NS_ABORT_MSG_UNLESS (is.is_open (), "Checkpoint: can't open file " << filename);
+  Restore (is);
+}
+
+uint32_t
+Checkpoint::Fork (uint32_t replications, uint32_t concurrency)
+{
+  NS_LOG_FUNCTION (replications << concurrency);
+#ifdef CHECKPOINT_FORK
+  if (concurrency == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      concurrency = cpus > 0 ? cpus : 1;
+    }
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  // the running replications, oldest first.
+  std::deque<pid_t> children;
+  for (uint32_t i = 1; i <= replications; i++)
+    {
+      if (children.size () >= concurrency)
+        {
+          WaitReplication (children.front ());
+          children.pop_front ();
+        }
+      pid_t pid = fork ();
+      NS_ABORT_MSG_IF (pid < 0, "Checkpoint: fork failed");
+      if (pid == 0)
+        {
+          RngSeedManager::SetRun (RngSeedManager::GetRun () + i);
+          std::vector<RngStream *> streams = RngStream::GetStreams ();
+          for (std::vector<RngStream *>::const_iterator j = streams.begin (); j != streams.end (); ++j)
+            {
+              (*j)->AdvanceSubstreams (i);
+            }
+          return i;
+        }
+      children.push_back (pid);
+    }
+  for (std::deque<pid_t>::const_iterator i = children.begin (); i != children.end (); ++i)
+    {
+      WaitReplication (*i);
+    }
+  return 0;
+#else
+  NS_FATAL_ERROR ("Checkpoint::Fork is not supported on this platform");
+  return 0;
+#endif
+}
+
+} // namespace ns3
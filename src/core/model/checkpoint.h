@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "ptr.h"
+#include "object.h"
+#include <istream>
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Checkpoint declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \brief Save the state of a simulation, and resume from it.
+ *
+ * Many studies share a long warm-up period, which each replication
+ * simulates again.  Checkpoint offers two ways to start the
+ * replications from the end of the warm-up.
+ *
+ * Fork() replicates the whole process at the end of the warm-up,
+ * pending events included, without any support from the Objects.
+ * This works with any simulation, and is the way to replicate the
+ * scenarios built from the ns-3 models.
+ *
+ * Save() and Restore() move the warm-up state across processes, but
+ * only for the Objects written for it.  A checkpoint holds:
+ *
+ * - the current time,
+ * - the state of every random number stream, see RngStream, and the
+ *   RngSeedManager counters,
+ * - the state of the Objects given to Register(), and of the Objects
+ *   aggregated to them, see Object::Serialize().
+ *
+ * The pending events can't be saved, since they hold arbitrary
+ * functions and pointers: Restore() discards them, moves the
+ * simulation time to the time of the checkpoint, and restores the
+ * registered Objects, which must schedule again their own pending
+ * events from their saved state (Object::DoDeserialize()).  Restore()
+ * is thus limited to simulations whose events are all scheduled by
+ * registered Objects which implement DoSerialize() and DoDeserialize().
+ * Among the ns-3 models, a Node saves its applications, an Application
+ * its start and stop events, and the PacketSocketClient and
+ * PacketSocketServer their traffic, so that a scenario made of these
+ * is restored by registering its Nodes.  The packets queued in the
+ * devices or in flight on the channels are not saved, so the
+ * checkpoint must be taken while the network is idle.  Every other
+ * model loses the state which is not set up by the script: replicate
+ * such scenarios with Fork().  Restore() aborts if no Object is
+ * registered, or if the registered Objects schedule no event.
+ *
+ * The random number streams are matched by stream number.  If the
+ * replication runs with a larger RngRun than the warm-up, each stream
+ * jumps ahead by the difference in sub-streams, so that the
+ * replications draw independent numbers; with the same RngRun, the
+ * replication continues exactly like the warm-up run would have.
+ */
+class Checkpoint
+{
+public:
+  /**
+   * Add an Object to the checkpoints.
+   *
+   * The Objects are saved and restored in the order of registration.
+   * They are released at Simulator::Destroy.
+   *
+   * \param [in] object The Object.
+   */
+  static void Register (Ptr<Object> object);
+  /** Release the registered Objects. */
+  static void Clear (void);
+
+  /**
+   * Save the state of the simulation.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void Save (std::ostream &os);
+  /**
+   * Save the state of the simulation to a file.
+   *
+   * \param [in] filename The file name.
+   */
+  static void Save (std::string filename);
+  /**
+   * Restore the state saved by Save().
+   *
+   * This discards the pending events: the registered Objects must
+   * schedule again their own events, see the class documentation.
+   *
+   * \param [in,out] is The input stream.
+   */
+  static void Restore (std::istream &is);
+  /**
+   * Restore the state saved by Save() to a file.
+   *
+   * \param [in] filename The file name.
+   */
+  static void Restore (std::string filename);
+
+  /**
+   * Fork replications of the simulation.
+   *
+   * Each replication is a child process, which returns from this
+   * function with the whole simulation state of its parent.
+   * Replication \f$i\f$ runs with RngRun incremented by \f$i\f$, and
+   * its random number streams jump ahead by \f$i\f$ sub-streams.  At
+   * most \p concurrency replications run at once: the parent process
+   * waits for the oldest one to exit before it forks the next, and
+   * waits for all of them to exit before it returns.
+   *
+   * This must be called from the main thread, while no other thread
+   * is running, such as between two calls to Simulator::Run() with the
+   * DefaultSimulatorImpl.
+   *
+   * \param [in] replications The number of replications.
+   * \param [in] concurrency The number of replications which run at
+   *        once, or 0 for the number of processors.
+   * \returns The replication number, from 1 to \p replications, in the
+   *          replications, and 0 in the parent process.
+   */
+  static uint32_t Fork (uint32_t replications, uint32_t concurrency = 0);
+};
+
+} // namespace ns3
+
+#endif /* CHECKPOINT_H */
@@ -259,6 +259,133 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+namespace {
+
+/** An attribute which leads to other Objects on the Config paths. */
+struct ChildAttribute
+{
+  std::string name;                      //!< The attribute name.
+  Ptr<const AttributeAccessor> accessor; //!< The attribute accessor.
+  /** The container accessor, or 0 for a Pointer attribute. */
+  const ObjectPtrContainerAccessor *container;
+};
+
+/** The child attributes of a TypeId. */
+struct ChildTable
+{
+  /** The number of attributes of the TypeId and its parents, when built. */
+  uint32_t attributeN;
+  /** The Pointer and container attributes, most derived first. */
+  std::vector<ChildAttribute> children;
+};
+
+/**
+ * Get the attributes of a TypeId and of its parents which lead to
+ * other Objects, that is the Pointer and the container attributes.
+ *
+ * The tables are built on the first use of each TypeId, and built
+ * again if attributes were added to the TypeId since.
+ *
+ * \param [in] tid The TypeId.
+ * \returns The Pointer and container attributes, most derived first.
+ */
+const std::vector<ChildAttribute> &
+GetChildAttributes (TypeId tid)
+{
+  static std::vector<ChildTable> tables;
+  uint32_t attributeN = 0;
+  TypeId tmp = tid;
+  TypeId parent;
+  while (true)
+    {
+      attributeN += tmp.GetAttributeN ();
+      parent = tmp.GetParent ();
+      if (parent == tmp)
+        {
+          break;
+        }
+      tmp = parent;
+    }
+
+  uint16_t uid = tid.GetUid ();
+  if (uid >= tables.size ())
+    {
+      ChildTable empty;
+      empty.attributeN = 0;
+      tables.resize (uid + 1, empty);
+    }
+  ChildTable &table = tables[uid];
+  if (table.attributeN == attributeN)
+    {
+      return table.children;
+    }
+  NS_LOG_LOGIC ("build the child attributes of " << tid.GetName ());
+  table.attributeN = attributeN;
+  table.children.clear ();
+  tmp = tid;
+  while (true)
+    {
+      for (uint32_t i = 0; i < tmp.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = tmp.GetAttribute (i);
+          if (!(info.flags & TypeId::ATTR_GET) || !info.accessor->HasGetter ())
+            {
+              continue;
+            }
+          ChildAttribute child;
+          child.name = info.name;
+          child.accessor = info.accessor;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              child.container = 0;
+              table.children.push_back (child);
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              child.container = dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+              NS_ASSERT (child.container != 0);
+              table.children.push_back (child);
+            }
+        }
+      parent = tmp.GetParent ();
+      if (parent == tmp)
+        {
+          break;
+        }
+      tmp = parent;
+    }
+  return table.children;
+}
+
+/**
+ * Parse a plain index of a Config path.
+ *
+ * \param [in] item The Config path element.
+ * \param [out] index The index.
+ * \returns \c true if \p item is a plain decimal index.
+ */
+bool
+ParseIndex (const std::string &item, uint32_t *index)
+{
+  if (item.empty () || item.size () > 9)
+    {
+      return false;
+    }
+  uint32_t value = 0;
+  for (std::string::const_iterator i = item.begin (); i != item.end (); ++i)
+    {
+      if (*i < '0' || *i > '9')
+        {
+          return false;
+        }
+      value = value * 10 + (*i - '0');
+    }
+  *index = value;
+  return true;
+}
+
+} // unnamed namespace
+
 /**
  * Abstract class to parse Config paths into object references.
  */
@@ -298,9 +425,11 @@ private:
    * Parse an index on the Config path.
    *
    * \param [in] path The remaining Config path.
-   * \param [in,out] vector The resulting list of matching objects.
+   * \param [in] root The object holding the container.
+   * \param [in] container The container attribute.
    */
-  void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  void DoArrayResolve (std::string path, Ptr<Object> root,
+                       const ObjectPtrContainerAccessor *container);
   /**
    * Handle one object found on the path.
    *
@@ -479,62 +608,43 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
+      const std::vector<ChildAttribute> &children = GetChildAttributes (root->GetInstanceTypeId ());
       bool foundMatch = false;
-      
-      do
+
+      for (std::vector<ChildAttribute>::const_iterator i = children.begin (); i != children.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          if (i->name != item && item != "*")
+            {
+              continue;
+            }
+          if (i->container == 0)
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<i->name<<" on path="<<GetResolvedPath ());
+              PointerValue ptr;
+              i->accessor->Get (PeekPointer (root), ptr);
+              Ptr<Object> object = ptr.Get<Object> ();
+              if (object == 0)
                 {
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
                   continue;
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *ptr = dynamic_cast<const PointerChecker *> (PeekPointer (info.checker));
-              if (ptr != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue ptr;
-                  root->GetAttribute (info.name, ptr);
-                  Ptr<Object> object = ptr.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
-                  ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
-                  DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
-                }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoResolve (pathLeft, object);
+              m_workStack.pop_back ();
             }
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<i->name<<" on path="<<GetResolvedPath () << pathLeft);
+              foundMatch = true;
+              m_workStack.push_back (i->name);
+              DoArrayResolve (pathLeft, root, i->container);
+              m_workStack.pop_back ();
+            }
+        }
 
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
       if (!foundMatch)
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
@@ -544,9 +654,10 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
 }
 
 void 
-Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &container)
+Resolver::DoArrayResolve (std::string path, Ptr<Object> root,
+                          const ObjectPtrContainerAccessor *container)
 {
-  NS_LOG_FUNCTION(this << path << &container);
+  NS_LOG_FUNCTION(this << path << root << container);
   NS_ASSERT (path != "");
   NS_ASSERT ((path.find ("/")) == 0);
   std::string::size_type next = path.find ("/", 1);
@@ -557,9 +668,28 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
   std::string item = path.substr (1, next-1);
   std::string pathLeft = path.substr (next, path.size ()-next);
 
+  uint32_t index;
+  if (ParseIndex (item, &index))
+    {
+      // look the index up without copying the whole container.
+      Ptr<Object> object = container->Find (PeekPointer (root), index);
+      if (object != 0)
+        {
+          NS_LOG_DEBUG ("Array "<<index<<" found");
+          std::ostringstream oss;
+          oss << index;
+          m_workStack.push_back (oss.str ());
+          DoResolve (pathLeft, object);
+          m_workStack.pop_back ();
+        }
+      return;
+    }
+
+  ObjectPtrContainerValue vector;
+  container->Get (PeekPointer (root), vector);
   ArrayMatcher matcher = ArrayMatcher (item);
   ObjectPtrContainerValue::Iterator it;
-  for (it = container.Begin (); it != container.End (); ++it)
+  for (it = vector.Begin (); it != vector.End (); ++it)
     {
       if (matcher.Matches ((*it).first))
         {
@@ -27,8 +27,14 @@
 #include "pointer.h"
 #include "assert.h"
 #include "log.h"
+#include "uinteger.h"
+#include "boolean.h"
+#include "string.h"
 
 #include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
 
 
 /**
@@ -53,6 +59,40 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("CrossThreadEvents",
+                   "The number of events scheduled from other threads.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::GetCrossThreadEvents),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("CrossThreadQueueDepth",
+                   "The number of events scheduled from other threads "
+                   "and not yet moved to the event queue.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::GetCrossThreadQueueDepth),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("MaxCrossThreadQueueDepth",
+                   "The largest number of events scheduled from other threads "
+                   "found when moving them to the event queue.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&DefaultSimulatorImpl::GetMaxCrossThreadQueueDepth),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("EnableProfiler",
+                   "Measure the wall-clock execution time of the events, "
+                   "by function and by node, and print it at Simulator::Destroy.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::SetProfilerEnabled,
+                                        &DefaultSimulatorImpl::IsProfilerEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfilerFile",
+                   "The file the event profile is written to, "
+                   "or empty to write it to the standard error, where "
+                   "it is also written if the file can't be opened.",
+                   StringValue (""),
+                   MakeStringAccessor (&DefaultSimulatorImpl::m_profilerFile),
+                   MakeStringChecker ())
   ;
   return tid;
 }
@@ -71,13 +111,15 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
-  m_eventsWithContextEmpty = true;
+  m_maxEventsWithContext = 0;
   m_main = SystemThread::Self();
+  m_profiler = 0;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl ()
 {
   NS_LOG_FUNCTION (this);
+  delete m_profiler;
 }
 
 void
@@ -108,6 +150,29 @@ DefaultSimulatorImpl::Destroy ()
           ev->Invoke ();
         }
     }
+
+  if (m_profiler != 0 && m_profiler->GetEventCount () != 0)
+    {
+      if (m_profilerFile.empty ())
+        {
+          m_profiler->Print (std::clog);
+        }
+      else
+        {
+          std::ofstream os (m_profilerFile.c_str ());
+          if (os.is_open ())
+            {
+              m_profiler->Print (os);
+            }
+          else
+            {
+              // do not lose the report of a whole run.
+              std::clog << "Can't open file " << m_profilerFile
+                        << ", printing the event profile here" << std::endl;
+              m_profiler->Print (std::clog);
+            }
+        }
+    }
 }
 
 void
@@ -121,6 +186,13 @@ DefaultSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
       while (!m_events->IsEmpty ())
         {
           Scheduler::Event next = m_events->RemoveNext ();
+          if (next.impl->IsCancelled ())
+            {
+              // leave the cancelled events behind.
+              next.impl->Unref ();
+              m_unscheduledEvents--;
+              continue;
+            }
           scheduler->Insert (next);
         }
     }
@@ -146,7 +218,21 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
-  next.impl->Invoke ();
+  if (next.impl->IsCancelled ())
+    {
+      m_events->NotifyCancelledRemoved ();
+      next.impl->Invoke ();
+    }
+  else if (m_profiler == 0)
+    {
+      next.impl->Invoke ();
+    }
+  else
+    {
+      uint64_t start = EventProfiler::GetTicks ();
+      next.impl->Invoke ();
+      m_profiler->Record (next.impl, m_currentContext, EventProfiler::GetTicks () - start);
+    }
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
@@ -161,22 +247,15 @@ DefaultSimulatorImpl::IsFinished (void) const
 void
 DefaultSimulatorImpl::ProcessEventsWithContext (void)
 {
-  if (m_eventsWithContextEmpty)
+  if (m_eventsWithContext.IsEmpty ())
     {
       return;
     }
 
-  // swap queues
-  EventsWithContext eventsWithContext;
-  {
-    CriticalSection cs (m_eventsWithContextMutex);
-    m_eventsWithContext.swap(eventsWithContext);
-    m_eventsWithContextEmpty = true;
-  }
-  while (!eventsWithContext.empty ())
+  m_maxEventsWithContext = std::max (m_maxEventsWithContext, m_eventsWithContext.GetSize ());
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
     {
-       EventWithContext event = eventsWithContext.front ();
-       eventsWithContext.pop_front ();
        Scheduler::Event ev;
        ev.impl = event.event;
        ev.key.m_ts = m_currentTs + event.timestamp;
@@ -188,6 +267,51 @@ DefaultSimulatorImpl::ProcessEventsWithContext (void)
     }
 }
 
+uint64_t
+DefaultSimulatorImpl::GetCrossThreadEvents (void) const
+{
+  return m_eventsWithContext.GetPushCount ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetCrossThreadQueueDepth (void) const
+{
+  return m_eventsWithContext.GetSize ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetMaxCrossThreadQueueDepth (void) const
+{
+  return m_maxEventsWithContext;
+}
+
+void
+DefaultSimulatorImpl::SetProfilerEnabled (bool enabled)
+{
+  NS_LOG_FUNCTION (this << enabled);
+  if (enabled && m_profiler == 0)
+    {
+      m_profiler = new EventProfiler ();
+    }
+  else if (!enabled)
+    {
+      delete m_profiler;
+      m_profiler = 0;
+    }
+}
+
+bool
+DefaultSimulatorImpl::IsProfilerEnabled (void) const
+{
+  return m_profiler != 0;
+}
+
+const EventProfiler *
+DefaultSimulatorImpl::GetProfiler (void) const
+{
+  return m_profiler;
+}
+
 void
 DefaultSimulatorImpl::Run (void)
 {
@@ -269,11 +393,7 @@ DefaultSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
       // Current time added in ProcessEventsWithContext()
       ev.timestamp = delay.GetTimeStep ();
       ev.event = event;
-      {
-        CriticalSection cs (m_eventsWithContextMutex);
-        m_eventsWithContext.push_back(ev);
-        m_eventsWithContextEmpty = false;
-      }
+      m_eventsWithContext.Push (ev);
     }
 }
 
@@ -363,6 +483,10 @@ DefaultSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          m_unscheduledEvents -= NotifyCancel (m_events, m_unscheduledEvents);
+        }
     }
 }
 
@@ -414,4 +538,49 @@ DefaultSimulatorImpl::GetContext (void) const
   return m_currentContext;
 }
 
+void
+DefaultSimulatorImpl::FastForward (const Time &time)
+{
+  NS_LOG_FUNCTION (this << time);
+  NS_ASSERT_MSG (SystemThread::Equals (m_main), "Simulator::FastForward Thread-unsafe invocation!");
+  NS_ASSERT (time.GetTimeStep () >= (int64_t)m_currentTs);
+  ProcessEventsWithContext ();
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      if (next.impl->IsCancelled ())
+        {
+          m_events->NotifyCancelledRemoved ();
+        }
+      next.impl->Cancel ();
+      next.impl->Unref ();
+      m_unscheduledEvents--;
+    }
+  m_currentTs = time.GetTimeStep ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_events == 0 ? 0 : m_events->GetCancelledCount ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - GetCancelledEventCount ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetCompactionCount (void) const
+{
+  return m_events == 0 ? 0 : m_events->GetCompactionCount ();
+}
+
+uint64_t
+DefaultSimulatorImpl::GetCompactedEventCount (void) const
+{
+  return m_events == 0 ? 0 : m_events->GetCompactedCount ();
+}
+
 } // namespace ns3
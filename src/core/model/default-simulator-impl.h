@@ -25,7 +25,8 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "system-thread.h"
-#include "ns3/system-mutex.h"
+#include "mpsc-queue.h"
+#include "event-profiler.h"
 
 #include "ptr.h"
 
@@ -77,6 +78,51 @@ public:
   virtual void SetScheduler (ObjectFactory schedulerFactory);
   virtual uint32_t GetSystemId (void) const; 
   virtual uint32_t GetContext (void) const;
+  virtual void FastForward (const Time &time);
+  virtual uint64_t GetCancelledEventCount (void) const;
+  virtual uint64_t GetLiveEventCount (void) const;
+  virtual uint64_t GetCompactionCount (void) const;
+  virtual uint64_t GetCompactedEventCount (void) const;
+
+  /**
+   * Get the number of events scheduled from other threads.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetCrossThreadEvents (void) const;
+  /**
+   * Get the number of events scheduled from other threads, which
+   * have not been moved to the event queue yet.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetCrossThreadQueueDepth (void) const;
+  /**
+   * Get the largest number of events scheduled from other threads
+   * found when moving them to the event queue.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetMaxCrossThreadQueueDepth (void) const;
+
+  /**
+   * Enable or disable the event profiler.
+   *
+   * Disabling the profiler discards its results.
+   *
+   * \param [in] enabled \c true to measure the execution time of the events.
+   */
+  void SetProfilerEnabled (bool enabled);
+  /**
+   * \returns \c true if the event profiler is enabled.
+   */
+  bool IsProfilerEnabled (void) const;
+  /**
+   * Get the event profiler.
+   *
+   * \returns The profiler, or 0 if it is not enabled.
+   */
+  const EventProfiler * GetProfiler (void) const;
 
 private:
   virtual void DoDispose (void);
@@ -95,17 +141,13 @@ private:
     /** The event implementation. */
     EventImpl *event;
   };
-  /** Container type for the events from a different context. */
-  typedef std::list<struct EventWithContext> EventsWithContext;
-  /** The container of events from a different context. */
-  EventsWithContext m_eventsWithContext;
   /**
-   * Flag \c true if all events with context have been moved to the
-   * primary event queue.
+   * The lock-free queue of the events scheduled from other threads,
+   * moved to the main event queue by ProcessEventsWithContext.
    */
-  bool m_eventsWithContextEmpty;
-  /** Mutex to control access to the list of events with context. */
-  SystemMutex m_eventsWithContextMutex;
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
+  /** The largest number of events seen in #m_eventsWithContext. */
+  uint64_t m_maxEventsWithContext;
 
   /** Container type for the events to run at Simulator::Destroy() */
   typedef std::list<EventId> DestroyEvents;
@@ -132,6 +174,11 @@ private:
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
+
+  /** The event profiler, or 0 if it is not enabled. */
+  EventProfiler *m_profiler;
+  /** The file the profile is written to at Destroy, or empty for std::clog. */
+  std::string m_profilerFile;
 };
 
 } // namespace ns3
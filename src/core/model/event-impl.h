@@ -21,6 +21,9 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 #include "simple-ref-count.h"
 
 /**
@@ -40,6 +43,8 @@ namespace ns3 {
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * All the events are allocated from the EventPool.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -65,6 +70,33 @@ public:
    * Checked by the simulation engine before calling Invoke().
    */
   bool IsCancelled (void);
+  /**
+   * Get the function invoked by this event.
+   *
+   * This is used by the DefaultSimulatorImpl profiler to tell apart
+   * the events of a same class created with different functions.
+   *
+   * \returns The address of the function, or 0 if unknown.
+   */
+  virtual const void * GetTarget (void) const;
+
+  /**
+   * Allocate an event from the EventPool.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory for the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release an event to the EventPool.
+   *
+   * The destructor is virtual, so that \p size is the size of the
+   * most derived class.
+   *
+   * \param [in] p The event.
+   * \param [in] size The size of the event.
+   */
+  static void operator delete (void *p, std::size_t size);
 
 protected:
   /**
@@ -74,11 +106,33 @@ protected:
    * arguments bound by a call to one of the MakeEvent() functions.
    */
   virtual void Notify (void) = 0;
+  /**
+   * Get the address of a function or member function.
+   *
+   * This is the first word of the pointer, which holds the address of
+   * the function for function pointers and, on the usual C++ ABIs, for
+   * pointers to non-virtual member functions.
+   *
+   * \tparam F \deduced The function pointer type.
+   * \param [in] f The function pointer.
+   * \returns The address of the function.
+   */
+  template <typename F>
+  static const void * GetFunctionAddress (F f);
 
 private:
   bool m_cancel;  /**< Has this event been cancelled. */
 };
 
+template <typename F>
+const void *
+EventImpl::GetFunctionAddress (F f)
+{
+  const void *address = 0;
+  std::memcpy (&address, &f, std::min (sizeof (address), sizeof (f)));
+  return address;
+}
+
 } // namespace ns3
 
 #endif /* EVENT_IMPL_H */
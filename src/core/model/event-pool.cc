@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-pool.h"
+#include "ns3/core-config.h"
+#include <cstring>
+#include <mutex>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool implementation.
+ */
+
+namespace ns3 {
+
+// Note: no logging here, since the pool can be used during the
+// static destruction, after the log components are gone.
+
+namespace {
+
+/** Granularity and alignment of the size classes. */
+const std::size_t ALIGNMENT = 16;
+/** Largest size served by the pool. */
+const std::size_t MAX_SIZE = 512;
+/** Number of size classes. */
+const std::size_t CLASSES = MAX_SIZE / ALIGNMENT;
+/** Size of the chunks the blocks are carved from. */
+const std::size_t CHUNK_SIZE = 64 * 1024;
+/** Number of blocks handed over at once to the shared cache. */
+const uint32_t BATCH = 256;
+
+/** A free block, linked in its free list. */
+struct FreeBlock
+{
+  FreeBlock *next; //!< Next free block.
+};
+
+/**
+ * The free lists and counters of a thread.
+ *
+ * This is a plain structure, so that the shared cache is initialized
+ * statically and is never destroyed.
+ */
+struct Cache
+{
+  FreeBlock *free[CLASSES]; //!< The free lists, by size class.
+  uint32_t count[CLASSES];  //!< The lengths of the free lists.
+  char *current;            //!< The unused part of the current chunk.
+  std::size_t left;         //!< The size of the unused part of the current chunk.
+  EventPool::Stats stats;   //!< The counters.
+};
+
+/** The cache of the threads which have exited, protected by g_mutex. */
+Cache g_shared;
+/** The chunks, linked through their first bytes, protected by g_mutex. */
+FreeBlock *g_chunks = 0;
+/** Protects g_shared and g_chunks. */
+std::mutex g_mutex;
+
+/** The cache of a thread, handed over to g_shared when it exits. */
+struct ThreadCache : public Cache
+{
+  ThreadCache ();
+  ~ThreadCache ();
+};
+
+/** Set once the cache of this thread has been destroyed. */
+thread_local bool t_exited = false;
+/** The cache of this thread. */
+thread_local ThreadCache t_cache;
+
+ThreadCache::ThreadCache ()
+{
+  std::memset (static_cast<Cache *> (this), 0, sizeof (Cache));
+}
+
+ThreadCache::~ThreadCache ()
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (std::size_t i = 0; i < CLASSES; i++)
+    {
+      FreeBlock *last = free[i];
+      if (last == 0)
+        {
+          continue;
+        }
+      while (last->next != 0)
+        {
+          last = last->next;
+        }
+      last->next = g_shared.free[i];
+      g_shared.free[i] = free[i];
+      g_shared.count[i] += count[i];
+    }
+  g_shared.stats.allocations += stats.allocations;
+  g_shared.stats.deallocations += stats.deallocations;
+  g_shared.stats.systemAllocations += stats.systemAllocations;
+  g_shared.stats.bytesReserved += stats.bytesReserved;
+  t_exited = true;
+}
+
+#ifdef ENABLE_EVENT_POOL
+/**
+ * Get a block from a new chunk.
+ *
+ * \param [in,out] cache The cache.
+ * \param [in] index The size class.
+ * \param [in] shared \c true if the cache is g_shared, and g_mutex is held.
+ * \returns The block.
+ */
+void *
+Carve (Cache &cache, std::size_t index, bool shared)
+{
+  std::size_t size = (index + 1) * ALIGNMENT;
+  if (cache.left < size)
+    {
+      if (!shared)
+        {
+          // take back the blocks released by the threads which exited,
+          // before allocating a new chunk.
+          std::lock_guard<std::mutex> lock (g_mutex);
+          if (g_shared.free[index] != 0)
+            {
+              FreeBlock *block = g_shared.free[index];
+              cache.free[index] = block->next;
+              cache.count[index] = g_shared.count[index] - 1;
+              g_shared.free[index] = 0;
+              g_shared.count[index] = 0;
+              return block;
+            }
+        }
+      char *chunk = static_cast<char *> (::operator new (CHUNK_SIZE));
+      cache.stats.systemAllocations++;
+      cache.stats.bytesReserved += CHUNK_SIZE;
+      {
+        std::unique_lock<std::mutex> lock (g_mutex, std::defer_lock);
+        if (!shared)
+          {
+            lock.lock ();
+          }
+        FreeBlock *link = reinterpret_cast<FreeBlock *> (chunk);
+        link->next = g_chunks;
+        g_chunks = link;
+      }
+      cache.current = chunk + ALIGNMENT;
+      cache.left = CHUNK_SIZE - ALIGNMENT;
+    }
+  void *block = cache.current;
+  cache.current += size;
+  cache.left -= size;
+  return block;
+}
+#endif /* ENABLE_EVENT_POOL */
+
+/**
+ * Allocate a block from a cache.
+ *
+ * \param [in,out] cache The cache.
+ * \param [in] size The size of the block.
+ * \param [in] shared \c true if the cache is g_shared, and g_mutex is held.
+ * \returns The block.
+ */
+void *
+AllocateFrom (Cache &cache, std::size_t size, bool shared)
+{
+  cache.stats.allocations++;
+#ifdef ENABLE_EVENT_POOL
+  if (size != 0 && size <= MAX_SIZE)
+    {
+      std::size_t index = (size - 1) / ALIGNMENT;
+      FreeBlock *block = cache.free[index];
+      if (block != 0)
+        {
+          cache.free[index] = block->next;
+          cache.count[index]--;
+          return block;
+        }
+      return Carve (cache, index, shared);
+    }
+#endif
+  cache.stats.systemAllocations++;
+  return ::operator new (size);
+}
+
+/**
+ * Release a block to a cache.
+ *
+ * A thread which releases more blocks than it allocates, such as the
+ * main thread running the events scheduled by another thread, hands
+ * its surplus over to the shared cache, where the allocating threads
+ * pick it up instead of carving new chunks.
+ *
+ * \param [in,out] cache The cache.
+ * \param [in] p The block.
+ * \param [in] size The size of the block.
+ * \param [in] shared \c true if the cache is g_shared, and g_mutex is held.
+ */
+void
+DeallocateTo (Cache &cache, void *p, std::size_t size, bool shared)
+{
+  cache.stats.deallocations++;
+#ifdef ENABLE_EVENT_POOL
+  if (size != 0 && size <= MAX_SIZE)
+    {
+      std::size_t index = (size - 1) / ALIGNMENT;
+      FreeBlock *block = static_cast<FreeBlock *> (p);
+      block->next = cache.free[index];
+      cache.free[index] = block;
+      cache.count[index]++;
+      if (!shared && cache.count[index] >= 2 * BATCH)
+        {
+          FreeBlock *last = block;
+          for (uint32_t i = 1; i < BATCH; i++)
+            {
+              last = last->next;
+            }
+          cache.free[index] = last->next;
+          cache.count[index] -= BATCH;
+          std::lock_guard<std::mutex> lock (g_mutex);
+          last->next = g_shared.free[index];
+          g_shared.free[index] = block;
+          g_shared.count[index] += BATCH;
+        }
+      return;
+    }
+#endif
+  ::operator delete (p);
+}
+
+} // unnamed namespace
+
+void *
+EventPool::Allocate (std::size_t size)
+{
+  if (!t_exited)
+    {
+      return AllocateFrom (t_cache, size, false);
+    }
+  std::lock_guard<std::mutex> lock (g_mutex);
+  return AllocateFrom (g_shared, size, true);
+}
+
+void
+EventPool::Deallocate (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  if (!t_exited)
+    {
+      DeallocateTo (t_cache, p, size, false);
+      return;
+    }
+  std::lock_guard<std::mutex> lock (g_mutex);
+  DeallocateTo (g_shared, p, size, true);
+}
+
+EventPool::Stats
+EventPool::GetStats (void)
+{
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    stats = g_shared.stats;
+  }
+  if (!t_exited)
+    {
+      stats.allocations += t_cache.stats.allocations;
+      stats.deallocations += t_cache.stats.deallocations;
+      stats.systemAllocations += t_cache.stats.systemAllocations;
+      stats.bytesReserved += t_cache.stats.bytesReserved;
+    }
+  return stats;
+}
+
+bool
+EventPool::IsEnabled (void)
+{
+#ifdef ENABLE_EVENT_POOL
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace ns3
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <cstddef>
+#include <new>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool and ns3::EventPoolAllocator declarations.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief A size-class memory pool for the simulation events.
+ *
+ * Every call to Simulator::Schedule allocates an EventImpl, and most
+ * schedulers allocate a container node to hold its Scheduler::Event
+ * record.  Both are small, short-lived, and of a handful of distinct
+ * sizes, so they are served from per-thread free lists, one per
+ * 16-byte size class up to 512 bytes, which are refilled from 64 KiB
+ * chunks.  Larger requests go to the global \c operator \c new.
+ *
+ * Memory is never given back to the system: the free lists of a
+ * thread are handed over to the other threads when it exits, or when
+ * it releases many more blocks than it allocates.
+ *
+ * The pool is enabled by default, and can be disabled at configure
+ * time with \c --disable-event-pool, in which case every request goes
+ * to the global \c operator \c new.  The counters are maintained in
+ * both cases, so that the two configurations can be compared.
+ */
+class EventPool
+{
+public:
+  /** Allocation counters. */
+  struct Stats
+  {
+    uint64_t allocations;       //!< Number of blocks allocated.
+    uint64_t deallocations;     //!< Number of blocks released.
+    uint64_t systemAllocations; //!< Number of calls to the global operator new.
+    uint64_t bytesReserved;     //!< Bytes held in pool chunks.
+  };
+
+  /**
+   * Allocate a block.
+   *
+   * \param [in] size The size of the block, in bytes.
+   * \returns The block.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * Release a block.
+   *
+   * \param [in] p The block, as returned by Allocate.
+   * \param [in] size The size which was passed to Allocate.
+   */
+  static void Deallocate (void *p, std::size_t size);
+  /**
+   * Get the counters.
+   *
+   * The counters of the threads which are still running, other than
+   * the calling thread, are only included once they have exited.
+   *
+   * \returns The counters.
+   */
+  static Stats GetStats (void);
+  /**
+   * \returns \c true if the pool was enabled at configure time.
+   */
+  static bool IsEnabled (void);
+};
+
+/**
+ * \ingroup events
+ * \brief A standard allocator drawing from the EventPool.
+ *
+ * Used by the schedulers for the container nodes which hold the
+ * Scheduler::Event records.
+ *
+ * \tparam T \explicit The allocated type.
+ */
+template <typename T>
+class EventPoolAllocator
+{
+public:
+  typedef T value_type;                      //!< Allocated type.
+  typedef T * pointer;                       //!< Pointer type.
+  typedef const T * const_pointer;           //!< Const pointer type.
+  typedef T & reference;                     //!< Reference type.
+  typedef const T & const_reference;         //!< Const reference type.
+  typedef std::size_t size_type;             //!< Size type.
+  typedef std::ptrdiff_t difference_type;    //!< Difference type.
+
+  /**
+   * Rebind to another type.
+   * \tparam U \explicit The other type.
+   */
+  template <typename U>
+  struct rebind
+  {
+    typedef EventPoolAllocator<U> other; //!< The rebound allocator.
+  };
+
+  /** Constructor. */
+  EventPoolAllocator ()
+  {
+  }
+  /**
+   * Copy constructor from another type.
+   * \tparam U \deduced The other type.
+   */
+  template <typename U>
+  EventPoolAllocator (const EventPoolAllocator<U> &)
+  {
+  }
+  /**
+   * Allocate objects.
+   * \param [in] n The number of objects.
+   * \returns The memory for the objects.
+   */
+  pointer allocate (size_type n, const void * = 0)
+  {
+    return static_cast<pointer> (EventPool::Allocate (n * sizeof (T)));
+  }
+  /**
+   * Release objects.
+   * \param [in] p The objects.
+   * \param [in] n The number of objects.
+   */
+  void deallocate (pointer p, size_type n)
+  {
+    EventPool::Deallocate (p, n * sizeof (T));
+  }
+  /** \returns The maximum number of objects which can be allocated. */
+  size_type max_size (void) const
+  {
+    return size_type (-1) / sizeof (T);
+  }
+  /**
+   * Construct an object.
+   * \tparam U \deduced The type of the object.
+   * \tparam Args \deduced The types of the constructor arguments.
+   * \param [in] p The location of the object.
+   * \param [in] args The constructor arguments.
+   */
+  template <typename U, typename... Args>
+  void construct (U *p, Args&&... args)
+  {
+    new (p) U (static_cast<Args&&> (args)...);
+  }
+  /**
+   * Destroy an object.
+   * \tparam U \deduced The type of the object.
+   * \param [in] p The object.
+   */
+  template <typename U>
+  void destroy (U *p)
+  {
+    p->~U ();
+  }
+};
+
+/**
+ * All the EventPoolAllocators share the same pool.
+ * \returns \c true
+ */
+template <typename T, typename U>
+inline bool
+operator == (const EventPoolAllocator<T> &, const EventPoolAllocator<U> &)
+{
+  return true;
+}
+/**
+ * All the EventPoolAllocators share the same pool.
+ * \returns \c false
+ */
+template <typename T, typename U>
+inline bool
+operator != (const EventPoolAllocator<T> &, const EventPoolAllocator<U> &)
+{
+  return false;
+}
+
+} // namespace ns3
+
+#endif /* EVENT_POOL_H */
@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+#include "event-impl.h"
+#include "simulator.h"
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#define EVENT_PROFILER_TSC 1
+#endif
+
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+#if (__GNUC__ >= 3)
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventProfiler");
+
+namespace {
+
+/**
+ * Read the system clock.
+ *
+ * \returns The current time, in nanoseconds.
+ */
+int64_t
+GetClock (void)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/**
+ * Demangle a C++ symbol.
+ *
+ * \param [in] mangled The mangled symbol.
+ * \returns The demangled symbol, or \p mangled if it cannot be demangled.
+ */
+std::string
+Demangle (const char *mangled)
+{
+  std::string name = mangled;
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, 0, 0, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  return name;
+}
+
+/**
+ * Order the entries by decreasing total time.
+ *
+ * \param [in] a The first entry.
+ * \param [in] b The second entry.
+ * \returns \c true if \p a comes first.
+ */
+bool
+CompareEntries (const EventProfiler::Entry &a, const EventProfiler::Entry &b)
+{
+  if (a.total != b.total)
+    {
+      return a.total > b.total;
+    }
+  return a.name < b.name;
+}
+
+} // unnamed namespace
+
+EventProfiler::EventProfiler ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+uint64_t
+EventProfiler::GetTicks (void)
+{
+#ifdef EVENT_PROFILER_TSC
+  return __rdtsc ();
+#else
+  return GetClock ();
+#endif
+}
+
+void
+EventProfiler::Add (Stats &stats, uint64_t ticks)
+{
+  stats.count++;
+  stats.total += ticks;
+  stats.max = std::max (stats.max, ticks);
+}
+
+void
+EventProfiler::Record (const EventImpl *event, uint32_t context, uint64_t ticks)
+{
+  Key key;
+  key.type = &typeid (*event);
+  key.target = event->GetTarget ();
+  std::unordered_map<Key, Stats, KeyHash>::iterator i = m_functions.find (key);
+  if (i == m_functions.end ())
+    {
+      Stats stats = { 0, 0, 0 };
+      i = m_functions.insert (std::make_pair (key, stats)).first;
+    }
+  Add (i->second, ticks);
+
+  if (context == Simulator::NO_CONTEXT)
+    {
+      Add (m_noContext, ticks);
+      return;
+    }
+  if (context >= m_nodes.size ())
+    {
+      Stats stats = { 0, 0, 0 };
+      m_nodes.resize (context + 1, stats);
+    }
+  Add (m_nodes[context], ticks);
+}
+
+void
+EventProfiler::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_functions.clear ();
+  m_nodes.clear ();
+  m_noContext.count = 0;
+  m_noContext.total = 0;
+  m_noContext.max = 0;
+  m_startTicks = GetTicks ();
+  m_startTime = GetClock ();
+}
+
+uint64_t
+EventProfiler::GetEventCount (void) const
+{
+  uint64_t count = 0;
+  for (std::unordered_map<Key, Stats, KeyHash>::const_iterator i = m_functions.begin ();
+       i != m_functions.end (); ++i)
+    {
+      count += i->second.count;
+    }
+  return count;
+}
+
+double
+EventProfiler::GetSecondsPerTick (void) const
+{
+#ifdef EVENT_PROFILER_TSC
+  // calibrate the time stamp counter against the system clock over
+  // the lifetime of the profiler, and at least 10ms.
+  int64_t time = GetClock ();
+  while (time - m_startTime < 10000000)
+    {
+      time = GetClock ();
+    }
+  uint64_t ticks = GetTicks ();
+  if (ticks <= m_startTicks)
+    {
+      return 0;
+    }
+  return (time - m_startTime) * 1e-9 / (ticks - m_startTicks);
+#else
+  return 1e-9;
+#endif
+}
+
+EventProfiler::Entry
+EventProfiler::MakeEntry (std::string name, const Stats &stats, double secondsPerTick)
+{
+  Entry entry;
+  entry.name = name;
+  entry.count = stats.count;
+  entry.total = stats.total * secondsPerTick;
+  entry.max = stats.max * secondsPerTick;
+  return entry;
+}
+
+std::string
+EventProfiler::GetName (const Key &key)
+{
+#ifdef HAVE_DLADDR
+  Dl_info info;
+  if (key.target != 0
+      && dladdr (key.target, &info) != 0
+      && info.dli_sname != 0
+      && info.dli_saddr == key.target)
+    {
+      return Demangle (info.dli_sname);
+    }
+#endif
+  std::ostringstream oss;
+  oss << Demangle (key.type->name ());
+  if (key.target != 0)
+    {
+      oss << " at " << key.target;
+    }
+  return oss.str ();
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::GetFunctions (void) const
+{
+  NS_LOG_FUNCTION (this);
+  double secondsPerTick = GetSecondsPerTick ();
+  std::vector<Entry> entries;
+  for (std::unordered_map<Key, Stats, KeyHash>::const_iterator i = m_functions.begin ();
+       i != m_functions.end (); ++i)
+    {
+      entries.push_back (MakeEntry (GetName (i->first), i->second, secondsPerTick));
+    }
+  std::sort (entries.begin (), entries.end (), CompareEntries);
+  return entries;
+}
+
+std::vector<EventProfiler::Entry>
+EventProfiler::GetNodes (void) const
+{
+  NS_LOG_FUNCTION (this);
+  double secondsPerTick = GetSecondsPerTick ();
+  std::vector<Entry> entries;
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      if (m_nodes[i].count != 0)
+        {
+          std::ostringstream oss;
+          oss << i;
+          entries.push_back (MakeEntry (oss.str (), m_nodes[i], secondsPerTick));
+        }
+    }
+  if (m_noContext.count != 0)
+    {
+      entries.push_back (MakeEntry ("-", m_noContext, secondsPerTick));
+    }
+  std::sort (entries.begin (), entries.end (), CompareEntries);
+  return entries;
+}
+
+void
+EventProfiler::PrintEntries (std::ostream &os, const std::vector<Entry> &entries,
+                             double total, std::string heading)
+{
+  os << std::setw (12) << "total (s)"
+     << std::setw (8) << "share"
+     << std::setw (12) << "count"
+     << std::setw (12) << "mean (us)"
+     << std::setw (12) << "max (us)"
+     << "  " << heading << std::endl;
+  for (std::vector<Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      os << std::fixed
+         << std::setw (12) << std::setprecision (6) << i->total
+         << std::setw (7) << std::setprecision (1) << (total > 0 ? 100 * i->total / total : 0) << "%"
+         << std::setw (12) << i->count
+         << std::setw (12) << std::setprecision (3) << 1e6 * i->total / i->count
+         << std::setw (12) << std::setprecision (3) << 1e6 * i->max
+         << "  " << i->name << std::endl;
+    }
+  os.unsetf (std::ios::floatfield);
+}
+
+void
+EventProfiler::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::vector<Entry> functions = GetFunctions ();
+  std::vector<Entry> nodes = GetNodes ();
+  uint64_t count = 0;
+  double total = 0;
+  for (std::vector<Entry>::const_iterator i = functions.begin (); i != functions.end (); ++i)
+    {
+      count += i->count;
+      total += i->total;
+    }
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Event profile: " << count << " events, " << total << " s" << std::endl;
+  os << std::endl << "By function:" << std::endl;
+  PrintEntries (os, functions, total, "function");
+  os << std::endl << "By node:" << std::endl;
+  PrintEntries (os, nodes, total, "node");
+  os.flags (flags);
+  os.precision (precision);
+}
+
+} // namespace ns3
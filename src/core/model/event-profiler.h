@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ * \brief Wall-clock time spent in the events, by function and by node.
+ *
+ * Where DesMetrics records the causality of the events, this records
+ * how long they take to execute.  Each event is tagged with the class
+ * of its EventImpl and the function it invokes (see
+ * EventImpl::GetTarget), and separately with its context, which is
+ * the node id for the events of the nodes.  The number of events, and
+ * the total and largest execution times are accumulated for each tag.
+ *
+ * The times are measured with the time stamp counter where available,
+ * which costs a few nanoseconds per event, and are converted to
+ * seconds against the system clock when the results are read.
+ *
+ * The profiler is enabled with the DefaultSimulatorImpl
+ * \c EnableProfiler attribute, and prints its report at
+ * Simulator::Destroy:
+ * \verbatim
+   $ ./waf --run "my-program --ns3::DefaultSimulatorImpl::EnableProfiler=true" \endverbatim
+ *
+ * The functions are named after their symbol when it can be found in
+ * the dynamic symbol table, and after the EventImpl class and the
+ * function address otherwise.
+ */
+class EventProfiler
+{
+public:
+  /** The accumulated times of a function or node. */
+  struct Entry
+  {
+    std::string name;    //!< The function name, or the node id.
+    uint64_t count;      //!< The number of events.
+    double total;        //!< The total execution time, in seconds.
+    double max;          //!< The longest execution time, in seconds.
+  };
+
+  /** Constructor. */
+  EventProfiler ();
+
+  /**
+   * Read the time stamp counter, or the system clock if there is none.
+   *
+   * \returns The current time, in ticks.
+   */
+  static uint64_t GetTicks (void);
+
+  /**
+   * Account for an event.
+   *
+   * \param [in] event The event.
+   * \param [in] context The context of the event.
+   * \param [in] ticks The execution time of the event, in ticks.
+   */
+  void Record (const EventImpl *event, uint32_t context, uint64_t ticks);
+  /** Forget the events recorded so far. */
+  void Clear (void);
+
+  /**
+   * \returns The number of events recorded.
+   */
+  uint64_t GetEventCount (void) const;
+  /**
+   * \returns The times by function, by decreasing total time.
+   */
+  std::vector<Entry> GetFunctions (void) const;
+  /**
+   * \returns The times by node, by decreasing total time.
+   */
+  std::vector<Entry> GetNodes (void) const;
+  /**
+   * Print the times by function and by node.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void Print (std::ostream &os) const;
+
+private:
+  /** The tag of an event. */
+  struct Key
+  {
+    const std::type_info *type;  //!< The class of the event.
+    const void *target;          //!< The function invoked by the event.
+    /**
+     * \param [in] o The other key.
+     * \returns \c true if the keys are equal.
+     */
+    bool operator == (const Key &o) const
+    {
+      return type == o.type && target == o.target;
+    }
+  };
+  /** Hash a Key. */
+  struct KeyHash
+  {
+    /**
+     * \param [in] key The key.
+     * \returns The hash of the key.
+     */
+    std::size_t operator () (const Key &key) const
+    {
+      return reinterpret_cast<std::size_t> (key.type) * 31
+        ^ reinterpret_cast<std::size_t> (key.target);
+    }
+  };
+  /** The accumulated ticks of a tag. */
+  struct Stats
+  {
+    uint64_t count;  //!< The number of events.
+    uint64_t total;  //!< The total ticks.
+    uint64_t max;    //!< The largest number of ticks.
+  };
+
+  /**
+   * Add an event to the counters of a tag.
+   *
+   * \param [in,out] stats The counters.
+   * \param [in] ticks The execution time of the event.
+   */
+  static void Add (Stats &stats, uint64_t ticks);
+  /**
+   * Get the duration of a tick.
+   *
+   * \returns The duration of a tick, in seconds.
+   */
+  double GetSecondsPerTick (void) const;
+  /**
+   * Convert the counters of a tag.
+   *
+   * \param [in] name The name of the tag.
+   * \param [in] stats The counters.
+   * \param [in] secondsPerTick The duration of a tick.
+   * \returns The entry.
+   */
+  static Entry MakeEntry (std::string name, const Stats &stats, double secondsPerTick);
+  /**
+   * Get the name of a function.
+   *
+   * \param [in] key The tag of the function.
+   * \returns The name.
+   */
+  static std::string GetName (const Key &key);
+  /**
+   * Print a table of entries.
+   *
+   * \param [in,out] os The output stream.
+   * \param [in] entries The entries.
+   * \param [in] total The total time of all the events, in seconds.
+   * \param [in] heading The heading of the name column.
+   */
+  static void PrintEntries (std::ostream &os, const std::vector<Entry> &entries,
+                            double total, std::string heading);
+
+  /** The counters by function. */
+  std::unordered_map<Key, Stats, KeyHash> m_functions;
+  /** The counters by node, indexed by context. */
+  std::vector<Stats> m_nodes;
+  /** The counters of the events without context. */
+  Stats m_noContext;
+  /** The ticks when the profiler was created, for the calibration. */
+  uint64_t m_startTicks;
+  /** The system clock when the profiler was created, in nanoseconds. */
+  int64_t m_startTime;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
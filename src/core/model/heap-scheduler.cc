@@ -236,6 +236,14 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
+          // the last event may be smaller than the parent of the
+          // removed one.
+          while (!IsRoot (i) && !IsBottom (i)
+                 && IsLessStrictly (i, Parent (i)))
+            {
+              Exch (i, Parent (i));
+              i = Parent (i);
+            }
           TopDown (i);
           return;
         }
@@ -243,5 +251,31 @@ HeapScheduler::Remove (const Event &ev)
   NS_ASSERT (false);
 }
 
+uint64_t
+HeapScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t last = Root ();
+  for (uint32_t i = Root (); i < m_heap.size (); i++)
+    {
+      if (m_heap[i].impl->IsCancelled ())
+        {
+          m_heap[i].impl->Unref ();
+        }
+      else
+        {
+          m_heap[last++] = m_heap[i];
+        }
+    }
+  uint64_t removed = m_heap.size () - last;
+  m_heap.resize (last);
+  // rebuild the heap from the bottom, in linear time.
+  for (uint32_t i = Parent (Last ()); i >= Root (); i--)
+    {
+      TopDown (i);
+    }
+  return removed;
+}
+
 } // namespace ns3
 
@@ -72,6 +72,9 @@ public:
   virtual void Remove (const Scheduler::Event &ev);
 
 private:
+  // Inherited
+  virtual uint64_t DoCompact (void);
+
   /** Event list type:  vector of Events, managed as a heap. */
   typedef std::vector<Scheduler::Event> BinaryHeap;
 
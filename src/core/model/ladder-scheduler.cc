@@ -0,0 +1,356 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/** Buckets with more events than this are split in a new rung. */
+const uint32_t THRESHOLD = 50;
+/** Maximum number of rungs. */
+const uint32_t MAX_RUNGS = 8;
+/** Maximum number of buckets in a rung. */
+const uint32_t MAX_BUCKETS = 1 << 16;
+
+/**
+ * Compare two events by increasing key.
+ *
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a < \c b
+ */
+bool
+LessKey (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key < b.key;
+}
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (~0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_count (0)
+{
+  NS_LOG_FUNCTION (this);
+  // allocate all the rungs now: references to rungs must survive
+  // the creation of a new rung.
+  m_rungs.resize (MAX_RUNGS);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint32_t
+LadderScheduler::GetBucket (const Rung &rung, uint64_t ts) const
+{
+  uint32_t bucket = (ts - rung.start) / rung.width;
+  NS_ASSERT (bucket >= rung.current && bucket < rung.nBuckets);
+  return bucket;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      if (ts >= GetCurrentStart (m_rungs[i]))
+        {
+          return i;
+        }
+    }
+  return m_nRungs;
+}
+
+void
+LadderScheduler::CreateRung (uint64_t start, uint64_t end, Bucket &events)
+{
+  NS_LOG_FUNCTION (this << start << end << events.size ());
+  NS_ASSERT (m_nRungs < MAX_RUNGS);
+  NS_ASSERT (end > start);
+
+  uint32_t nBuckets = std::min<uint32_t> (std::max<uint32_t> (events.size (), 1), MAX_BUCKETS);
+  Rung &rung = m_rungs[m_nRungs];
+  rung.start = start;
+  rung.width = (end - start) / nBuckets + 1;
+  rung.current = 0;
+  rung.nBuckets = nBuckets;
+  rung.count = events.size ();
+  if (rung.buckets.size () < nBuckets)
+    {
+      rung.buckets.resize (nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      rung.buckets[GetBucket (rung, i->key.m_ts)].push_back (*i);
+    }
+  events.clear ();
+  m_nRungs++;
+}
+
+void
+LadderScheduler::InsertInBottom (const Event &ev)
+{
+  Simultaneous &events = m_bottom[ev.key.m_ts];
+  // the simulator schedules the simultaneous events by increasing
+  // uid, so the search from the end stops at once.
+  Simultaneous::iterator i = events.end ();
+  while (i != events.begin ())
+    {
+      Simultaneous::iterator prev = i;
+      --prev;
+      if (prev->key.m_uid < ev.key.m_uid)
+        {
+          break;
+        }
+      i = prev;
+    }
+  events.insert (i, ev);
+}
+
+void
+LadderScheduler::MoveToBottom (Bucket &events)
+{
+  NS_ASSERT (m_bottom.empty ());
+  std::sort (events.begin (), events.end (), LessKey);
+  Bottom::iterator last = m_bottom.end ();
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      if (last == m_bottom.end () || last->first != i->key.m_ts)
+        {
+          last = m_bottom.insert (m_bottom.end (), std::make_pair (i->key.m_ts, Simultaneous ()));
+        }
+      last->second.push_back (*i);
+    }
+  events.clear ();
+}
+
+void
+LadderScheduler::FillBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty () && m_count > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          NS_ASSERT (!m_top.empty ());
+          if (m_top.size () <= THRESHOLD)
+            {
+              m_topStart = m_topMax + 1;
+              MoveToBottom (m_top);
+            }
+          else
+            {
+              CreateRung (m_topMin, m_topMax + 1, m_top);
+              const Rung &rung = m_rungs[0];
+              m_topStart = rung.start + rung.nBuckets * rung.width;
+            }
+          m_topMin = ~0;
+          m_topMax = 0;
+          continue;
+        }
+
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      NS_ASSERT (rung.current < rung.nBuckets);
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = GetCurrentStart (rung);
+      rung.current++;
+      rung.count -= bucket.size ();
+      if (bucket.size () > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          CreateRung (start, start + rung.width, bucket);
+        }
+      else
+        {
+          MoveToBottom (bucket);
+        }
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_count++;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          rung.buckets[GetBucket (rung, ts)].push_back (ev);
+          rung.count++;
+        }
+      else
+        {
+          InsertInBottom (ev);
+          if (m_bottom.size () > THRESHOLD && m_nRungs < MAX_RUNGS)
+            {
+              // too many timestamps in the near future: spread them
+              // over a new rung to keep insertion cheap.
+              uint64_t end = m_nRungs > 0 ? GetCurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+              uint64_t start = m_bottom.begin ()->first;
+              Bucket events;
+              for (Bottom::const_iterator i = m_bottom.begin (); i != m_bottom.end (); ++i)
+                {
+                  events.insert (events.end (), i->second.begin (), i->second.end ());
+                }
+              m_bottom.clear ();
+              CreateRung (start, end, events);
+            }
+        }
+    }
+  FillBottom ();
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_count == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.begin ()->second.front ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Bottom::iterator first = m_bottom.begin ();
+  Scheduler::Event next = first->second.front ();
+  first->second.pop_front ();
+  if (first->second.empty ())
+    {
+      m_bottom.erase (first);
+    }
+  m_count--;
+  FillBottom ();
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i == m_nRungs)
+        {
+          Bottom::iterator events = m_bottom.find (ts);
+          NS_ASSERT (events != m_bottom.end ());
+          Simultaneous::iterator j = events->second.begin ();
+          while (j->key.m_uid != ev.key.m_uid)
+            {
+              ++j;
+              NS_ASSERT (j != events->second.end ());
+            }
+          NS_ASSERT (ev.impl == j->impl);
+          events->second.erase (j);
+          if (events->second.empty ())
+            {
+              m_bottom.erase (events);
+            }
+          m_count--;
+          FillBottom ();
+          return;
+        }
+      Rung &rung = m_rungs[i];
+      bucket = &rung.buckets[GetBucket (rung, ts)];
+      rung.count--;
+    }
+  for (Bucket::iterator j = bucket->begin (); j != bucket->end (); ++j)
+    {
+      if (j->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == j->impl);
+          *j = bucket->back ();
+          bucket->pop_back ();
+          m_count--;
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include "event-pool.h"
+#include <list>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue described in
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh
+ * and Ian Li-Jin Thng (ACM TOMACS, 2005).
+ *
+ * The events are stored in three tiers:
+ *  - the Top, an unsorted vector of the events far in the future,
+ *  - the Ladder, a few rungs of unsorted buckets, each rung
+ *    splitting one bucket of the rung above it,
+ *  - the Bottom, the earliest events, with a list of events by
+ *    increasing uid for each timestamp.
+ *
+ * Events are only sorted once they reach the Bottom, and a bucket
+ * is split in a new rung rather than sorted when it holds more than
+ * 50 events, so that insertion and removal of the earliest
+ * event take amortized constant time, whatever the distribution of the
+ * timestamps.  Simultaneous events can not be split over a rung: they
+ * share the list of their timestamp, where an event scheduled after
+ * the others is appended in constant time.  The Bottom only holds more
+ * than 50 timestamps once all the rungs are in use, and its insertion
+ * then takes logarithmic time.  Removal of an arbitrary event needs to
+ * scan its bucket (or the Top, for far-future events, or the list of
+ * its timestamp).
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: an unsorted vector of Events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+  /** The events of a timestamp in the Bottom, by increasing uid. */
+  typedef std::list<Scheduler::Event, EventPoolAllocator<Scheduler::Event> > Simultaneous;
+  /** The Bottom: the events by timestamp. */
+  typedef std::map<uint64_t, Simultaneous, std::less<uint64_t>,
+                   EventPoolAllocator<std::pair<const uint64_t, Simultaneous> > > Bottom;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    /** Timestamp of the start of the first bucket. */
+    uint64_t start;
+    /** Duration of a bucket, in dimensionless time units. */
+    uint64_t width;
+    /** Index of the first bucket which has not been moved down. */
+    uint32_t current;
+    /** Number of buckets in use. */
+    uint32_t nBuckets;
+    /** Number of events in the rung. */
+    uint32_t count;
+    /** The buckets. */
+    std::vector<Bucket> buckets;
+  };
+
+  /**
+   * Find the rung which covers a timestamp.
+   *
+   * \param [in] ts The timestamp.
+   * \returns The rung index, or the number of rungs if the
+   *          timestamp belongs to the Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Get the bucket of a rung which covers a timestamp.
+   *
+   * \param [in] rung The rung.
+   * \param [in] ts The timestamp.
+   * \returns The bucket index.
+   */
+  uint32_t GetBucket (const Rung &rung, uint64_t ts) const;
+  /**
+   * Get the first timestamp still covered by a rung.
+   *
+   * \param [in] rung The rung.
+   * \returns The start of the current bucket.
+   */
+  uint64_t GetCurrentStart (const Rung &rung) const;
+  /**
+   * Add a rung below the existing ones and spread events over it.
+   *
+   * \param [in] start The first timestamp covered by the rung.
+   * \param [in] end The timestamp just after the range covered by the rung.
+   * \param [in,out] events The events to move into the rung.
+   */
+  void CreateRung (uint64_t start, uint64_t end, Bucket &events);
+  /**
+   * Insert an event in the Bottom.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertInBottom (const Scheduler::Event &ev);
+  /**
+   * Sort events and move them to the empty Bottom.
+   *
+   * \param [in,out] events The events.
+   */
+  void MoveToBottom (Bucket &events);
+  /** Refill the empty Bottom from the Ladder or the Top. */
+  void FillBottom (void);
+
+  /** The events far in the future. */
+  Bucket m_top;
+  /** Smallest timestamp in the Top. */
+  uint64_t m_topMin;
+  /** Largest timestamp in the Top. */
+  uint64_t m_topMax;
+  /** Events with at least this timestamp go to the Top. */
+  uint64_t m_topStart;
+  /** The rungs; only the first m_nRungs ones are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** The earliest events. */
+  Bottom m_bottom;
+  /** Number of events in the queue. */
+  uint32_t m_count;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
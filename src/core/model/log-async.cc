@@ -0,0 +1,606 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+#ifdef HAVE_PTHREAD_H
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#endif
+
+/**
+ * \file
+ * \ingroup logging
+ * Log record and asynchronous logging implementation.
+ *
+ * Each thread stages the text of its log messages in a string, and,
+ * in the asynchronous mode, copies it with a RecordHeader into its own
+ * single-producer, single-consumer ring; the rings are drained under
+ * a mutex, by a background thread, by LogAsyncFlush(), or by the
+ * producer itself when its ring is full.
+ */
+
+namespace ns3 {
+
+namespace {
+
+/** The size of the ring of each thread, a power of two. */
+const uint32_t LOG_RING_SIZE = 1 << 20;
+
+/** The header of a log record in a ring, followed by its text. */
+struct RecordHeader
+{
+  const LogComponent *component;  //!< The component, or 0.
+  const char *function;           //!< The name of the logging function.
+  LogStampPrinter timePrinter;    //!< The printer of the time stamp.
+  int64_t time;                   //!< The time stamp.
+  int64_t node;                   //!< The node stamp.
+  uint32_t length;                //!< The length of the text.
+  uint32_t context;               //!< The length of the context at the start of the text.
+  uint32_t prefixes;              //!< The LOG_PREFIX_* flags to render.
+  uint32_t kind;                  //!< The LogRecordKind.
+  uint32_t level;                 //!< The LogLevel.
+};
+
+/**
+ * Render a log record as the synchronous macros print it.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] header The record header.
+ * \param [in] text The text of the record.
+ */
+void
+Render (std::ostream &os, const RecordHeader &header, const std::string &text)
+{
+  if (header.kind == LOG_RECORD_UNCOND)
+    {
+      os << text << '\n';
+      return;
+    }
+  if (header.prefixes & LOG_PREFIX_TIME)
+    {
+      if (header.timePrinter != 0)
+        {
+          (*header.timePrinter)(os, header.time);
+        }
+      else
+        {
+          os << header.time;
+        }
+      os << " ";
+    }
+  if (header.prefixes & LOG_PREFIX_NODE)
+    {
+      os << header.node << " ";
+    }
+  os.write (text.data (), header.context);
+  if (header.kind == LOG_RECORD_FUNCTION)
+    {
+      os << header.component->Name () << ":" << header.function << "(";
+      os.write (text.data () + header.context, header.length - header.context);
+      os << ")\n";
+      return;
+    }
+  if (header.prefixes & LOG_PREFIX_FUNC)
+    {
+      os << header.component->Name () << ":" << header.function << "(): ";
+    }
+  if (header.prefixes & LOG_PREFIX_LEVEL)
+    {
+      os << "[" << LogComponent::GetLevelLabel ((enum LogLevel)header.level) << "] ";
+    }
+  os.write (text.data () + header.context, header.length - header.context);
+  os << '\n';
+}
+
+/** The ring of the log records of one thread. */
+class Ring
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] size The size of the ring, a power of two.
+   */
+  Ring (uint32_t size)
+    : m_buffer (size),
+      m_head (0),
+      m_tail (0),
+      m_orphan (false)
+  {
+  }
+  /**
+   * Append a record; called by the thread which owns the ring.
+   *
+   * \param [in] header The record header.
+   * \param [in] text The record text.
+   * \returns \c false if the ring is too full.
+   */
+  bool Push (const RecordHeader &header, const char *text)
+  {
+    uint64_t head = m_head.load (std::memory_order_relaxed);
+    uint64_t tail = m_tail.load (std::memory_order_acquire);
+    uint64_t size = sizeof (header) + header.length;
+    if (m_buffer.size () - (head - tail) < size)
+      {
+        return false;
+      }
+    Write (head, &header, sizeof (header));
+    Write (head + sizeof (header), text, header.length);
+    m_head.store (head + size, std::memory_order_release);
+    return true;
+  }
+  /**
+   * Render and remove all the records; called under g_drainMutex.
+   *
+   * \param [in,out] os The output stream.
+   */
+  void Drain (std::ostream &os)
+  {
+    uint64_t tail = m_tail.load (std::memory_order_relaxed);
+    uint64_t head = m_head.load (std::memory_order_acquire);
+    while (tail != head)
+      {
+        RecordHeader header;
+        Read (tail, &header, sizeof (header));
+        m_text.resize (header.length);
+        Read (tail + sizeof (header), &m_text[0], header.length);
+        Render (os, header, m_text);
+        tail += sizeof (header) + header.length;
+        m_tail.store (tail, std::memory_order_release);
+      }
+  }
+  /**
+   * Get the largest record text which fits in the ring.
+   * \returns The length.
+   */
+  uint32_t GetMaxLength (void) const
+  {
+    return m_buffer.size () - sizeof (RecordHeader);
+  }
+  /** Mark the ring as orphaned: its thread exited. */
+  void Orphan (void)
+  {
+    m_orphan.store (true, std::memory_order_release);
+  }
+  /**
+   * Check if the thread of the ring exited.
+   * \returns \c true if no record will be pushed any more.
+   */
+  bool IsOrphan (void) const
+  {
+    return m_orphan.load (std::memory_order_acquire);
+  }
+
+private:
+  /**
+   * Copy bytes into the ring, wrapping around its end.
+   * \param [in] position The position in the ring.
+   * \param [in] data The bytes.
+   * \param [in] n The number of bytes.
+   */
+  void Write (uint64_t position, const void *data, uint32_t n)
+  {
+    uint32_t offset = position & (m_buffer.size () - 1);
+    uint32_t first = std::min<uint32_t> (n, m_buffer.size () - offset);
+    std::memcpy (&m_buffer[offset], data, first);
+    std::memcpy (&m_buffer[0], (const char *)data + first, n - first);
+  }
+  /**
+   * Copy bytes out of the ring, wrapping around its end.
+   * \param [in] position The position in the ring.
+   * \param [out] data The bytes.
+   * \param [in] n The number of bytes.
+   */
+  void Read (uint64_t position, void *data, uint32_t n) const
+  {
+    uint32_t offset = position & (m_buffer.size () - 1);
+    uint32_t first = std::min<uint32_t> (n, m_buffer.size () - offset);
+    std::memcpy (data, &m_buffer[offset], first);
+    std::memcpy ((char *)data + first, &m_buffer[0], n - first);
+  }
+
+  std::vector<char> m_buffer;         //!< The bytes of the ring.
+  std::atomic<uint64_t> m_head;       //!< The write position.
+  std::atomic<uint64_t> m_tail;       //!< The read position.
+  std::atomic<bool> m_orphan;         //!< Set when the thread exits.
+  std::string m_text;                 //!< The text of the record being rendered.
+};
+
+/** A stream buffer which appends to a string. */
+class StagingBuffer : public std::streambuf
+{
+public:
+  std::string m_text;                 //!< The staged text.
+protected:
+  virtual int_type overflow (int_type c)
+  {
+    if (c != traits_type::eof ())
+      {
+        m_text.push_back (traits_type::to_char_type (c));
+      }
+    return traits_type::not_eof (c);
+  }
+  virtual std::streamsize xsputn (const char *s, std::streamsize n)
+  {
+    m_text.append (s, n);
+    return n;
+  }
+};
+
+/** A log record being formatted by a thread. */
+struct Frame
+{
+  Frame ()
+    : m_stream (&m_buffer)
+  {
+    m_stream.copyfmt (std::clog);
+  }
+  bool m_async;                       //!< The record is asynchronous.
+  RecordHeader m_header;              //!< The header of the record.
+  StagingBuffer m_buffer;             //!< The text of the record.
+  std::ostream m_stream;              //!< The stream on m_buffer.
+};
+
+/**
+ * The log records being formatted by a thread: a message can log
+ * while it is formatted.
+ */
+struct ThreadState
+{
+  ThreadState ()
+    : m_depth (0),
+      m_ring (0),
+      m_rendering (false)
+  {
+  }
+  ~ThreadState ()
+  {
+    for (std::vector<Frame *>::iterator i = m_frames.begin (); i != m_frames.end (); ++i)
+      {
+        delete *i;
+      }
+    if (m_ring != 0)
+      {
+        m_ring->Orphan ();
+      }
+  }
+  std::vector<Frame *> m_frames;      //!< The frames, reused.
+  uint32_t m_depth;                   //!< The number of frames in use.
+  Ring *m_ring;                       //!< The ring of the thread.
+  bool m_rendering;                   //!< The thread is rendering records.
+};
+
+/**
+ * The state of each thread.  It is a plain pointer, and not an object
+ * with a destructor, so that the destructors of the static objects can
+ * still log after the thread_local objects are destroyed.
+ */
+thread_local ThreadState *t_state = 0;
+/** The ThreadCleanup of the thread was constructed. */
+thread_local bool t_cleanup = false;
+
+/** Delete the ThreadState when its thread exits. */
+struct ThreadCleanup
+{
+  ~ThreadCleanup ()
+  {
+    delete t_state;
+    t_state = 0;
+  }
+};
+
+/**
+ * Get the state of the calling thread.
+ * \returns The state.
+ */
+ThreadState &
+GetState (void)
+{
+  if (t_state == 0)
+    {
+      t_state = new ThreadState ();
+      if (!t_cleanup)
+        {
+          t_cleanup = true;
+          static thread_local ThreadCleanup cleanup;
+          (void)cleanup;
+        }
+    }
+  return *t_state;
+}
+
+std::atomic<bool> g_async (false);    //!< The asynchronous mode is on.
+std::mutex g_drainMutex;              //!< Protects g_rings and the draining.
+std::vector<Ring *> g_rings;          //!< The rings of all the threads.
+bool g_atExit = false;                //!< The exit handler is registered.
+LogStampGetter g_timeStamp = 0;       //!< The time stamp getter.
+LogStampPrinter g_timeStampPrinter = 0; //!< The time stamp printer.
+LogStampGetter g_nodeStamp = 0;       //!< The node stamp getter.
+#ifdef HAVE_PTHREAD_H
+std::thread g_renderer;               //!< The background thread.
+std::condition_variable g_wakeup;     //!< Wakes the background thread up.
+bool g_stop = false;                  //!< Stops the background thread.
+#endif
+
+/**
+ * Render the records of all the rings on \c std::clog;
+ * called with g_drainMutex locked.
+ */
+void
+DrainAll (void)
+{
+  ThreadState &state = GetState ();
+  bool rendering = state.m_rendering;
+  // the stamp printers can log, synchronously.
+  state.m_rendering = true;
+  for (std::vector<Ring *>::iterator i = g_rings.begin (); i != g_rings.end (); )
+    {
+      bool orphan = (*i)->IsOrphan ();
+      (*i)->Drain (std::clog);
+      if (orphan)
+        {
+          delete *i;
+          i = g_rings.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  std::clog.flush ();
+  state.m_rendering = rendering;
+}
+
+#ifdef HAVE_PTHREAD_H
+/** The loop of the background thread. */
+void
+RenderLoop (void)
+{
+  GetState ().m_rendering = true;
+  std::unique_lock<std::mutex> lock (g_drainMutex);
+  while (!g_stop)
+    {
+      g_wakeup.wait_for (lock, std::chrono::milliseconds (1));
+      DrainAll ();
+    }
+}
+#endif
+
+/** Stop the asynchronous mode before the program exits. */
+void
+StopAtExit (void)
+{
+  LogSetAsync (false);
+}
+
+/**
+ * Get the ring of the calling thread.
+ * \returns The ring.
+ */
+Ring *
+GetRing (void)
+{
+  ThreadState &state = GetState ();
+  if (state.m_ring == 0)
+    {
+      state.m_ring = new Ring (LOG_RING_SIZE);
+      std::lock_guard<std::mutex> lock (g_drainMutex);
+      g_rings.push_back (state.m_ring);
+    }
+  return state.m_ring;
+}
+
+} // anonymous namespace
+
+void
+LogSetTimeStamp (LogStampGetter getter, LogStampPrinter printer)
+{
+  g_timeStamp = getter;
+  g_timeStampPrinter = printer;
+}
+
+void
+LogSetNodeStamp (LogStampGetter getter)
+{
+  g_nodeStamp = getter;
+}
+
+void
+LogSetAsync (bool enable)
+{
+  if (enable == g_async.load ())
+    {
+      return;
+    }
+  if (enable)
+    {
+      if (!g_atExit)
+        {
+          std::atexit (&StopAtExit);
+          g_atExit = true;
+        }
+      g_async.store (true);
+#ifdef HAVE_PTHREAD_H
+      g_stop = false;
+      g_renderer = std::thread (&RenderLoop);
+#endif
+      return;
+    }
+  g_async.store (false);
+#ifdef HAVE_PTHREAD_H
+    {
+      std::lock_guard<std::mutex> lock (g_drainMutex);
+      g_stop = true;
+    }
+  g_wakeup.notify_one ();
+  g_renderer.join ();
+#endif
+  LogAsyncFlush ();
+}
+
+bool
+LogIsAsync (void)
+{
+  return g_async.load ();
+}
+
+void
+LogAsyncFlush (void)
+{
+  if (GetState ().m_rendering)
+    {
+      return;
+    }
+  std::lock_guard<std::mutex> lock (g_drainMutex);
+  DrainAll ();
+}
+
+bool
+LogRecordBegin (const LogComponent *component)
+{
+  ThreadState &state = GetState ();
+  if (state.m_depth == state.m_frames.size ())
+    {
+      state.m_frames.push_back (new Frame ());
+    }
+  Frame *frame = state.m_frames[state.m_depth++];
+  frame->m_async = g_async.load (std::memory_order_relaxed) && !state.m_rendering;
+  if (!frame->m_async)
+    {
+      return false;
+    }
+  frame->m_buffer.m_text.clear ();
+  frame->m_stream.clear ();
+  RecordHeader &header = frame->m_header;
+  header.component = component;
+  header.timePrinter = g_timeStampPrinter;
+  header.time = 0;
+  header.node = 0;
+  header.prefixes = 0;
+  if (component == 0)
+    {
+      return true;
+    }
+  bool time = component->IsEnabled (LOG_PREFIX_TIME);
+  bool node = component->IsEnabled (LOG_PREFIX_NODE);
+  if ((!time || g_timeStamp != 0) && (!node || g_nodeStamp != 0))
+    {
+      if (time)
+        {
+          header.time = (*g_timeStamp)();
+          header.prefixes |= LOG_PREFIX_TIME;
+        }
+      if (node)
+        {
+          header.node = (*g_nodeStamp)();
+          header.prefixes |= LOG_PREFIX_NODE;
+        }
+    }
+  else
+    {
+      // no stamps: print the prefixes now, in front of the context.
+      LogTimePrinter timePrinter = LogGetTimePrinter ();
+      if (time && timePrinter != 0)
+        {
+          (*timePrinter)(frame->m_stream);
+          frame->m_stream << " ";
+        }
+      LogNodePrinter nodePrinter = LogGetNodePrinter ();
+      if (node && nodePrinter != 0)
+        {
+          (*nodePrinter)(frame->m_stream);
+          frame->m_stream << " ";
+        }
+    }
+  if (component->IsEnabled (LOG_PREFIX_FUNC))
+    {
+      header.prefixes |= LOG_PREFIX_FUNC;
+    }
+  if (component->IsEnabled (LOG_PREFIX_LEVEL))
+    {
+      header.prefixes |= LOG_PREFIX_LEVEL;
+    }
+  return true;
+}
+
+bool
+LogRecordMark (void)
+{
+  ThreadState &state = GetState ();
+  Frame *frame = state.m_frames[state.m_depth - 1];
+  if (!frame->m_async)
+    {
+      return false;
+    }
+  frame->m_header.context = frame->m_buffer.m_text.size ();
+  return true;
+}
+
+std::ostream &
+LogRecordStream (void)
+{
+  ThreadState &state = GetState ();
+  if (state.m_depth == 0 || !state.m_frames[state.m_depth - 1]->m_async)
+    {
+      return std::clog;
+    }
+  return state.m_frames[state.m_depth - 1]->m_stream;
+}
+
+void
+LogRecordEnd (const char *function, enum LogRecordKind kind, enum LogLevel level)
+{
+  ThreadState &state = GetState ();
+  Frame *frame = state.m_frames[--state.m_depth];
+  if (!frame->m_async)
+    {
+      if (kind == LOG_RECORD_FUNCTION)
+        {
+          std::clog << ")";
+        }
+      std::clog << std::endl;
+      return;
+    }
+  RecordHeader &header = frame->m_header;
+  const std::string &text = frame->m_buffer.m_text;
+  if (kind == LOG_RECORD_UNCOND)
+    {
+      header.context = 0;
+    }
+  header.function = function;
+  header.kind = kind;
+  header.level = level;
+  Ring *ring = GetRing ();
+  header.length = std::min<uint64_t> (text.size (), ring->GetMaxLength ());
+  header.context = std::min (header.context, header.length);
+  if (!ring->Push (header, text.data ()))
+    {
+      LogAsyncFlush ();
+      ring->Push (header, text.data ());
+    }
+}
+
+} // namespace ns3
@@ -29,6 +29,35 @@
 
 #ifdef NS3_LOG_ENABLE
 
+#ifndef NS_LOG_STATIC_LEVELS
+/**
+ * \ingroup logging
+ * The log levels which can be enabled at run time.
+ *
+ * Define it, for example with the \c --log-levels option of
+ * \c waf configure, to a constant mask of LogLevel values: the
+ * checks of the other levels then fold to \c false at compile time.
+ */
+#define NS_LOG_STATIC_LEVELS ns3::LOG_ALL
+#endif /* NS_LOG_STATIC_LEVELS */
+
+/**
+ * \ingroup logging
+ * Check if \c level is enabled for the LogComponent of this file.
+ * \internal
+ * Logging implementation macro; should not be called directly.
+ *
+ * \param [in] level The log level.
+ */
+#define NS_LOG_IS_ENABLED(level)                                \
+  (((level) & (NS_LOG_STATIC_LEVELS)) && g_log.IsEnabled (level))
+
+/**
+ * \ingroup logging
+ * The stream of the log message being formatted, on which
+ * NS_LOG_APPEND_CONTEXT should write.
+ */
+#define NS_LOG_STREAM ns3::LogRecordStream ()
 
 /**
  * \ingroup logging
@@ -104,7 +133,7 @@
  * \code
  *   if (var)
  *     {
- *       std::clog << "[node " << var->GetObject<Node> ()->GetId () << "] ";
+ *       NS_LOG_STREAM << "[node " << var->GetObject<Node> ()->GetId () << "] ";
  *     }
  * \endcode
  */
@@ -153,14 +182,22 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (level))                              \
+      if (NS_LOG_IS_ENABLED (level))                            \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
+          if (!ns3::LogRecordBegin (&g_log))                    \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+            }                                                   \
           NS_LOG_APPEND_CONTEXT;                                \
-          NS_LOG_APPEND_FUNC_PREFIX;                            \
-          NS_LOG_APPEND_LEVEL_PREFIX (level);                   \
-          std::clog << msg << std::endl;                        \
+          if (!ns3::LogRecordMark ())                           \
+            {                                                   \
+              NS_LOG_APPEND_FUNC_PREFIX;                        \
+              NS_LOG_APPEND_LEVEL_PREFIX (level);               \
+            }                                                   \
+          NS_LOG_STREAM << msg;                                 \
+          ns3::LogRecordEnd (__FUNCTION__,                      \
+                             ns3::LOG_RECORD_MESSAGE, level);   \
         }                                                       \
     }                                                           \
   while (false)
@@ -177,13 +214,22 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
+          if (!ns3::LogRecordBegin (&g_log))                    \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+            }                                                   \
           NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "()" << std::endl;       \
+          if (!ns3::LogRecordMark ())                           \
+            {                                                   \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "(";                 \
+            }                                                   \
+          ns3::LogRecordEnd (__FUNCTION__,                      \
+                             ns3::LOG_RECORD_FUNCTION,          \
+                             ns3::LOG_FUNCTION);                \
         }                                                       \
     }                                                           \
   while (false)
@@ -214,15 +260,23 @@
   NS_LOG_CONDITION                                              \
   do                                                            \
     {                                                           \
-      if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
+      if (NS_LOG_IS_ENABLED (ns3::LOG_FUNCTION))                \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
+          if (!ns3::LogRecordBegin (&g_log))                    \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+            }                                                   \
           NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "(";                     \
-          ns3::ParameterLogger (std::clog) << parameters;       \
-          std::clog << ")" << std::endl;                        \
+          if (!ns3::LogRecordMark ())                           \
+            {                                                   \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "(";                 \
+            }                                                   \
+          ns3::ParameterLogger (NS_LOG_STREAM) << parameters;   \
+          ns3::LogRecordEnd (__FUNCTION__,                      \
+                             ns3::LOG_RECORD_FUNCTION,          \
+                             ns3::LOG_FUNCTION);                \
         }                                                       \
     }                                                           \
   while (false)
@@ -235,12 +289,15 @@
  *
  * \param [in] msg The message to log
  */
-#define NS_LOG_UNCOND(msg)              \
+#define NS_LOG_UNCOND(msg)                                      \
   NS_LOG_CONDITION                                              \
-  do                                    \
-    {                                   \
-      std::clog << msg << std::endl;    \
-    }                                   \
+  do                                                            \
+    {                                                           \
+      ns3::LogRecordBegin (0);                                  \
+      NS_LOG_STREAM << msg;                                     \
+      ns3::LogRecordEnd (__FUNCTION__,                          \
+                         ns3::LOG_RECORD_UNCOND, ns3::LOG_NONE); \
+    }                                                           \
   while (false)
 
 
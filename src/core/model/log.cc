@@ -268,19 +268,6 @@ LogComponent::EnvVarCheck (void)
 }
 
 
-bool 
-LogComponent::IsEnabled (const enum LogLevel level) const
-{
-  //  LogComponentEnableEnvVar ();
-  return (level & m_levels) ? 1 : 0;
-}
-
-bool
-LogComponent::IsNoneEnabled (void) const
-{
-  return m_levels == 0;
-}
-
 void
 LogComponent::SetMask (const enum LogLevel level)
 {
@@ -611,11 +598,19 @@ static void CheckEnvironmentVariables (void)
 void LogSetTimePrinter (LogTimePrinter printer)
 {
   g_logTimePrinter = printer;
+  LogSetTimeStamp (0, 0);
   /** \internal
    *  This is the only place where we are more or less sure that all log variables
    * are registered. See \bugid{1082} for details.
    */
   CheckEnvironmentVariables(); 
+#ifdef HAVE_GETENV
+  char *async = getenv ("NS_LOG_ASYNC");
+  if (async != 0 && std::strlen (async) != 0 && std::strcmp (async, "0") != 0)
+    {
+      LogSetAsync (true);
+    }
+#endif
 }
 LogTimePrinter LogGetTimePrinter (void)
 {
@@ -625,6 +620,7 @@ LogTimePrinter LogGetTimePrinter (void)
 void LogSetNodePrinter (LogNodePrinter printer)
 {
   g_logNodePrinter = printer;
+  LogSetNodeStamp (0);
 }
 LogNodePrinter LogGetNodePrinter (void)
 {
@@ -78,6 +78,24 @@
  *   NS_LOG_FUNCTION (this << arg1 << args);
  * \endcode
  * Use NS_LOG_FUNCTION_NOARGS() only in static functions with no arguments.
+ *
+ * By default each message is formatted and written to \c std::clog
+ * in the logging call.  With LogSetAsync(), or with the \c NS_LOG_ASYNC
+ * environment variable set to any value but \c 0, the logging call
+ * only formats the message text, and copies it with the time and node
+ * stamps into a per-thread ring buffer; a background thread adds the
+ * prefixes and writes the messages to \c std::clog, in the order in
+ * which each thread logged them.  The output is the same in both modes.
+ * \code
+ *   $ NS_LOG='Component1=level_all|prefix_all' NS_LOG_ASYNC=1 ./waf --run ...
+ * \endcode
+ *
+ * In builds without \c NS3_LOG_ENABLE the logging macros compile to
+ * nothing.  Between the two, the levels which can be enabled at run
+ * time can be limited at compile time with \c NS_LOG_STATIC_LEVELS
+ * (see the \c --log-levels option of \c waf configure): the checks
+ * of the other levels fold to \c false, and the compiler drops their
+ * messages.
  */
 /** @{ */
 
@@ -303,6 +321,61 @@ void LogSetNodePrinter (LogNodePrinter np);
  */
 LogNodePrinter LogGetNodePrinter (void);
 
+/**
+ * Function signature for taking a stamp, such as the simulation time
+ * or the node id, when a message is logged in asynchronous mode.
+ *
+ * \returns The stamp.
+ */
+typedef int64_t (*LogStampGetter)(void);
+/**
+ * Function signature for printing a time stamp when an asynchronous
+ * log message is written.
+ *
+ * \param [in,out] os The output stream to print on.
+ * \param [in] stamp The stamp taken when the message was logged.
+ */
+typedef void (*LogStampPrinter)(std::ostream &os, int64_t stamp);
+
+/**
+ * Set the functions which stamp asynchronous log messages with the
+ * simulation time, and print the stamp in the prefix.  They must
+ * print the same prefix as the LogTimePrinter; LogSetTimePrinter()
+ * clears them.  Without them, the LogTimePrinter is called in the
+ * logging call.
+ *
+ * \param [in] getter The function which takes the time stamp.
+ * \param [in] printer The function which prints it.
+ */
+void LogSetTimeStamp (LogStampGetter getter, LogStampPrinter printer);
+/**
+ * Set the function which stamps asynchronous log messages with the
+ * node id, which is printed as a decimal number in the prefix, as the
+ * LogNodePrinter should; LogSetNodePrinter() clears it.
+ *
+ * \param [in] getter The function which takes the node stamp.
+ */
+void LogSetNodeStamp (LogStampGetter getter);
+
+/**
+ * Start or stop the asynchronous logging mode.
+ *
+ * When stopping, the pending messages are written before returning.
+ *
+ * \param [in] enable \c true to log asynchronously.
+ */
+void LogSetAsync (bool enable);
+/**
+ * Check the logging mode.
+ * \returns \c true if the messages are logged asynchronously.
+ */
+bool LogIsAsync (void);
+/**
+ * Write the pending asynchronous log messages of all the threads to
+ * \c std::clog.  This is called before aborting on a fatal error.
+ */
+void LogAsyncFlush (void);
+
 
 /**
  * A single log component configuration.
@@ -328,13 +401,13 @@ public:
    * \param [in] level The level to check for.
    * \return \c true if we are enabled at \c level.
    */
-  bool IsEnabled (const enum LogLevel level) const;
+  inline bool IsEnabled (const enum LogLevel level) const;
   /**
    * Check if all levels are disabled.
    *
    * \return \c true if all levels are disabled.
    */
-  bool IsNoneEnabled (void) const;
+  inline bool IsNoneEnabled (void) const;
   /**
    * Enable this LogComponent at \c level
    *
@@ -409,6 +482,67 @@ private:
 
 };  // class LogComponent
 
+bool
+LogComponent::IsEnabled (const enum LogLevel level) const
+{
+  return (level & m_levels) ? 1 : 0;
+}
+
+bool
+LogComponent::IsNoneEnabled (void) const
+{
+  return m_levels == 0;
+}
+
+/**
+ * \internal
+ * The kinds of log records, which the logging macros pass to
+ * LogRecordEnd().
+ */
+enum LogRecordKind
+{
+  LOG_RECORD_MESSAGE,           //!< NS_LOG() and its variants.
+  LOG_RECORD_FUNCTION,          //!< NS_LOG_FUNCTION() and NS_LOG_FUNCTION_NOARGS().
+  LOG_RECORD_UNCOND             //!< NS_LOG_UNCOND().
+};
+
+/**
+ * \internal
+ * Start a log record.  In the synchronous mode, the macro then prints
+ * the time and node prefixes on \c std::clog; in the asynchronous
+ * mode, they are stamped here.
+ *
+ * \param [in] component The LogComponent, or 0 for NS_LOG_UNCOND().
+ * \returns \c true if the record is asynchronous.
+ */
+bool LogRecordBegin (const LogComponent *component);
+/**
+ * \internal
+ * Mark the end of the NS_LOG_APPEND_CONTEXT text of the current record.
+ *
+ * \returns \c true if the record is asynchronous, and the macro
+ *          should not print the function and level prefixes.
+ */
+bool LogRecordMark (void);
+/**
+ * \internal
+ * Get the stream of the current log record: \c std::clog in the
+ * synchronous mode, or the staging buffer of the record.
+ *
+ * \returns The stream.
+ */
+std::ostream & LogRecordStream (void);
+/**
+ * \internal
+ * End the current log record, and write it to \c std::clog, or to the
+ * ring buffer of the thread.
+ *
+ * \param [in] function The name of the logging function.
+ * \param [in] kind The kind of the record.
+ * \param [in] level The level of the message.
+ */
+void LogRecordEnd (const char *function, enum LogRecordKind kind, enum LogLevel level);
+
   
 /**
  * Insert `, ` when streaming function arguments.
@@ -52,6 +52,10 @@ protected:
     {
       (*m_function)();
     }
+    virtual const void * GetTarget (void) const
+    {
+      return GetFunctionAddress (m_function);
+    }
 private:
     F m_function;
   } *ev = new EventFunctionImpl0 (f);
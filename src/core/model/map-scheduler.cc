@@ -109,4 +109,26 @@ MapScheduler::Remove (const Event &ev)
   m_list.erase (i);
 }
 
+uint64_t
+MapScheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t removed = 0;
+  EventMapI i = m_list.begin ();
+  while (i != m_list.end ())
+    {
+      if (i->second->IsCancelled ())
+        {
+          i->second->Unref ();
+          m_list.erase (i++);
+          removed++;
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  return removed;
+}
+
 } // namespace ns3
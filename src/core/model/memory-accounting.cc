@@ -0,0 +1,527 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "memory-accounting.h"
+#include "simulator.h"
+#include "log.h"
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+/**
+ * \file
+ * \ingroup object
+ * ns3::MemoryAccounting and ns3::MemoryAccountingMonitor implementations.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MemoryAccounting");
+
+NS_OBJECT_ENSURE_REGISTERED (MemoryAccountingMonitor);
+
+namespace {
+
+/**
+ * \ingroup object
+ * The counters of a category or node.
+ */
+struct Usage
+{
+  uint64_t count;  //!< The number of live allocations.
+  uint64_t bytes;  //!< The bytes of the live allocations.
+};
+
+/**
+ * \ingroup object
+ * A live allocation.
+ */
+struct Record
+{
+  uint32_t category;  //!< The category.
+  uint32_t context;   //!< The context in which it was allocated.
+  uint64_t bytes;     //!< The size.
+};
+
+/**
+ * \ingroup object
+ * The state of the accounting.
+ */
+struct State
+{
+  std::mutex mutex;                                 //!< Protects the state.
+  std::vector<std::string> names;                   //!< The names of the categories.
+  std::map<std::string, uint32_t> categories;       //!< The categories by name.
+  /** The categories by TypeId uid, plus one, or zero if not yet known. */
+  std::vector<uint32_t> typeIds;
+  std::vector<Usage> usage;                         //!< The counters by category.
+  std::map<uint32_t, Usage> nodes;                  //!< The counters by context.
+  std::unordered_map<const void *, Record> live;    //!< The live allocations.
+  std::atomic<uint32_t (*)(void)> getter;          //!< The context getter.
+};
+
+/**
+ * \ingroup object
+ * Get the state of the accounting.
+ *
+ * The state is never deleted, since Objects can be released during
+ * the destruction of the static variables.
+ *
+ * \returns The state.
+ */
+State *
+GetState (void)
+{
+  static State *state = new State ();
+  return state;
+}
+
+/**
+ * \ingroup object
+ * Get the category of a name.
+ *
+ * \param [in,out] state The state, locked.
+ * \param [in] name The name.
+ * \returns The category.
+ */
+uint32_t
+LookupCategory (State *state, std::string name)
+{
+  std::map<std::string, uint32_t>::const_iterator i = state->categories.find (name);
+  if (i != state->categories.end ())
+    {
+      return i->second;
+    }
+  uint32_t category = state->names.size ();
+  state->names.push_back (name);
+  state->categories[name] = category;
+  Usage zero = { 0, 0 };
+  state->usage.push_back (zero);
+  return category;
+}
+
+/**
+ * \ingroup object
+ * Compare entries by decreasing size.
+ *
+ * \param [in] a The first entry.
+ * \param [in] b The second entry.
+ * \returns \c true if \pname{a} is larger than \pname{b}.
+ */
+bool
+CompareEntries (const MemoryAccounting::Entry &a, const MemoryAccounting::Entry &b)
+{
+  if (a.bytes != b.bytes)
+    {
+      return a.bytes > b.bytes;
+    }
+  return a.name < b.name;
+}
+
+/**
+ * \ingroup object
+ * Make an entry.
+ *
+ * \param [in] name The name of the entry.
+ * \param [in] usage The counters.
+ * \returns The entry.
+ */
+MemoryAccounting::Entry
+MakeEntry (std::string name, const Usage &usage)
+{
+  MemoryAccounting::Entry entry;
+  entry.name = name;
+  entry.count = usage.count;
+  entry.bytes = usage.bytes;
+  return entry;
+}
+
+/**
+ * \ingroup object
+ * Print a table of entries.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] entries The entries.
+ * \param [in] total The total size of the live allocations.
+ * \param [in] heading The heading of the name column.
+ */
+void
+PrintEntries (std::ostream &os, const std::vector<MemoryAccounting::Entry> &entries,
+              uint64_t total, std::string heading)
+{
+  os << std::setw (14) << "bytes"
+     << std::setw (8) << "share"
+     << std::setw (12) << "count"
+     << "  " << heading << std::endl;
+  for (std::vector<MemoryAccounting::Entry>::const_iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      os << std::fixed
+         << std::setw (14) << i->bytes
+         << std::setw (7) << std::setprecision (1) << (total > 0 ? 100.0 * i->bytes / total : 0) << "%"
+         << std::setw (12) << i->count
+         << "  " << i->name << std::endl;
+    }
+  os.unsetf (std::ios::floatfield);
+}
+
+} // unnamed namespace
+
+std::atomic<bool> MemoryAccounting::g_enabled (false);
+
+void
+MemoryAccounting::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_enabled.store (true, std::memory_order_relaxed);
+}
+
+void
+MemoryAccounting::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  g_enabled.store (false, std::memory_order_relaxed);
+  state->live.clear ();
+  state->nodes.clear ();
+  for (std::vector<Usage>::iterator i = state->usage.begin (); i != state->usage.end (); ++i)
+    {
+      i->count = 0;
+      i->bytes = 0;
+    }
+}
+
+uint32_t
+MemoryAccounting::GetCategory (TypeId tid)
+{
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  uint16_t uid = tid.GetUid ();
+  if (uid >= state->typeIds.size ())
+    {
+      state->typeIds.resize (uid + 1, 0);
+    }
+  if (state->typeIds[uid] == 0)
+    {
+      state->typeIds[uid] = LookupCategory (state, tid.GetName ()) + 1;
+    }
+  return state->typeIds[uid] - 1;
+}
+
+uint32_t
+MemoryAccounting::GetCategory (std::string name)
+{
+  NS_LOG_FUNCTION (name);
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  return LookupCategory (state, name);
+}
+
+void
+MemoryAccounting::DoNotifyAllocate (const void *p, uint32_t category, uint64_t bytes)
+{
+  State *state = GetState ();
+  // the getter must not be called with the lock held, since it could
+  // allocate.
+  uint32_t (*getter)(void) = state->getter.load (std::memory_order_acquire);
+  uint32_t context = getter != 0 ? getter () : Simulator::NO_CONTEXT;
+  std::lock_guard<std::mutex> lock (state->mutex);
+  if (!IsEnabled ())
+    {
+      return;
+    }
+  Record record = { category, context, bytes };
+  std::pair<std::unordered_map<const void *, Record>::iterator, bool> inserted =
+    state->live.insert (std::make_pair (p, record));
+  if (!inserted.second)
+    {
+      // the release of the previous allocation at this address was
+      // not seen.
+      Record &previous = inserted.first->second;
+      state->usage[previous.category].count--;
+      state->usage[previous.category].bytes -= previous.bytes;
+      Usage &node = state->nodes[previous.context];
+      node.count--;
+      node.bytes -= previous.bytes;
+      previous = record;
+    }
+  state->usage[category].count++;
+  state->usage[category].bytes += bytes;
+  Usage &node = state->nodes[context];
+  node.count++;
+  node.bytes += bytes;
+}
+
+void
+MemoryAccounting::NotifyCategory (const void *p, uint32_t category)
+{
+  if (!IsEnabled ())
+    {
+      return;
+    }
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  std::unordered_map<const void *, Record>::iterator i = state->live.find (p);
+  if (i == state->live.end () || i->second.category == category)
+    {
+      return;
+    }
+  state->usage[i->second.category].count--;
+  state->usage[i->second.category].bytes -= i->second.bytes;
+  i->second.category = category;
+  state->usage[category].count++;
+  state->usage[category].bytes += i->second.bytes;
+}
+
+void
+MemoryAccounting::NotifyContext (const void *p, uint32_t context)
+{
+  if (!IsEnabled ())
+    {
+      return;
+    }
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  std::unordered_map<const void *, Record>::iterator i = state->live.find (p);
+  if (i == state->live.end () || i->second.context == context)
+    {
+      return;
+    }
+  Usage &previous = state->nodes[i->second.context];
+  previous.count--;
+  previous.bytes -= i->second.bytes;
+  i->second.context = context;
+  Usage &node = state->nodes[context];
+  node.count++;
+  node.bytes += i->second.bytes;
+}
+
+void
+MemoryAccounting::DoNotifyRelease (const void *p)
+{
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  std::unordered_map<const void *, Record>::iterator i = state->live.find (p);
+  if (i == state->live.end ())
+    {
+      // allocated before the accounting was enabled.
+      return;
+    }
+  const Record &record = i->second;
+  state->usage[record.category].count--;
+  state->usage[record.category].bytes -= record.bytes;
+  Usage &node = state->nodes[record.context];
+  node.count--;
+  node.bytes -= record.bytes;
+  state->live.erase (i);
+}
+
+void
+MemoryAccounting::SetContextGetter (uint32_t (*getter)(void))
+{
+  GetState ()->getter.store (getter, std::memory_order_release);
+}
+
+MemoryAccounting::Entry
+MemoryAccounting::GetUsage (TypeId tid)
+{
+  NS_LOG_FUNCTION (tid.GetName ());
+  return GetUsage (tid.GetName ());
+}
+
+MemoryAccounting::Entry
+MemoryAccounting::GetUsage (std::string name)
+{
+  NS_LOG_FUNCTION (name);
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  Usage usage = { 0, 0 };
+  std::map<std::string, uint32_t>::const_iterator i = state->categories.find (name);
+  if (i != state->categories.end ())
+    {
+      usage = state->usage[i->second];
+    }
+  return MakeEntry (name, usage);
+}
+
+MemoryAccounting::Entry
+MemoryAccounting::GetNodeUsage (uint32_t context)
+{
+  NS_LOG_FUNCTION (context);
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  Usage usage = { 0, 0 };
+  std::map<uint32_t, Usage>::const_iterator i = state->nodes.find (context);
+  if (i != state->nodes.end ())
+    {
+      usage = i->second;
+    }
+  std::ostringstream oss;
+  oss << context;
+  return MakeEntry (oss.str (), usage);
+}
+
+MemoryAccounting::Entry
+MemoryAccounting::GetTotal (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  State *state = GetState ();
+  std::lock_guard<std::mutex> lock (state->mutex);
+  Usage total = { 0, 0 };
+  for (std::vector<Usage>::const_iterator i = state->usage.begin (); i != state->usage.end (); ++i)
+    {
+      total.count += i->count;
+      total.bytes += i->bytes;
+    }
+  return MakeEntry ("total", total);
+}
+
+std::vector<MemoryAccounting::Entry>
+MemoryAccounting::GetCategories (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  State *state = GetState ();
+  std::vector<Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock (state->mutex);
+    for (uint32_t i = 0; i < state->usage.size (); i++)
+      {
+        if (state->usage[i].count != 0)
+          {
+            entries.push_back (MakeEntry (state->names[i], state->usage[i]));
+          }
+      }
+  }
+  std::sort (entries.begin (), entries.end (), CompareEntries);
+  return entries;
+}
+
+std::vector<MemoryAccounting::Entry>
+MemoryAccounting::GetNodes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  State *state = GetState ();
+  std::vector<Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock (state->mutex);
+    for (std::map<uint32_t, Usage>::const_iterator i = state->nodes.begin (); i != state->nodes.end (); ++i)
+      {
+        if (i->second.count == 0)
+          {
+            continue;
+          }
+        if (i->first == Simulator::NO_CONTEXT)
+          {
+            entries.push_back (MakeEntry ("-", i->second));
+          }
+        else
+          {
+            std::ostringstream oss;
+            oss << i->first;
+            entries.push_back (MakeEntry (oss.str (), i->second));
+          }
+      }
+  }
+  std::sort (entries.begin (), entries.end (), CompareEntries);
+  return entries;
+}
+
+void
+MemoryAccounting::Print (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  std::vector<Entry> categories = GetCategories ();
+  std::vector<Entry> nodes = GetNodes ();
+  Entry total = GetTotal ();
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << "Memory: " << total.count << " allocations, " << total.bytes << " bytes" << std::endl;
+  os << std::endl << "By type:" << std::endl;
+  PrintEntries (os, categories, total.bytes, "type");
+  os << std::endl << "By node (\"-\": not attached to a node):" << std::endl;
+  PrintEntries (os, nodes, total.bytes, "node");
+  os.flags (flags);
+  os.precision (precision);
+}
+
+
+TypeId
+MemoryAccountingMonitor::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MemoryAccountingMonitor")
+    .SetParent<Object> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MemoryAccountingMonitor> ()
+    .AddAttribute ("Interval",
+                   "The simulation time between two reports.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&MemoryAccountingMonitor::m_interval),
+                   MakeTimeChecker (Time (1)))
+    .AddTraceSource ("Report",
+                     "The live allocations by type and by node, "
+                     "reported every Interval.",
+                     MakeTraceSourceAccessor (&MemoryAccountingMonitor::m_reportTrace),
+                     "ns3::MemoryAccountingMonitor::ReportCallback")
+  ;
+  return tid;
+}
+
+MemoryAccountingMonitor::MemoryAccountingMonitor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MemoryAccountingMonitor::~MemoryAccountingMonitor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MemoryAccountingMonitor::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  MemoryAccounting::Enable ();
+  Simulator::Cancel (m_event);
+  m_event = Simulator::Schedule (m_interval, &MemoryAccountingMonitor::Report, this);
+}
+
+void
+MemoryAccountingMonitor::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_event);
+}
+
+void
+MemoryAccountingMonitor::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_event);
+  Object::DoDispose ();
+}
+
+void
+MemoryAccountingMonitor::Report (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_reportTrace (MemoryAccounting::GetCategories (), MemoryAccounting::GetNodes ());
+  m_event = Simulator::Schedule (m_interval, &MemoryAccountingMonitor::Report, this);
+}
+
+} // namespace ns3
@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEMORY_ACCOUNTING_H
+#define MEMORY_ACCOUNTING_H
+
+#include "object.h"
+#include "nstime.h"
+#include "event-id.h"
+#include "traced-callback.h"
+#include "type-id.h"
+#include <stdint.h>
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup object
+ * ns3::MemoryAccounting and ns3::MemoryAccountingMonitor declarations.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup object
+ * \brief The memory held by the live Objects, by TypeId and by node.
+ *
+ * When it is enabled, every Object constructed is accounted for, with
+ * the size of its allocation, under its TypeId and under the context
+ * in which it was constructed, which is the node id for the Objects
+ * created by the events of the nodes.  The network module moves a
+ * node, the Objects aggregated to it, its devices and its
+ * applications under its node id when they are attached to it, so
+ * that the Objects created at setup are accounted for under their
+ * node too.  The other Objects created outside of the events of the
+ * nodes, such as the channels and the queues of the devices, stay
+ * without context.  The Objects are accounted for until they are
+ * deleted.  Other large allocations are accounted for
+ * under a category of their own: the network module accounts for the
+ * packets under \c ns3::Packet, for their buffers under \c ns3::Buffer
+ * and for their metadata under \c ns3::PacketMetadata.
+ *
+ * The sizes are those of the allocations themselves, and do not
+ * include the memory which the Objects allocate separately, such as
+ * the content of their containers.
+ *
+ * The accounting is disabled by default; when it is enabled, each
+ * allocation costs a lookup in a hash table, under a lock.  The
+ * allocations which happened before it was enabled are not accounted
+ * for.
+ *
+ * The memory can be queried at any time, or reported periodically by
+ * a MemoryAccountingMonitor.
+ */
+class MemoryAccounting
+{
+public:
+  /** The live allocations of a TypeId, category or node. */
+  struct Entry
+  {
+    std::string name;    //!< The TypeId or category name, or the node id.
+    uint64_t count;      //!< The number of live allocations.
+    uint64_t bytes;      //!< The bytes of the live allocations.
+  };
+
+  /**
+   * Start accounting for the allocations.
+   */
+  static void Enable (void);
+  /**
+   * Stop accounting for the allocations, and forget those accounted
+   * for so far.
+   */
+  static void Disable (void);
+  /**
+   * \returns \c true if the allocations are accounted for.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Get the category of the allocations of a TypeId.
+   *
+   * \param [in] tid The TypeId.
+   * \returns The category.
+   */
+  static uint32_t GetCategory (TypeId tid);
+  /**
+   * Get the category of other allocations, registering it if needed.
+   *
+   * \param [in] name The name of the category.
+   * \returns The category.
+   */
+  static uint32_t GetCategory (std::string name);
+
+  /**
+   * Account for an allocation, if the accounting is enabled.
+   *
+   * \param [in] p The allocation.
+   * \param [in] category The category of the allocation.
+   * \param [in] bytes The size of the allocation.
+   */
+  static void NotifyAllocate (const void *p, uint32_t category, uint64_t bytes);
+  /**
+   * Move an allocation to another category, as when the TypeId of an
+   * Object is set after its construction.
+   *
+   * \param [in] p The allocation.
+   * \param [in] category The new category of the allocation.
+   */
+  static void NotifyCategory (const void *p, uint32_t category);
+  /**
+   * Move an allocation to another context, as when an Object created
+   * at setup is attached to a node.
+   *
+   * \param [in] p The allocation.
+   * \param [in] context The new context of the allocation.
+   */
+  static void NotifyContext (const void *p, uint32_t context);
+  /**
+   * Stop accounting for an allocation which is released.
+   *
+   * \param [in] p The allocation.
+   */
+  static void NotifyRelease (const void *p);
+
+  /**
+   * Set the function which returns the context of the allocations.
+   *
+   * The Simulator sets it when the simulator is created, so that the
+   * allocations done before do not create it.
+   *
+   * \param [in] getter The function, or null for no context.
+   */
+  static void SetContextGetter (uint32_t (*getter)(void));
+
+  /**
+   * \param [in] tid The TypeId.
+   * \returns The live Objects of the TypeId.
+   */
+  static Entry GetUsage (TypeId tid);
+  /**
+   * \param [in] name The TypeId or category name.
+   * \returns The live allocations of the category.
+   */
+  static Entry GetUsage (std::string name);
+  /**
+   * \param [in] context The context, usually a node id.
+   * \returns The live allocations made in the context.
+   */
+  static Entry GetNodeUsage (uint32_t context);
+  /**
+   * \returns All the live allocations.
+   */
+  static Entry GetTotal (void);
+  /**
+   * \returns The live allocations by TypeId or category, by decreasing
+   *          size.
+   */
+  static std::vector<Entry> GetCategories (void);
+  /**
+   * \returns The live allocations by node, by decreasing size.  The
+   *          allocations without context, such as the channels and
+   *          the other Objects created at setup but not attached to
+   *          a node, are named "-".
+   */
+  static std::vector<Entry> GetNodes (void);
+  /**
+   * Print the live allocations by TypeId or category and by node.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void Print (std::ostream &os);
+
+private:
+  /**
+   * Account for an allocation.
+   *
+   * \param [in] p The allocation.
+   * \param [in] category The category of the allocation.
+   * \param [in] bytes The size of the allocation.
+   */
+  static void DoNotifyAllocate (const void *p, uint32_t category, uint64_t bytes);
+  /**
+   * Stop accounting for an allocation.
+   *
+   * \param [in] p The allocation.
+   */
+  static void DoNotifyRelease (const void *p);
+
+  /** Whether the allocations are accounted for. */
+  static std::atomic<bool> g_enabled;
+};
+
+/**
+ * \ingroup object
+ * \brief Report the memory accounted for by MemoryAccounting
+ * periodically.
+ *
+ * Start() enables the accounting, and fires the \c Report trace
+ * source every \c Interval of simulation time until Stop() is called
+ * or the monitor is disposed.  Since the reports are events, the
+ * simulation should then end with Simulator::Stop.
+ */
+class MemoryAccountingMonitor : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MemoryAccountingMonitor ();
+  /** Destructor. */
+  virtual ~MemoryAccountingMonitor ();
+
+  /**
+   * Enable the accounting and start the reports.
+   */
+  void Start (void);
+  /**
+   * Stop the reports.  The accounting stays enabled.
+   */
+  void Stop (void);
+
+  /**
+   * TracedCallback signature for the periodic reports.
+   *
+   * \param [in] types The live allocations by TypeId or category,
+   *            see MemoryAccounting::GetCategories().
+   * \param [in] nodes The live allocations by node,
+   *            see MemoryAccounting::GetNodes().
+   */
+  typedef void (* ReportCallback)(const std::vector<MemoryAccounting::Entry> &types,
+                                  const std::vector<MemoryAccounting::Entry> &nodes);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /** Fire the trace source, and schedule the next report. */
+  void Report (void);
+
+  Time m_interval;      //!< The interval between the reports.
+  EventId m_event;      //!< The next report.
+  /** The trace source of the reports. */
+  TracedCallback<const std::vector<MemoryAccounting::Entry> &,
+                 const std::vector<MemoryAccounting::Entry> &> m_reportTrace;
+};
+
+} // namespace ns3
+
+/********************************************************************
+ *  Implementation of the inline methods.
+ ********************************************************************/
+
+namespace ns3 {
+
+inline bool
+MemoryAccounting::IsEnabled (void)
+{
+  return g_enabled.load (std::memory_order_relaxed);
+}
+
+inline void
+MemoryAccounting::NotifyAllocate (const void *p, uint32_t category, uint64_t bytes)
+{
+  if (IsEnabled ())
+    {
+      DoNotifyAllocate (p, category, bytes);
+    }
+}
+
+inline void
+MemoryAccounting::NotifyRelease (const void *p)
+{
+  if (IsEnabled ())
+    {
+      DoNotifyRelease (p);
+    }
+}
+
+} // namespace ns3
+
+#endif /* MEMORY_ACCOUNTING_H */
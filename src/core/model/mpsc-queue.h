@@ -0,0 +1,231 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "event-pool.h"
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MpscQueue declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \brief A lock-free multiple-producer, single-consumer queue.
+ *
+ * This is the non-intrusive queue of Dmitry Vyukov, with a stub node:
+ * producers exchange the head pointer and then link the previous head
+ * to their node, so that Push never waits for another thread.  The
+ * consumer follows the links from the tail.  Between the exchange and the link,
+ * a node is not yet visible to the consumer, so that Pop may report
+ * an empty queue while a Push is in progress; callers must tolerate
+ * this and have the producer signal the consumer after Push returns.
+ *
+ * The nodes come from the EventPool: the consumer thread hands the
+ * nodes it releases back to the producer threads in batches, so that
+ * Push does not reach the global \c operator \c new once the queue
+ * has warmed up.
+ *
+ * Push can be called from any thread; Pop, IsEmpty and the
+ * destructor only from the consumer thread.
+ *
+ * \tparam T \explicit The type of the queued values.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+  /** Constructor. */
+  MpscQueue ();
+  /** Destructor; the values left in the queue are dropped. */
+  ~MpscQueue ();
+
+  /**
+   * Append a value.
+   *
+   * \param [in] value The value.
+   */
+  void Push (const T &value);
+  /**
+   * Remove the oldest value.
+   *
+   * \param [out] value The value.
+   * \returns \c true if a value was removed.
+   */
+  bool Pop (T &value);
+  /**
+   * \returns \c true if there is no value to Pop.
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \returns The number of values pushed so far.
+   */
+  uint64_t GetPushCount (void) const;
+  /**
+   * \returns The number of values pushed but not yet popped.
+   */
+  uint64_t GetSize (void) const;
+
+private:
+  /** A queue node. */
+  struct Node
+  {
+    std::atomic<Node *> next; //!< The next, more recent, node.
+    T value;                  //!< The value.
+  };
+
+  /**
+   * Get a node from the EventPool.
+   * \returns The node, not linked.
+   */
+  static Node * AllocateNode (void);
+  /**
+   * Give a node back to the EventPool.
+   * \param [in] node The node.
+   */
+  static void ReleaseNode (Node *node);
+
+  /** Copy constructor: not implemented. */
+  MpscQueue (const MpscQueue &);
+  /**
+   * Copy assignment: not implemented.
+   * \returns The queue.
+   */
+  MpscQueue & operator = (const MpscQueue &);
+
+  /** The most recent node, updated by the producers. */
+  std::atomic<Node *> m_head;
+  /** The number of values pushed. */
+  std::atomic<uint64_t> m_pushes;
+  /** Keep the consumer state on its own cache line. */
+  char m_padding[64];
+  /** The last popped node, whose value is stale; owned by the consumer. */
+  Node *m_tail;
+  /** The number of values popped. */
+  std::atomic<uint64_t> m_pops;
+};
+
+} // namespace ns3
+
+
+/********************************************************************
+ *  Implementation of the templates declared above.
+ ********************************************************************/
+
+namespace ns3 {
+
+template <typename T>
+MpscQueue<T>::MpscQueue ()
+  : m_pushes (0),
+    m_pops (0)
+{
+  Node *stub = AllocateNode ();
+  m_head.store (stub, std::memory_order_relaxed);
+  m_tail = stub;
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue ()
+{
+  Node *node = m_tail;
+  while (node != 0)
+    {
+      Node *next = node->next.load (std::memory_order_acquire);
+      ReleaseNode (node);
+      node = next;
+    }
+}
+
+template <typename T>
+void
+MpscQueue<T>::Push (const T &value)
+{
+  Node *node = AllocateNode ();
+  node->value = value;
+  Node *prev = m_head.exchange (node, std::memory_order_acq_rel);
+  prev->next.store (node, std::memory_order_release);
+  m_pushes.fetch_add (1, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool
+MpscQueue<T>::Pop (T &value)
+{
+  Node *tail = m_tail;
+  Node *next = tail->next.load (std::memory_order_acquire);
+  if (next == 0)
+    {
+      return false;
+    }
+  value = next->value;
+  m_tail = next;
+  ReleaseNode (tail);
+  m_pops.fetch_add (1, std::memory_order_relaxed);
+  return true;
+}
+
+template <typename T>
+typename MpscQueue<T>::Node *
+MpscQueue<T>::AllocateNode (void)
+{
+  Node *node = new (EventPool::Allocate (sizeof (Node))) Node;
+  node->next.store (0, std::memory_order_relaxed);
+  return node;
+}
+
+template <typename T>
+void
+MpscQueue<T>::ReleaseNode (Node *node)
+{
+  node->~Node ();
+  EventPool::Deallocate (node, sizeof (Node));
+}
+
+template <typename T>
+bool
+MpscQueue<T>::IsEmpty (void) const
+{
+  return m_tail->next.load (std::memory_order_acquire) == 0;
+}
+
+template <typename T>
+uint64_t
+MpscQueue<T>::GetPushCount (void) const
+{
+  return m_pushes.load (std::memory_order_relaxed);
+}
+
+template <typename T>
+uint64_t
+MpscQueue<T>::GetSize (void) const
+{
+  uint64_t pops = m_pops.load (std::memory_order_relaxed);
+  uint64_t pushes = m_pushes.load (std::memory_order_relaxed);
+  return pushes > pops ? pushes - pops : 0;
+}
+
+} // namespace ns3
+
+#endif /* MPSC_QUEUE_H */
@@ -0,0 +1,918 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+#include "simulator.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "config.h"
+#include "uinteger.h"
+
+#include "ptr.h"
+#include "assert.h"
+#include "fatal-error.h"
+#include "log.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+thread_local MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::m_currentPartition = 0;
+
+const MultithreadedSimulatorImpl *
+MultithreadedSimulatorImpl::m_parallelRun = 0;
+
+namespace {
+
+/**
+ * Get the lookahead finder of the models.
+ * \return The finder, which is null until a module sets it.
+ */
+MultithreadedSimulatorImpl::LookaheadFinder &
+GetLookaheadFinder (void)
+{
+  static MultithreadedSimulatorImpl::LookaheadFinder finder;
+  return finder;
+}
+
+} // anonymous namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Core")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("ThreadCount",
+                   "The number of partitions executed in parallel. "
+                   "Zero means one per online processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_threadCount),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Lookahead",
+                   "The minimum delay of the events the models exchange "
+                   "between partitions other than through their channels.  "
+                   "Zero means that they exchange none.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookaheadAttribute),
+                   MakeTimeChecker (Seconds (0)))
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  m_partitionCount = 0;
+  m_threadCount = 0;
+  m_uid = 4;
+  m_lookahead = 0;
+  m_windowEnd = 0;
+  m_parallel = false;
+  m_exit = false;
+  m_eventsWithContextEmpty = true;
+  m_stop = false;
+  m_main = SystemThread::Self ();
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
+
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      while (!i->events->IsEmpty ())
+        {
+          Scheduler::Event next = i->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      i->events = 0;
+      i->renumbered.clear ();
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_partitionCount = m_threadCount;
+  if (m_partitionCount == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      m_partitionCount = cpus > 0 ? cpus : 1;
+    }
+  // the last partition holds the context-less events.
+  m_partitions.resize (m_partitionCount + 1);
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      i->events = schedulerFactory.Create<Scheduler> ();
+      i->currentTs = 0;
+      i->currentContext = Simulator::NO_CONTEXT;
+      i->currentEvent = 0;
+      i->renumberedCleanup = 64;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+
+  if (m_partitions.empty ())
+    {
+      CreatePartitions (schedulerFactory);
+      return;
+    }
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!i->events->IsEmpty ())
+        {
+          Scheduler::Event next = i->events->RemoveNext ();
+          scheduler->Insert (next);
+        }
+      i->events = scheduler;
+    }
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitionCount;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead);
+}
+
+void
+MultithreadedSimulatorImpl::SetLookaheadFinder (LookaheadFinder finder)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetLookaheadFinder () = finder;
+}
+
+bool
+MultithreadedSimulatorImpl::IsOtherPartition (uint32_t context)
+{
+  const MultithreadedSimulatorImpl *simulator = m_parallelRun;
+  if (simulator == 0)
+    {
+      return false;
+    }
+  return &simulator->m_partitions[simulator->GetPartitionIndex (context)] !=
+         simulator->GetCurrentPartition ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionIndex (uint32_t context) const
+{
+  if (context == Simulator::NO_CONTEXT)
+    {
+      return m_partitions.size () - 1;
+    }
+  return context % m_partitionCount;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrentPartition (void) const
+{
+  if (m_currentPartition != 0)
+    {
+      return m_currentPartition;
+    }
+  // Outside of the partition events, the main thread executes the
+  // context-less events.
+  return const_cast<Partition *> (&m_partitions.back ());
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition &partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  // uids are allocated from 4, as with DefaultSimulatorImpl.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = m_uid;
+  m_uid++;
+  NS_ASSERT_MSG (m_uid < PROVISIONAL, "Too many events");
+  partition.events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Enqueue (Partition &current, uint32_t index, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  if (!m_parallel)
+    {
+      return Insert (m_partitions[index], ts, context, event);
+    }
+  // The events scheduled during the window are numbered in the order
+  // of this partition, after all the events scheduled before.
+  NS_ASSERT (!current.records.empty ());
+  uint32_t creation = current.creations.size ();
+  current.creations.push_back (current.records.size () - 1);
+  uint32_t uid = PROVISIONAL | creation;
+  if (&m_partitions[index] == &current && ts < m_windowEnd)
+    {
+      Scheduler::Event ev;
+      ev.impl = event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = context;
+      ev.key.m_uid = uid;
+      current.events->Insert (ev);
+      return uid;
+    }
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " at " << ts <<
+                      " violates the lookahead of partition " << index <<
+                      " (window ends at " << m_windowEnd << ")");
+    }
+  Handover handover;
+  handover.partition = index;
+  handover.context = context;
+  handover.timestamp = ts;
+  handover.event = event;
+  handover.creation = creation;
+  current.outbox.push_back (handover);
+  return uid;
+}
+
+bool
+MultithreadedSimulatorImpl::IsScheduledBefore (uint32_t a, uint32_t i, uint32_t b, uint32_t j) const
+{
+  // Within a partition, the events are scheduled in their order.
+  // Otherwise, the events which scheduled them are compared, as
+  // DefaultSimulatorImpl would have executed them.
+  while (a != b)
+    {
+      const Partition &first = m_partitions[a];
+      const Partition &second = m_partitions[b];
+      const Record &x = first.records[first.creations[i]];
+      const Record &y = second.records[second.creations[j]];
+      if (x.ts != y.ts)
+        {
+          return x.ts < y.ts;
+        }
+      bool xProvisional = (x.uid & PROVISIONAL) != 0;
+      bool yProvisional = (y.uid & PROVISIONAL) != 0;
+      if (!xProvisional || !yProvisional)
+        {
+          // the events scheduled before the window come first.
+          return xProvisional ? false : (yProvisional || x.uid < y.uid);
+        }
+      i = x.uid & ~PROVISIONAL;
+      j = y.uid & ~PROVISIONAL;
+    }
+  return i < j;
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookahead (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_lookahead = 0;
+  if (m_partitionCount == 1)
+    {
+      return;
+    }
+  Time lookahead = Time::Max ();
+  if (!m_lookaheadAttribute.IsZero ())
+    {
+      lookahead = m_lookaheadAttribute;
+    }
+  LookaheadFinder finder = GetLookaheadFinder ();
+  if (!finder.IsNull ())
+    {
+      lookahead = Min (lookahead, finder (this));
+    }
+  if (lookahead == Time::Max ())
+    {
+      NS_LOG_LOGIC ("no event crosses the partitions: running them in turn");
+      return;
+    }
+  if (lookahead.IsZero ())
+    {
+      NS_LOG_WARN ("some channel between partitions has no delay: running them in turn");
+      return;
+    }
+  m_lookahead = lookahead.GetTimeStep ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (Partition &partition)
+{
+  Scheduler::Event next = partition.events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= partition.currentTs);
+  NS_LOG_LOGIC ("handle " << next.key.m_ts);
+  partition.currentTs = next.key.m_ts;
+  partition.currentContext = next.key.m_context;
+  partition.currentEvent = next.impl;
+  if (m_parallel)
+    {
+      Record record;
+      record.ts = next.key.m_ts;
+      record.uid = next.key.m_uid;
+      partition.records.push_back (record);
+    }
+  next.impl->Invoke ();
+  // The uids of the events are provisional during the windows: an
+  // executed event is expired through its cancel flag.
+  next.impl->Cancel ();
+  partition.currentEvent = 0;
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::UpdateGlobalTime (const Partition &partition)
+{
+  Partition &global = m_partitions.back ();
+  if (partition.currentTs > global.currentTs)
+    {
+      global.currentTs = partition.currentTs;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessPartition (uint32_t index)
+{
+  Partition &partition = m_partitions[index];
+  while (!partition.events->IsEmpty ())
+    {
+      Scheduler::Event next = partition.events->PeekNext ();
+      if (next.key.m_ts >= m_windowEnd)
+        {
+          break;
+        }
+      ProcessOneEvent (partition);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::ScheduledBefore::operator () (const std::pair<uint32_t, uint32_t> &a,
+                                                         const std::pair<uint32_t, uint32_t> &b) const
+{
+  const std::vector<Partition> &partitions = simulator->m_partitions;
+  return simulator->IsScheduledBefore (a.first, partitions[a.first].outbox[a.second].creation,
+                                       b.first, partitions[b.first].outbox[b.second].creation);
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOutboxes (void)
+{
+  // The buffered events get their uids in the order in which
+  // DefaultSimulatorImpl would have scheduled them, which makes the
+  // execution independent of the thread timing.
+  std::vector<std::pair<uint32_t, uint32_t> > handovers;
+  for (uint32_t i = 0; i < m_partitionCount; ++i)
+    {
+      for (uint32_t j = 0; j < m_partitions[i].outbox.size (); ++j)
+        {
+          handovers.push_back (std::make_pair (i, j));
+        }
+    }
+  ScheduledBefore order;
+  order.simulator = this;
+  std::sort (handovers.begin (), handovers.end (), order);
+
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = handovers.begin (); i != handovers.end (); ++i)
+    {
+      Partition &source = m_partitions[i->first];
+      const Handover &handover = source.outbox[i->second];
+      if (!source.removed.empty () && source.removed.erase (handover.event) > 0)
+        {
+          handover.event->Unref ();
+          continue;
+        }
+      Partition &partition = m_partitions[handover.partition];
+      uint32_t uid = Insert (partition, handover.timestamp, handover.context, handover.event);
+      if (handover.event->GetReferenceCount () > 1)
+        {
+          // Some EventId holds the provisional uid of the event.
+          Renumbered renumbered;
+          renumbered.ts = handover.timestamp;
+          renumbered.provisional = PROVISIONAL | handover.creation;
+          renumbered.uid = uid;
+          renumbered.event = handover.event;
+          partition.renumbered[handover.event] = renumbered;
+        }
+    }
+
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      i->records.clear ();
+      i->creations.clear ();
+      i->outbox.clear ();
+      if (i->renumbered.size () >= i->renumberedCleanup)
+        {
+          CleanupRenumbered (*i);
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CleanupRenumbered (Partition &partition)
+{
+  for (RenumberedEvents::iterator i = partition.renumbered.begin (); i != partition.renumbered.end (); )
+    {
+      // Only this entry and the queue hold the event, or it is expired.
+      EventImpl *event = PeekPointer (i->second.event);
+      if (event->GetReferenceCount () <= 2 || event->IsCancelled ())
+        {
+          partition.renumbered.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  partition.renumberedCleanup = std::max<std::size_t> (64, 2 * partition.renumbered.size ());
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  // swap queues
+  std::list<struct EventWithContext> eventsWithContext;
+  {
+    CriticalSection cs (m_eventsWithContextMutex);
+    m_eventsWithContext.swap (eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  uint64_t now = m_partitions.back ().currentTs;
+  while (!eventsWithContext.empty ())
+    {
+      EventWithContext event = eventsWithContext.front ();
+      eventsWithContext.pop_front ();
+      Partition &partition = m_partitions[GetPartitionIndex (event.context)];
+      Insert (partition, now + event.timestamp, event.context, event.event);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::WorkerThread (MultithreadedSimulatorImpl *self, uint32_t index)
+{
+  m_currentPartition = &self->m_partitions[index];
+  while (true)
+    {
+      pthread_barrier_wait (&self->m_windowStartBarrier);
+      if (self->m_exit)
+        {
+          break;
+        }
+      self->ProcessPartition (index);
+      pthread_barrier_wait (&self->m_windowEndBarrier);
+    }
+  m_currentPartition = 0;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!i->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Set the current threadId as the main threadId
+  m_main = SystemThread::Self ();
+  ProcessEventsWithContext ();
+  CalculateLookahead ();
+  m_stop = false;
+
+  if (m_lookahead == 0 || m_partitionCount == 1)
+    {
+      RunSequential ();
+    }
+  else
+    {
+      RunParallel ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::RunSequential (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_stop && ProcessEarliestEvent ())
+    {
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::ProcessEarliestEvent (void)
+{
+  ProcessEventsWithContext ();
+
+  // The uids of the pending events are those DefaultSimulatorImpl
+  // would have given them, so this is its order.
+  Partition *next = 0;
+  Scheduler::EventKey nextKey;
+  for (std::vector<Partition>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!i->events->IsEmpty ())
+        {
+          Scheduler::EventKey key = i->events->PeekNext ().key;
+          if (next == 0 || key < nextKey)
+            {
+              next = &*i;
+              nextKey = key;
+            }
+        }
+    }
+  if (next == 0)
+    {
+      return false;
+    }
+  m_currentPartition = next;
+  ProcessOneEvent (*next);
+  m_currentPartition = 0;
+  UpdateGlobalTime (*next);
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::RunParallel (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_exit = false;
+  pthread_barrier_init (&m_windowStartBarrier, NULL, m_partitionCount);
+  pthread_barrier_init (&m_windowEndBarrier, NULL, m_partitionCount);
+  // The main thread runs the first partition.
+  for (uint32_t i = 1; i < m_partitionCount; ++i)
+    {
+      Ptr<SystemThread> thread =
+        Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::WorkerThread, this, i));
+      thread->Start ();
+      m_threads.push_back (thread);
+    }
+
+  // The models hand their objects over to the other partitions from now on.
+  m_parallelRun = this;
+  Partition &global = m_partitions.back ();
+  const uint64_t infinity = GetMaximumSimulationTime ().GetTimeStep ();
+  while (!m_stop)
+    {
+      ProcessEventsWithContext ();
+
+      uint64_t next = infinity;
+      for (uint32_t i = 0; i < m_partitionCount; ++i)
+        {
+          if (!m_partitions[i].events->IsEmpty ())
+            {
+              next = std::min (next, m_partitions[i].events->PeekNext ().key.m_ts);
+            }
+        }
+      uint64_t nextGlobal = global.events->IsEmpty () ?
+        infinity : global.events->PeekNext ().key.m_ts;
+      if (next == infinity && nextGlobal == infinity)
+        {
+          break;
+        }
+      if (nextGlobal <= next)
+        {
+          // The context-less events, and the events of the partitions
+          // at the same time, are executed one by one.
+          ProcessEarliestEvent ();
+          continue;
+        }
+
+      m_windowEnd = std::min (nextGlobal, next + m_lookahead);
+      m_parallel = true;
+      m_currentPartition = &m_partitions.front ();
+      pthread_barrier_wait (&m_windowStartBarrier);
+      ProcessPartition (0);
+      pthread_barrier_wait (&m_windowEndBarrier);
+      m_currentPartition = 0;
+      m_parallel = false;
+
+      ProcessOutboxes ();
+      for (uint32_t i = 0; i < m_partitionCount; ++i)
+        {
+          UpdateGlobalTime (m_partitions[i]);
+        }
+    }
+
+  m_exit = true;
+  pthread_barrier_wait (&m_windowStartBarrier);
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+  m_parallelRun = 0;
+  pthread_barrier_destroy (&m_windowStartBarrier);
+  pthread_barrier_destroy (&m_windowEndBarrier);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_parallel)
+    {
+      NS_FATAL_ERROR ("Simulator::Stop can not be invoked while the partitions run in parallel: "
+                      "use Simulator::Stop (delay) instead");
+    }
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  // A context-less event stops all the partitions at the same time.
+  Simulator::ScheduleWithContext (Simulator::NO_CONTEXT, delay, &Simulator::Stop);
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (m_currentPartition != 0 || SystemThread::Equals (m_main),
+                 "Simulator::Schedule Thread-unsafe invocation!");
+
+  Partition *partition = GetCurrentPartition ();
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->currentTs));
+  uint64_t ts = (uint64_t) tAbsolute.GetTimeStep ();
+  uint32_t context = partition->currentContext;
+  uint32_t uid = Enqueue (*partition, partition - &m_partitions.front (), ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  if (m_currentPartition == 0 && !SystemThread::Equals (m_main))
+    {
+      EventWithContext ev;
+      ev.context = context;
+      // Current time added in ProcessEventsWithContext()
+      ev.timestamp = delay.GetTimeStep ();
+      ev.event = event;
+      {
+        CriticalSection cs (m_eventsWithContextMutex);
+        m_eventsWithContext.push_back (ev);
+        m_eventsWithContextEmpty = false;
+      }
+      return;
+    }
+
+  Partition *partition = GetCurrentPartition ();
+  uint64_t ts = (uint64_t)(delay + TimeStep (partition->currentTs)).GetTimeStep ();
+  Enqueue (*partition, GetPartitionIndex (context), ts, context, event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_ASSERT_MSG (m_currentPartition != 0 || SystemThread::Equals (m_main),
+                 "Simulator::ScheduleNow Thread-unsafe invocation!");
+
+  Partition *partition = GetCurrentPartition ();
+  uint64_t ts = partition->currentTs;
+  uint32_t context = partition->currentContext;
+  uint32_t uid = Enqueue (*partition, partition - &m_partitions.front (), ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  NS_ASSERT_MSG (!m_parallel && SystemThread::Equals (m_main),
+                 "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+  EventId id (Ptr<EventImpl> (event, false), GetCurrentPartition ()->currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  m_uid++;
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrentPartition ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrentPartition ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      NS_ASSERT_MSG (!m_parallel, "Destroy events cannot be removed from a partition");
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition &partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+  NS_ASSERT_MSG (!m_parallel || &partition == GetCurrentPartition (),
+                 "Simulator::Remove of an event owned by another partition");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  if ((event.key.m_uid & PROVISIONAL) != 0)
+    {
+      RenumberedEvents::iterator i = partition.renumbered.find (event.impl);
+      if (i != partition.renumbered.end () &&
+          i->second.provisional == event.key.m_uid &&
+          i->second.ts == event.key.m_ts)
+        {
+          // the event was handed over at a barrier.
+          event.key.m_uid = i->second.uid;
+          partition.renumbered.erase (i);
+        }
+      else if (m_parallel && event.key.m_ts >= m_windowEnd)
+        {
+          // the event is still buffered by this partition.
+          event.impl->Cancel ();
+          partition.removed.insert (event.impl);
+          return;
+        }
+    }
+  partition.events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      NS_ASSERT_MSG (!m_parallel ||
+                     &m_partitions[GetPartitionIndex (id.GetContext ())] == GetCurrentPartition (),
+                     "Simulator::Cancel of an event owned by another partition");
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  // The context-less events do not change while the partitions run.
+  const Partition &partition = m_partitions[GetPartitionIndex (id.GetContext ())];
+  NS_ASSERT_MSG (!m_parallel || &partition == GetCurrentPartition () || &partition == &m_partitions.back (),
+                 "Simulator::IsExpired of an event owned by another partition");
+  // The executed events are cancelled.
+  return id.PeekEventImpl ()->IsCancelled () ||
+         id.PeekEventImpl () == partition.currentEvent;
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrentPartition ()->currentContext;
+}
+
+} // namespace ns3
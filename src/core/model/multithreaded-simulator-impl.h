@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "simulator-impl.h"
+#include "scheduler.h"
+#include "event-impl.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "nstime.h"
+#include "callback.h"
+
+#include "ptr.h"
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <pthread.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ *
+ * A shared-memory parallel simulator implementation, for models whose
+ * contexts share no mutable state.
+ *
+ * Events are partitioned by their execution context: the event queue
+ * of context \c c is owned by partition <tt>c % ThreadCount</tt>.
+ * Events without a context (Simulator::NO_CONTEXT), such as the events
+ * scheduled by the main program before Simulator::Run, are kept in a
+ * separate queue and are executed by the main thread while all the
+ * partitions are idle.
+ *
+ * The events are executed in the order DefaultSimulatorImpl would
+ * execute them.  The partitions are executed by parallel threads,
+ * synchronized conservatively with a barrier at the end of each time
+ * window.  A window starts at the earliest pending event, is one
+ * lookahead long and ends before the next context-less event.  The
+ * events scheduled during a window past its end, or for another
+ * partition, are buffered by their partition.  At the barrier, the
+ * buffered events of all the partitions are numbered in the order in
+ * which DefaultSimulatorImpl would have scheduled them, then handed
+ * over to their partitions.
+ *
+ * The lookahead is the minimum delay of the events exchanged between
+ * partitions.  It is found at Simulator::Run, by the LookaheadFinder
+ * set by the models, and by the \c Lookahead attribute for the events
+ * exchanged without them.  The network module finds the minimum
+ * Channel::GetLookahead of the channels between nodes of different
+ * partitions, a node being the context of its events.  When the
+ * lookahead is zero, or when no event can cross the partitions, the
+ * partitions are executed in turn by the main thread, always picking
+ * the earliest event.
+ *
+ * The models of different partitions must not share mutable state.
+ * The nodes only share their channels: a channel between partitions
+ * hands over to the receiving device a Packet::CopyForContext of the
+ * packet, which shares no reference count, buffer, tag or metadata
+ * with the packet of the sender, and it does not touch the reference
+ * counts of the receiving device and node.  The Packet uids, the
+ * PacketPool, the PacketMetadata arena and the Buffer are safe for
+ * concurrent threads.  The packet uids are unique, but they are not
+ * those of DefaultSimulatorImpl.  The Timers of the TimerWheel and
+ * Simulator::ScheduleDestroy must not be used by the partitions.
+ *
+ * While the partitions run in parallel, an event can only schedule
+ * events for another partition, or context-less events, at least one
+ * lookahead in the future, and it can only cancel, remove or check the
+ * events of its own partition.  Simulator::Stop can not be invoked by
+ * an event of a partition, since the other partitions may already
+ * have executed later events: Simulator::Stop (delay) schedules a
+ * context-less event, which stops all the partitions at once.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * The function which finds the minimum delay of the events the
+   * models exchange between the partitions of a simulator, or
+   * Time::Max () if they exchange none.
+   */
+  typedef Callback<Time, const MultithreadedSimulatorImpl *> LookaheadFinder;
+
+  /**
+   * Set the function which finds the lookahead of the models.
+   *
+   * The network module sets it when it is loaded.
+   *
+   * \param [in] finder The lookahead finder.
+   */
+  static void SetLookaheadFinder (LookaheadFinder finder);
+  /**
+   * Check whether a context belongs to another partition than the
+   * current event, while a simulator runs its partitions in parallel.
+   *
+   * The models must then hand over to the event of the context objects
+   * which share no state with those of the current partition.
+   *
+   * \param [in] context The context of an event.
+   * \return \c true if the event runs in another partition.
+   */
+  static bool IsOtherPartition (uint32_t context);
+
+  /**
+   * Get the number of partitions.
+   *
+   * The partitions are only executed in parallel when the lookahead
+   * is not zero.
+   *
+   * \return The number of partitions.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * Get the lookahead used to synchronize the partitions.
+   *
+   * This is only meaningful once Simulator::Run has been invoked.
+   *
+   * \return The lookahead.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * Find the partition which owns a context.
+   * \param [in] context The context.
+   * \return The index of the partition.
+   */
+  uint32_t GetPartitionIndex (uint32_t context) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** Wrap an event with its execution context. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+
+  /**
+   * The flag of the uids of the events scheduled during a window,
+   * above the uids of the events scheduled before it.
+   */
+  static const uint32_t PROVISIONAL = 0x80000000;
+
+  /** An event executed by a partition during the current window. */
+  struct Record
+  {
+    /** Event timestamp. */
+    uint64_t ts;
+    /** Event uid, with PROVISIONAL if scheduled during the window. */
+    uint32_t uid;
+  };
+  /** An event buffered by a partition until the end of the window. */
+  struct Handover
+  {
+    /** The partition of the event. */
+    uint32_t partition;
+    /** The event context. */
+    uint32_t context;
+    /** Event timestamp. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+    /** The index of the event in Partition::creations. */
+    uint32_t creation;
+  };
+  /** The uid given at the barrier to an event with a provisional uid. */
+  struct Renumbered
+  {
+    /** Event timestamp. */
+    uint64_t ts;
+    /** The provisional uid, held by the EventIds of the event. */
+    uint32_t provisional;
+    /** The uid of the event in its queue. */
+    uint32_t uid;
+    /** The event, kept alive while this entry exists. */
+    Ptr<EventImpl> event;
+  };
+  /** Order the buffered events with IsScheduledBefore. */
+  struct ScheduledBefore
+  {
+    /** The simulator. */
+    const MultithreadedSimulatorImpl *simulator;
+    /**
+     * Compare two buffered events.
+     * \param [in] a The partition and the index in its outbox of the first event.
+     * \param [in] b The partition and the index in its outbox of the second event.
+     * \return \c true if the first event was scheduled before the second.
+     */
+    bool operator () (const std::pair<uint32_t, uint32_t> &a,
+                      const std::pair<uint32_t, uint32_t> &b) const;
+  };
+  /** Container type for the renumbered events, by event. */
+  typedef std::map<const EventImpl *, struct Renumbered> RenumberedEvents;
+
+  /** The state owned by each partition. */
+  struct Partition
+  {
+    /** The event priority queue. */
+    Ptr<Scheduler> events;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** The current event, or 0 between events. */
+    EventImpl *currentEvent;
+    /** The events executed during the current window. */
+    std::vector<struct Record> records;
+    /**
+     * The events scheduled during the current window, in order: the
+     * index in \c records of the event which scheduled each of them.
+     */
+    std::vector<uint32_t> creations;
+    /** The events buffered until the end of the current window. */
+    std::vector<struct Handover> outbox;
+    /** The buffered events removed during the current window. */
+    std::set<const EventImpl *> removed;
+    /** The events of this partition renumbered at a barrier. */
+    RenumberedEvents renumbered;
+    /** The size of \c renumbered which triggers its next cleanup. */
+    std::size_t renumberedCleanup;
+  };
+
+  /**
+   * Create the partitions and their event queues.
+   * \param [in] schedulerFactory The factory of the event queues.
+   */
+  void CreatePartitions (ObjectFactory schedulerFactory);
+  /**
+   * Get the partition of the calling thread.
+   * \return The current partition.
+   */
+  Partition * GetCurrentPartition (void) const;
+  /**
+   * Insert an event in the queue of a partition, with the next uid.
+   * \param [in] partition The partition.
+   * \param [in] ts The absolute event timestamp.
+   * \param [in] context The event context.
+   * \param [in] event The event implementation.
+   * \return The uid of the event.
+   */
+  uint32_t Insert (Partition &partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Schedule an event from the current partition.
+   *
+   * While the partitions run in parallel, the event gets a provisional
+   * uid, and it is buffered until the end of the window unless it
+   * belongs to the current partition and to the current window.
+   *
+   * \param [in] current The current partition.
+   * \param [in] index The index of the partition of the event.
+   * \param [in] ts The absolute event timestamp.
+   * \param [in] context The event context.
+   * \param [in] event The event implementation.
+   * \return The uid of the EventId of the event.
+   */
+  uint32_t Enqueue (Partition &current, uint32_t index, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Compare the order in which DefaultSimulatorImpl would have
+   * scheduled two events scheduled during the current window.
+   * \param [in] a The partition which scheduled the first event.
+   * \param [in] i The index of the first event in its Partition::creations.
+   * \param [in] b The partition which scheduled the second event.
+   * \param [in] j The index of the second event in its Partition::creations.
+   * \return \c true if the first event was scheduled before the second.
+   */
+  bool IsScheduledBefore (uint32_t a, uint32_t i, uint32_t b, uint32_t j) const;
+  /** Find the lookahead, or zero to run the partitions in turn. */
+  void CalculateLookahead (void);
+  /** Run all the partitions from the main thread. */
+  void RunSequential (void);
+  /** Run the partitions in parallel, one window at a time. */
+  void RunParallel (void);
+  /**
+   * Process the earliest event of all the partitions from the main thread.
+   * \return \c false if there was no event.
+   */
+  bool ProcessEarliestEvent (void);
+  /**
+   * Process the next event of a partition.
+   * \param [in] partition The partition.
+   */
+  void ProcessOneEvent (Partition &partition);
+  /**
+   * Advance the time seen outside of the partitions.
+   * \param [in] partition A partition which has processed events.
+   */
+  void UpdateGlobalTime (const Partition &partition);
+  /**
+   * Process the events of a partition up to the end of the current window.
+   * \param [in] index The index of the partition.
+   */
+  void ProcessPartition (uint32_t index);
+  /**
+   * Number the events buffered during the window and hand them over
+   * to their partitions.
+   */
+  void ProcessOutboxes (void);
+  /**
+   * Forget the renumbered events which can not be removed any more.
+   * \param [in] partition The partition.
+   */
+  void CleanupRenumbered (Partition &partition);
+  /** Move events from a foreign thread into the partitions. */
+  void ProcessEventsWithContext (void);
+  /**
+   * The main function of the worker threads.
+   * \param [in] self The simulator.
+   * \param [in] index The index of the partition run by this thread.
+   */
+  static void WorkerThread (MultithreadedSimulatorImpl *self, uint32_t index);
+
+  /** The partition of the calling thread, or 0 outside of any event. */
+  static thread_local Partition *m_currentPartition;
+  /** The simulator running its partitions in parallel, if any. */
+  static const MultithreadedSimulatorImpl *m_parallelRun;
+
+  /** The partitions; the last one holds the context-less events. */
+  std::vector<Partition> m_partitions;
+  /** Number of partitions, not counting the context-less one. */
+  uint32_t m_partitionCount;
+  /** The requested number of threads. */
+  uint32_t m_threadCount;
+  /** The lookahead of the events exchanged without the channels. */
+  Time m_lookaheadAttribute;
+  /** Next event unique id. */
+  uint32_t m_uid;
+  /** The lookahead, in time steps. */
+  uint64_t m_lookahead;
+  /** End of the current window (exclusive), in time steps. */
+  uint64_t m_windowEnd;
+  /** Flag \c true while the partitions run in parallel. */
+  bool m_parallel;
+  /** Flag telling the worker threads to exit. */
+  bool m_exit;
+  /** Barrier at the start of each window. */
+  pthread_barrier_t m_windowStartBarrier;
+  /** Barrier at the end of each window. */
+  pthread_barrier_t m_windowEndBarrier;
+  /** The worker threads. */
+  std::vector<Ptr<SystemThread> > m_threads;
+
+  /** The container of events scheduled from a foreign thread. */
+  std::list<struct EventWithContext> m_eventsWithContext;
+  /**
+   * Flag \c true if all events with context have been moved to the
+   * partitions.
+   */
+  bool m_eventsWithContextEmpty;
+  /** Mutex to control access to the list of events with context. */
+  SystemMutex m_eventsWithContextMutex;
+
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** Flag calling for the end of the simulation. */
+  bool m_stop;
+
+  /** Main execution thread. */
+  SystemThread::ThreadId m_main;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
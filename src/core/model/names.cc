@@ -16,7 +16,9 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "object.h"
 #include "log.h"
 #include "assert.h"
@@ -75,13 +77,18 @@ public:
   std::string m_name;
   /** The object corresponding to this NameNode. */
   Ptr<Object> m_object;
+  /**
+   * The path of this NameNode below "/Names", interned as the key of
+   * NamesPriv::m_pathMap, or null for the root.
+   */
+  const std::string *m_path;
 
   /** Children of this NameNode. */
-  std::map<std::string, NameNode *> m_nameMap;
+  std::unordered_map<std::string, NameNode *> m_nameMap;
 };
 
 NameNode::NameNode ()
-  : m_parent (0), m_name (""), m_object (0)
+  : m_parent (0), m_name (""), m_object (0), m_path (0)
 {
 }
 
@@ -90,6 +97,7 @@ NameNode::NameNode (const NameNode &nameNode)
   m_parent = nameNode.m_parent;
   m_name = nameNode.m_name;
   m_object = nameNode.m_object;
+  m_path = nameNode.m_path;
   m_nameMap = nameNode.m_nameMap;
 }
 
@@ -99,12 +107,13 @@ NameNode::operator = (const NameNode &rhs)
   m_parent = rhs.m_parent;
   m_name = rhs.m_name;
   m_object = rhs.m_object;
+  m_path = rhs.m_path;
   m_nameMap = rhs.m_nameMap;
   return *this;
 }
 
 NameNode::NameNode (NameNode *parent, std::string name, Ptr<Object> object)
-  : m_parent (parent), m_name (name), m_object (object)
+  : m_parent (parent), m_name (name), m_object (object), m_path (0)
 {
   NS_LOG_FUNCTION (this << parent << name << object);
 }
@@ -141,6 +150,12 @@ public:
    * \return \c true if the object was named successfully.
    */
   bool Add (Ptr<Object> context, std::string name, Ptr<Object> object);
+  /**
+   * Make room for more names, before they are added in bulk.
+   *
+   * \param [in] n The number of names about to be added.
+   */
+  void Reserve (std::size_t n);
 
   /**
    * \copydoc Names::Rename(std::string,std::string)
@@ -191,12 +206,37 @@ private:
    * \returns \c true if \c name already exists as a child of \c node.
    */
   bool IsDuplicateName (NameNode *node, std::string name);
+  /**
+   * Find the NameNode of a path.
+   *
+   * \param [in] path The path, with or without the "/Names/" prefix.
+   * \returns The NameNode, or null if the path is not named.
+   */
+  NameNode *FindNode (const std::string &path) const;
+  /**
+   * Intern the paths of a NameNode and of its descendants in the path map.
+   *
+   * \param [in] node The NameNode, which must not be the root.
+   * \returns \c false if one of the paths is already taken.
+   */
+  bool Index (NameNode *node);
+  /**
+   * Remove the paths of a NameNode and of its descendants from the path map.
+   *
+   * \param [in] node The NameNode, which must not be the root.
+   */
+  void Unindex (NameNode *node);
 
   /** The root NameNode. */
   NameNode m_root;
 
+  /**
+   * Map from the paths below "/Names", such as "Client/eth0", to their
+   * NameNodes, so that a path is found with a single lookup.
+   */
+  std::unordered_map<std::string, NameNode *> m_pathMap;
   /** Map from object pointers to their NameNodes. */
-  std::map<Ptr<Object>, NameNode *> m_objectMap;
+  std::unordered_map<const Object *, NameNode *> m_objectMap;
 };
 
 NamesPriv::NamesPriv ()
@@ -223,13 +263,14 @@ NamesPriv::Clear (void)
   // Every name is associated with an object in the object map, so freeing the
   // NameNodes in this map will free all of the memory allocated for the NameNodes
   //
-  for (std::map<Ptr<Object>, NameNode *>::iterator i = m_objectMap.begin (); i != m_objectMap.end (); ++i)
+  for (std::unordered_map<const Object *, NameNode *>::iterator i = m_objectMap.begin (); i != m_objectMap.end (); ++i)
     {
       delete i->second;
       i->second = 0;
     }
 
   m_objectMap.clear ();
+  m_pathMap.clear ();
 
   m_root.m_parent = 0;
   m_root.m_name = "Names";
@@ -339,12 +380,71 @@ NamesPriv::Add (Ptr<Object> context, std::string name, Ptr<Object> object)
     }
 
   NameNode *newNode = new NameNode (node, name, object);
+  if (!Index (newNode))
+    {
+      NS_LOG_LOGIC ("Path is already taken");
+      delete newNode;
+      return false;
+    }
   node->m_nameMap[name] = newNode;
-  m_objectMap[object] = newNode;
+  m_objectMap[PeekPointer (object)] = newNode;
 
   return true;
 }
 
+void
+NamesPriv::Reserve (std::size_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_pathMap.reserve (m_pathMap.size () + n);
+  m_objectMap.reserve (m_objectMap.size () + n);
+}
+
+bool
+NamesPriv::Index (NameNode *node)
+{
+  NS_LOG_FUNCTION (this << node);
+  NS_ASSERT (node->m_parent);
+  std::string path = node->m_parent == &m_root ? node->m_name : *node->m_parent->m_path + "/" + node->m_name;
+  std::pair<std::unordered_map<std::string, NameNode *>::iterator, bool> result =
+    m_pathMap.insert (std::make_pair (path, node));
+  if (!result.second)
+    {
+      node->m_path = 0;
+      return false;
+    }
+  //
+  // The keys of an unordered_map do not move when it rehashes, so the
+  // NameNode can keep a pointer to its path rather than a copy.
+  //
+  node->m_path = &result.first->first;
+  bool indexed = true;
+  for (std::unordered_map<std::string, NameNode *>::iterator i = node->m_nameMap.begin (); i != node->m_nameMap.end (); ++i)
+    {
+      indexed = Index (i->second) && indexed;
+    }
+  return indexed;
+}
+
+void
+NamesPriv::Unindex (NameNode *node)
+{
+  NS_LOG_FUNCTION (this << node);
+  for (std::unordered_map<std::string, NameNode *>::iterator i = node->m_nameMap.begin (); i != node->m_nameMap.end (); ++i)
+    {
+      Unindex (i->second);
+    }
+  if (node->m_path != 0)
+    {
+      std::unordered_map<std::string, NameNode *>::iterator i = m_pathMap.find (*node->m_path);
+      if (i != m_pathMap.end () && i->second == node)
+        {
+          m_pathMap.erase (i);
+        }
+      node->m_path = 0;
+    }
+}
+
 bool
 NamesPriv::Rename (std::string oldpath, std::string newname)
 {
@@ -442,7 +542,7 @@ NamesPriv::Rename (Ptr<Object> context, std::string oldname, std::string newname
       return false;
     }
 
-  std::map<std::string, NameNode *>::iterator i = node->m_nameMap.find (oldname);
+  std::unordered_map<std::string, NameNode *>::iterator i = node->m_nameMap.find (oldname);
   if (i == node->m_nameMap.end ())
     {
       NS_LOG_LOGIC ("Old name does not exist in name map");
@@ -457,11 +557,22 @@ NamesPriv::Rename (Ptr<Object> context, std::string oldname, std::string newname
       // 1.  Geting the pointer to the name node from the map and remembering it;
       // 2.  Removing the map entry corresponding to oldname from the map;
       // 3.  Changing the name string in the name node;
-      // 4.  Adding the name node back in the map under the newname.
+      // 4.  Adding the name node back in the map under the newname;
+      // 5.  Interning the new paths of the name node and of its children.
       //
       NameNode *changeNode = i->second;
-      node->m_nameMap.erase (i);
+      Unindex (changeNode);
       changeNode->m_name = newname;
+      if (!Index (changeNode))
+        {
+          NS_LOG_LOGIC ("New path is already taken");
+          Unindex (changeNode);
+          changeNode->m_name = oldname;
+          bool indexed = Index (changeNode);
+          NS_ASSERT_MSG (indexed, "NamesPriv::Rename(): Internal error: can't restore the old paths");
+          return false;
+        }
+      node->m_nameMap.erase (i);
       node->m_nameMap[newname] = changeNode;
       return true;
     }
@@ -472,7 +583,7 @@ NamesPriv::FindName (Ptr<Object> object)
 {
   NS_LOG_FUNCTION (this << object);
 
-  std::map<Ptr<Object>, NameNode *>::iterator i = m_objectMap.find (object);
+  std::unordered_map<const Object *, NameNode *>::iterator i = m_objectMap.find (PeekPointer (object));
   if (i == m_objectMap.end ())
     {
       NS_LOG_LOGIC ("Object does not exist in object map");
@@ -490,7 +601,7 @@ NamesPriv::FindPath (Ptr<Object> object)
 {
   NS_LOG_FUNCTION (this << object);
 
-  std::map<Ptr<Object>, NameNode *>::iterator i = m_objectMap.find (object);
+  std::unordered_map<const Object *, NameNode *>::iterator i = m_objectMap.find (PeekPointer (object));
   if (i == m_objectMap.end ())
     {
       NS_LOG_LOGIC ("Object does not exist in object map");
@@ -498,17 +609,10 @@ NamesPriv::FindPath (Ptr<Object> object)
     }
 
   NameNode *p = i->second;
-  NS_ASSERT_MSG (p, "NamesPriv::FindFullName(): Internal error: Invalid NameNode pointer from map");
-
-  std::string path;
-
-  do
-    {
-      path = "/" + p->m_name + path;
-      NS_LOG_LOGIC ("path is " << path);
-    }
-  while ((p = p->m_parent) != 0);
+  NS_ASSERT_MSG (p && p->m_path, "NamesPriv::FindFullName(): Internal error: Invalid NameNode pointer from map");
 
+  std::string path = "/Names/" + *p->m_path;
+  NS_LOG_LOGIC ("path is " << path);
   return path;
 }
 
@@ -526,85 +630,43 @@ NamesPriv::Find (std::string path)
   // and simply do a Find ("Client/eth0") instead of having to always do a
   // Find ("/Names/Client/eth0");
   //
-  // So, if we are given a name that begins with "/Names/" the upshot is that we
-  // just remove that prefix and treat the rest of the string as starting with a 
-  // name in the root namespace.
-  //
-
   NS_LOG_FUNCTION (this << path);
-  std::string namespaceName = "/Names/";
-  std::string remaining;
+  NameNode *node = FindNode (path);
+  if (node == 0)
+    {
+      NS_LOG_LOGIC ("Name does not exist in path map");
+      return 0;
+    }
+  NS_LOG_LOGIC ("Name parsed, found object");
+  return node->m_object;
+}
 
-  std::string::size_type offset = path.find (namespaceName);
-  if (offset == 0)
+NameNode *
+NamesPriv::FindNode (const std::string &path) const
+{
+  NS_LOG_FUNCTION (this << path);
+  //
+  // Every named path is interned in the path map without the "/Names/"
+  // prefix, e.g., "ClientNode/eth0", so we remove the prefix, if any,
+  // and look the rest of the path up at once.
+  //
+  static const std::string namespaceName = "/Names/";
+  std::unordered_map<std::string, NameNode *>::const_iterator i;
+  if (path.compare (0, namespaceName.size (), namespaceName) == 0)
     {
       NS_LOG_LOGIC (path << " is a fully qualified name");
-      remaining = path.substr (namespaceName.size ());
+      i = m_pathMap.find (path.substr (namespaceName.size ()));
     }
   else
     {
       NS_LOG_LOGIC (path << " begins with a relative name");
-      remaining = path;
+      i = m_pathMap.find (path);
     }
-
-  NameNode *node = &m_root;
-
-  //
-  // The string <remaining> is now composed entirely of path segments in
-  // the /Names name space and we have eaten the leading slash. e.g., 
-  // remaining = "ClientNode/eth0"
-  //
-  // The start of the search is always at the root of the name space.
-  //
-  for (;;)
+  if (i == m_pathMap.end ())
     {
-      NS_LOG_LOGIC ("Looking for the object of name " << remaining);
-      offset = remaining.find ("/");
-      if (offset == std::string::npos)
-        {
-          //
-          // There are no remaining slashes so this is the last segment of the 
-          // specified name.  We're done when we find it
-          //
-          std::map<std::string, NameNode *>::iterator i = node->m_nameMap.find (remaining);
-          if (i == node->m_nameMap.end ())
-            {
-              NS_LOG_LOGIC ("Name does not exist in name map");
-              return 0;
-            }
-          else
-            {
-              NS_LOG_LOGIC ("Name parsed, found object");
-              return i->second->m_object;
-            }
-        }
-      else
-        {
-          //
-          // There are more slashes so this is an intermediate segment of the 
-          // specified name.  We need to "recurse" when we find this segment.
-          //
-          offset = remaining.find ("/");
-          std::string segment = remaining.substr (0, offset);
-
-          std::map<std::string, NameNode *>::iterator i = node->m_nameMap.find (segment);
-          if (i == node->m_nameMap.end ())
-            {
-              NS_LOG_LOGIC ("Name does not exist in name map");
-              return 0;
-            }
-          else
-            {
-              node = i->second;
-              remaining = remaining.substr (offset + 1);
-              NS_LOG_LOGIC ("Intermediate segment parsed");
-              continue;
-            }
-        }
+      return 0;
     }
-
-  NS_ASSERT_MSG (node, "NamesPriv::Find(): Internal error:  this can't happen");
-  return 0;
+  return i->second;
 }
 
 Ptr<Object>
@@ -641,7 +703,7 @@ NamesPriv::Find (Ptr<Object> context, std::string name)
         }
     }
 
-  std::map<std::string, NameNode *>::iterator i = node->m_nameMap.find (name);
+  std::unordered_map<std::string, NameNode *>::iterator i = node->m_nameMap.find (name);
   if (i == node->m_nameMap.end ())
     {
       NS_LOG_LOGIC ("Name does not exist in name map");
@@ -659,7 +721,7 @@ NamesPriv::IsNamed (Ptr<Object> object)
 {
   NS_LOG_FUNCTION (this << object);
 
-  std::map<Ptr<Object>, NameNode *>::iterator i = m_objectMap.find (object);
+  std::unordered_map<const Object *, NameNode *>::iterator i = m_objectMap.find (PeekPointer (object));
   if (i == m_objectMap.end ())
     {
       NS_LOG_LOGIC ("Object does not exist in object map, returning NameNode 0");
@@ -677,7 +739,7 @@ NamesPriv::IsDuplicateName (NameNode *node, std::string name)
 {
   NS_LOG_FUNCTION (this << node << name);
 
-  std::map<std::string, NameNode *>::iterator i = node->m_nameMap.find (name);
+  std::unordered_map<std::string, NameNode *>::iterator i = node->m_nameMap.find (name);
   if (i == node->m_nameMap.end ())
     {
       NS_LOG_LOGIC ("Name does not exist in name map");
@@ -698,6 +760,19 @@ Names::Add (std::string name, Ptr<Object> object)
   NS_ABORT_MSG_UNLESS (result, "Names::Add(): Error adding name " << name);
 }
 
+void
+Names::Add (const std::vector<std::pair<std::string, Ptr<Object> > > &names)
+{
+  NS_LOG_FUNCTION (&names);
+  NamesPriv *priv = NamesPriv::Get ();
+  priv->Reserve (names.size ());
+  for (std::vector<std::pair<std::string, Ptr<Object> > >::const_iterator i = names.begin (); i != names.end (); ++i)
+    {
+      bool result = priv->Add (i->first, i->second);
+      NS_ABORT_MSG_UNLESS (result, "Names::Add(): Error adding name " << i->first);
+    }
+}
+
 void
 Names::Rename (std::string oldpath, std::string newname)
 {
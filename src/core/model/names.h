@@ -19,6 +19,9 @@
 #ifndef OBJECT_NAMES_H
 #define OBJECT_NAMES_H
 
+#include <string>
+#include <utility>
+#include <vector>
 #include "ptr.h"
 #include "object.h"
 
@@ -34,6 +37,12 @@ namespace ns3 {
  * \ingroup config
  * \brief A directory of name and Ptr<Object> associations that allows
  * us to give any ns3 Object a name.
+ *
+ * The full paths of the names are interned in a hash table, so that
+ * Find with a path costs a single lookup whatever the depth of the
+ * path, and the objects are indexed by a second hash table, so that
+ * FindName, FindPath and the lookups under a context do not depend on
+ * the number of names either.
  */
 class Names
 {
@@ -171,6 +180,20 @@ public:
    */
   static void Add (Ptr<Object> context, std::string name, Ptr<Object> object);
 
+  /**
+   * \brief Add many names at once.
+   *
+   * Each name is added as by Names::Add (std::string,Ptr<Object>),
+   * in order, so that a name may be added under a name which precedes
+   * it in the list.  The name space makes room for all of the names
+   * beforehand, which makes this the fastest way to name a large
+   * number of objects, such as all of the nodes of a topology.
+   *
+   * \param [in] names The names, which may be prepended with a path,
+   *             and the objects to associate with them.
+   */
+  static void Add (const std::vector<std::pair<std::string, Ptr<Object> > > &names);
+
   /**
    * \brief Rename a previously associated name.
    *
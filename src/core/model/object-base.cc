@@ -76,19 +76,24 @@ ObjectBase::NotifyConstructionCompleted (void)
   NS_LOG_FUNCTION (this);
 }
 
-void
-ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
+AttributeConstructionPlan::AttributeConstructionPlan (TypeId tid,
+                                                      const AttributeConstructionList &attributes)
+  : m_tid (tid),
+    m_generation (TypeId::GetAttributeGeneration ())
 {
   // loop over the inheritance tree back to the Object base class.
-  NS_LOG_FUNCTION (this << &attributes);
-  TypeId tid = GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid.GetName () << &attributes);
+#ifdef HAVE_GETENV
+  // read the env var once, rather than for each attribute.
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+#endif /* HAVE_GETENV */
   do {
       // loop over all attributes in object type
       NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
       for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
         {
           struct TypeId::AttributeInformation info = tid.GetAttribute(i);
-          NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
+          NS_LOG_DEBUG ("plan \""<< tid.GetName ()<<"::"<<
                         info.name <<"\"");
           // is this attribute stored in this AttributeConstructionList instance ?
           Ptr<AttributeValue> value = attributes.Find(info.checker);
@@ -112,29 +117,30 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
                   NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
                 }
             }
+          // The values are tried in order when an object is
+          // constructed, until one of them is set.  A value which
+          // passes the checker is always set, so the values after it
+          // are never tried.  The others are only converted then, since
+          // a conversion may create an Object for each construction.
+          struct Step step;
+          step.accessor = info.accessor;
+          step.checker = info.checker;
           bool found = false;
           if (value != 0)
             {
               // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
-                {
-                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
-                  found = true;
-                  continue;
-                }
+              found = AddValue (step, value);
             }              
           if (!found)
             {
               // No matching attribute value so we try to look at the env var.
 #ifdef HAVE_GETENV
-              char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
               if (envVar != 0)
                 {
                   std::string env = std::string (envVar);
                   std::string::size_type cur = 0;
                   std::string::size_type next = 0;
-                  while (next != std::string::npos)
+                  while (next != std::string::npos && !found)
                     {
                       next = env.find (";", cur);
                       std::string tmp = std::string (env, cur, next-cur);
@@ -145,13 +151,7 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
                           std::string value = tmp.substr (equal+1, tmp.size () - equal - 1);
                           if (name == tid.GetAttributeFullName (i))
                             {
-                              if (DoSet (info.accessor, info.checker, StringValue (value)))
-                                {
-                                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                                info.name <<"\" from env var");
-                                  found = true;
-                                  break;
-                                }
+                              found = AddValue (step, Create<StringValue> (value));
                             }
                         }
                       cur = next + 1;
@@ -162,13 +162,70 @@ ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
           if (!found)
             {
               // No matching attribute value so we try to set the default value.
-              DoSet (info.accessor, info.checker, *info.initialValue);
-              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                            info.name <<"\" from initial value.");
+              AddValue (step, info.initialValue);
             }
+          m_steps.push_back (step);
         }
       tid = tid.GetParent ();
     } while (tid != ObjectBase::GetTypeId ());
+}
+
+bool
+AttributeConstructionPlan::AddValue (struct Step &step, Ptr<const AttributeValue> value)
+{
+  NS_LOG_FUNCTION (this << value);
+  struct Value v;
+  v.value = value;
+  v.checked = step.checker->Check (*value);
+  step.values.push_back (v);
+  return v.checked;
+}
+
+TypeId
+AttributeConstructionPlan::GetTypeId (void) const
+{
+  return m_tid;
+}
+
+bool
+AttributeConstructionPlan::IsUpToDate (void) const
+{
+  return m_generation == TypeId::GetAttributeGeneration ();
+}
+
+void
+ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
+{
+  NS_LOG_FUNCTION (this << &attributes);
+  ConstructSelf (AttributeConstructionPlan (GetInstanceTypeId (), attributes));
+}
+
+void
+ObjectBase::ConstructSelf (const AttributeConstructionPlan &plan)
+{
+  NS_LOG_FUNCTION (this << &plan);
+  for (std::vector<struct AttributeConstructionPlan::Step>::const_iterator i = plan.m_steps.begin ();
+       i != plan.m_steps.end (); ++i)
+    {
+      for (std::vector<struct AttributeConstructionPlan::Value>::const_iterator j = i->values.begin ();
+           j != i->values.end (); ++j)
+        {
+          bool ok;
+          if (j->checked)
+            {
+              // no need to copy a value which is valid as is.
+              ok = i->accessor->Set (this, *j->value);
+            }
+          else
+            {
+              ok = DoSet (i->accessor, i->checker, *j->value);
+            }
+          if (ok)
+            {
+              break;
+            }
+        }
+    }
   NotifyConstructionCompleted ();
 }
 
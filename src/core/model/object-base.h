@@ -22,8 +22,10 @@
 
 #include "type-id.h"
 #include "callback.h"
+#include "simple-ref-count.h"
 #include <string>
 #include <list>
+#include <vector>
 
 /**
  * \file
@@ -55,6 +57,77 @@ namespace ns3 {
 
 class AttributeConstructionList;
 
+/**
+ * \ingroup object
+ *
+ * \brief The Attribute values which ObjectBase::ConstructSelf() sets
+ * on an object of a TypeId.
+ *
+ * The values are resolved once, in the order ConstructSelf() uses:
+ * the value in the AttributeConstructionList, else the value in the
+ * \c NS_ATTRIBUTE_DEFAULT environment variable, else the initial
+ * value of the Attribute.  ObjectFactory keeps the plan of its TypeId
+ * and Attributes, and reuses it for all the Objects it creates until
+ * TypeId::GetAttributeGeneration() changes.
+ */
+class AttributeConstructionPlan : public SimpleRefCount<AttributeConstructionPlan>
+{
+public:
+  /**
+   * Resolve the Attribute values of a TypeId.
+   *
+   * \param [in] tid The TypeId of the objects to construct.
+   * \param [in] attributes The Attribute values set by the user.
+   */
+  AttributeConstructionPlan (TypeId tid, const AttributeConstructionList &attributes);
+  /**
+   * Get the TypeId of the plan.
+   * \returns The TypeId.
+   */
+  TypeId GetTypeId (void) const;
+  /**
+   * Check that no Attribute was added, and no initial value was set,
+   * since the plan was resolved.
+   * \returns \c true if the plan can still be used.
+   */
+  bool IsUpToDate (void) const;
+
+private:
+  friend class ObjectBase;
+
+  /** A value to try for an Attribute. */
+  struct Value
+  {
+    Ptr<const AttributeValue> value;        //!< The value.
+    /**
+     * The value passes the checker, so it is set without a copy;
+     * otherwise it is converted by the checker for each object.
+     */
+    bool checked;
+  };
+  /** An Attribute to set. */
+  struct Step
+  {
+    Ptr<const AttributeAccessor> accessor;  //!< The accessor.
+    Ptr<const AttributeChecker> checker;    //!< The checker.
+    std::vector<struct Value> values;       //!< The values to try, in order.
+  };
+
+  /**
+   * Add a value to try for an Attribute.
+   *
+   * \param [in,out] step The Attribute.
+   * \param [in] value The value.
+   * \returns \c true if the value passes the checker, so the next
+   *          values would never be tried.
+   */
+  bool AddValue (struct Step &step, Ptr<const AttributeValue> value);
+
+  TypeId m_tid;                             //!< The TypeId.
+  uint64_t m_generation;                    //!< The generation of the Attributes.
+  std::vector<struct Step> m_steps;         //!< The Attributes to set, in order.
+};
+
 /**
  * \ingroup object
  *
@@ -213,6 +286,13 @@ protected:
    *        the member variables of this object's instance.
    */
   void ConstructSelf (const AttributeConstructionList &attributes);
+  /**
+   * Complete construction of ObjectBase with the values of a plan.
+   *
+   * \param [in] plan The Attribute values resolved for the TypeId of
+   *        this object.
+   */
+  void ConstructSelf (const AttributeConstructionPlan &plan);
 
 private:
   /**
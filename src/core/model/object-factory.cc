@@ -47,18 +47,21 @@ ObjectFactory::SetTypeId (TypeId tid)
 {
   NS_LOG_FUNCTION (this << tid.GetName ());
   m_tid = tid;
+  m_plan = 0;
 }
 void
 ObjectFactory::SetTypeId (std::string tid)
 {
   NS_LOG_FUNCTION (this << tid);
   m_tid = TypeId::LookupByName (tid);
+  m_plan = 0;
 }
 void
 ObjectFactory::SetTypeId (const char *tid)
 {
   NS_LOG_FUNCTION (this << tid);
   m_tid = TypeId::LookupByName (tid);
+  m_plan = 0;
 }
 void
 ObjectFactory::Set (std::string name, const AttributeValue &value)
@@ -82,6 +85,7 @@ ObjectFactory::Set (std::string name, const AttributeValue &value)
       return;
     }
   m_parameters.Add (name, info.checker, value.Copy ());
+  m_plan = 0;
 }
 
 TypeId 
@@ -96,11 +100,58 @@ ObjectFactory::Create (void) const
 {
   NS_LOG_FUNCTION (this);
   Callback<ObjectBase *> cb = m_tid.GetConstructor ();
-  ObjectBase *base = cb ();
+  return Construct (cb (), GetPlan ());
+}
+
+std::vector<Ptr<Object> >
+ObjectFactory::CreateN (uint32_t n) const
+{
+  NS_LOG_FUNCTION (this << n);
+  std::vector<Ptr<Object> > objects;
+  objects.reserve (n);
+  Callback<ObjectBase *> cb = m_tid.GetConstructor ();
+  Ptr<const AttributeConstructionPlan> plan = GetPlan ();
+  Object::Arena arena (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // each Object is fully constructed before the next one, as
+      // with Create, so that they draw their random variable streams
+      // in the same order.
+      arena.Arm ();
+      ObjectBase *base = cb ();
+      Object::Arena::Disarm ();
+      objects.push_back (Construct (base, plan));
+    }
+  return objects;
+}
+
+Ptr<const AttributeConstructionPlan>
+ObjectFactory::GetPlan (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_plan == 0 || !m_plan->IsUpToDate ())
+    {
+      m_plan = ns3::Create<AttributeConstructionPlan> (m_tid, m_parameters);
+    }
+  return m_plan;
+}
+
+Ptr<Object>
+ObjectFactory::Construct (ObjectBase *base, Ptr<const AttributeConstructionPlan> plan) const
+{
+  NS_LOG_FUNCTION (this << base << plan);
   Object *derived = dynamic_cast<Object *> (base);
   NS_ASSERT (derived != 0);
   derived->SetTypeId (m_tid);
-  derived->Construct (m_parameters);
+  if (derived->GetInstanceTypeId () == plan->GetTypeId ())
+    {
+      derived->Construct (*plan);
+    }
+  else
+    {
+      // the class reports another TypeId than the one of the factory.
+      derived->Construct (m_parameters);
+    }
   Ptr<Object> object = Ptr<Object> (derived, false);
   return object;
 }
@@ -184,6 +235,7 @@ std::istream & operator >> (std::istream &is, ObjectFactory &factory)
               else
                 {
                   factory.m_parameters.Add (name, info.checker, val);
+                  factory.m_plan = 0;
                 }
             }
         }
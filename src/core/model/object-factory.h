@@ -23,6 +23,7 @@
 #include "attribute-construction-list.h"
 #include "object.h"
 #include "type-id.h"
+#include <vector>
 
 /**
  * \file
@@ -104,8 +105,45 @@ public:
    */
   template <typename T>
   Ptr<T> Create (void) const;
+  /**
+   * Create Object instances of the configured TypeId.
+   *
+   * The Attribute values are resolved once for all the Objects,
+   * rather than once per Object, and the Objects are allocated
+   * contiguously.  The Objects are constructed one after the other,
+   * as by \pname{n} calls to Create().
+   *
+   * \param [in] n The number of Objects.
+   * \returns The new object instances.
+   */
+  std::vector<Ptr<Object> > CreateN (uint32_t n) const;
+  /**
+   * Create Object instances of the requested type.
+   *
+   * \tparam T \explicit The requested Object type.
+   * \param [in] n The number of Objects.
+   * \returns The new object instances.
+   */
+  template <typename T>
+  std::vector<Ptr<T> > CreateN (uint32_t n) const;
 
 private:
+  /**
+   * Get the Attribute values of the Objects, resolved for the current
+   * TypeId, Attributes and initial values.
+   *
+   * \returns The plan.
+   */
+  Ptr<const AttributeConstructionPlan> GetPlan (void) const;
+  /**
+   * Complete the construction of an Object.
+   *
+   * \param [in] base The Object returned by the constructor of the TypeId.
+   * \param [in] plan The plan returned by GetPlan().
+   * \returns The Object.
+   */
+  Ptr<Object> Construct (ObjectBase *base, Ptr<const AttributeConstructionPlan> plan) const;
+
   /**
    * Print the factory configuration on an output stream.
    *
@@ -136,6 +174,8 @@ private:
    * objects by this factory.
    */
   AttributeConstructionList m_parameters;  
+  /** The plan resolved from m_tid and m_parameters, if any. */
+  mutable Ptr<const AttributeConstructionPlan> m_plan;
 };
 
 std::ostream & operator << (std::ostream &os, const ObjectFactory &factory);
@@ -201,6 +241,20 @@ ObjectFactory::Create (void) const
   return object->GetObject<T> ();
 }
 
+template <typename T>
+std::vector<Ptr<T> >
+ObjectFactory::CreateN (uint32_t n) const
+{
+  std::vector<Ptr<Object> > objects = CreateN (n);
+  std::vector<Ptr<T> > result;
+  result.reserve (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      result.push_back (objects[i]->GetObject<T> ());
+    }
+  return result;
+}
+
 template <typename T>
 Ptr<T> 
 CreateObjectWithAttributes (std::string n1, const AttributeValue & v1,
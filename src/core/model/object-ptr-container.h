@@ -220,6 +220,27 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * Get the number of instances in the container, without copying
+   * the container into an ObjectPtrContainerValue.
+   *
+   * \param [in] object The container object.
+   * \param [out] n The number of instances in the container.
+   * \returns true if the value could be obtained successfully.
+   */
+  bool GetN (const ObjectBase *object, uint32_t *n) const;
+  /**
+   * Find the instance of an index, without copying the container
+   * into an ObjectPtrContainerValue.
+   *
+   * This takes constant time for the containers whose indices are the
+   * positions of the instances, such as the ObjectVector attributes.
+   *
+   * \param [in] object The container object.
+   * \param [in] index The index.
+   * \returns The instance, or 0 if there is none with this index.
+   */
+  Ptr<Object> Find (const ObjectBase *object, uint32_t index) const;
 private:
   /**
    * Get the number of instances in the container.
@@ -24,11 +24,16 @@
 #include "assert.h"
 #include "attribute.h"
 #include "log.h"
+#include "abort.h"
 #include "string.h"
+#include "memory-accounting.h"
 #include <vector>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <new>
 
 /**
  * \file
@@ -46,6 +51,52 @@ NS_LOG_COMPONENT_DEFINE ("Object");
 
 NS_OBJECT_ENSURE_REGISTERED (Object);
 
+/**
+ * The memory of an Arena: the header, then the Objects.
+ */
+struct Object::Arena::Block
+{
+  /** The number of Objects not yet deleted, plus one for the Arena. */
+  std::atomic<uint32_t> live;
+  std::size_t stride;   //!< The size of an Object.
+  uint32_t used;        //!< The number of Objects allocated.
+  uint8_t shift;        //!< The exponent of the alignment of the memory.
+};
+
+namespace {
+
+/**
+ * \ingroup object
+ * The Arena from which the next Object of this thread is allocated.
+ */
+thread_local Object::Arena *g_armedArena = 0;
+
+/**
+ * \ingroup object
+ * The last Object allocated by operator new in this thread, for the
+ * MemoryAccounting.
+ */
+thread_local const void *g_lastAllocation = 0;
+/**
+ * \ingroup object
+ * The size of the last Object allocated by operator new in this thread.
+ */
+thread_local std::size_t g_lastAllocationSize = 0;
+/**
+ * \ingroup object
+ * The exponent of the alignment of the Arena of the last Object
+ * allocated by operator new in this thread, or 0 for the heap.
+ */
+thread_local uint8_t g_lastAllocationShift = 0;
+/**
+ * \ingroup object
+ * The Arena::Block of the Object which this thread is deleting, set by
+ * the destructor for operator delete, or null for the heap.
+ */
+thread_local void *g_releasedBlock = 0;
+
+} // unnamed namespace
+
 Object::AggregateIterator::AggregateIterator ()
   : m_object (0),
     m_current (0)
@@ -98,16 +149,19 @@ Object::Object ()
     m_disposed (false),
     m_initialized (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_getObjectCount (0),
+    m_arenaShift (0)
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  NotifyAllocate ();
 }
 Object::~Object () 
 {
   // remove this object from the aggregate list
   NS_LOG_FUNCTION (this);
+  MemoryAccounting::NotifyRelease (this);
   uint32_t n = m_aggregates->n;
   for (uint32_t i = 0; i < n; i++)
     {
@@ -127,16 +181,26 @@ Object::~Object ()
       std::free (m_aggregates);
     }
   m_aggregates = 0;
+  // operator delete, which runs next, releases the Object to its
+  // Arena, whose header is at the start of the aligned memory.
+  g_releasedBlock = 0;
+  if (m_arenaShift != 0)
+    {
+      uintptr_t mask = (uintptr_t (1) << m_arenaShift) - 1;
+      g_releasedBlock = reinterpret_cast<void *> (reinterpret_cast<uintptr_t> (this) & ~mask);
+    }
 }
 Object::Object (const Object &o)
   : m_tid (o.m_tid),
     m_disposed (false),
     m_initialized (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
-    m_getObjectCount (0)
+    m_getObjectCount (0),
+    m_arenaShift (0)
 {
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
+  NotifyAllocate ();
 }
 void
 Object::Construct (const AttributeConstructionList &attributes)
@@ -144,6 +208,13 @@ Object::Construct (const AttributeConstructionList &attributes)
   NS_LOG_FUNCTION (this << &attributes);
   ConstructSelf (attributes);
 }
+void
+Object::Construct (const AttributeConstructionPlan &plan)
+{
+  NS_LOG_FUNCTION (this << &plan);
+  NS_ASSERT (plan.GetTypeId () == m_tid);
+  ConstructSelf (plan);
+}
 
 Ptr<Object>
 Object::DoGetObject (TypeId tid) const
@@ -210,6 +281,226 @@ Object::IsInitialized (void) const
   NS_LOG_FUNCTION (this);
   return m_initialized;
 }
+
+namespace {
+
+/**
+ * Order the Objects of an aggregate by TypeId name.
+ *
+ * \param [in] a The first Object.
+ * \param [in] b The second Object.
+ * \returns \c true if \p a comes first.
+ */
+bool
+CompareTypeNames (const Object *a, const Object *b)
+{
+  return a->GetInstanceTypeId ().GetName () < b->GetInstanceTypeId ().GetName ();
+}
+
+} // unnamed namespace
+
+void
+Object::Serialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  // the aggregate array is reordered by GetObject, so sort it.
+  std::vector<const Object *> objects (m_aggregates->buffer,
+                                       m_aggregates->buffer + m_aggregates->n);
+  std::sort (objects.begin (), objects.end (), CompareTypeNames);
+  os << objects.size () << std::endl;
+  for (std::vector<const Object *>::const_iterator i = objects.begin (); i != objects.end (); ++i)
+    {
+      std::ostringstream state;
+      (*i)->DoSerialize (state);
+      os << (*i)->GetInstanceTypeId ().GetName () << " "
+         << state.str ().size () << std::endl
+         << state.str ();
+    }
+}
+
+void
+Object::Deserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+  uint32_t n = 0;
+  is >> n;
+  NS_ABORT_MSG_UNLESS (is && n == m_aggregates->n,
+                       "Object::Deserialize(): expected " << m_aggregates->n << " objects");
+  for (uint32_t i = 0; i < n; i++)
+    {
+      std::string name;
+      std::size_t size = 0;
+      is >> name >> size;
+      is.ignore ();
+      std::string state (size, 0);
+      is.read (&state[0], size);
+      NS_ABORT_MSG_UNLESS (is, "Object::Deserialize(): truncated state of " << name);
+      Object *object = 0;
+      for (uint32_t j = 0; j < m_aggregates->n; j++)
+        {
+          if (m_aggregates->buffer[j]->GetInstanceTypeId ().GetName () == name)
+            {
+              object = m_aggregates->buffer[j];
+              break;
+            }
+        }
+      NS_ABORT_MSG_UNLESS (object != 0, "Object::Deserialize(): no object of type " << name);
+      std::istringstream stateStream (state);
+      object->DoDeserialize (stateStream);
+    }
+}
+
+Object::Arena::Arena (uint32_t n)
+  : m_n (n),
+    m_block (0)
+{
+  NS_LOG_FUNCTION (this << n);
+}
+Object::Arena::~Arena ()
+{
+  NS_LOG_FUNCTION (this);
+  if (g_armedArena == this)
+    {
+      g_armedArena = 0;
+    }
+  if (m_block != 0)
+    {
+      Release (m_block);
+    }
+}
+void
+Object::Arena::Arm (void)
+{
+  NS_LOG_FUNCTION (this);
+  g_armedArena = this;
+}
+void
+Object::Arena::Disarm (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_armedArena = 0;
+}
+void *
+Object::Arena::Allocate (std::size_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  // the Block and each Object keep the alignment.
+  const std::size_t align = alignof (std::max_align_t);
+  const std::size_t start = (sizeof (Block) + align - 1) / align * align;
+  std::size_t stride = (size + align - 1) / align * align;
+  if (m_block == 0)
+    {
+      // align the memory on a power of two at least as large, so that
+      // the Block is found by masking the address of an Object.
+      std::size_t bytes = start + m_n * stride;
+      uint8_t shift = 0;
+      while ((std::size_t (1) << shift) < std::max (bytes, sizeof (void *)))
+        {
+          shift++;
+        }
+      void *memory = 0;
+      if (posix_memalign (&memory, std::size_t (1) << shift, bytes) != 0)
+        {
+          return 0;
+        }
+      m_block = new (memory) Block;
+      m_block->live = 1;
+      m_block->stride = stride;
+      m_block->used = 0;
+      m_block->shift = shift;
+    }
+  if (m_block->stride != stride || m_block->used == m_n)
+    {
+      NS_LOG_LOGIC ("object of " << size << " bytes allocated from the heap");
+      return 0;
+    }
+  char *slot = reinterpret_cast<char *> (m_block) + start + m_block->used * stride;
+  m_block->used++;
+  m_block->live.fetch_add (1, std::memory_order_relaxed);
+  return slot;
+}
+
+void
+Object::Arena::Release (struct Block *block)
+{
+  if (block->live.fetch_sub (1, std::memory_order_acq_rel) == 1)
+    {
+      block->~Block ();
+      std::free (block);
+    }
+}
+
+void
+Object::NotifyAllocate (void)
+{
+  // the allocation of the most derived object, if it comes from
+  // operator new, is the last one of this thread, since the base
+  // classes are constructed first.
+  const char *start = static_cast<const char *> (g_lastAllocation);
+  const char *self = reinterpret_cast<const char *> (this);
+  bool allocated = start != 0 && self >= start && self < start + g_lastAllocationSize;
+  if (allocated)
+    {
+      m_arenaShift = g_lastAllocationShift;
+    }
+  if (!MemoryAccounting::IsEnabled ())
+    {
+      return;
+    }
+  uint64_t bytes = allocated ? g_lastAllocationSize : sizeof (Object);
+  MemoryAccounting::NotifyAllocate (this, MemoryAccounting::GetCategory (m_tid), bytes);
+}
+void *
+Object::operator new (std::size_t size)
+{
+  Arena *arena = g_armedArena;
+  if (arena != 0)
+    {
+      // only the next Object comes from the arena, not the Objects
+      // its constructor creates.
+      g_armedArena = 0;
+      void *p = arena->Allocate (size);
+      if (p != 0)
+        {
+          g_lastAllocation = p;
+          g_lastAllocationSize = size;
+          g_lastAllocationShift = arena->m_block->shift;
+          return p;
+        }
+    }
+  void *p = std::malloc (size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  g_lastAllocation = p;
+  g_lastAllocationSize = size;
+  g_lastAllocationShift = 0;
+  return p;
+}
+void
+Object::operator delete (void *p)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  // the destructor of the Object, which ran just before, tells
+  // whether it comes from an Arena.
+  Arena::Block *block = static_cast<Arena::Block *> (g_releasedBlock);
+  g_releasedBlock = 0;
+  if (block != 0)
+    {
+      NS_ASSERT (static_cast<char *> (p) > reinterpret_cast<char *> (block)
+                 && static_cast<char *> (p) < reinterpret_cast<char *> (block) + (std::size_t (1) << block->shift));
+      Arena::Release (block);
+    }
+  else
+    {
+      std::free (p);
+    }
+}
+
 void 
 Object::Dispose (void)
 {
@@ -340,6 +631,10 @@ Object::SetTypeId (TypeId tid)
   NS_LOG_FUNCTION (this << tid);
   NS_ASSERT (Check ());
   m_tid = tid;
+  if (MemoryAccounting::IsEnabled ())
+    {
+      MemoryAccounting::NotifyCategory (this, MemoryAccounting::GetCategory (tid));
+    }
 }
 
 void
@@ -349,6 +644,18 @@ Object::DoDispose (void)
   NS_ASSERT (!m_disposed);
 }
 
+void
+Object::DoSerialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+}
+
+void
+Object::DoDeserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+}
+
 void
 Object::DoInitialize (void)
 {
@@ -22,8 +22,11 @@
 #define OBJECT_H
 
 #include <stdint.h>
+#include <cstddef>
 #include <string>
 #include <vector>
+#include <istream>
+#include <ostream>
 #include "ptr.h"
 #include "attribute.h"
 #include "object-base.h"
@@ -226,6 +229,126 @@ private:
    */
   bool IsInitialized (void) const;
 
+  /**
+   * Save the state of this Object and of the Objects aggregated to it.
+   *
+   * This calls the virtual DoSerialize() method of each Object, in the
+   * order of their TypeId names, and frames the output of each one, so
+   * that Deserialize() can check that it is restored into an aggregate
+   * of the same types.
+   *
+   * \param [in,out] os The output stream.
+   * \sa Checkpoint
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * Restore the state saved by Serialize() into this Object and the
+   * Objects aggregated to it.
+   *
+   * \param [in,out] is The input stream.
+   * \sa Checkpoint
+   */
+  void Deserialize (std::istream &is);
+
+  /**
+   * \brief Contiguous memory for a batch of Objects of the same type.
+   *
+   * ObjectFactory::CreateN() allocates the Objects it creates from an
+   * Arena, rather than one by one from the heap.  The memory of the
+   * Arena is released once the Arena and all its Objects are deleted.
+   * An Object which does not fit in the Arena, because it is full or
+   * because its size differs from the first Object, is allocated from
+   * the heap.  The memory of an Arena is aligned on a power of two at
+   * least as large as itself, so that its header is found by masking
+   * the address of any of its Objects: each Object only records the
+   * exponent of that power, and operator delete takes no lock.
+   */
+  class Arena
+  {
+public:
+    /**
+     * Constructor.  The memory is allocated with the first Object.
+     *
+     * \param [in] n The number of Objects of the Arena.
+     */
+    Arena (uint32_t n);
+    /** Destructor. */
+    ~Arena ();
+    /**
+     * Allocate the next Object created by this thread from this Arena.
+     *
+     * The Objects created by the constructor of that Object, if any,
+     * are allocated from the heap.
+     */
+    void Arm (void);
+    /**
+     * Allocate the next Object created by this thread from the heap,
+     * if it was to be allocated from an Arena.
+     */
+    static void Disarm (void);
+private:
+    friend class Object;
+    struct Block;
+    /**
+     * Allocate an Object.
+     *
+     * \param [in] size The size of the Object.
+     * \returns The memory of the Object, or null if it does not fit.
+     */
+    void * Allocate (std::size_t size);
+    /**
+     * Release an Object, or the Arena itself.
+     *
+     * \param [in] block The memory of the Arena.
+     */
+    static void Release (struct Block *block);
+
+    /** Copying is not supported. */
+    Arena (const Arena &);
+    /**
+     * Copying is not supported.
+     * \returns The Arena.
+     */
+    Arena & operator = (const Arena &);
+
+    uint32_t m_n;             //!< The number of Objects of the Arena.
+    struct Block *m_block;    //!< The memory, or null before the first Object.
+  };
+
+  /**
+   * Allocate an Object, from the armed Arena if any.
+   *
+   * \param [in] size The size of the Object.
+   * \returns The memory of the Object.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the memory of an Object.
+   *
+   * \param [in] p The memory of the Object.
+   */
+  static void operator delete (void *p);
+  /**
+   * Construct an Object in place.
+   *
+   * \param [in] size The size of the Object.
+   * \param [in] p The memory of the Object.
+   * \returns \pname{p}
+   */
+  static void * operator new (std::size_t size, void *p)
+  {
+    return p;
+  }
+  /**
+   * Undo a placement new.
+   *
+   * \param [in] p The memory of the Object.
+   * \param [in] place The memory of the Object.
+   */
+  static void operator delete (void *p, void *place)
+  {
+  }
+
 protected:
   /**
    * Notify all Objects aggregated to this one of a new Object being
@@ -269,6 +392,29 @@ protected:
    * It is safe to call GetObject() from within this method.
    */
   virtual void DoDispose (void);
+  /**
+   * Serialize() implementation.
+   *
+   * Subclasses which take part in a Checkpoint save the state which
+   * is not set up by the simulation script, such as counters, queued
+   * packets and the time left before their pending events, and chain
+   * up to their parent's implementation first.  The default
+   * implementation saves nothing.
+   *
+   * \param [in,out] os The output stream.
+   */
+  virtual void DoSerialize (std::ostream &os) const;
+  /**
+   * Deserialize() implementation.
+   *
+   * This reads back what DoSerialize() wrote.  It is called after
+   * the pending events of the simulation have been discarded, at the
+   * time of the Checkpoint, so that the Object should schedule again
+   * its pending events.
+   *
+   * \param [in,out] is The input stream.
+   */
+  virtual void DoDeserialize (std::istream &is);
   /**
    * Copy an Object.
    *
@@ -322,6 +468,7 @@ private:
   friend class ObjectFactory;
   friend class AggregateIterator;
   friend struct ObjectDeleter;
+  friend class Resolver;
 
   /**
    * The list of Objects aggregated to this one.
@@ -388,6 +535,23 @@ private:
    * registered with the associated TypeId.
   */
   void Construct (const AttributeConstructionList &attributes);
+  /**
+   * Initialize all member variables registered as Attributes of this
+   * TypeId from a plan.
+   *
+   * \param [in] plan The attribute values resolved for the TypeId of
+   *        this Object.
+   *
+   * Invoked from ns3::ObjectFactory only.
+   */
+  void Construct (const AttributeConstructionPlan &plan);
+  /**
+   * Record the Arena of this Object, if any, and account for this
+   * Object in the MemoryAccounting, if enabled.
+   *
+   * Invoked from the constructors only.
+   */
+  void NotifyAllocate (void);
 
   /**
    * Keep the list of aggregates in most-recently-used order
@@ -435,6 +599,11 @@ private:
    * the array of aggregates in most-frequently accessed order.
    */
   uint32_t m_getObjectCount;
+  /**
+   * The exponent of the alignment of the Arena of this Object, or 0 if
+   * it was not allocated from an Arena.
+   */
+  uint8_t m_arenaShift;
 };
 
 template <typename T>
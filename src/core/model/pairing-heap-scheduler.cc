@@ -0,0 +1,257 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "pairing-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::PairingHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PairingHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (PairingHeapScheduler);
+
+namespace {
+
+/** Number of nodes allocated at once. */
+const uint32_t BLOCK_SIZE = 1024;
+
+} // unnamed namespace
+
+TypeId
+PairingHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PairingHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<PairingHeapScheduler> ()
+  ;
+  return tid;
+}
+
+PairingHeapScheduler::PairingHeapScheduler ()
+  : m_root (0),
+    m_free (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PairingHeapScheduler::~PairingHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Node *>::iterator i = m_blocks.begin (); i != m_blocks.end (); ++i)
+    {
+      delete [] *i;
+    }
+  m_blocks.clear ();
+}
+
+PairingHeapScheduler::Node *
+PairingHeapScheduler::Allocate (void)
+{
+  if (m_free == 0)
+    {
+      Node *block = new Node [BLOCK_SIZE];
+      m_blocks.push_back (block);
+      for (uint32_t i = 0; i < BLOCK_SIZE; i++)
+        {
+          block[i].next = m_free;
+          m_free = &block[i];
+        }
+    }
+  Node *node = m_free;
+  m_free = node->next;
+  node->child = 0;
+  node->next = 0;
+  node->prev = 0;
+  return node;
+}
+
+void
+PairingHeapScheduler::Release (Node *node)
+{
+  node->next = m_free;
+  m_free = node;
+}
+
+PairingHeapScheduler::Node *
+PairingHeapScheduler::Meld (Node *a, Node *b)
+{
+  if (b->ev.key < a->ev.key)
+    {
+      Node *tmp = a;
+      a = b;
+      b = tmp;
+    }
+  // b becomes the leftmost child of a.
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != 0)
+    {
+      a->child->prev = b;
+    }
+  a->child = b;
+  a->next = 0;
+  a->prev = 0;
+  return a;
+}
+
+PairingHeapScheduler::Node *
+PairingHeapScheduler::MergePairs (Node *first)
+{
+  if (first == 0)
+    {
+      return 0;
+    }
+  // first pass: meld the siblings by pairs, from left to right,
+  // and stack the results through their next pointer.
+  Node *stack = 0;
+  while (first != 0)
+    {
+      Node *a = first;
+      Node *b = a->next;
+      if (b == 0)
+        {
+          a->next = stack;
+          stack = a;
+          break;
+        }
+      first = b->next;
+      Node *pair = Meld (a, b);
+      pair->next = stack;
+      stack = pair;
+    }
+  // second pass: meld the pairs from right to left.
+  Node *root = stack;
+  stack = stack->next;
+  root->next = 0;
+  while (stack != 0)
+    {
+      Node *node = stack;
+      stack = stack->next;
+      root = Meld (root, node);
+    }
+  return root;
+}
+
+PairingHeapScheduler::Node *
+PairingHeapScheduler::Find (const Event &ev) const
+{
+  std::vector<Node *> stack;
+  if (m_root != 0)
+    {
+      stack.push_back (m_root);
+    }
+  while (!stack.empty ())
+    {
+      Node *node = stack.back ();
+      stack.pop_back ();
+      if (node->ev.key.m_uid == ev.key.m_uid)
+        {
+          return node;
+        }
+      // children are never earlier than their parent.
+      if (node->child != 0 && !(ev.key < node->ev.key))
+        {
+          stack.push_back (node->child);
+        }
+      if (node->next != 0)
+        {
+          stack.push_back (node->next);
+        }
+    }
+  return 0;
+}
+
+void
+PairingHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.key.m_ts << ev.key.m_uid);
+  Node *node = Allocate ();
+  node->ev = ev;
+  m_root = m_root == 0 ? node : Meld (m_root, node);
+}
+
+bool
+PairingHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_root == 0;
+}
+
+Scheduler::Event
+PairingHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_root->ev;
+}
+
+Scheduler::Event
+PairingHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Node *root = m_root;
+  Scheduler::Event next = root->ev;
+  m_root = MergePairs (root->child);
+  Release (root);
+  return next;
+}
+
+void
+PairingHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (!IsEmpty ());
+  Node *node = Find (ev);
+  NS_ASSERT (node != 0);
+  NS_ASSERT (ev.impl == node->ev.impl);
+  if (node == m_root)
+    {
+      RemoveNext ();
+      return;
+    }
+  // unlink the node from its siblings, then meld its children
+  // back into the heap.
+  if (node->prev->child == node)
+    {
+      node->prev->child = node->next;
+    }
+  else
+    {
+      node->prev->next = node->next;
+    }
+  if (node->next != 0)
+    {
+      node->next->prev = node->prev;
+    }
+  Node *children = MergePairs (node->child);
+  if (children != 0)
+    {
+      m_root = Meld (m_root, children);
+    }
+  Release (node);
+}
+
+} // namespace ns3
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PAIRING_HEAP_SCHEDULER_H
+#define PAIRING_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::PairingHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a pairing heap event scheduler
+ *
+ * This event scheduler implements the pairing heap of Fredman,
+ * Sedgewick, Sleator and Tarjan, with the usual two-pass pairing on
+ * removal of the root.  Insertion takes constant time, and removal of
+ * the earliest event takes amortized logarithmic time.  Since new
+ * events are merged lazily, the heap behaves well with the
+ * schedule-soon, fire-soon patterns of protocol timers.
+ *
+ * The heap nodes are recycled through a free list, so that a
+ * steady-state simulation does not allocate memory for its events.
+ * Removal of an arbitrary event needs to walk the heap to find it.
+ */
+class PairingHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  PairingHeapScheduler ();
+  /** Destructor. */
+  virtual ~PairingHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** A heap node, in the leftmost-child, right-sibling representation. */
+  struct Node
+  {
+    Scheduler::Event ev; /**< The event. */
+    Node *child;         /**< The leftmost child. */
+    Node *next;          /**< The next sibling. */
+    Node *prev;          /**< The previous sibling, or the parent of a leftmost child. */
+  };
+
+  /**
+   * Get a node from the free list.
+   *
+   * \returns A new node.
+   */
+  Node * Allocate (void);
+  /**
+   * Put a node back on the free list.
+   *
+   * \param [in] node The node.
+   */
+  void Release (Node *node);
+  /**
+   * Merge two heaps.
+   *
+   * \param [in] a The root of the first heap.
+   * \param [in] b The root of the second heap.
+   * \returns The root of the merged heap.
+   */
+  Node * Meld (Node *a, Node *b);
+  /**
+   * Merge a list of sibling heaps with the two-pass pairing.
+   *
+   * \param [in] first The first sibling.
+   * \returns The root of the merged heap.
+   */
+  Node * MergePairs (Node *first);
+  /**
+   * Find the node holding an event.
+   *
+   * \param [in] ev The event.
+   * \returns The node.
+   */
+  Node * Find (const Scheduler::Event &ev) const;
+
+  /** The root of the heap. */
+  Node *m_root;
+  /** The free list, linked through Node::next. */
+  Node *m_free;
+  /** The blocks of nodes allocated so far. */
+  std::vector<Node *> m_blocks;
+};
+
+} // namespace ns3
+
+#endif /* PAIRING_HEAP_SCHEDULER_H */
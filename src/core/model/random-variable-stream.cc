@@ -27,6 +27,7 @@
 #include "assert.h"
 #include "boolean.h"
 #include "double.h"
+#include "enum.h"
 #include "integer.h"
 #include "string.h"
 #include "pointer.h"
@@ -34,6 +35,7 @@
 #include "rng-stream.h"
 #include "rng-seed-manager.h"
 #include "unused.h"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -47,6 +49,55 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RandomVariableStream");
 
+namespace {
+
+/** The number of values of the bulk draws which need a buffer. */
+const uint32_t BULK_CHUNK = 64;
+
+/**
+ * Replace uniform values by their antithetic values.
+ *
+ * \param [in,out] u The uniform values.
+ * \param [in] n The number of values.
+ */
+void
+Reflect (double *u, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      u[i] = 1 - u[i];
+    }
+}
+
+/**
+ * Keep, in order, the values of a bulk draw which are at most a bound,
+ * as the scalar draws would reject the others.
+ *
+ * \param [in,out] values The values.
+ * \param [in] n The number of values.
+ * \param [in] bound The bound, or 0 for none.
+ * \returns The number of values kept.
+ */
+uint32_t
+KeepBounded (double *values, uint32_t n, double bound)
+{
+  if (bound == 0)
+    {
+      return n;
+    }
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (values[i] <= bound)
+        {
+          values[kept++] = values[i];
+        }
+    }
+  return kept;
+}
+
+} // unnamed namespace
+
 NS_OBJECT_ENSURE_REGISTERED (RandomVariableStream);
 
 TypeId 
@@ -110,7 +161,8 @@ RandomVariableStream::SetStream (int64_t stream)
       NS_ASSERT(nextStream <= ((1ULL)<<63));
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              nextStream,
-                             RngSeedManager::GetRun ());
+                             RngSeedManager::GetRun (),
+                             RngSeedManager::GetEngine ());
     }
   else
     {
@@ -120,7 +172,8 @@ RandomVariableStream::SetStream (int64_t stream)
       uint64_t target = base + stream;
       m_rng = new RngStream (RngSeedManager::GetSeed (),
                              target,
-                             RngSeedManager::GetRun ());
+                             RngSeedManager::GetRun (),
+                             RngSeedManager::GetEngine ());
     }
   m_stream = stream;
 }
@@ -131,6 +184,43 @@ RandomVariableStream::GetStream(void) const
   return m_stream;
 }
 
+void
+RandomVariableStream::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = GetValue ();
+    }
+}
+
+void
+RandomVariableStream::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = GetInteger ();
+    }
+}
+
+void
+RandomVariableStream::GetValuesAsIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  double buffer[BULK_CHUNK];
+  for (uint32_t done = 0; done < n; )
+    {
+      uint32_t todo = std::min (n - done, BULK_CHUNK);
+      GetValues (buffer, todo);
+      for (uint32_t i = 0; i < todo; i++)
+        {
+          values[done + i] = (uint32_t)buffer[i];
+        }
+      done += todo;
+    }
+}
+
 RngStream *
 RandomVariableStream::Peek(void) const
 {
@@ -208,6 +298,56 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  double range = m_max - m_min;
+  if (IsAntithetic ())
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          values[i] = m_min + (m_max - (m_min + values[i] * range));
+        }
+    }
+  else
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          values[i] = m_min + values[i] * range;
+        }
+    }
+}
+void
+UniformRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // the casts of GetValue (m_min, m_max + 1).
+  double max = m_max + 1;
+  double range = max - m_min;
+  double buffer[BULK_CHUNK];
+  for (uint32_t done = 0; done < n; )
+    {
+      uint32_t todo = std::min (n - done, BULK_CHUNK);
+      Peek ()->RandU01 (buffer, todo);
+      if (IsAntithetic ())
+        {
+          for (uint32_t i = 0; i < todo; i++)
+            {
+              values[done + i] = (uint32_t)(m_min + (max - (m_min + buffer[i] * range)));
+            }
+        }
+      else
+        {
+          for (uint32_t i = 0; i < todo; i++)
+            {
+              values[done + i] = (uint32_t)(m_min + buffer[i] * range);
+            }
+        }
+      done += todo;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
@@ -445,6 +585,34 @@ ExponentialRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_bound);
 }
+void
+ExponentialRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // draw one uniform value for each value still missing, so that we
+  // never draw past the uniform values of the scalar calls.
+  for (uint32_t done = 0; done < n; )
+    {
+      double *u = values + done;
+      uint32_t todo = n - done;
+      Peek ()->RandU01 (u, todo);
+      if (IsAntithetic ())
+        {
+          Reflect (u, todo);
+        }
+      for (uint32_t i = 0; i < todo; i++)
+        {
+          u[i] = -m_mean*std::log (u[i]);
+        }
+      done += KeepBounded (u, todo, m_bound);
+    }
+}
+void
+ExponentialRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValuesAsIntegers (values, n);
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
@@ -564,6 +732,34 @@ ParetoRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_scale, m_shape, m_bound);
 }
+void
+ParetoRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // draw one uniform value for each value still missing, so that we
+  // never draw past the uniform values of the scalar calls.
+  for (uint32_t done = 0; done < n; )
+    {
+      double *u = values + done;
+      uint32_t todo = n - done;
+      Peek ()->RandU01 (u, todo);
+      if (IsAntithetic ())
+        {
+          Reflect (u, todo);
+        }
+      for (uint32_t i = 0; i < todo; i++)
+        {
+          u[i] = (m_scale * ( 1.0 / std::pow (u[i], 1.0 / m_shape)));
+        }
+      done += KeepBounded (u, todo, m_bound);
+    }
+}
+void
+ParetoRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValuesAsIntegers (values, n);
+}
 
 NS_OBJECT_ENSURE_REGISTERED(WeibullRandomVariable);
 
@@ -658,6 +854,158 @@ WeibullRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_scale, m_shape, m_bound);
 }
+void
+WeibullRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // draw one uniform value for each value still missing, so that we
+  // never draw past the uniform values of the scalar calls.
+  for (uint32_t done = 0; done < n; )
+    {
+      double *u = values + done;
+      uint32_t todo = n - done;
+      Peek ()->RandU01 (u, todo);
+      if (IsAntithetic ())
+        {
+          Reflect (u, todo);
+        }
+      double exponent = 1.0 / m_shape;
+      for (uint32_t i = 0; i < todo; i++)
+        {
+          u[i] = m_scale * std::pow ( -std::log (u[i]), exponent);
+        }
+      done += KeepBounded (u, todo, m_bound);
+    }
+}
+void
+WeibullRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValuesAsIntegers (values, n);
+}
+
+namespace {
+
+/**
+ * The uniform values drawn by the ziggurat method: the values of a bulk
+ * draw, then the next values of the stream.
+ */
+class ZigguratUniforms
+{
+public:
+  /**
+   * Constructor.
+   *
+   * \param [in] rng The stream.
+   * \param [in] antithetic Whether to return the antithetic values.
+   * \param [in] u The values of a bulk draw.
+   * \param [in] n The number of values of the bulk draw.
+   */
+  ZigguratUniforms (RngStream *rng, bool antithetic, const double *u = 0, uint32_t n = 0)
+    : m_rng (rng),
+      m_antithetic (antithetic),
+      m_next (u),
+      m_end (u + n)
+  {
+  }
+  /** \returns The next uniform value. */
+  double Next (void)
+  {
+    double u = m_next != m_end ? *m_next++ : m_rng->RandU01 ();
+    return m_antithetic ? 1 - u : u;
+  }
+  /** \returns \c true if the values of the bulk draw are used up. */
+  bool IsEmpty (void) const
+  {
+    return m_next == m_end;
+  }
+private:
+  RngStream *m_rng;      //!< The stream.
+  bool m_antithetic;     //!< Whether to return the antithetic values.
+  const double *m_next;  //!< The next value of the bulk draw.
+  const double *m_end;   //!< The end of the bulk draw.
+};
+
+/** The tables of the 128 layers of the ziggurat. */
+struct ZigguratTables
+{
+  ZigguratTables ();
+  uint32_t k[128];  //!< The magnitudes of the layers' rectangles.
+  double w[128];    //!< The widths of the layers, per unit magnitude.
+  double f[128];    //!< The density at the layers' edges.
+};
+
+/** The right edge of the base layer. */
+const double ZIGGURAT_R = 3.442619855899;
+
+ZigguratTables::ZigguratTables ()
+{
+  // G. Marsaglia and W. W. Tsang, "The Ziggurat Method for Generating
+  // Random Variables", Journal of Statistical Software 5(8), 2000.
+  const double m = 2147483648.0;
+  const double v = 9.91256303526217e-3;
+  double dn = ZIGGURAT_R;
+  double tn = dn;
+  double q = v / std::exp (-0.5 * dn * dn);
+  k[0] = (uint32_t)((dn / q) * m);
+  k[1] = 0;
+  w[0] = q / m;
+  w[127] = dn / m;
+  f[0] = 1.0;
+  f[127] = std::exp (-0.5 * dn * dn);
+  for (int i = 126; i >= 1; i--)
+    {
+      dn = std::sqrt (-2.0 * std::log (v / dn + std::exp (-0.5 * dn * dn)));
+      k[i + 1] = (uint32_t)((dn / tn) * m);
+      tn = dn;
+      f[i] = std::exp (-0.5 * dn * dn);
+      w[i] = dn / m;
+    }
+}
+
+/**
+ * Draw a standard normal value with the ziggurat method.
+ *
+ * \param [in] uniforms The uniform values.
+ * \returns The normal value.
+ */
+double
+Ziggurat (ZigguratUniforms &uniforms)
+{
+  static const ZigguratTables tables;
+  while (1)
+    {
+      // the 32 bits of a uniform value select the layer, the sign and
+      // the abscissa.
+      int32_t hz = (int32_t)(uint32_t)(uniforms.Next () * 4294967296.0);
+      uint32_t iz = hz & 127;
+      uint32_t magnitude = hz < 0 ? 0 - (uint32_t)hz : (uint32_t)hz;
+      if (magnitude < tables.k[iz])
+        {
+          return hz * tables.w[iz];
+        }
+      if (iz == 0)
+        {
+          // the tail, beyond the base layer.
+          double x, y;
+          do
+            {
+              x = -std::log (uniforms.Next ()) / ZIGGURAT_R;
+              y = -std::log (uniforms.Next ());
+            }
+          while (y + y < x * x);
+          return hz > 0 ? ZIGGURAT_R + x : -ZIGGURAT_R - x;
+        }
+      // the wedge of the layer, under the density.
+      double x = hz * tables.w[iz];
+      if (tables.f[iz] + uniforms.Next () * (tables.f[iz - 1] - tables.f[iz]) < std::exp (-0.5 * x * x))
+        {
+          return x;
+        }
+    }
+}
+
+} // unnamed namespace
 
 NS_OBJECT_ENSURE_REGISTERED(NormalRandomVariable);
 
@@ -682,12 +1030,19 @@ NormalRandomVariable::GetTypeId (void)
 		  DoubleValue(INFINITE_VALUE),
 		  MakeDoubleAccessor(&NormalRandomVariable::m_bound),
 		  MakeDoubleChecker<double>())
+    .AddAttribute("Algorithm", "The method which draws the values: the polar method, "
+                  "or the faster ziggurat method, which draws other values for the same stream.",
+		  EnumValue(POLAR),
+		  MakeEnumAccessor(&NormalRandomVariable::m_algorithm),
+		  MakeEnumChecker(POLAR, "Polar",
+                                  ZIGGURAT, "Ziggurat"))
     ;
   return tid;
 }
 NormalRandomVariable::NormalRandomVariable ()
   :
-  m_nextValid (false)
+  m_nextValid (false),
+  m_algorithm (POLAR)
 {
   // m_mean, m_variance, and m_bound are initialized after constructor
   // by attributes
@@ -717,6 +1072,18 @@ double
 NormalRandomVariable::GetValue (double mean, double variance, double bound)
 {
   NS_LOG_FUNCTION (this << mean << variance << bound);
+  if (m_algorithm == ZIGGURAT)
+    {
+      while (1)
+        {
+          ZigguratUniforms uniforms (Peek (), IsAntithetic ());
+          double x = mean + Ziggurat (uniforms) * std::sqrt (variance);
+          if (std::fabs (x - mean) <= bound)
+            {
+              return x;
+            }
+        }
+    }
   if (m_nextValid)
     { // use previously generated
       m_nextValid = false;
@@ -778,6 +1145,85 @@ NormalRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mean, m_variance, m_bound);
 }
+void
+NormalRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  double sd = std::sqrt (m_variance);
+  uint32_t done = 0;
+  if (m_algorithm == ZIGGURAT)
+    {
+      // each value draws at least one uniform value: draw one for each
+      // value still missing, and the next ones from the stream.
+      while (done < n)
+        {
+          Peek ()->RandU01 (values + done, n - done);
+          ZigguratUniforms uniforms (Peek (), IsAntithetic (), values + done, n - done);
+          while (done < n && !uniforms.IsEmpty ())
+            {
+              double x = m_mean + Ziggurat (uniforms) * sd;
+              if (std::fabs (x - m_mean) <= m_bound)
+                {
+                  values[done++] = x;
+                }
+            }
+        }
+      return;
+    }
+  if (n > 0 && m_nextValid)
+    {
+      m_nextValid = false;
+      values[done++] = m_next;
+    }
+  // each pair of uniform values gives at most two values: draw a pair
+  // for every two values still missing, and keep the second value of
+  // the last pair for the next call, as GetValue() does.
+  double u[2 * BULK_CHUNK];
+  while (done < n)
+    {
+      uint32_t pairs = std::min ((n - done + 1) / 2, BULK_CHUNK);
+      Peek ()->RandU01 (u, 2 * pairs);
+      if (IsAntithetic ())
+        {
+          Reflect (u, 2 * pairs);
+        }
+      for (uint32_t i = 0; i < pairs; i++)
+        {
+          double v1 = 2 * u[2 * i] - 1;
+          double v2 = 2 * u[2 * i + 1] - 1;
+          double w = v1 * v1 + v2 * v2;
+          if (w > 1.0)
+            {
+              continue;
+            }
+          double y = std::sqrt ((-2 * std::log (w)) / w);
+          double x1 = m_mean + v1 * y * sd;
+          double x2 = m_mean + v2 * y * sd;
+          if (std::fabs (x1 - m_mean) <= m_bound)
+            {
+              values[done++] = x1;
+            }
+          if (std::fabs (x2 - m_mean) <= m_bound)
+            {
+              if (done < n)
+                {
+                  values[done++] = x2;
+                }
+              else
+                {
+                  m_next = x2;
+                  m_nextValid = true;
+                }
+            }
+        }
+    }
+}
+void
+NormalRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValuesAsIntegers (values, n);
+}
 
 NS_OBJECT_ENSURE_REGISTERED(LogNormalRandomVariable);
 
@@ -898,6 +1344,41 @@ LogNormalRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_mu, m_sigma);
 }
+void
+LogNormalRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  // each value draws at least a pair of uniform values: draw a pair
+  // for each value still missing.
+  double u[2 * BULK_CHUNK];
+  for (uint32_t done = 0; done < n; )
+    {
+      uint32_t pairs = std::min (n - done, BULK_CHUNK);
+      Peek ()->RandU01 (u, 2 * pairs);
+      if (IsAntithetic ())
+        {
+          Reflect (u, 2 * pairs);
+        }
+      for (uint32_t i = 0; i < pairs; i++)
+        {
+          double v1 = -1 + 2 * u[2 * i];
+          double v2 = -1 + 2 * u[2 * i + 1];
+          double r2 = v1 * v1 + v2 * v2;
+          if (r2 > 1.0 || r2 == 0)
+            {
+              continue;
+            }
+          double normal = v1 * std::sqrt (-2.0 * std::log (r2) / r2);
+          values[done++] = std::exp (m_sigma * normal + m_mu);
+        }
+    }
+}
+void
+LogNormalRandomVariable::GetIntegers (uint32_t *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  GetValuesAsIntegers (values, n);
+}
 
 NS_OBJECT_ENSURE_REGISTERED(GammaRandomVariable);
 
@@ -1559,12 +2040,26 @@ EmpiricalRandomVariable::GetTypeId (void)
     .SetParent<RandomVariableStream>()
     .SetGroupName ("Core")
     .AddConstructor<EmpiricalRandomVariable> ()
+    .AddAttribute("Interpolate", "Whether to interpolate between the CDF points, "
+                  "or to draw the values of the points only.",
+		  BooleanValue(true),
+		  MakeBooleanAccessor(&EmpiricalRandomVariable::m_interpolate),
+		  MakeBooleanChecker())
+    .AddAttribute("Sampling", "How to find the values: search the CDF points, "
+                  "or look them up in an inverse-CDF grid, or an alias table "
+                  "for the discrete distribution, in constant time.",
+		  EnumValue(SEARCH),
+		  MakeEnumAccessor(&EmpiricalRandomVariable::m_sampling),
+		  MakeEnumChecker(SEARCH, "Search",
+                                  TABLE, "Table"))
     ;
   return tid;
 }
 EmpiricalRandomVariable::EmpiricalRandomVariable ()
   :
-  validated (false)
+  validated (false),
+  m_interpolate (true),
+  m_sampling (SEARCH)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -1590,6 +2085,65 @@ EmpiricalRandomVariable::GetValue (void)
     {
       r = (1 - r);
     }
+  return Sample (r);
+}
+
+void
+EmpiricalRandomVariable::GetValues (double *values, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  if (emp.size () == 0)
+    {
+      for (uint32_t i = 0; i < n; i++)
+        {
+          values[i] = 0.0;
+        }
+      return;
+    }
+  if (!validated)
+    {
+      Validate ();
+    }
+  Peek ()->RandU01 (values, n);
+  if (IsAntithetic ())
+    {
+      Reflect (values, n);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      values[i] = Sample (values[i]);
+    }
+}
+
+double
+EmpiricalRandomVariable::Sample (double r)
+{
+  if (!m_interpolate)
+    {
+      if (m_sampling == TABLE)
+        {
+          // a column of the alias table, and a uniform value within it.
+          double column = r * m_alias.size ();
+          uint32_t j = std::min ((uint32_t)column, (uint32_t)(m_alias.size () - 1));
+          return emp[column - j < m_aliasProbability[j] ? j : m_alias[j]].value;
+        }
+      // the first point whose CDF reaches r, or the last point.
+      std::vector<ValueCDF>::size_type bottom = 0;
+      std::vector<ValueCDF>::size_type top = emp.size () - 1;
+      while (bottom < top)
+        {
+          std::vector<ValueCDF>::size_type c = (top + bottom) / 2;
+          if (emp[c].cdf < r)
+            {
+              bottom = c + 1;
+            }
+          else
+            {
+              top = c;
+            }
+        }
+      return emp[bottom].value;
+    }
 
   if (r <= emp.front ().cdf)
     {
@@ -1599,28 +2153,64 @@ EmpiricalRandomVariable::GetValue (void)
     {
       return emp.back ().value;  // Greater than last
     }
-  // Binary search
-  std::vector<ValueCDF>::size_type bottom = 0;
-  std::vector<ValueCDF>::size_type top = emp.size () - 1;
-  while (1)
+  std::vector<ValueCDF>::size_type c;
+  if (m_sampling == TABLE)
     {
-      std::vector<ValueCDF>::size_type c = (top + bottom) / 2;
-      if (r >= emp[c].cdf && r < emp[c + 1].cdf)
-        { // Found it
-          return Interpolate (emp[c].cdf, emp[c + 1].cdf,
-                              emp[c].value, emp[c + 1].value,
-                              r);
+      // the grid gives the segments at the start and at the end of the
+      // cell of r: search the points within the cell, which are few
+      // unless many points fall in a small range of probabilities.
+      uint32_t k = std::min ((uint32_t)(r * m_grid.size ()), (uint32_t)(m_grid.size () - 1));
+      std::vector<ValueCDF>::size_type bottom = m_grid[k];
+      std::vector<ValueCDF>::size_type top = (k + 1 < m_grid.size ()) ? m_grid[k + 1] : emp.size () - 2;
+      while (bottom < top)
+        {
+          std::vector<ValueCDF>::size_type middle = (bottom + top + 1) / 2;
+          if (emp[middle].cdf <= r)
+            {
+              bottom = middle;
+            }
+          else
+            {
+              top = middle - 1;
+            }
         }
-      // Not here, adjust bounds
-      if (r < emp[c].cdf)
+      c = bottom;
+      // r may be rounded across the bounds of its cell.
+      while (c > 0 && r < emp[c].cdf)
         {
-          top    = c - 1;
+          c--;
         }
-      else
+      while (r >= emp[c + 1].cdf)
         {
-          bottom = c + 1;
+          c++;
         }
     }
+  else
+    {
+      // Binary search
+      std::vector<ValueCDF>::size_type bottom = 0;
+      std::vector<ValueCDF>::size_type top = emp.size () - 1;
+      while (1)
+        {
+          c = (top + bottom) / 2;
+          if (r >= emp[c].cdf && r < emp[c + 1].cdf)
+            { // Found it
+              break;
+            }
+          // Not here, adjust bounds
+          if (r < emp[c].cdf)
+            {
+              top    = c - 1;
+            }
+          else
+            {
+              bottom = c + 1;
+            }
+        }
+    }
+  return Interpolate (emp[c].cdf, emp[c + 1].cdf,
+                      emp[c].value, emp[c + 1].value,
+                      r);
 }
 
 uint32_t 
@@ -1635,6 +2225,7 @@ void EmpiricalRandomVariable::CDF (double v, double c)
   // NOTE.   These MUST be inserted in non-decreasing order
   NS_LOG_FUNCTION (this << v << c);
   emp.push_back (ValueCDF (v, c));
+  validated = false;
 }
 
 void EmpiricalRandomVariable::Validate ()
@@ -1655,9 +2246,74 @@ void EmpiricalRandomVariable::Validate ()
         }
       prior = current;
     }
+  BuildGrid ();
+  BuildAliasTable ();
   validated = true;
 }
 
+void
+EmpiricalRandomVariable::BuildGrid (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_grid.clear ();
+  if (emp.size () < 2)
+    {
+      return;
+    }
+  // a few cells per point, so that few points fall in each cell.
+  uint32_t cells = 4 * emp.size ();
+  m_grid.resize (cells);
+  std::vector<ValueCDF>::size_type c = 0;
+  for (uint32_t k = 0; k < cells; k++)
+    {
+      double start = (double)k / cells;
+      while (c + 2 < emp.size () && emp[c + 1].cdf <= start)
+        {
+          c++;
+        }
+      m_grid[k] = c;
+    }
+}
+
+void
+EmpiricalRandomVariable::BuildAliasTable (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Vose's method: each column holds the probability of its point, and
+  // the rest of the column is filled by a point with a larger probability.
+  uint32_t n = emp.size ();
+  m_aliasProbability.assign (n, 1.0);
+  m_alias.resize (n);
+  std::vector<double> scaled (n);
+  double below = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // the search returns the last point for the rest of the uniform values.
+      double cdf = i + 1 < n ? std::min (emp[i].cdf, 1.0) : 1.0;
+      scaled[i] = (cdf - below) * n;
+      below = cdf;
+      m_alias[i] = i;
+    }
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      (scaled[i] < 1.0 ? small : large).push_back (i);
+    }
+  while (!small.empty () && !large.empty ())
+    {
+      uint32_t s = small.back ();
+      small.pop_back ();
+      uint32_t l = large.back ();
+      large.pop_back ();
+      m_aliasProbability[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+      (scaled[l] < 1.0 ? small : large).push_back (l);
+    }
+  // the columns left are full, up to the rounding errors.
+}
+
 double EmpiricalRandomVariable::Interpolate (double c1, double c2,
                                            double v1, double v2, double r)
 { // Interpolate random value in range [v1..v2) based on [c1 .. r .. c2)
@@ -149,12 +149,44 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next random values drawn from the distribution.
+   *
+   * This draws the same values as \p n calls of GetValue(void), in a
+   * single call; the distributions which can draw their values in bulk
+   * override it.
+   *
+   * \param [out] values The random values.
+   * \param [in] n The number of values.
+   */
+  virtual void GetValues (double *values, uint32_t n);
+
+  /**
+   * \brief Get the next random integer values drawn from the distribution.
+   *
+   * This draws the same values as \p n calls of GetInteger(void), in a
+   * single call.
+   *
+   * \param [out] values The random values.
+   * \param [in] n The number of values.
+   */
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RNG stream.
    */
   RngStream *Peek(void) const;
 
+  /**
+   * \brief Draw the integer values as the casts of GetValues(), for the
+   * distributions whose GetInteger(void) casts GetValue(void).
+   *
+   * \param [out] values The random values.
+   * \param [in] n The number of values.
+   */
+  void GetValuesAsIntegers (uint32_t *values, uint32_t n);
+
 private:
   /**
    * Copy constructor.  These objects are not copyable.
@@ -293,6 +325,8 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -585,6 +619,8 @@ public:
   // Inherited from RandomVariableStream
   virtual double GetValue (void);
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
 
 private:
   /** The mean value of the unbounded exponential distribution. */
@@ -790,6 +826,8 @@ public:
    * which now involves the distance \f$u\f$ is from 1 in the denominator.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
 
 private:
   /** The mean parameter for the Pareto distribution returned by this RNG stream. */
@@ -999,6 +1037,8 @@ public:
    * which now involves the log of the distance \f$u\f$ is from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
 
 private:
   /** The scale parameter for the Weibull distribution returned by this RNG stream. */
@@ -1045,6 +1085,12 @@ private:
  *   // normally distributed random variable is equal to mean.
  *   double value = x->GetValue ();
  * \endcode
+ *
+ * The values are drawn with the polar method by default.  The Algorithm
+ * attribute selects the ziggurat method of Marsaglia and Tsang instead,
+ * which draws most values from a single uniform value, with a table
+ * lookup and a multiplication, but draws other values than the polar
+ * method for the same stream.
  */
 class NormalRandomVariable : public RandomVariableStream
 {
@@ -1052,6 +1098,13 @@ public:
   /** Large constant to bound the range. */
   static const double INFINITE_VALUE;
 
+  /** The method which draws the normal values. */
+  enum Algorithm
+  {
+    POLAR,      //!< The polar method, which draws the values in pairs.
+    ZIGGURAT    //!< The ziggurat method of Marsaglia and Tsang.
+  };
+
   /**
    * \brief Register this type.
    * \return The object TypeId.
@@ -1232,6 +1285,8 @@ public:
    * which now involves the distances \f$u1\f$ and \f$u2\f$ are from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
 
 private:
   /** The mean value for the normal distribution returned by this RNG stream. */
@@ -1249,6 +1304,9 @@ private:
   /** The algorithm produces two values at a time. */
   double m_next;
 
+  /** The method which draws the values. */
+  enum Algorithm m_algorithm;
+
 };  // class NormalRandomVariable
 
   
@@ -1462,6 +1520,8 @@ public:
    * which now involves the distances \f$u1\f$ and \f$u2\f$ are from 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
+  virtual void GetIntegers (uint32_t *values, uint32_t n);
 
 private:
   /** The mu value for the log-normal distribution returned by this RNG stream. */
@@ -2437,6 +2497,23 @@ private:
  *   //                          
  *   double value = x->GetValue ();
  * \endcode
+ *
+ * When the Interpolate attribute is \c false, the distribution is
+ * discrete instead: each point has the probability of its step of the
+ * CDF, and the values returned are the values of the points.
+ *
+ * By default, each value searches the CDF points, in a time which grows
+ * with the log of the number of points.  The Sampling attribute selects
+ * tables instead, built once when the CDF is validated by the first
+ * value, which find the values in a time independent of the number of
+ * points: a grid of the inverse CDF, which leads to the few points
+ * around each uniform value, when interpolating, and the alias table
+ * of Walker and Vose for the discrete distribution.  The grid has four
+ * cells per point, and its cells are searched, so that a CDF with many
+ * points in a small range of probabilities is never found slower than
+ * with the search of all the points.  The grid gives the values
+ * of the search; the alias table gives the same distribution, but other
+ * values for the same stream.
  */
 class EmpiricalRandomVariable : public RandomVariableStream
 {
@@ -2447,6 +2524,13 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /** How the values are found from the uniform values. */
+  enum Sampling
+  {
+    SEARCH,   //!< Binary search of the CDF points.
+    TABLE     //!< An inverse-CDF grid, or an alias table.
+  };
+
   /**
    * \brief Creates an empirical RNG that has a specified, empirical
    * distribution.
@@ -2485,6 +2569,7 @@ public:
    * which is the distance \f$u\f$ is from the 1.
    */
   virtual uint32_t GetInteger (void);
+  virtual void GetValues (double *values, uint32_t n);
 
 private:
   /** Helper to hold one point of the CDF. */
@@ -2536,12 +2621,37 @@ public:
    */
   virtual double Interpolate (double c1, double c2,
                               double v1, double v2, double r);
+  /**
+   * Get the value of a uniform value.
+   *
+   * \param [in] r The uniform value.
+   * \returns The value of the distribution.
+   */
+  double Sample (double r);
+  /** Build the inverse-CDF grid of the interpolated distribution. */
+  void BuildGrid (void);
+  /** Build the alias table of the discrete distribution. */
+  void BuildAliasTable (void);
   
   /** \c true once the CDF has been validated. */
   bool validated;
   /** The vector of CDF points. */
   std::vector<ValueCDF> emp; 
 
+  /** Whether to interpolate between the CDF points. */
+  bool m_interpolate;
+  /** How the values are found. */
+  enum Sampling m_sampling;
+  /**
+   * The inverse-CDF grid: the segment of the CDF points in which each
+   * cell of the uniform values starts.
+   */
+  std::vector<uint32_t> m_grid;
+  /** The probability of each column of the alias table to keep its point. */
+  std::vector<double> m_aliasProbability;
+  /** The other point of each column of the alias table. */
+  std::vector<uint32_t> m_alias;
+
 };  // class EmpiricalRandomVariable
   
 
@@ -25,15 +25,20 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "object-factory.h"
 #include "assert.h"
 #include "fatal-error.h"
 #include "log.h"
 #include "system-mutex.h"
 #include "boolean.h"
 #include "enum.h"
+#include "uinteger.h"
+#include "nstime.h"
+#include "trace-source-accessor.h"
 
 
 #include <cmath>
+#include <algorithm>
 
 
 /**
@@ -69,6 +74,49 @@ RealtimeSimulatorImpl::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&RealtimeSimulatorImpl::m_hardLimit),
                    MakeTimeChecker ())
+    .AddAttribute ("CrossThreadEvents",
+                   "The number of events scheduled from other threads.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RealtimeSimulatorImpl::GetCrossThreadEvents),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("CrossThreadQueueDepth",
+                   "The number of events scheduled from other threads "
+                   "and not yet moved to the event queue.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RealtimeSimulatorImpl::GetCrossThreadQueueDepth),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("MaxCrossThreadQueueDepth",
+                   "The largest number of events scheduled from other threads "
+                   "found when moving them to the event queue.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RealtimeSimulatorImpl::GetMaxCrossThreadQueueDepth),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("SynchronizerType",
+                   "The type of the Synchronizer which paces the simulation.",
+                   TypeIdValue (WallClockSynchronizer::GetTypeId ()),
+                   MakeTypeIdAccessor (&RealtimeSimulatorImpl::SetSynchronizerType,
+                                       &RealtimeSimulatorImpl::GetSynchronizerType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("LatenessReportInterval",
+                   "The simulation time between the reports of the "
+                   "LatenessHistogram trace source, or 0 to report it "
+                   "only at the end of Run.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RealtimeSimulatorImpl::m_latenessReportInterval),
+                   MakeTimeChecker (Time (0)))
+    .AddTraceSource ("Lateness",
+                     "The lateness of each event: the real time at which "
+                     "it is executed minus its simulation time.",
+                     MakeTraceSourceAccessor (&RealtimeSimulatorImpl::m_latenessTrace),
+                     "ns3::RealtimeSimulatorImpl::LatenessCallback")
+    .AddTraceSource ("LatenessHistogram",
+                     "The histogram of the lateness of the events of each "
+                     "LatenessReportInterval, see GetLatenessHistogram.",
+                     MakeTraceSourceAccessor (&RealtimeSimulatorImpl::m_latenessHistogramTrace),
+                     "ns3::RealtimeSimulatorImpl::LatenessHistogramCallback")
   ;
   return tid;
 }
@@ -90,6 +138,11 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_maxEventsWithContext = 0;
+  m_lateness.resize (LATENESS_BINS, 0);
+  m_latenessReport.resize (LATENESS_BINS, 0);
+  m_maxLateness = 0;
+  m_nextLatenessReport = 0;
 
   m_main = SystemThread::Self();
 
@@ -107,6 +160,11 @@ void
 RealtimeSimulatorImpl::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      event.event->Unref ();
+    }
   while (!m_events->IsEmpty ())
     {
       Scheduler::Event next = m_events->RemoveNext ();
@@ -229,6 +287,14 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         // tsNext is the simulation time of the next event we want to execute.
         //
         tsNow = m_synchronizer->GetCurrentRealtime ();
+        //
+        // The events scheduled from other threads are only moved to the
+        // event list here, after the synchronizer condition has been
+        // reset: a thread which schedules an event after this point will
+        // interrupt the wait below with its Signal ().
+        //
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
         tsNext = NextTs ();
 
         //
@@ -255,8 +321,9 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
         // to work with the synchronizer to make sure we're awakened if something 
         // external happens (like a packet is received).  This next line resets
         // the synchronizer so that any future event will cause it to interrupt.
+        // This was done above, before looking at the events scheduled from
+        // other threads.
         //
-        m_synchronizer->SetCondition (false);
       }
 
       //
@@ -316,6 +383,7 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   // whatever event is at the head of this list if the list is in time order.
   //
   Scheduler::Event next;
+  uint64_t tsLate;
 
   { 
     CriticalSection cs (m_mutex);
@@ -359,9 +427,10 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
     // We check the simulation time against the current real time to make this
     // judgement.
     //
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    tsLate = tsFinal > m_currentTs ? tsFinal - m_currentTs : 0;
     if (m_synchronizationMode == SYNC_HARD_LIMIT)
       {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
         uint64_t tsJitter;
 
         if (tsFinal >= m_currentTs)
@@ -386,6 +455,8 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
   // event list so we can execute it outside a critical section without fear of someone
   // changing things out from under us.
 
+  RecordLateness (tsLate);
+
   EventImpl *event = next.impl;
   m_synchronizer->EventStart ();
   event->Invoke ();
@@ -405,6 +476,55 @@ RealtimeSimulatorImpl::IsFinished (void) const
   return rc;
 }
 
+void
+RealtimeSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContext.IsEmpty ())
+    {
+      return;
+    }
+
+  m_maxEventsWithContext = std::max (m_maxEventsWithContext, m_eventsWithContext.GetSize ());
+  EventWithContext event;
+  while (m_eventsWithContext.Pop (event))
+    {
+      //
+      // If the simulator is running, we're pacing and have a meaningful 
+      // realtime clock.  If we're not, then m_currentTs is where we stopped.
+      // The event may have waited in the queue while an event was run
+      // ahead of real time: never schedule in the past.
+      // 
+      uint64_t ts = m_running ? event.realtime : m_currentTs;
+      ts = std::max (ts + event.delay, m_currentTs);
+      Scheduler::Event ev;
+      ev.impl = event.event;
+      ev.key.m_ts = ts;
+      ev.key.m_context = event.context;
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_unscheduledEvents++;
+      m_events->Insert (ev);
+    }
+}
+
+uint64_t
+RealtimeSimulatorImpl::GetCrossThreadEvents (void) const
+{
+  return m_eventsWithContext.GetPushCount ();
+}
+
+uint64_t
+RealtimeSimulatorImpl::GetCrossThreadQueueDepth (void) const
+{
+  return m_eventsWithContext.GetSize ();
+}
+
+uint64_t
+RealtimeSimulatorImpl::GetMaxCrossThreadQueueDepth (void) const
+{
+  return m_maxEventsWithContext;
+}
+
 //
 // Peeks into event list.  Should be called with critical section locked.
 //
@@ -429,8 +549,14 @@ RealtimeSimulatorImpl::Run (void)
   m_main = SystemThread::Self();
 
   m_stop = false;
+  {
+    // the events queued by other threads before Run are relative to m_currentTs.
+    CriticalSection cs (m_mutex);
+    ProcessEventsWithContext ();
+  }
   m_running = true;
   m_synchronizer->SetOrigin (m_currentTs);
+  m_nextLatenessReport = m_currentTs + m_latenessReportInterval.GetTimeStep ();
 
   // Sleep until signalled
   uint64_t tsNow;
@@ -442,6 +568,8 @@ RealtimeSimulatorImpl::Run (void)
       {
         CriticalSection cs (m_mutex);
 
+        m_synchronizer->SetCondition (false);
+        ProcessEventsWithContext ();
         if (!m_events->IsEmpty ())
           {
             process = true;
@@ -476,9 +604,81 @@ RealtimeSimulatorImpl::Run (void)
                    "RealtimeSimulatorImpl::Run(): Empty queue and unprocessed events");
   }
 
+  ReportLateness ();
   m_running = false;
 }
 
+void
+RealtimeSimulatorImpl::RecordLateness (uint64_t tsLate)
+{
+  Time lateness = TimeStep (tsLate);
+  uint64_t ns = lateness.GetNanoSeconds ();
+  uint32_t bin = 0;
+  while (ns != 0 && bin < LATENESS_BINS - 1)
+    {
+      ns >>= 1;
+      bin++;
+    }
+  m_lateness[bin]++;
+  m_latenessReport[bin]++;
+  m_maxLateness = std::max (m_maxLateness, tsLate);
+  m_latenessTrace (lateness);
+  if (m_latenessReportInterval.IsStrictlyPositive ()
+      && m_currentTs >= m_nextLatenessReport)
+    {
+      ReportLateness ();
+      m_nextLatenessReport = m_currentTs + m_latenessReportInterval.GetTimeStep ();
+    }
+}
+
+void
+RealtimeSimulatorImpl::ReportLateness (void)
+{
+  uint64_t events = 0;
+  for (uint32_t i = 0; i < LATENESS_BINS; i++)
+    {
+      events += m_latenessReport[i];
+    }
+  if (events == 0)
+    {
+      return;
+    }
+  m_latenessHistogramTrace (m_latenessReport);
+  std::fill (m_latenessReport.begin (), m_latenessReport.end (), 0);
+}
+
+std::vector<uint64_t>
+RealtimeSimulatorImpl::GetLatenessHistogram (void) const
+{
+  return m_lateness;
+}
+
+Time
+RealtimeSimulatorImpl::GetMaxLateness (void) const
+{
+  return TimeStep (m_maxLateness);
+}
+
+void
+RealtimeSimulatorImpl::SetSynchronizerType (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  NS_ASSERT_MSG (!m_running, "RealtimeSimulatorImpl::SetSynchronizerType(): Simulator running");
+  if (m_synchronizer != 0 && m_synchronizer->GetInstanceTypeId () == tid)
+    {
+      return;
+    }
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  m_synchronizer = factory.Create<Synchronizer> ();
+}
+
+TypeId
+RealtimeSimulatorImpl::GetSynchronizerType (void) const
+{
+  return m_synchronizer->GetInstanceTypeId ();
+}
+
 bool
 RealtimeSimulatorImpl::Running (void) const
 {
@@ -543,23 +743,26 @@ RealtimeSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay,
 {
   NS_LOG_FUNCTION (this << context << delay << impl);
 
+  if (!SystemThread::Equals (m_main))
+    {
+      //
+      // Other threads do not take the lock: the event is queued, and
+      // moved to the event list by the main thread, which the Signal ()
+      // wakes up.
+      //
+      EventWithContext ev;
+      ev.context = context;
+      ev.delay = delay.GetTimeStep ();
+      ev.realtime = m_synchronizer->GetCurrentRealtime ();
+      ev.event = impl;
+      m_eventsWithContext.Push (ev);
+      m_synchronizer->Signal ();
+      return;
+    }
+
   {
     CriticalSection cs (m_mutex);
-    uint64_t ts;
-
-    if (SystemThread::Equals (m_main))
-      {
-        ts = m_currentTs + delay.GetTimeStep ();
-      }
-    else
-      {
-        //
-        // If the simulator is running, we're pacing and have a meaningful 
-        // realtime clock.  If we're not, then m_currentTs is where we stopped.
-        // 
-        ts = m_running ? m_synchronizer->GetCurrentRealtime () : m_currentTs;
-        ts += delay.GetTimeStep ();
-      }
+    uint64_t ts = m_currentTs + delay.GetTimeStep ();
 
     NS_ASSERT_MSG (ts >= m_currentTs, "RealtimeSimulatorImpl::ScheduleRealtime(): schedule for time < m_currentTs");
     Scheduler::Event ev;
@@ -30,8 +30,12 @@
 #include "assert.h"
 #include "log.h"
 #include "system-mutex.h"
+#include "mpsc-queue.h"
+#include "traced-callback.h"
+#include "type-id.h"
 
 #include <list>
+#include <vector>
 
 /**
  * \file
@@ -154,6 +158,76 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /**
+   * Get the number of events scheduled from other threads.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetCrossThreadEvents (void) const;
+  /**
+   * Get the number of events scheduled from other threads, which
+   * have not been moved to the event queue yet.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetCrossThreadQueueDepth (void) const;
+  /**
+   * Get the largest number of events scheduled from other threads
+   * found when moving them to the event queue.
+   *
+   * \returns The number of events.
+   */
+  uint64_t GetMaxCrossThreadQueueDepth (void) const;
+
+  /**
+   * Set the type of the Synchronizer, which must be set before the
+   * simulation runs.
+   *
+   * \param [in] tid The TypeId of a subclass of Synchronizer.
+   */
+  void SetSynchronizerType (TypeId tid);
+  /**
+   * Get the type of the Synchronizer.
+   *
+   * \returns The TypeId of the Synchronizer.
+   */
+  TypeId GetSynchronizerType (void) const;
+
+  /** The number of bins of the lateness histogram. */
+  static const uint32_t LATENESS_BINS = 32;
+  /**
+   * Get the histogram of the lateness of the events, that is of the real
+   * time at which they were executed minus their simulation time.
+   *
+   * Bin 0 counts the events executed less than one nanosecond late,
+   * and bin \c i the events executed between \c 2^(i-1) and \c 2^i
+   * nanoseconds late; the last bin also counts all the later events.
+   *
+   * \returns The number of events of each bin, since the start.
+   */
+  std::vector<uint64_t> GetLatenessHistogram (void) const;
+  /**
+   * Get the largest lateness of the events.
+   *
+   * \returns The largest lateness, since the start.
+   */
+  Time GetMaxLateness (void) const;
+
+  /**
+   * TracedCallback signature for the lateness of an event.
+   *
+   * \param [in] lateness The real time at which the event is executed
+   *            minus its simulation time.
+   */
+  typedef void (* LatenessCallback)(Time lateness);
+  /**
+   * TracedCallback signature for the lateness histogram.
+   *
+   * \param [in] histogram The number of events of each bin,
+   *            see GetLatenessHistogram().
+   */
+  typedef void (* LatenessHistogramCallback)(const std::vector<uint64_t> &histogram);
+
 private:
   /**
    * Is the simulator running?
@@ -172,6 +246,22 @@ private:
   uint64_t NextTs (void) const;
   /** Process the next event. */
   void ProcessOneEvent (void);
+  /**
+   * Move the events scheduled from other threads into the event list.
+   * Should be called with #m_mutex locked.
+   */
+  void ProcessEventsWithContext (void);
+  /**
+   * Record the lateness of the current event.
+   *
+   * \param [in] tsLate The lateness of the event, in time steps.
+   */
+  void RecordLateness (uint64_t tsLate);
+  /**
+   * Report the lateness histogram of the events since the previous
+   * report, if any.
+   */
+  void ReportLateness (void);
   /** Destructor implementation. */
   virtual void DoDispose (void);
 
@@ -207,6 +297,26 @@ private:
   /** Mutex to control access to key state. */  
   mutable SystemMutex m_mutex;  
 
+  /** Wrap an event scheduled from another thread. */
+  struct EventWithContext
+  {
+    /** The event context. */
+    uint32_t context;
+    /** The delay of the event. */
+    uint64_t delay;
+    /** The real time at which the event was scheduled. */
+    uint64_t realtime;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /**
+   * The lock-free queue of the events scheduled from other threads,
+   * so that these threads do not contend for #m_mutex.
+   */
+  MpscQueue<struct EventWithContext> m_eventsWithContext;
+  /** The largest number of events seen in #m_eventsWithContext. */
+  uint64_t m_maxEventsWithContext;
+
   /** The synchronizer in use to track real time. */
   Ptr<Synchronizer> m_synchronizer;
 
@@ -216,6 +326,21 @@ private:
   /** The maximum allowable drift from real-time in SYNC_HARD_LIMIT mode. */
   Time m_hardLimit;
 
+  /** The lateness histogram, since the start. */
+  std::vector<uint64_t> m_lateness;
+  /** The lateness histogram, since the previous report. */
+  std::vector<uint64_t> m_latenessReport;
+  /** The largest lateness, in time steps. */
+  uint64_t m_maxLateness;
+  /** The simulation time between the reports of the histogram. */
+  Time m_latenessReportInterval;
+  /** The timestep of the next report of the histogram. */
+  uint64_t m_nextLatenessReport;
+  /** The lateness of each event. */
+  TracedCallback<Time> m_latenessTrace;
+  /** The lateness histogram of each report interval. */
+  TracedCallback<const std::vector<uint64_t> &> m_latenessHistogramTrace;
+
   /** Main SystemThread. */
   SystemThread::ThreadId m_main;
 };
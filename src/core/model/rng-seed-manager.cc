@@ -21,6 +21,7 @@
 #include "global-value.h"
 #include "attribute-helper.h"
 #include "integer.h"
+#include "enum.h"
 #include "config.h"
 #include "log.h"
 
@@ -66,6 +67,18 @@ static ns3::GlobalValue g_rngRun ("RngRun",
                                   "The substream index used for all streams",
                                   ns3::IntegerValue (1),
                                   ns3::MakeIntegerChecker<int64_t> ());
+/**
+ * \relates RngSeedManager
+ * The random number generator of all streams: the MRG32k3a generator,
+ * or the counter-based Philox4x32 generator.
+ *
+ * This is accessible as "--RngEngine" from CommandLine.
+ */
+static ns3::GlobalValue g_rngEngine ("RngEngine",
+                                     "The generator of all rng streams",
+                                     ns3::EnumValue (RngStream::MRG32K3A),
+                                     ns3::MakeEnumChecker (RngStream::MRG32K3A, "MRG32k3a",
+                                                           RngStream::PHILOX4X32, "Philox4x32"));
 
 
 uint32_t RngSeedManager::GetSeed (void)
@@ -105,4 +118,32 @@ uint64_t RngSeedManager::GetNextStreamIndex (void)
   return next;
 }
 
+uint64_t RngSeedManager::PeekNextStreamIndex (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_nextStreamIndex;
+}
+
+void RngSeedManager::SetNextStreamIndex (uint64_t next)
+{
+  NS_LOG_FUNCTION (next);
+  g_nextStreamIndex = next;
+}
+
+void
+RngSeedManager::SetEngine (RngStream::Engine engine)
+{
+  NS_LOG_FUNCTION (engine);
+  Config::SetGlobal ("RngEngine", EnumValue (engine));
+}
+
+RngStream::Engine
+RngSeedManager::GetEngine (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  EnumValue value;
+  g_rngEngine.GetValue (value);
+  return static_cast<RngStream::Engine> (value.Get ());
+}
+
 } // namespace ns3
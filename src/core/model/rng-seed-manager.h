@@ -21,6 +21,7 @@
 #define RNG_SEED_MANAGER_H
 
 #include <stdint.h>
+#include "rng-stream.h"
 
 /**
  * \file
@@ -104,6 +105,39 @@ public:
    * \returns The next stream index.
    */
   static uint64_t GetNextStreamIndex(void);
+  /**
+   * Get the next automatically assigned stream index, without
+   * assigning it.
+   * \returns The next stream index.
+   */
+  static uint64_t PeekNextStreamIndex (void);
+  /**
+   * Set the next automatically assigned stream index.
+   *
+   * This is used to restore a Checkpoint, so that the streams created
+   * after it don't reuse the stream numbers of the restored streams.
+   *
+   * \param [in] next The next stream index.
+   */
+  static void SetNextStreamIndex (uint64_t next);
+
+  /**
+   * \brief Set the generator of the streams.
+   *
+   * This sets the generator of all the subsequently instantiated
+   * RandomVariableStream objects.  The default is MRG32k3a.  With
+   * the counter-based Philox4x32, each (seed, run, stream) maps directly
+   * to its own sequence, without jumping ahead in a common sequence.
+   *
+   * \param [in] engine The generator.
+   */
+  static void SetEngine (RngStream::Engine engine);
+  /**
+   * \brief Get the generator of the streams.
+   * \returns The generator.
+   * \see SetEngine
+   */
+  static RngStream::Engine GetEngine (void);
 
 };
 
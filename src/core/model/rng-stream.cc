@@ -22,13 +22,16 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include "rng-stream.h"
 #include "fatal-error.h"
 #include "log.h"
+#include "assert.h"
 
 /// \file
 /// \ingroup rngimpl
-/// Class RngStream and MRG32k3a implementation.
+/// Class RngStream, MRG32k3a and Philox4x32-10 implementation.
 
 namespace ns3 {
   
@@ -332,33 +335,260 @@ void PowerOfTwoMatrix (int n, Matrix a1p, Matrix a2p)
 
 
 namespace ns3 {
+
+namespace {
+
+/** The streams, by stream number. */
+typedef std::multimap<uint64_t, RngStream *> Streams;
+/** The streams which currently exist, protected by g_streamsMutex. */
+Streams g_streams;
+/** Protects g_streams. */
+std::mutex g_streamsMutex;
+
+/**
+ * Add a stream to g_streams.
+ *
+ * \param [in] stream The stream.
+ */
+void
+Register (RngStream *stream)
+{
+  std::lock_guard<std::mutex> lock (g_streamsMutex);
+  g_streams.insert (std::make_pair (stream->GetStream (), stream));
+}
+
+/**
+ * Remove a stream from g_streams.
+ *
+ * \param [in] stream The stream.
+ */
+void
+Unregister (RngStream *stream)
+{
+  std::lock_guard<std::mutex> lock (g_streamsMutex);
+  std::pair<Streams::iterator, Streams::iterator> range = g_streams.equal_range (stream->GetStream ());
+  for (Streams::iterator i = range.first; i != range.second; ++i)
+    {
+      if (i->second == stream)
+        {
+          g_streams.erase (i);
+          break;
+        }
+    }
+}
+
+/// The first Philox multiplier.
+const uint32_t PHILOX_M0 = 0xD2511F53;
+/// The second Philox multiplier.
+const uint32_t PHILOX_M1 = 0xCD9E8D57;
+/// The first Philox key increment, the golden ratio.
+const uint32_t PHILOX_W0 = 0x9E3779B9;
+/// The second Philox key increment, sqrt(3) - 1.
+const uint32_t PHILOX_W1 = 0xBB67AE85;
+/// The number of Philox rounds.
+const int PHILOX_ROUNDS = 10;
+
+/**
+ * Convert a random word to a double in (0, 1).
+ *
+ * \param [in] word The random word.
+ * \returns The double.
+ */
+inline double
+WordToU01 (uint32_t word)
+{
+  return (word + 0.5) * (1.0 / 4294967296.0);
+}
+
+} // unnamed namespace
+
 //-------------------------------------------------------------------------
 // Generate the next random number.
 //
 double RngStream::RandU01 ()
+{
+  if (m_prefetchNext == m_prefetchEnd)
+    {
+      if (m_engine == MRG32K3A)
+        {
+          return MrgU01 (m_currentState);
+        }
+      Prefetch ();
+    }
+  return m_prefetch[m_prefetchNext++];
+}
+
+void
+RngStream::RandU01 (double *values, uint32_t n)
+{
+  uint32_t i = 0;
+  while (i < n && m_prefetchNext != m_prefetchEnd)
+    {
+      values[i++] = m_prefetch[m_prefetchNext++];
+    }
+  // the generator is now at the position of the next value.
+  Generate (values + i, n - i);
+}
+
+void
+RngStream::Generate (double *values, uint32_t n)
+{
+  uint32_t i = 0;
+  if (m_engine == MRG32K3A)
+    {
+      for (; i < n; i++)
+        {
+          values[i] = MrgU01 (m_currentState);
+        }
+      return;
+    }
+  // finish the current block, then compute whole batches of blocks.
+  while (i < n && (m_position & 3) != 0)
+    {
+      values[i++] = PhiloxU01 ();
+    }
+  while (n - i >= 4 * PHILOX_LANES)
+    {
+      PhiloxBatch (values + i);
+      i += 4 * PHILOX_LANES;
+    }
+  while (i < n)
+    {
+      values[i++] = PhiloxU01 ();
+    }
+}
+
+void
+RngStream::Prefetch (void)
+{
+  m_prefetch.resize (PREFETCH);
+  Generate (&m_prefetch[0], PREFETCH);
+  m_prefetchNext = 0;
+  m_prefetchEnd = PREFETCH;
+}
+
+void
+RngStream::Rewind (void)
+{
+  // only the Philox streams prefetch.
+  m_position -= m_prefetchEnd - m_prefetchNext;
+  m_prefetchNext = 0;
+  m_prefetchEnd = 0;
+}
+
+double
+RngStream::PhiloxU01 (void)
+{
+  if ((m_position >> 2) != m_blockNumber)
+    {
+      PhiloxFill ();
+    }
+  return WordToU01 (m_block[m_position++ & 3]);
+}
+
+void
+RngStream::Philox (const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+{
+  uint32_t c0 = counter[0];
+  uint32_t c1 = counter[1];
+  uint32_t c2 = counter[2];
+  uint32_t c3 = counter[3];
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+      uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+      uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+      c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      c1 = (uint32_t)p1;
+      c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c3 = (uint32_t)p0;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void
+RngStream::PhiloxFill (void)
+{
+  uint64_t block = m_position >> 2;
+  uint32_t counter[4] = {
+    (uint32_t)block, (uint32_t)(block >> 32),
+    (uint32_t)m_substream, (uint32_t)(m_substream >> 32)
+  };
+  Philox (counter, m_key, m_block);
+  m_blockNumber = block;
+}
+
+void
+RngStream::PhiloxBatch (double values[4 * PHILOX_LANES])
+{
+  // The same rounds as Philox(), on the lanes of independent blocks,
+  // which the compiler can keep in vector registers.
+  uint64_t block = m_position >> 2;
+  uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+  for (uint32_t j = 0; j < PHILOX_LANES; j++)
+    {
+      c0[j] = (uint32_t)(block + j);
+      c1[j] = (uint32_t)((block + j) >> 32);
+      c2[j] = (uint32_t)m_substream;
+      c3[j] = (uint32_t)(m_substream >> 32);
+    }
+  uint32_t k0 = m_key[0];
+  uint32_t k1 = m_key[1];
+  for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+      for (uint32_t j = 0; j < PHILOX_LANES; j++)
+        {
+          uint64_t p0 = (uint64_t)PHILOX_M0 * c0[j];
+          uint64_t p1 = (uint64_t)PHILOX_M1 * c2[j];
+          c0[j] = (uint32_t)(p1 >> 32) ^ c1[j] ^ k0;
+          c1[j] = (uint32_t)p1;
+          c2[j] = (uint32_t)(p0 >> 32) ^ c3[j] ^ k1;
+          c3[j] = (uint32_t)p0;
+        }
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+  for (uint32_t j = 0; j < PHILOX_LANES; j++)
+    {
+      values[4 * j] = WordToU01 (c0[j]);
+      values[4 * j + 1] = WordToU01 (c1[j]);
+      values[4 * j + 2] = WordToU01 (c2[j]);
+      values[4 * j + 3] = WordToU01 (c3[j]);
+    }
+  m_position += 4 * PHILOX_LANES;
+}
+
+double
+RngStream::MrgU01 (double state[6])
 {
   int32_t k;
   double p1, p2, u;
 
   /* Component 1 */
-  p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
+  p1 = a12 * state[1] - a13n * state[0];
   k = static_cast<int32_t> (p1 / m1);
   p1 -= k * m1;
   if (p1 < 0.0)
     {
       p1 += m1;
     }
-  m_currentState[0] = m_currentState[1]; m_currentState[1] = m_currentState[2]; m_currentState[2] = p1;
+  state[0] = state[1]; state[1] = state[2]; state[2] = p1;
 
   /* Component 2 */
-  p2 = a21 * m_currentState[5] - a23n * m_currentState[3];
+  p2 = a21 * state[5] - a23n * state[3];
   k = static_cast<int32_t> (p2 / m2);
   p2 -= k * m2;
   if (p2 < 0.0)
     {
       p2 += m2;
     }
-  m_currentState[3] = m_currentState[4]; m_currentState[4] = m_currentState[5]; m_currentState[5] = p2;
+  state[3] = state[4]; state[4] = state[5]; state[5] = p2;
 
   /* Combination */
   u = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
@@ -366,7 +596,16 @@ double RngStream::RandU01 ()
   return u;
 }
 
-RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
+RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream,
+                      Engine engine)
+  : m_stream (stream),
+    m_engine (engine),
+    m_seed (seedNumber),
+    m_substream (substream),
+    m_position (0),
+    m_blockNumber (~(uint64_t)0),
+    m_prefetchNext (0),
+    m_prefetchEnd (0)
 {
   if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
     {
@@ -376,16 +615,142 @@ RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
     {
       m_currentState[i] = seedNumber;
     }
-  AdvanceNthBy (stream, 127, m_currentState);
-  AdvanceNthBy (substream, 76, m_currentState);
+  // the Philox streams of a seed have distinct keys.
+  m_key[0] = (uint32_t)stream;
+  m_key[1] = (uint32_t)(stream >> 32) ^ (seedNumber * PHILOX_W1);
+  m_block[0] = m_block[1] = m_block[2] = m_block[3] = 0;
+  if (m_engine == MRG32K3A)
+    {
+      AdvanceNthBy (stream, 127, m_currentState);
+      AdvanceNthBy (substream, 76, m_currentState);
+    }
+  Register (this);
 }
 
 RngStream::RngStream(const RngStream& r)
 {
+  Copy (r);
+  Register (this);
+}
+
+RngStream &
+RngStream::operator= (const RngStream & r)
+{
+  if (this != &r)
+    {
+      // the stream number, which keys g_streams, may change.
+      Unregister (this);
+      Copy (r);
+      Register (this);
+    }
+  return *this;
+}
+
+RngStream::~RngStream ()
+{
+  Unregister (this);
+}
+
+void
+RngStream::Copy (const RngStream & r)
+{
+  m_stream = r.m_stream;
+  m_engine = r.m_engine;
+  m_seed = r.m_seed;
+  m_substream = r.m_substream;
+  m_position = r.m_position;
+  m_blockNumber = r.m_blockNumber;
+  m_prefetchNext = r.m_prefetchNext;
+  m_prefetchEnd = r.m_prefetchEnd;
   for (int i = 0; i < 6; ++i)
     {
       m_currentState[i] = r.m_currentState[i];
     }
+  for (int i = 0; i < 4; ++i)
+    {
+      m_block[i] = r.m_block[i];
+    }
+  m_prefetch = r.m_prefetch;
+  m_key[0] = r.m_key[0];
+  m_key[1] = r.m_key[1];
+}
+
+uint64_t
+RngStream::GetStream (void) const
+{
+  return m_stream;
+}
+
+RngStream::Engine
+RngStream::GetEngine (void) const
+{
+  return m_engine;
+}
+
+void
+RngStream::GetState (uint32_t state[6]) const
+{
+  if (m_engine == PHILOX4X32)
+    {
+      // the position of the first value not yet returned.
+      uint64_t position = m_position - (m_prefetchEnd - m_prefetchNext);
+      state[0] = (uint32_t)position;
+      state[1] = (uint32_t)(position >> 32);
+      state[2] = (uint32_t)m_substream;
+      state[3] = (uint32_t)(m_substream >> 32);
+      state[4] = m_seed;
+      state[5] = 0;
+      return;
+    }
+  for (int i = 0; i < 6; ++i)
+    {
+      state[i] = static_cast<uint32_t> (m_currentState[i]);
+    }
+}
+
+void
+RngStream::SetState (const uint32_t state[6])
+{
+  if (m_engine == PHILOX4X32)
+    {
+      NS_ASSERT_MSG (state[4] == m_seed && state[5] == 0, "invalid RngStream state");
+      m_position = ((uint64_t)state[1] << 32) | state[0];
+      m_substream = ((uint64_t)state[3] << 32) | state[2];
+      m_blockNumber = ~(uint64_t)0;
+      m_prefetchNext = m_prefetchEnd = 0;
+      return;
+    }
+  m_prefetchNext = m_prefetchEnd = 0;
+  for (int i = 0; i < 6; ++i)
+    {
+      NS_ASSERT_MSG (state[i] < (i < 3 ? m1 : m2), "invalid RngStream state");
+      m_currentState[i] = state[i];
+    }
+}
+
+void
+RngStream::AdvanceSubstreams (uint64_t n)
+{
+  Rewind ();
+  if (m_engine == PHILOX4X32)
+    {
+      m_substream += n;
+      m_blockNumber = ~(uint64_t)0;
+      return;
+    }
+  AdvanceNthBy (n, 76, m_currentState);
+}
+
+std::vector<RngStream *>
+RngStream::GetStreams (void)
+{
+  std::lock_guard<std::mutex> lock (g_streamsMutex);
+  std::vector<RngStream *> streams;
+  for (Streams::const_iterator i = g_streams.begin (); i != g_streams.end (); ++i)
+    {
+      streams.push_back (i->second);
+    }
+  return streams;
 }
 
 void 
@@ -20,6 +20,7 @@
 #ifndef RNGSTREAM_H
 #define RNGSTREAM_H
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 /**
@@ -45,24 +46,59 @@ namespace ns3 {
  * holds a static instance of this class.  The details of this
  * class are explained in:
  * http://www.iro.umontreal.ca/~lecuyer/myftp/papers/streams00.pdf
+ *
+ * A stream can instead use the counter-based generator Philox4x32-10,
+ * described in:
+ * J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw, "Parallel
+ * random numbers: as easy as 1, 2, 3", SC'11.
+ * Philox encrypts a counter with a key: the key of a stream is its
+ * stream number, mixed with the seed, and the counter is the sub-stream
+ * (the run number) and the position in the sub-stream.  The streams of
+ * a seed are thus independent without any jump ahead, and the values
+ * can be computed several blocks at a time, see RandU01(double*,uint32_t).
+ *
+ * For Philox, RandU01(void) returns the values of a small prefetch
+ * buffer, which is refilled a batch of blocks at a time; GetState,
+ * SetState and AdvanceSubstreams see the position of the values
+ * returned, so that the buffer does not change the sequence of a
+ * stream, nor its checkpoints.  MRG32k3a computes its values one at a
+ * time, so its streams do not prefetch.
  */
 class RngStream
 {
 public:
+  /** The generator of a stream. */
+  enum Engine
+  {
+    MRG32K3A,   //!< The combined multiple-recursive generator MRG32k3a.
+    PHILOX4X32  //!< The counter-based generator Philox4x32-10.
+  };
+
   /**
    * Construct from explicit seed, stream and substream values.
    *
    * \param [in] seed The starting seed.
    * \param [in] stream The stream number.
    * \param [in] substream The sub-stream number.
+   * \param [in] engine The generator.
    */
-  RngStream (uint32_t seed, uint64_t stream, uint64_t substream);
+  RngStream (uint32_t seed, uint64_t stream, uint64_t substream,
+             Engine engine = MRG32K3A);
   /**
    * Copy constructor.
    *
    * \param [in] r The RngStream to copy.
    */
   RngStream (const RngStream & r);
+  /**
+   * Assignment operator.
+   *
+   * \param [in] r The RngStream to copy.
+   * \returns This RngStream.
+   */
+  RngStream & operator= (const RngStream & r);
+  /** Destructor. */
+  ~RngStream ();
   /**
    * Generate the next random number for this stream.
    * Uniformly distributed between 0 and 1.
@@ -70,8 +106,114 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next random numbers of this stream, the same as
+   * \p n calls of RandU01(void).
+   *
+   * \param [out] values The random numbers.
+   * \param [in] n The number of random numbers.
+   */
+  void RandU01 (double *values, uint32_t n);
+
+  /**
+   * \returns The stream number given to the constructor.
+   */
+  uint64_t GetStream (void) const;
+  /**
+   * \returns The generator of this stream.
+   */
+  Engine GetEngine (void) const;
+  /**
+   * Get the state, to save it in a Checkpoint.
+   *
+   * \param [out] state The state vector.
+   */
+  void GetState (uint32_t state[6]) const;
+  /**
+   * Set the state saved by GetState.
+   *
+   * \param [in] state The state vector.
+   */
+  void SetState (const uint32_t state[6]);
+  /**
+   * Jump ahead by a number of sub-streams.
+   *
+   * The sub-streams are \f$2^{76}\f$ values apart, or another counter
+   * for Philox, so that this moves a stream restored from a Checkpoint
+   * taken with run \f$r\f$ to the same position in the sub-stream of
+   * run \f$r + n\f$.
+   *
+   * \param [in] n The number of sub-streams.
+   */
+  void AdvanceSubstreams (uint64_t n);
+
+  /**
+   * Get the streams which currently exist.
+   *
+   * \returns The streams, by stream number, and then by creation order.
+   */
+  static std::vector<RngStream *> GetStreams (void);
+
+  /**
+   * Compute a block of the Philox4x32-10 generator.
+   *
+   * \param [in] counter The counter.
+   * \param [in] key The key.
+   * \param [out] out The four random words of the block.
+   */
+  static void Philox (const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
 
 private:
+  /**
+   * Copy the state of another stream.
+   *
+   * \param [in] r The RngStream to copy.
+   */
+  void Copy (const RngStream & r);
+
+  /** The number of Philox blocks computed together by the bulk RandU01(). */
+  static const uint32_t PHILOX_LANES = 8;
+  /** The number of values prefetched by RandU01(void) for Philox. */
+  static const uint32_t PREFETCH = 4 * PHILOX_LANES;
+
+  /**
+   * Generate the next random number of the MRG32k3a generator.
+   *
+   * \param [in,out] state The state vector of the generator.
+   * \returns The next random.
+   */
+  static double MrgU01 (double state[6]);
+  /**
+   * Generate the next random number of the Philox generator.
+   *
+   * \returns The next random.
+   */
+  double PhiloxU01 (void);
+  /**
+   * Generate the next random numbers of the generator, behind the
+   * prefetch buffer.
+   *
+   * \param [out] values The random numbers.
+   * \param [in] n The number of random numbers.
+   */
+  void Generate (double *values, uint32_t n);
+  /** Refill the empty prefetch buffer of a Philox stream. */
+  void Prefetch (void);
+  /**
+   * Move the Philox generator back to the first value of the prefetch
+   * buffer not yet returned, and empty the buffer.
+   */
+  void Rewind (void);
+  /**
+   * Compute the Philox block of the current position.
+   */
+  void PhiloxFill (void);
+  /**
+   * Compute consecutive Philox blocks, from the current position.
+   *
+   * \param [out] values The random numbers of the blocks.
+   */
+  void PhiloxBatch (double values[4 * PHILOX_LANES]);
   /**
    * Advance \p state of the RNG by leaps and bounds.
    *
@@ -83,6 +225,28 @@ private:
 
   /** The RNG state vector. */
   double m_currentState[6];
+  /** The stream number. */
+  uint64_t m_stream;
+  /** The generator. */
+  Engine m_engine;
+  /** The Philox key. */
+  uint32_t m_key[2];
+  /** The seed, for the Philox generator. */
+  uint32_t m_seed;
+  /** The sub-stream, for the Philox generator. */
+  uint64_t m_substream;
+  /** The number of values drawn from the Philox sub-stream. */
+  uint64_t m_position;
+  /** The Philox block of m_blockNumber. */
+  uint32_t m_block[4];
+  /** The number of the Philox block in m_block, or ~0 if none. */
+  uint64_t m_blockNumber;
+  /** The prefetched values, allocated by the first Prefetch. */
+  std::vector<double> m_prefetch;
+  /** The next prefetched value to return. */
+  uint32_t m_prefetchNext;
+  /** The end of the prefetched values. */
+  uint32_t m_prefetchEnd;
 };
 
 } // namespace ns3
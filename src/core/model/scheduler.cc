@@ -19,9 +19,12 @@
  */
 
 #include "scheduler.h"
+#include "event-impl.h"
 #include "assert.h"
 #include "log.h"
 
+#include <vector>
+
 /**
  * \file
  * \ingroup scheduler
@@ -34,6 +37,14 @@ NS_LOG_COMPONENT_DEFINE ("Scheduler");
 
 NS_OBJECT_ENSURE_REGISTERED (Scheduler);
 
+Scheduler::Scheduler ()
+  : m_cancelled (0),
+    m_compactions (0),
+    m_compacted (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
 Scheduler::~Scheduler ()
 {
   NS_LOG_FUNCTION (this);
@@ -49,4 +60,77 @@ Scheduler::GetTypeId (void)
   return tid;
 }
 
+void
+Scheduler::NotifyCancel (void)
+{
+  m_cancelled++;
+}
+
+void
+Scheduler::NotifyCancelledRemoved (void)
+{
+  // the events cancelled behind the back of the SimulatorImpl were
+  // not counted.
+  if (m_cancelled > 0)
+    {
+      m_cancelled--;
+    }
+}
+
+uint64_t
+Scheduler::Compact (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t removed = DoCompact ();
+  NS_LOG_LOGIC ("removed " << removed << " of " << m_cancelled << " cancelled events");
+  m_cancelled = 0;
+  m_compactions++;
+  m_compacted += removed;
+  return removed;
+}
+
+uint64_t
+Scheduler::GetCancelledCount (void) const
+{
+  return m_cancelled;
+}
+
+uint64_t
+Scheduler::GetCompactionCount (void) const
+{
+  return m_compactions;
+}
+
+uint64_t
+Scheduler::GetCompactedCount (void) const
+{
+  return m_compacted;
+}
+
+uint64_t
+Scheduler::DoCompact (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Event> live;
+  uint64_t removed = 0;
+  while (!IsEmpty ())
+    {
+      Event ev = RemoveNext ();
+      if (ev.impl->IsCancelled ())
+        {
+          ev.impl->Unref ();
+          removed++;
+        }
+      else
+        {
+          live.push_back (ev);
+        }
+    }
+  for (std::vector<Event>::const_iterator i = live.begin (); i != live.end (); ++i)
+    {
+      Insert (*i);
+    }
+  return removed;
+}
+
 } // namespace ns3
@@ -62,6 +62,11 @@ class EventImpl;
  * calling EventId::Ref and SimpleRefCount::Unref at the right time.
  * Typically, EventId::Ref is called before Insert and SimpleRefCount::Unref is called
  * after a call to one of the Remove methods.
+ *
+ * Cancelled events stay in the event list until RemoveNext returns
+ * them.  The SimulatorImpl reports the cancellations with NotifyCancel
+ * and NotifyCancelledRemoved, so that the Scheduler knows how many dead
+ * events it holds, and can drop them all at once with Compact.
  */
 class Scheduler : public Object
 {
@@ -95,6 +100,8 @@ public:
     EventKey key;          /**< Key for sorting and ordering Events. */
   };
 
+  /** Constructor. */
+  Scheduler ();
   /** Destructor. */
   virtual ~Scheduler () = 0;
 
@@ -135,6 +142,51 @@ public:
    * \param [in] ev The event to remove
    */
   virtual void Remove (const Event &ev) = 0;
+
+  /**
+   * Record that an event of the event list has been cancelled.
+   */
+  void NotifyCancel (void);
+  /**
+   * Record that RemoveNext returned a cancelled event.
+   */
+  void NotifyCancelledRemoved (void);
+  /**
+   * Remove all the cancelled events from the event list.
+   *
+   * The removed events are released with SimpleRefCount::Unref.
+   *
+   * \returns The number of events removed.
+   */
+  uint64_t Compact (void);
+  /**
+   * \returns The number of cancelled events in the event list.
+   */
+  uint64_t GetCancelledCount (void) const;
+  /**
+   * \returns The number of calls to Compact.
+   */
+  uint64_t GetCompactionCount (void) const;
+  /**
+   * \returns The number of events removed by Compact.
+   */
+  uint64_t GetCompactedCount (void) const;
+
+protected:
+  /**
+   * Remove all the cancelled events from the event list.
+   *
+   * The default implementation removes all the events with RemoveNext,
+   * and inserts the live ones again.  The subclasses can do better.
+   *
+   * \returns The number of events removed.
+   */
+  virtual uint64_t DoCompact (void);
+
+private:
+  uint64_t m_cancelled;    //!< The number of cancelled events in the event list.
+  uint64_t m_compactions;  //!< The number of calls to Compact.
+  uint64_t m_compacted;    //!< The number of events removed by Compact.
 };
 
 /**
@@ -18,7 +18,11 @@
  */
 
 #include "simulator-impl.h"
+#include "scheduler.h"
+#include "double.h"
+#include "uinteger.h"
 #include "log.h"
+#include "fatal-error.h"
 
 /**
  * \file
@@ -38,8 +42,100 @@ SimulatorImpl::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::SimulatorImpl")
     .SetParent<Object> ()
     .SetGroupName ("Core")
+    .AddAttribute ("CompactionThreshold",
+                   "The fraction of cancelled events in the event list above "
+                   "which they are removed all at once, or 0 to keep them "
+                   "until their time.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&SimulatorImpl::m_compactionThreshold),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("CompactionMinEvents",
+                   "The smallest event list whose cancelled events are "
+                   "removed before their time.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&SimulatorImpl::m_compactionMinEvents),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CancelledEvents",
+                   "The number of cancelled events still in the event list.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SimulatorImpl::GetCancelledEventCount),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("LiveEvents",
+                   "The number of events in the event list which are not cancelled.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SimulatorImpl::GetLiveEventCount),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("Compactions",
+                   "The number of times the cancelled events were removed "
+                   "from the event list.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SimulatorImpl::GetCompactionCount),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("CompactedEvents",
+                   "The number of cancelled events removed from the event "
+                   "list before their time.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SimulatorImpl::GetCompactedEventCount),
+                   MakeUintegerChecker<uint64_t> ())
   ;
   return tid;
 }
 
+SimulatorImpl::SimulatorImpl ()
+  : m_compactionThreshold (0.5),
+    m_compactionMinEvents (1024)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+SimulatorImpl::FastForward (const Time &time)
+{
+  NS_LOG_FUNCTION (this << time);
+  NS_FATAL_ERROR (GetInstanceTypeId ().GetName () << " does not support FastForward");
+}
+
+uint64_t
+SimulatorImpl::GetCancelledEventCount (void) const
+{
+  return 0;
+}
+
+uint64_t
+SimulatorImpl::GetLiveEventCount (void) const
+{
+  return 0;
+}
+
+uint64_t
+SimulatorImpl::GetCompactionCount (void) const
+{
+  return 0;
+}
+
+uint64_t
+SimulatorImpl::GetCompactedEventCount (void) const
+{
+  return 0;
+}
+
+uint64_t
+SimulatorImpl::NotifyCancel (Ptr<Scheduler> events, uint64_t size)
+{
+  events->NotifyCancel ();
+  uint64_t cancelled = events->GetCancelledCount ();
+  if (m_compactionThreshold <= 0
+      || size < m_compactionMinEvents
+      || cancelled <= m_compactionThreshold * size)
+    {
+      return 0;
+    }
+  NS_LOG_LOGIC ("compact " << cancelled << " cancelled events of " << size);
+  return events->Compact ();
+}
+
 } // namespace ns3
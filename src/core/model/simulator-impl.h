@@ -99,6 +99,67 @@ public:
   virtual uint32_t GetSystemId () const = 0; 
   /** \copydoc Simulator::GetContext */
   virtual uint32_t GetContext (void) const = 0;
+  /**
+   * Discard the pending events, other than the Destroy events, and
+   * move the current time forward.
+   *
+   * This is used to restore a Checkpoint.  The discarded events are
+   * cancelled, so that their EventId expire.  The default
+   * implementation reports a fatal error.
+   *
+   * \param [in] time The new current time, which must not be earlier
+   *             than Now().
+   */
+  virtual void FastForward (const Time &time);
+
+  /**
+   * \returns The number of cancelled events still in the event list.
+   *
+   * The cancelled events are removed from the event list when their
+   * time comes, or all at once when they exceed the CompactionThreshold
+   * fraction of the event list.  The default implementation, for the
+   * simulators which don't track them, returns 0.
+   */
+  virtual uint64_t GetCancelledEventCount (void) const;
+  /**
+   * \returns The number of events in the event list which are not
+   *          cancelled.  The default implementation returns 0.
+   */
+  virtual uint64_t GetLiveEventCount (void) const;
+  /**
+   * \returns The number of times the cancelled events were removed
+   *          from the event list.  The default implementation returns 0.
+   */
+  virtual uint64_t GetCompactionCount (void) const;
+  /**
+   * \returns The number of cancelled events removed from the event list
+   *          before their time.  The default implementation returns 0.
+   */
+  virtual uint64_t GetCompactedEventCount (void) const;
+
+protected:
+  /** Constructor. */
+  SimulatorImpl ();
+
+  /**
+   * Record the cancellation of an event of an event list, and remove
+   * the cancelled events from the list if they exceed the thresholds.
+   *
+   * \param [in] events The event list.
+   * \param [in] size The number of events in the list, cancelled
+   *            events included.
+   * \returns The number of events removed from the list.
+   */
+  uint64_t NotifyCancel (Ptr<Scheduler> events, uint64_t size);
+
+private:
+  /**
+   * The fraction of cancelled events in the event list above which
+   * they are removed, or 0 to keep them until their time.
+   */
+  double m_compactionThreshold;
+  /** The smallest event list whose cancelled events are removed. */
+  uint32_t m_compactionMinEvents;
 };
 
 } // namespace ns3
@@ -31,6 +31,7 @@
 #include "global-value.h"
 #include "assert.h"
 #include "log.h"
+#include "memory-accounting.h"
 
 #include <cmath>
 #include <fstream>
@@ -107,6 +108,59 @@ NodePrinter (std::ostream &os)
     }
 }
 
+/**
+ * \ingroup logging
+ * Default time stamp of the asynchronous log messages.
+ *
+ * \returns The current simulation time, in time steps.
+ */
+static int64_t
+TimeStamp (void)
+{
+  return Simulator::Now ().GetTimeStep ();
+}
+
+/**
+ * \ingroup logging
+ * Print a time stamp as TimePrinter does.
+ *
+ * \param [in,out] os The output stream to print the time on.
+ * \param [in] stamp The time stamp.
+ */
+static void
+TimeStampPrinter (std::ostream &os, int64_t stamp)
+{
+  os << Time (stamp).GetSeconds () << "s";
+}
+
+/**
+ * \ingroup logging
+ * Default node stamp of the asynchronous log messages.
+ *
+ * \returns The current context, or -1 as NodePrinter prints it.
+ */
+static int64_t
+NodeStamp (void)
+{
+  if (Simulator::GetContext () == Simulator::NO_CONTEXT)
+    {
+      return -1;
+    }
+  return Simulator::GetContext ();
+}
+
+/**
+ * \ingroup simulator
+ * Context of the allocations accounted for by MemoryAccounting.
+ *
+ * \returns The current context.
+ */
+static uint32_t
+AllocationContext (void)
+{
+  return Simulator::GetContext ();
+}
+
 /**
  * \ingroup simulator
  * \brief Get the static SimulatorImpl instance.
@@ -157,6 +211,9 @@ static SimulatorImpl * GetImpl (void)
 //
       LogSetTimePrinter (&TimePrinter);
       LogSetNodePrinter (&NodePrinter);
+      LogSetTimeStamp (&TimeStamp, &TimeStampPrinter);
+      LogSetNodeStamp (&NodeStamp);
+      MemoryAccounting::SetContextGetter (&AllocationContext);
     }
   return *pimpl;
 }
@@ -178,6 +235,7 @@ Simulator::Destroy (void)
    */
   LogSetTimePrinter (0);
   LogSetNodePrinter (0);
+  MemoryAccounting::SetContextGetter (0);
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
@@ -394,6 +452,7 @@ Simulator::SetImplementation (Ptr<SimulatorImpl> impl)
 //
   LogSetTimePrinter (&TimePrinter);
   LogSetNodePrinter (&NodePrinter);
+  MemoryAccounting::SetContextGetter (&AllocationContext);
 }
 
 Ptr<SimulatorImpl>
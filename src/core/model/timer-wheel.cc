@@ -0,0 +1,525 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timer-wheel.h"
+#include "simulator.h"
+#include "assert.h"
+#include "abort.h"
+#include "log.h"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimerWheel");
+
+namespace {
+
+/** The span of a tick, in time steps, or 0 for the default. */
+uint64_t g_granularity = 0;
+/** The number of simulator events scheduled by the wheels. */
+uint64_t g_events = 0;
+/** The number of timers armed in the wheels. */
+uint64_t g_arms = 0;
+
+/**
+ * Get the wheels, indexed by context plus one, so that
+ * Simulator::NO_CONTEXT comes first.
+ *
+ * \returns The wheels.
+ */
+std::vector<TimerWheel *> *
+GetWheels (void)
+{
+  static std::vector<TimerWheel *> wheels;
+  return &wheels;
+}
+
+/**
+ * Find the lowest bit set.
+ *
+ * \param [in] bits The bits, not zero.
+ * \returns The index of the lowest bit set.
+ */
+uint32_t
+LowestBit (uint64_t bits)
+{
+#if defined (__GNUC__)
+  return __builtin_ctzll (bits);
+#else
+  uint32_t index = 0;
+  while ((bits & 1) == 0)
+    {
+      bits >>= 1;
+      index++;
+    }
+  return index;
+#endif
+}
+
+} // unnamed namespace
+
+TimerWheel::Entry::Entry ()
+  : m_wheel (0),
+    m_slot (NO_SLOT),
+    m_ts (0),
+    m_uid (0)
+{
+  prev = 0;
+  next = 0;
+}
+
+TimerWheel::Entry::Entry (const Entry &o)
+  : Link (),
+    m_wheel (0),
+    m_slot (NO_SLOT),
+    m_ts (0),
+    m_uid (0)
+{
+  NS_ASSERT_MSG (o.m_wheel == 0, "a running timer cannot be copied");
+  prev = 0;
+  next = 0;
+}
+
+TimerWheel::Entry &
+TimerWheel::Entry::operator = (const Entry &o)
+{
+  NS_ASSERT_MSG (o.m_wheel == 0, "a running timer cannot be copied");
+  if (this != &o)
+    {
+      Cancel ();
+    }
+  return *this;
+}
+
+TimerWheel::Entry::~Entry ()
+{
+  Cancel ();
+}
+
+void
+TimerWheel::Entry::SetFunction (Callback<void> expire)
+{
+  m_expire = expire;
+}
+
+void
+TimerWheel::Entry::Schedule (const Time &delay)
+{
+  NS_ASSERT_MSG (!m_expire.IsNull (), "the timer has no function");
+  NS_ASSERT_MSG (!delay.IsStrictlyNegative (), "negative delay " << delay);
+  Cancel ();
+  TimerWheel::Get ()->Arm (this, delay);
+}
+
+void
+TimerWheel::Entry::Cancel (void)
+{
+  if (m_wheel != 0)
+    {
+      m_wheel->Disarm (this);
+    }
+}
+
+bool
+TimerWheel::Entry::IsRunning (void) const
+{
+  return m_wheel != 0;
+}
+
+bool
+TimerWheel::Entry::IsExpired (void) const
+{
+  return m_wheel == 0;
+}
+
+Time
+TimerWheel::Entry::GetDelayLeft (void) const
+{
+  if (m_wheel == 0)
+    {
+      return TimeStep (0);
+    }
+  return TimeStep (m_ts - Simulator::Now ().GetTimeStep ());
+}
+
+void
+TimerWheel::SetGranularity (const Time &granularity)
+{
+  NS_LOG_FUNCTION (granularity);
+  NS_ABORT_MSG_UNLESS (granularity.IsStrictlyPositive (),
+                       "TimerWheel: the granularity must be positive");
+  NS_ABORT_MSG_UNLESS (GetWheels ()->empty (),
+                       "TimerWheel: the granularity can't change while the wheels are running");
+  g_granularity = granularity.GetTimeStep ();
+}
+
+Time
+TimerWheel::GetGranularity (void)
+{
+  if (g_granularity == 0)
+    {
+      return MilliSeconds (1);
+    }
+  return TimeStep (g_granularity);
+}
+
+uint64_t
+TimerWheel::GetEventCount (void)
+{
+  return g_events;
+}
+
+uint64_t
+TimerWheel::GetArmCount (void)
+{
+  return g_arms;
+}
+
+TimerWheel::TimerWheel (uint32_t context)
+  : m_context (context),
+    m_granularity (GetGranularity ().GetTimeStep ()),
+    m_tick (Simulator::Now ().GetTimeStep () / m_granularity),
+    m_wake (0),
+    m_size (0),
+    m_expiring (false)
+{
+  NS_LOG_FUNCTION (this << context);
+  for (uint32_t l = 0; l < LEVELS; l++)
+    {
+      for (uint32_t s = 0; s < SLOTS; s++)
+        {
+          m_slots[l][s].prev = &m_slots[l][s];
+          m_slots[l][s].next = &m_slots[l][s];
+        }
+      m_bits[l] = 0;
+    }
+  m_overflow.prev = &m_overflow;
+  m_overflow.next = &m_overflow;
+  m_ready.prev = &m_ready;
+  m_ready.next = &m_ready;
+}
+
+TimerWheel::~TimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t l = 0; l < LEVELS; l++)
+    {
+      for (uint32_t s = 0; s < SLOTS; s++)
+        {
+          Clear (&m_slots[l][s]);
+        }
+    }
+  Clear (&m_overflow);
+  Clear (&m_ready);
+  m_event.Cancel ();
+}
+
+TimerWheel *
+TimerWheel::Get (void)
+{
+  uint32_t index = Simulator::GetContext () + 1;
+  std::vector<TimerWheel *> *wheels = GetWheels ();
+  if (index >= wheels->size ())
+    {
+      if (wheels->empty ())
+        {
+          Simulator::ScheduleDestroy (&TimerWheel::DestroyAll);
+        }
+      wheels->resize (index + 1, 0);
+    }
+  TimerWheel *wheel = (*wheels)[index];
+  if (wheel == 0)
+    {
+      wheel = new TimerWheel (Simulator::GetContext ());
+      (*wheels)[index] = wheel;
+    }
+  return wheel;
+}
+
+void
+TimerWheel::DestroyAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::vector<TimerWheel *> *wheels = GetWheels ();
+  for (std::vector<TimerWheel *>::iterator i = wheels->begin (); i != wheels->end (); ++i)
+    {
+      delete *i;
+    }
+  wheels->clear ();
+}
+
+void
+TimerWheel::Arm (Entry *entry, const Time &delay)
+{
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  if (m_size == 0)
+    {
+      // nothing to move: skip the idle ticks.
+      m_tick = now / m_granularity;
+    }
+  entry->m_wheel = this;
+  entry->m_ts = now + delay.GetTimeStep ();
+  entry->m_uid = g_arms++;
+  m_size++;
+  Place (entry);
+  Reschedule ();
+}
+
+void
+TimerWheel::Disarm (Entry *entry)
+{
+  Unlink (entry);
+  entry->m_wheel = 0;
+  m_size--;
+  // the simulator event stays: if it comes too early, it finds
+  // nothing to expire and schedules the next one.
+}
+
+void
+TimerWheel::Place (Entry *entry)
+{
+  uint64_t tick = entry->m_ts / m_granularity;
+  if (tick <= m_tick)
+    {
+      InsertReady (entry);
+      return;
+    }
+  for (uint32_t l = 0; l < LEVELS; l++)
+    {
+      if ((tick >> (BITS * (l + 1))) == (m_tick >> (BITS * (l + 1))))
+        {
+          uint32_t s = (tick >> (BITS * l)) & (SLOTS - 1);
+          LinkBefore (&m_slots[l][s], entry);
+          entry->m_slot = l * SLOTS + s;
+          m_bits[l] |= uint64_t (1) << s;
+          return;
+        }
+    }
+  LinkBefore (&m_overflow, entry);
+}
+
+void
+TimerWheel::InsertReady (Entry *entry)
+{
+  // most timers are armed in time order: search from the end.
+  Link *position = m_ready.prev;
+  while (position != &m_ready)
+    {
+      Entry *other = static_cast<Entry *> (position);
+      if (other->m_ts < entry->m_ts
+          || (other->m_ts == entry->m_ts && other->m_uid < entry->m_uid))
+        {
+          break;
+        }
+      position = position->prev;
+    }
+  LinkBefore (position->next, entry);
+}
+
+void
+TimerWheel::LinkBefore (Link *position, Entry *entry)
+{
+  entry->prev = position->prev;
+  entry->next = position;
+  position->prev->next = entry;
+  position->prev = entry;
+}
+
+void
+TimerWheel::Unlink (Entry *entry)
+{
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+  if (entry->m_slot != NO_SLOT)
+    {
+      uint32_t l = entry->m_slot / SLOTS;
+      uint32_t s = entry->m_slot % SLOTS;
+      if (m_slots[l][s].next == &m_slots[l][s])
+        {
+          m_bits[l] &= ~(uint64_t (1) << s);
+        }
+      entry->m_slot = NO_SLOT;
+    }
+  entry->prev = 0;
+  entry->next = 0;
+}
+
+void
+TimerWheel::Clear (Link *head)
+{
+  Link *i = head->next;
+  while (i != head)
+    {
+      Entry *entry = static_cast<Entry *> (i);
+      i = i->next;
+      entry->prev = 0;
+      entry->next = 0;
+      entry->m_slot = NO_SLOT;
+      entry->m_wheel = 0;
+    }
+  head->prev = head;
+  head->next = head;
+}
+
+bool
+TimerWheel::FindNextTick (uint64_t *tick) const
+{
+  // the timers of a level are all later than the timers of the
+  // levels below, and later than the current slot of their level.
+  for (uint32_t l = 0; l < LEVELS; l++)
+    {
+      uint32_t current = (m_tick >> (BITS * l)) & (SLOTS - 1);
+      uint64_t later = current + 1 < SLOTS ? m_bits[l] & (~uint64_t (0) << (current + 1)) : 0;
+      if (later != 0)
+        {
+          uint64_t base = (m_tick >> (BITS * (l + 1))) << (BITS * (l + 1));
+          *tick = base | (uint64_t (LowestBit (later)) << (BITS * l));
+          return true;
+        }
+    }
+  if (m_overflow.next == &m_overflow)
+    {
+      return false;
+    }
+  uint64_t first = static_cast<const Entry *> (m_overflow.next)->m_ts;
+  for (const Link *i = m_overflow.next; i != &m_overflow; i = i->next)
+    {
+      first = std::min (first, static_cast<const Entry *> (i)->m_ts);
+    }
+  *tick = first / m_granularity;
+  return true;
+}
+
+void
+TimerWheel::Advance (uint64_t tick)
+{
+  NS_ASSERT (tick > m_tick);
+  uint64_t old = m_tick;
+  m_tick = tick;
+  if ((old >> (BITS * LEVELS)) != (tick >> (BITS * LEVELS)))
+    {
+      Cascade (&m_overflow);
+    }
+  // from the top level down, so that the timers moved from a slot
+  // move on if they land in a slot which the tick enters.
+  for (uint32_t l = LEVELS; l-- > 0; )
+    {
+      if ((old >> (BITS * l)) != (tick >> (BITS * l)))
+        {
+          Cascade (&m_slots[l][(tick >> (BITS * l)) & (SLOTS - 1)]);
+        }
+    }
+}
+
+void
+TimerWheel::Cascade (Link *head)
+{
+  if (head->next == head)
+    {
+      return;
+    }
+  Link pending;
+  pending.prev = &pending;
+  pending.next = &pending;
+  while (head->next != head)
+    {
+      Entry *entry = static_cast<Entry *> (head->next);
+      Unlink (entry);
+      LinkBefore (&pending, entry);
+    }
+  while (pending.next != &pending)
+    {
+      Entry *entry = static_cast<Entry *> (pending.next);
+      Unlink (entry);
+      Place (entry);
+    }
+}
+
+void
+TimerWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event = EventId ();
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  uint64_t nowTick = now / m_granularity;
+  uint64_t tick;
+  while (FindNextTick (&tick) && tick <= nowTick)
+    {
+      Advance (tick);
+    }
+  if (m_tick < nowTick)
+    {
+      Advance (nowTick);
+    }
+  // the functions can arm and cancel timers, this one included.
+  m_expiring = true;
+  while (m_ready.next != &m_ready)
+    {
+      Entry *entry = static_cast<Entry *> (m_ready.next);
+      if (entry->m_ts > now)
+        {
+          break;
+        }
+      Disarm (entry);
+      NS_LOG_LOGIC ("expire " << entry << " of context " << m_context);
+      entry->m_expire ();
+    }
+  m_expiring = false;
+  Reschedule ();
+}
+
+void
+TimerWheel::Reschedule (void)
+{
+  if (m_expiring)
+    {
+      return;
+    }
+  uint64_t wake;
+  if (m_ready.next != &m_ready)
+    {
+      wake = static_cast<Entry *> (m_ready.next)->m_ts;
+    }
+  else
+    {
+      uint64_t tick;
+      if (!FindNextTick (&tick))
+        {
+          return;
+        }
+      wake = tick * m_granularity;
+    }
+  uint64_t now = Simulator::Now ().GetTimeStep ();
+  wake = std::max (wake, now);
+  if (m_event.IsRunning () && m_wake <= wake)
+    {
+      return;
+    }
+  m_event.Cancel ();
+  m_wake = wake;
+  m_event = Simulator::Schedule (TimeStep (wake - now), &TimerWheel::Expire, this);
+  g_events++;
+}
+
+} // namespace ns3
@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "nstime.h"
+#include "event-id.h"
+#include "callback.h"
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup timer
+ * ns3::TimerWheel declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup timer
+ * \brief A hierarchical timing wheel for timers which are cancelled
+ * and re-armed much more often than they expire.
+ *
+ * Protocol timers, such as retransmission or delayed acknowledgement
+ * timers, are usually cancelled or re-armed long before they expire.
+ * Scheduled as plain events, each of them leaves a cancelled event in
+ * the scheduler until its time comes.  The timers of a TimerWheel
+ * are instead kept in the slots of a hierarchical wheel, where arming
+ * and cancelling them takes constant time, and the wheel holds a single
+ * simulator event for its next occupied slot.
+ *
+ * The wheel has four levels of 64 slots; the slots of the first level
+ * span one tick, see SetGranularity(), and the slots of each other
+ * level span the whole previous level.  The timers keep their exact
+ * expiration time: when its slot comes, a timer expires at its own
+ * time, in the order of the expiration times, and of arming for equal
+ * times.  Relative to the events scheduled at the same time, the order
+ * is not specified, which is why the timers opt in to the wheel,
+ * see Timer::SetUseWheel() and Watchdog::SetUseWheel().
+ *
+ * There is one wheel per simulation context, so that the timers expire
+ * in the context in which they were armed.  The wheels are deleted by
+ * Simulator::Destroy(), which stops their pending timers.
+ */
+class TimerWheel
+{
+private:
+  /** The links of a list of timers. */
+  struct Link
+  {
+    Link *prev;                 //!< The previous element.
+    Link *next;                 //!< The next element.
+  };
+
+public:
+  /**
+   * \brief A timer of the wheel.
+   *
+   * The owner of the timer keeps it, typically as a member, and the
+   * wheel links it in its slots while it is running.  A timer cannot be
+   * copied while it is running.  The function of a timer is usually
+   * bound to its owner, so it is not copied either: the owner sets the
+   * function of its copies again.
+   */
+  class Entry : private Link
+  {
+  public:
+    /** Constructor. */
+    Entry ();
+    /**
+     * Copy constructor: the copy is not running, and has no function.
+     *
+     * \param [in] o The timer to copy.
+     */
+    Entry (const Entry &o);
+    /**
+     * Assignment: this timer is cancelled, and keeps its function.
+     * The other timer must not be running.
+     *
+     * \param [in] o The timer to copy.
+     * \returns This timer.
+     */
+    Entry & operator = (const Entry &o);
+    /** Destructor, which cancels the timer. */
+    ~Entry ();
+    /**
+     * Set the function invoked when the timer expires.
+     *
+     * \param [in] expire The function.
+     */
+    void SetFunction (Callback<void> expire);
+    /**
+     * Arm the timer in the wheel of the current context.
+     *
+     * The timer is cancelled first if it is running.
+     *
+     * \param [in] delay The delay before the expiration.
+     */
+    void Schedule (const Time &delay);
+    /** Stop the timer, if it is running. */
+    void Cancel (void);
+    /**
+     * \returns \c true if the timer is armed and has not expired yet.
+     */
+    bool IsRunning (void) const;
+    /**
+     * \returns \c true if the timer is not running.
+     */
+    bool IsExpired (void) const;
+    /**
+     * \returns The delay left before the expiration, or zero if
+     *          the timer is not running.
+     */
+    Time GetDelayLeft (void) const;
+
+  private:
+    friend class TimerWheel;
+
+    TimerWheel *m_wheel;        //!< The wheel, while running.
+    uint32_t m_slot;            //!< The index of the slot, or NO_SLOT.
+    uint64_t m_ts;              //!< The expiration time, in time steps.
+    uint64_t m_uid;             //!< The arming order, for equal times.
+    Callback<void> m_expire;    //!< The function to invoke.
+  };
+
+  /**
+   * Set the span of the slots of the first level of the wheels.
+   *
+   * This must be called while there is no wheel, that is before the
+   * first timer is armed, or after Simulator::Destroy().  A shorter
+   * granularity wakes the wheels more often; a longer one sorts
+   * more timers when their slot comes.  The default is one millisecond.
+   *
+   * \param [in] granularity The span of a tick.
+   */
+  static void SetGranularity (const Time &granularity);
+  /**
+   * \returns The span of a tick.
+   */
+  static Time GetGranularity (void);
+  /**
+   * \returns The number of simulator events scheduled by the wheels,
+   *          since the start of the process.
+   */
+  static uint64_t GetEventCount (void);
+  /**
+   * \returns The number of timers armed in the wheels, since the start
+   *          of the process.
+   */
+  static uint64_t GetArmCount (void);
+
+private:
+  /** The number of levels. */
+  static const uint32_t LEVELS = 4;
+  /** The number of bits of the slot index of each level. */
+  static const uint32_t BITS = 6;
+  /** The number of slots of each level, one bit of the bitmaps each. */
+  static const uint32_t SLOTS = 1 << BITS;
+  /** The slot index of the timers which are not in a slot. */
+  static const uint32_t NO_SLOT = 0xffffffff;
+
+  /**
+   * Constructor.
+   *
+   * \param [in] context The context of the wheel.
+   */
+  TimerWheel (uint32_t context);
+  /** Destructor, which stops the pending timers. */
+  ~TimerWheel ();
+
+  /**
+   * Get the wheel of the current context, and create it if needed.
+   *
+   * \returns The wheel.
+   */
+  static TimerWheel * Get (void);
+  /** Delete all the wheels, at Simulator::Destroy(). */
+  static void DestroyAll (void);
+
+  /**
+   * Arm a timer.
+   *
+   * \param [in] entry The timer, which is not running.
+   * \param [in] delay The delay before the expiration.
+   */
+  void Arm (Entry *entry, const Time &delay);
+  /**
+   * Stop a running timer.
+   *
+   * \param [in] entry The timer.
+   */
+  void Disarm (Entry *entry);
+  /**
+   * Link a timer in its slot, relative to the current tick, or in
+   * the ready timers if its tick has come.
+   *
+   * \param [in] entry The timer.
+   */
+  void Place (Entry *entry);
+  /**
+   * Link a timer in the expiration order of the ready timers.
+   *
+   * \param [in] entry The timer.
+   */
+  void InsertReady (Entry *entry);
+  /**
+   * Link a timer before an element of a list.
+   *
+   * \param [in] position The element.
+   * \param [in] entry The timer.
+   */
+  static void LinkBefore (Link *position, Entry *entry);
+  /**
+   * Unlink a timer from its list, and update the bitmap of its slot.
+   *
+   * \param [in] entry The timer.
+   */
+  void Unlink (Entry *entry);
+  /**
+   * Stop all the timers of a list.
+   *
+   * \param [in] head The head of the list.
+   */
+  static void Clear (Link *head);
+  /**
+   * Find the next tick at which the wheel has timers to move.
+   *
+   * \param [out] tick The tick.
+   * \returns \c false if the wheel has no timer beyond the ready ones.
+   */
+  bool FindNextTick (uint64_t *tick) const;
+  /**
+   * Move the wheel to a later tick, and move the timers of the slots
+   * which the tick enters to the lower levels, and to the ready timers.
+   *
+   * The wheel must have no timer before the tick.
+   *
+   * \param [in] tick The tick.
+   */
+  void Advance (uint64_t tick);
+  /**
+   * Place again all the timers of a list.
+   *
+   * \param [in] head The head of the list.
+   */
+  void Cascade (Link *head);
+  /** Expire the ready timers, and move the wheel to the current time. */
+  void Expire (void);
+  /** Make sure that the simulator event wakes the wheel up in time. */
+  void Reschedule (void);
+
+  uint32_t m_context;                   //!< The context of the wheel.
+  uint64_t m_granularity;               //!< The span of a tick, in time steps.
+  uint64_t m_tick;                      //!< The current tick.
+  Link m_slots[LEVELS][SLOTS];          //!< The heads of the slots.
+  uint64_t m_bits[LEVELS];              //!< The occupied slots.
+  Link m_overflow;                      //!< The timers beyond the last level.
+  Link m_ready;                         //!< The timers of the current tick, by time.
+  EventId m_event;                      //!< The simulator event.
+  uint64_t m_wake;                      //!< The time of the simulator event.
+  uint64_t m_size;                      //!< The number of running timers.
+  bool m_expiring;                      //!< Whether Expire() is running.
+};
+
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
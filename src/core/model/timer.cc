@@ -50,12 +50,48 @@ Timer::Timer (enum DestroyPolicy destroyPolicy)
   NS_LOG_FUNCTION (this << destroyPolicy);
 }
 
+Timer::Timer (const Timer &o)
+  : m_flags (o.m_flags),
+    m_delay (o.m_delay),
+    m_event (o.m_event),
+    m_entry (o.m_entry),
+    m_impl (o.m_impl),
+    m_delayLeft (o.m_delayLeft)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (m_flags & TIMER_WHEEL)
+    {
+      // the function of the wheel is bound to the Timer.
+      m_entry.SetFunction (MakeCallback (&Timer::Invoke, this));
+    }
+}
+
+Timer &
+Timer::operator = (const Timer &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (this != &o)
+    {
+      m_flags = o.m_flags;
+      m_delay = o.m_delay;
+      m_event = o.m_event;
+      m_entry = o.m_entry;
+      m_impl = o.m_impl;
+      m_delayLeft = o.m_delayLeft;
+      if (m_flags & TIMER_WHEEL)
+        {
+          m_entry.SetFunction (MakeCallback (&Timer::Invoke, this));
+        }
+    }
+  return *this;
+}
+
 Timer::~Timer ()
 {
   NS_LOG_FUNCTION (this);
   if (m_flags & CHECK_ON_DESTROY)
     {
-      if (m_event.IsRunning ())
+      if (m_event.IsRunning () || m_entry.IsRunning ())
         {
           NS_FATAL_ERROR ("Event is still running while destroying.");
         }
@@ -68,6 +104,7 @@ Timer::~Timer ()
     {
       Simulator::Remove (m_event);
     }
+  m_entry.Cancel ();
   delete m_impl;
 }
 
@@ -90,6 +127,10 @@ Timer::GetDelayLeft (void) const
   switch (GetState ())
     {
     case Timer::RUNNING:
+      if (m_flags & TIMER_WHEEL)
+        {
+          return m_entry.GetDelayLeft ();
+        }
       return Simulator::GetDelayLeft (m_event);
       break;
     case Timer::EXPIRED:
@@ -110,23 +151,33 @@ Timer::Cancel (void)
 {
   NS_LOG_FUNCTION (this);
   Simulator::Cancel (m_event);
+  m_entry.Cancel ();
 }
 void
 Timer::Remove (void)
 {
   NS_LOG_FUNCTION (this);
   Simulator::Remove (m_event);
+  m_entry.Cancel ();
 }
 bool
 Timer::IsExpired (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_flags & TIMER_WHEEL)
+    {
+      return !IsSuspended () && m_entry.IsExpired ();
+    }
   return !IsSuspended () && m_event.IsExpired ();
 }
 bool
 Timer::IsRunning (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_flags & TIMER_WHEEL)
+    {
+      return !IsSuspended () && m_entry.IsRunning ();
+    }
   return !IsSuspended () && m_event.IsRunning ();
 }
 bool
@@ -166,10 +217,15 @@ Timer::Schedule (Time delay)
 {
   NS_LOG_FUNCTION (this << delay);
   NS_ASSERT (m_impl != 0);
-  if (m_event.IsRunning ())
+  if (m_event.IsRunning () || m_entry.IsRunning ())
     {
       NS_FATAL_ERROR ("Event is still running while re-scheduling.");
     }
+  if (m_flags & TIMER_WHEEL)
+    {
+      m_entry.Schedule (delay);
+      return;
+    }
   m_event = m_impl->Schedule (delay);
 }
 
@@ -178,8 +234,16 @@ Timer::Suspend (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (IsRunning ());
-  m_delayLeft = Simulator::GetDelayLeft (m_event);
-  Simulator::Remove (m_event);
+  if (m_flags & TIMER_WHEEL)
+    {
+      m_delayLeft = m_entry.GetDelayLeft ();
+      m_entry.Cancel ();
+    }
+  else
+    {
+      m_delayLeft = Simulator::GetDelayLeft (m_event);
+      Simulator::Remove (m_event);
+    }
   m_flags |= TIMER_SUSPENDED;
 }
 
@@ -188,10 +252,50 @@ Timer::Resume (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_flags & TIMER_SUSPENDED);
-  m_event = m_impl->Schedule (m_delayLeft);
+  if (m_flags & TIMER_WHEEL)
+    {
+      m_entry.Schedule (m_delayLeft);
+    }
+  else
+    {
+      m_event = m_impl->Schedule (m_delayLeft);
+    }
   m_flags &= ~TIMER_SUSPENDED;
 }
 
+void
+Timer::SetUseWheel (bool useWheel)
+{
+  NS_LOG_FUNCTION (this << useWheel);
+  if (IsRunning () || IsSuspended ())
+    {
+      NS_FATAL_ERROR ("Event is still running while changing the wheel.");
+    }
+  if (useWheel)
+    {
+      m_entry.SetFunction (MakeCallback (&Timer::Invoke, this));
+      m_flags |= TIMER_WHEEL;
+    }
+  else
+    {
+      m_flags &= ~TIMER_WHEEL;
+    }
+}
+
+bool
+Timer::IsUsingWheel (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return (m_flags & TIMER_WHEEL) == TIMER_WHEEL;
+}
+
+void
+Timer::Invoke (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_impl->Invoke ();
+}
+
 
 } // namespace ns3
 
@@ -24,6 +24,7 @@
 #include "nstime.h"
 #include "event-id.h"
 #include "int-to-type.h"
+#include "timer-wheel.h"
 
 /**
  * \file
@@ -112,6 +113,21 @@ public:
    * to use for destroy events
    */
   Timer (enum DestroyPolicy destroyPolicy);
+  /**
+   * Copy constructor: the copy invokes its own function when it uses
+   * the TimerWheel.
+   *
+   * \param [in] o The Timer to copy.
+   */
+  Timer (const Timer &o);
+  /**
+   * Assignment: this Timer invokes its own function when it uses the
+   * TimerWheel.
+   *
+   * \param [in] o The Timer to copy.
+   * \returns This Timer.
+   */
+  Timer & operator = (const Timer &o);
   ~Timer ();
 
   /**
@@ -262,12 +278,35 @@ public:
    */
   void Resume (void);
 
+  /**
+   * \param [in] useWheel Whether to keep this Timer in the TimerWheel
+   *            of its context, rather than as an event of the simulator.
+   *
+   * Cancelling and scheduling again a Timer of the wheel takes constant
+   * time, and leaves no cancelled event in the simulator.  The order
+   * of expiration, relative to the events scheduled for the same time,
+   * is not specified.  Calling SetUseWheel on a running timer is an error.
+   */
+  void SetUseWheel (bool useWheel);
+  /**
+   * \returns \c true if this Timer is kept in the TimerWheel.
+   */
+  bool IsUsingWheel (void) const;
+
 private:
   /** Internal bit marking the suspended state. */
   enum InternalSuspended
   {
     TIMER_SUSPENDED = (1 << 7)  /** Timer suspended. */
   };
+  /** Internal bit marking the timers of the TimerWheel. */
+  enum InternalWheel
+  {
+    TIMER_WHEEL = (1 << 8)  /** Timer in the TimerWheel. */
+  };
+
+  /** Invoke the function, when the timer of the wheel expires. */
+  void Invoke (void);
 
   /**
    * Bitfield for Timer State, DestroyPolicy and InternalSuspended.
@@ -283,6 +322,8 @@ private:
   Time m_delay;
   /** The future event scheduled to expire the timer. */
   EventId m_event;
+  /** The timer of the wheel, with TIMER_WHEEL. */
+  TimerWheel::Entry m_entry;
   /**
    * The timer implementation, which contains the bound callback
    * function and arguments.
@@ -0,0 +1,326 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timerfd-synchronizer.h"
+#include "enum.h"
+#include "integer.h"
+#include "uinteger.h"
+#include "abort.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+/**
+ * \file
+ * \ingroup realtime
+ * ns3::TimerFdSynchronizer implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimerFdSynchronizer");
+
+NS_OBJECT_ENSURE_REGISTERED (TimerFdSynchronizer);
+
+TypeId
+TimerFdSynchronizer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimerFdSynchronizer")
+    .SetParent<Synchronizer> ()
+    .SetGroupName ("Core")
+    .AddConstructor<TimerFdSynchronizer> ()
+    .AddAttribute ("WaitMode",
+                   "How to wait for the next event: sleep in the timer "
+                   "then spin for SpinThreshold, only sleep, or only spin.",
+                   EnumValue (SLEEP_SPIN),
+                   MakeEnumAccessor (&TimerFdSynchronizer::m_mode),
+                   MakeEnumChecker (SLEEP_SPIN, "SleepSpin",
+                                    SLEEP, "Sleep",
+                                    BUSY_POLL, "BusyPoll"))
+    .AddAttribute ("SpinThreshold",
+                   "The real time spun before each event in SleepSpin mode, "
+                   "which should cover the wake-up latency of the kernel.",
+                   TimeValue (MicroSeconds (50)),
+                   MakeTimeAccessor (&TimerFdSynchronizer::m_spinThreshold),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("CpuAffinity",
+                   "The CPU to which the simulation thread is pinned when "
+                   "the simulation starts, or -1 to leave it on any CPU.",
+                   IntegerValue (-1),
+                   MakeIntegerAccessor (&TimerFdSynchronizer::m_cpu),
+                   MakeIntegerChecker<int32_t> (-1))
+    .AddAttribute ("RealtimePriority",
+                   "The SCHED_FIFO priority given to the simulation thread "
+                   "when the simulation starts, from 1 to 99, or 0 to keep "
+                   "its scheduling policy.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TimerFdSynchronizer::m_priority),
+                   MakeUintegerChecker<uint32_t> (0, 99))
+  ;
+  return tid;
+}
+
+TimerFdSynchronizer::TimerFdSynchronizer ()
+  : m_mode (SLEEP_SPIN),
+    m_cpu (-1),
+    m_priority (0),
+    m_condition (false),
+    m_nsEventStart (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_timerFd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC);
+  NS_ABORT_MSG_IF (m_timerFd < 0, "TimerFdSynchronizer: timerfd_create failed: "
+                   << std::strerror (errno));
+  m_signalFd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  NS_ABORT_MSG_IF (m_signalFd < 0, "TimerFdSynchronizer: eventfd failed: "
+                   << std::strerror (errno));
+}
+
+TimerFdSynchronizer::~TimerFdSynchronizer ()
+{
+  NS_LOG_FUNCTION (this);
+  close (m_timerFd);
+  close (m_signalFd);
+}
+
+bool
+TimerFdSynchronizer::DoRealtime (void)
+{
+  NS_LOG_FUNCTION (this);
+  return true;
+}
+
+uint64_t
+TimerFdSynchronizer::DoGetCurrentRealtime (void)
+{
+  NS_LOG_FUNCTION (this);
+  return GetNormalizedRealtime ();
+}
+
+void
+TimerFdSynchronizer::DoSetOrigin (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  ConfigureThread ();
+  m_realtimeOriginNano = GetRealtime ();
+  NS_LOG_INFO ("origin = " << m_realtimeOriginNano);
+}
+
+int64_t
+TimerFdSynchronizer::DoGetDrift (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  uint64_t nsNow = GetNormalizedRealtime ();
+  if (nsNow > ns)
+    {
+      return (int64_t)(nsNow - ns);
+    }
+  else
+    {
+      return -(int64_t)(ns - nsNow);
+    }
+}
+
+bool
+TimerFdSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
+{
+  NS_LOG_FUNCTION (this << nsCurrent << nsDelay);
+  uint64_t ns = nsCurrent + nsDelay;
+  switch (m_mode)
+    {
+    case SLEEP:
+      return SleepUntil (ns);
+    case BUSY_POLL:
+      return SpinUntil (ns);
+    default:
+      break;
+    }
+  uint64_t spin = m_spinThreshold.GetNanoSeconds ();
+  if (nsDelay > spin)
+    {
+      if (!SleepUntil (ns - spin))
+        {
+          return false;
+        }
+    }
+  return SpinUntil (ns);
+}
+
+void
+TimerFdSynchronizer::DoSignal (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_condition.store (true, std::memory_order_release);
+  uint64_t one = 1;
+  if (write (m_signalFd, &one, sizeof (one)) < 0)
+    {
+      // the counter is already large enough to wake the wait up.
+      NS_LOG_LOGIC ("eventfd write failed: " << std::strerror (errno));
+    }
+}
+
+void
+TimerFdSynchronizer::DoSetCondition (bool cond)
+{
+  NS_LOG_FUNCTION (this << cond);
+  m_condition.store (cond, std::memory_order_release);
+  if (!cond)
+    {
+      // forget the signals we have already seen: a later Signal sets the
+      // condition again before writing to the eventfd.
+      uint64_t count;
+      while (read (m_signalFd, &count, sizeof (count)) > 0)
+        {
+        }
+    }
+}
+
+void
+TimerFdSynchronizer::DoEventStart (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nsEventStart = GetNormalizedRealtime ();
+}
+
+uint64_t
+TimerFdSynchronizer::DoEventEnd (void)
+{
+  NS_LOG_FUNCTION (this);
+  return GetNormalizedRealtime () - m_nsEventStart;
+}
+
+bool
+TimerFdSynchronizer::SleepUntil (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  if (m_condition.load (std::memory_order_acquire))
+    {
+      return false;
+    }
+  // Arming the timer also clears its pending expirations.
+  uint64_t absolute = m_realtimeOriginNano + ns;
+  struct itimerspec spec;
+  std::memset (&spec, 0, sizeof (spec));
+  spec.it_value.tv_sec = absolute / NS_PER_SEC;
+  spec.it_value.tv_nsec = absolute % NS_PER_SEC;
+  int status = timerfd_settime (m_timerFd, TFD_TIMER_ABSTIME, &spec, 0);
+  NS_ABORT_MSG_IF (status < 0, "TimerFdSynchronizer: timerfd_settime failed: "
+                   << std::strerror (errno));
+
+  struct pollfd fds[2];
+  fds[0].fd = m_timerFd;
+  fds[0].events = POLLIN;
+  fds[1].fd = m_signalFd;
+  fds[1].events = POLLIN;
+  for (;;)
+    {
+      fds[0].revents = 0;
+      fds[1].revents = 0;
+      if (poll (fds, 2, -1) < 0)
+        {
+          NS_ABORT_MSG_IF (errno != EINTR, "TimerFdSynchronizer: poll failed: "
+                           << std::strerror (errno));
+          continue;
+        }
+      if (fds[1].revents & POLLIN)
+        {
+          uint64_t count;
+          while (read (m_signalFd, &count, sizeof (count)) > 0)
+            {
+            }
+          if (m_condition.load (std::memory_order_acquire))
+            {
+              return false;
+            }
+        }
+      if (fds[0].revents & POLLIN)
+        {
+          uint64_t expirations;
+          if (read (m_timerFd, &expirations, sizeof (expirations)) > 0)
+            {
+              return true;
+            }
+        }
+    }
+}
+
+bool
+TimerFdSynchronizer::SpinUntil (uint64_t ns)
+{
+  NS_LOG_FUNCTION (this << ns);
+  for (;;)
+    {
+      if (GetNormalizedRealtime () >= ns)
+        {
+          return true;
+        }
+      if (m_condition.load (std::memory_order_acquire))
+        {
+          return false;
+        }
+    }
+}
+
+void
+TimerFdSynchronizer::ConfigureThread (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_cpu >= 0)
+    {
+      cpu_set_t set;
+      CPU_ZERO (&set);
+      CPU_SET (m_cpu, &set);
+      if (sched_setaffinity (0, sizeof (set), &set) != 0)
+        {
+          NS_LOG_WARN ("TimerFdSynchronizer: can't pin the thread to CPU "
+                       << m_cpu << ": " << std::strerror (errno));
+        }
+    }
+  if (m_priority > 0)
+    {
+      struct sched_param param;
+      std::memset (&param, 0, sizeof (param));
+      param.sched_priority = m_priority;
+      if (sched_setscheduler (0, SCHED_FIFO, &param) != 0)
+        {
+          NS_LOG_WARN ("TimerFdSynchronizer: can't set SCHED_FIFO priority "
+                       << m_priority << ": " << std::strerror (errno));
+        }
+    }
+}
+
+uint64_t
+TimerFdSynchronizer::GetRealtime (void) const
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+uint64_t
+TimerFdSynchronizer::GetNormalizedRealtime (void) const
+{
+  return GetRealtime () - m_realtimeOriginNano;
+}
+
+} // namespace ns3
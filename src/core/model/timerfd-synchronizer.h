@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMERFD_SYNCHRONIZER_H
+#define TIMERFD_SYNCHRONIZER_H
+
+#include "synchronizer.h"
+#include "nstime.h"
+#include <atomic>
+
+/**
+ * \file
+ * \ingroup realtime
+ * ns3::TimerFdSynchronizer declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup realtime
+ * \brief A low-jitter synchronizer for Linux, which sleeps in a
+ * \c timerfd of the \c CLOCK_MONOTONIC clock.
+ *
+ * The WallClockSynchronizer sleeps by whole jiffies on a condition
+ * variable of the \c gettimeofday clock, and spins for the last three
+ * jiffies.  This synchronizer arms a \c timerfd at the absolute
+ * \c CLOCK_MONOTONIC time of the next event, which the kernel wakes
+ * up with the resolution of its high-resolution timers, and waits for
+ * it and for the Signal() of the other threads with \c poll.  The
+ * WaitMode attribute selects how the synchronizer waits:
+ *
+ *   - \c SleepSpin, the default, sleeps in the timer until SpinThreshold
+ *     before the event, and spins for the rest, which hides the wake-up
+ *     latency of the kernel;
+ *   - \c Sleep only sleeps in the timer, and uses the least CPU time;
+ *   - \c BusyPoll only spins on the clock, and gives the lowest jitter
+ *     on a dedicated core, see the CpuAffinity attribute.
+ *
+ * When the simulation starts, the synchronizer can also pin the
+ * simulation thread to a CPU, and give it the \c SCHED_FIFO policy,
+ * see the CpuAffinity and RealtimePriority attributes; the thread keeps
+ * them after the simulation.  \c SCHED_FIFO needs the \c CAP_SYS_NICE
+ * capability; without it, the synchronizer logs a warning and keeps
+ * the policy of the thread.
+ *
+ * Select this synchronizer with the SynchronizerType attribute of
+ * the RealtimeSimulatorImpl:
+ *
+ * \code
+ *   GlobalValue::Bind ("SimulatorImplementationType",
+ *                      StringValue ("ns3::RealtimeSimulatorImpl"));
+ *   Config::SetDefault ("ns3::RealtimeSimulatorImpl::SynchronizerType",
+ *                       TypeIdValue (TimerFdSynchronizer::GetTypeId ()));
+ * \endcode
+ */
+class TimerFdSynchronizer : public Synchronizer
+{
+public:
+  /**
+   * Get the registered TypeId for this class.
+   * \returns The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  TimerFdSynchronizer ();
+  /** Destructor. */
+  virtual ~TimerFdSynchronizer ();
+
+  /** How the synchronizer waits for the next event. */
+  enum WaitMode
+  {
+    SLEEP_SPIN,   //!< Sleep in the timer, then spin for SpinThreshold.
+    SLEEP,        //!< Only sleep in the timer.
+    BUSY_POLL     //!< Only spin on the clock.
+  };
+
+  /** Conversion constant between ns and s. */
+  static const uint64_t NS_PER_SEC = (uint64_t)1000000000;
+
+protected:
+  // Inherited from Synchronizer
+  virtual void DoSetOrigin (uint64_t ns);
+  virtual bool DoRealtime (void);
+  virtual uint64_t DoGetCurrentRealtime (void);
+  virtual bool DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay);
+  virtual void DoSignal (void);
+  virtual void DoSetCondition (bool cond);
+  virtual int64_t DoGetDrift (uint64_t ns);
+  virtual void DoEventStart (void);
+  virtual uint64_t DoEventEnd (void);
+
+private:
+  /**
+   * Sleep in the timer until a normalized real time, or until the
+   * condition is set.
+   *
+   * \param [in] ns The normalized real time.
+   * \returns \c true if we reached the time,
+   *          \c false if we returned because the condition was set.
+   */
+  bool SleepUntil (uint64_t ns);
+  /**
+   * Spin on the clock until a normalized real time, or until the
+   * condition is set.
+   *
+   * \param [in] ns The normalized real time.
+   * \returns \c true if we reached the time,
+   *          \c false if we returned because the condition was set.
+   */
+  bool SpinUntil (uint64_t ns);
+  /** Apply the CpuAffinity and RealtimePriority to the calling thread. */
+  void ConfigureThread (void);
+  /**
+   * Get the current time of the \c CLOCK_MONOTONIC clock.
+   *
+   * \returns The time, in ns.
+   */
+  uint64_t GetRealtime (void) const;
+  /**
+   * Get the current normalized real time.
+   *
+   * \returns The time since the origin, in ns.
+   */
+  uint64_t GetNormalizedRealtime (void) const;
+
+  enum WaitMode m_mode;             //!< How to wait.
+  Time m_spinThreshold;             //!< The time spun in SLEEP_SPIN mode.
+  int32_t m_cpu;                    //!< The CPU of the thread, or -1.
+  uint32_t m_priority;              //!< The SCHED_FIFO priority, or 0.
+  int m_timerFd;                    //!< The timer.
+  int m_signalFd;                   //!< The eventfd written by DoSignal().
+  std::atomic<bool> m_condition;    //!< Set to interrupt the wait.
+  uint64_t m_nsEventStart;          //!< Time recorded by DoEventStart().
+};
+
+} // namespace ns3
+
+#endif /* TIMERFD_SYNCHRONIZER_H */
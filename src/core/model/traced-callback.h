@@ -22,6 +22,7 @@
 #define TRACED_CALLBACK_H
 
 #include <list>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -46,6 +47,15 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * The chain is a contiguous vector, so invoking a TracedCallback
+ * with nothing connected costs a single comparison.  When computing
+ * the arguments is expensive, check IsEmpty() first.
+ *
+ * A Callback may connect or disconnect Callbacks, itself included,
+ * while the chain is invoked: the Callbacks connected are invoked by
+ * the same invocation, and those disconnected are not invoked any
+ * more.
+ *
  * \tparam T1 \explicit Type of the first argument to the functor.
  * \tparam T2 \explicit Type of the second argument to the functor.
  * \tparam T3 \explicit Type of the third argument to the functor.
@@ -93,6 +103,12 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * Check if the chain of Callbacks is empty.
+   *
+   * \returns \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const;
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -234,9 +250,27 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
-  /** The chain of Callbacks. */
-  CallbackList m_callbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+
+  /** Enter an invocation of the chain. */
+  void BeginInvoke (void) const;
+  /**
+   * Leave an invocation of the chain, and remove the Callbacks
+   * disconnected during the outermost invocation.
+   */
+  void EndInvoke (void) const;
+
+  /**
+   * The chain of Callbacks.  The Callbacks disconnected while the
+   * chain is invoked are set to null, and removed when the outermost
+   * invocation returns, so that the invocation goes on with the next
+   * Callbacks.
+   */
+  mutable CallbackList m_callbackList;
+  /** The depth of the nested invocations of the chain. */
+  mutable uint32_t m_invoking;
+  /** Whether null Callbacks are to be removed from the chain. */
+  mutable bool m_purge;
 };
 
 } // namespace ns3
@@ -253,8 +287,44 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::TracedCallback ()
-  : m_callbackList () 
+  : m_callbackList (),
+    m_invoking (0),
+    m_purge (false)
+{
+}
+template<typename T1, typename T2,
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+void
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::BeginInvoke (void) const
 {
+  m_invoking++;
+}
+template<typename T1, typename T2,
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+void
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::EndInvoke (void) const
+{
+  m_invoking--;
+  if (m_invoking == 0 && m_purge)
+    {
+      for (typename CallbackList::iterator i = m_callbackList.begin ();
+           i != m_callbackList.end (); /* empty */)
+        {
+          if ((*i).IsNull ())
+            {
+              i = m_callbackList.erase (i);
+            }
+          else
+            {
+              i++;
+            }
+        }
+      m_purge = false;
+    }
 }
 template<typename T1, typename T2,
          typename T3, typename T4,
@@ -291,9 +361,20 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DisconnectWithoutContext (const Callbac
   for (typename CallbackList::iterator i = m_callbackList.begin ();
        i != m_callbackList.end (); /* empty */)
     {
-      if ((*i).IsEqual (callback))
+      if (!(*i).IsNull () && (*i).IsEqual (callback))
         {
-          i = m_callbackList.erase (i);
+          if (m_invoking > 0)
+            {
+              // the chain is being invoked: keep the indices of the
+              // other Callbacks until the invocation returns.
+              (*i).Nullify ();
+              m_purge = true;
+              i++;
+            }
+          else
+            {
+              i = m_callbackList.erase (i);
+            }
         }
       else
         {
@@ -314,6 +395,15 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callba
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   DisconnectWithoutContext (realCb);
 }
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_callbackList.empty ();
+}
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
@@ -321,11 +411,23 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)();
+      return;
     }
+  // the size is read again after each call, since a Callback can
+  // connect other Callbacks to this chain.
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb ();
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -334,11 +436,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1);
+      return;
     }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -347,11 +459,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
+    {
+      return;
+    }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2);
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -360,11 +482,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3);
+      return;
     }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -373,11 +505,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4);
+      return;
     }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3, a4);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -386,11 +528,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
+    {
+      return;
+    }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
     {
-      (*i)(a1, a2, a3, a4, a5);
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3, a4, a5);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -399,11 +551,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      return;
+    }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3, a4, a5, a6);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -412,11 +574,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      return;
     }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3, a4, a5, a6, a7);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -425,11 +597,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (m_callbackList.empty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      return;
+    }
+  BeginInvoke ();
+  for (std::size_t i = 0; i < m_callbackList.size (); i++)
+    {
+      // the copy keeps the Callback alive if it disconnects itself.
+      typename CallbackList::value_type cb = m_callbackList[i];
+      if (!cb.IsNull ())
+        {
+          cb (a1, a2, a3, a4, a5, a6, a7, a8);
+        }
     }
+  EndInvoke ();
 }
 
 } // namespace ns3
@@ -24,6 +24,7 @@
 #include "trace-source-accessor.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <sstream>
 #include <iomanip>
@@ -51,7 +52,9 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
  * \brief TypeId information manager
  *
  * Information records are stored in a vector.  Name and hash lookup
- * are performed by maps to the vector index.
+ * are performed by maps to the vector index.  Each record also holds
+ * hash indices of its Attributes and TraceSources, with the inherited
+ * ones, which are built on the first lookup by name.
  *
  * \internal
  * <b>Hash Chaining</b>
@@ -78,6 +81,8 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
 class IidManager : public Singleton<IidManager>
 {
 public:
+  /** Constructor. */
+  IidManager ();
   /**
    * Create a new unique type id.
    * \param [in] name The name of this type id.
@@ -222,6 +227,12 @@ public:
    * \returns The number of attributes associated to this TypeId
    */
   uint32_t GetAttributeN (uint16_t uid) const;
+  /**
+   * Get the generation of the Attributes.
+   * \returns The generation, which changes whenever an Attribute is
+   *          added or its initial value is set.
+   */
+  uint64_t GetAttributeGeneration (void) const;
   /**
    * Get Attribute information by index.
    * \param [in] uid The id.
@@ -270,6 +281,26 @@ public:
    * \returns \c true if this TypeId should be hidden from the user.
    */
   bool MustHideFromDocumentation (uint16_t uid) const;
+  /**
+   * Find an Attribute of a type id or of its parents, by name.
+   * \param [in] uid The id.
+   * \param [in] name The Attribute name.
+   * \param [out] owner The id which declares the Attribute.
+   * \param [out] i The index of the Attribute in \p owner.
+   * \returns \c true if the Attribute was found.
+   */
+  bool FindAttribute (uint16_t uid, const std::string &name,
+                      uint16_t *owner, uint32_t *i);
+  /**
+   * Find a TraceSource of a type id or of its parents, by name.
+   * \param [in] uid The id.
+   * \param [in] name The TraceSource name.
+   * \param [out] owner The id which declares the TraceSource.
+   * \param [out] i The index of the TraceSource in \p owner.
+   * \returns \c true if the TraceSource was found.
+   */
+  bool FindTraceSource (uint16_t uid, const std::string &name,
+                        uint16_t *owner, uint32_t *i);
 
 private:
   /**
@@ -319,6 +350,12 @@ private:
     TypeId::SupportLevel supportLevel;
     /** Support message. */
     std::string supportMsg;
+    /** The Attributes of this type id and of its parents, by name. */
+    std::unordered_map<std::string, std::pair<uint16_t, uint32_t> > attributeIndex;
+    /** The TraceSources of this type id and of its parents, by name. */
+    std::unordered_map<std::string, std::pair<uint16_t, uint32_t> > traceSourceIndex;
+    /** The value of IidManager::m_version when the indices were built. */
+    uint32_t indexVersion;
   };
   /** Iterator type. */
   typedef std::vector<struct IidInformation>::const_iterator Iterator;
@@ -329,6 +366,17 @@ private:
    * \returns The information record.
    */
   struct IidManager::IidInformation *LookupInformation (uint16_t uid) const;
+  /**
+   * Build the Attribute and TraceSource indices of a type id, if
+   * they are missing or out of date.
+   *
+   * The indices hold the entries of the type id and of its parents,
+   * the most derived ones first, so that the lookups match a search
+   * from the type id up to the root of the inheritance tree.
+   * \param [in] uid The id.
+   * \returns The information record of the type id.
+   */
+  struct IidInformation *UpdateIndex (uint16_t uid);
 
   /** The container of all type id records. */
   std::vector<struct IidInformation> m_information;
@@ -343,6 +391,17 @@ private:
   /** The by-hash index. */
   hashmap_t m_hashmap;
 
+  /**
+   * The version of the inheritance trees and of their Attributes and
+   * TraceSources, which invalidates the indices when it changes.
+   */
+  uint32_t m_version;
+  /**
+   * The generation of the Attributes and of their initial values,
+   * which invalidates the AttributeConstructionPlans when it changes.
+   */
+  uint64_t m_attributeGeneration;
+
 
   /** IidManager constants. */
   enum {
@@ -368,6 +427,13 @@ IidManager::Hasher (const std::string name)
 #define IID "IidManager"
 #define IIDL IID << ": "
 
+IidManager::IidManager ()
+  : m_version (1),
+    m_attributeGeneration (1)
+{
+  NS_LOG_FUNCTION (IID);
+}
+
 uint16_t
 IidManager::AllocateUid (std::string name)
 {
@@ -429,6 +495,7 @@ IidManager::AllocateUid (std::string name)
   information.size = (std::size_t)(-1);
   information.hasConstructor = false;
   information.mustHideFromDocumentation = false;
+  information.indexVersion = 0;
   m_information.push_back (information);
   uint32_t uid = m_information.size ();
   NS_ASSERT (uid <= 0xffff);
@@ -456,6 +523,8 @@ IidManager::SetParent (uint16_t uid, uint16_t parent)
   NS_ASSERT (parent <= m_information.size ());
   struct IidInformation *information = LookupInformation (uid);
   information->parent = parent;
+  m_version++;
+  m_attributeGeneration++;
 }
 void 
 IidManager::SetGroupName (uint16_t uid, std::string groupName)
@@ -665,6 +734,8 @@ IidManager::AddAttribute (uint16_t uid,
   info.supportLevel = supportLevel;
   info.supportMsg = supportMsg;
   information->attributes.push_back (info);
+  m_version++;
+  m_attributeGeneration++;
   NS_LOG_LOGIC (IIDL << information->attributes.size () - 1);
 }
 void 
@@ -676,6 +747,12 @@ IidManager::SetAttributeInitialValue(uint16_t uid,
   struct IidInformation *information = LookupInformation (uid);
   NS_ASSERT (i < information->attributes.size ());
   information->attributes[i].initialValue = initialValue;
+  m_attributeGeneration++;
+}
+uint64_t
+IidManager::GetAttributeGeneration (void) const
+{
+  return m_attributeGeneration;
 }
 
 
@@ -756,6 +833,7 @@ IidManager::AddTraceSource (uint16_t uid,
   source.supportLevel = supportLevel;
   source.supportMsg = supportMsg;
   information->traceSources.push_back (source);
+  m_version++;
   NS_LOG_LOGIC (IIDL << information->traceSources.size () - 1);
 }
 uint32_t 
@@ -786,6 +864,80 @@ IidManager::MustHideFromDocumentation (uint16_t uid) const
   return hide;
 }
 
+struct IidManager::IidInformation *
+IidManager::UpdateIndex (uint16_t uid)
+{
+  struct IidInformation *information = LookupInformation (uid);
+  if (information->indexVersion == m_version)
+    {
+      return information;
+    }
+  NS_LOG_LOGIC (IIDL << "index " << information->name);
+  information->attributeIndex.clear ();
+  information->traceSourceIndex.clear ();
+  while (true)
+    {
+      struct IidInformation *current = LookupInformation (uid);
+      // insert does not replace the entries of the derived type ids.
+      for (uint32_t i = 0; i < current->attributes.size (); i++)
+        {
+          information->attributeIndex.insert (std::make_pair (current->attributes[i].name,
+                                                              std::make_pair (uid, i)));
+        }
+      for (uint32_t i = 0; i < current->traceSources.size (); i++)
+        {
+          information->traceSourceIndex.insert (std::make_pair (current->traceSources[i].name,
+                                                                std::make_pair (uid, i)));
+        }
+      if (current->parent == uid || current->parent == 0)
+        {
+          // top of inheritance tree
+          break;
+        }
+      uid = current->parent;
+    }
+  information->indexVersion = m_version;
+  return information;
+}
+
+bool
+IidManager::FindAttribute (uint16_t uid, const std::string &name,
+                           uint16_t *owner, uint32_t *i)
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  struct IidInformation *information = UpdateIndex (uid);
+  std::unordered_map<std::string, std::pair<uint16_t, uint32_t> >::const_iterator found =
+    information->attributeIndex.find (name);
+  if (found == information->attributeIndex.end ())
+    {
+      NS_LOG_LOGIC (IIDL << false);
+      return false;
+    }
+  *owner = found->second.first;
+  *i = found->second.second;
+  NS_LOG_LOGIC (IIDL << *owner << " " << *i);
+  return true;
+}
+
+bool
+IidManager::FindTraceSource (uint16_t uid, const std::string &name,
+                             uint16_t *owner, uint32_t *i)
+{
+  NS_LOG_FUNCTION (IID << uid << name);
+  struct IidInformation *information = UpdateIndex (uid);
+  std::unordered_map<std::string, std::pair<uint16_t, uint32_t> >::const_iterator found =
+    information->traceSourceIndex.find (name);
+  if (found == information->traceSourceIndex.end ())
+    {
+      NS_LOG_LOGIC (IIDL << false);
+      return false;
+    }
+  *owner = found->second.first;
+  *i = found->second.second;
+  NS_LOG_LOGIC (IIDL << *owner << " " << *i);
+  return true;
+}
+
 } // namespace ns3
 
 namespace ns3 {
@@ -866,37 +1018,31 @@ bool
 TypeId::LookupAttributeByName (std::string name, struct TypeId::AttributeInformation *info) const
 {
   NS_LOG_FUNCTION (this << name << info);
-  TypeId tid;
-  TypeId nextTid = *this;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
-        {
-          struct TypeId::AttributeInformation tmp = tid.GetAttribute(i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "Attribute '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return true;
-                }
-              else if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("Attribute '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
+  uint16_t owner;
+  uint32_t i;
+  if (!IidManager::Get ()->FindAttribute (m_tid, name, &owner, &i))
+    {
+      return false;
+    }
+  struct TypeId::AttributeInformation tmp = IidManager::Get ()->GetAttribute (owner, i);
+  if (tmp.supportLevel == TypeId::SUPPORTED)
+    {
+      *info = tmp;
+      return true;
+    }
+  else if (tmp.supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "Attribute '" << name << "' is deprecated: "
+                << tmp.supportMsg << std::endl;
+      *info = tmp;
+      return true;
+    }
+  else if (tmp.supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("Attribute '" << name
+                      << "' is obsolete, with no fallback: "
+                      << tmp.supportMsg);
+    }
   return false;
 }
 
@@ -1054,6 +1200,12 @@ TypeId::MustHideFromDocumentation (void) const
   return mustHide;
 }
 
+uint64_t
+TypeId::GetAttributeGeneration (void)
+{
+  return IidManager::Get ()->GetAttributeGeneration ();
+}
+
 uint32_t 
 TypeId::GetAttributeN (void) const
 {
@@ -1126,38 +1278,31 @@ TypeId::LookupTraceSourceByName (std::string name,
                                  struct TraceSourceInformation *info) const
 {
   NS_LOG_FUNCTION (this << name);
-  TypeId tid;
-  TypeId nextTid = *this;
-  struct TypeId::TraceSourceInformation tmp;
-  do {
-      tid = nextTid;
-      for (uint32_t i = 0; i < tid.GetTraceSourceN (); i++)
-        {
-          tmp = tid.GetTraceSource (i);
-          if (tmp.name == name)
-            {
-              if (tmp.supportLevel == TypeId::SUPPORTED)
-                {
-                  *info = tmp;
-                   return tmp.accessor;
-                }
-              else if (tmp.supportLevel == TypeId::DEPRECATED)
-                {
-                  std::cerr << "TraceSource '" << name << "' is deprecated: "
-                                 << tmp.supportMsg << std::endl;
-                  *info = tmp;
-                  return tmp.accessor;
-                }
-              else  if (tmp.supportLevel == TypeId::OBSOLETE)
-                {
-                  NS_FATAL_ERROR ("TraceSource '" << name
-                                  << "' is obsolete, with no fallback: "
-                                  << tmp.supportMsg);
-                }
-            }
-        }
-      nextTid = tid.GetParent ();
-    } while (nextTid != tid);
+  uint16_t owner;
+  uint32_t i;
+  if (!IidManager::Get ()->FindTraceSource (m_tid, name, &owner, &i))
+    {
+      return 0;
+    }
+  struct TypeId::TraceSourceInformation tmp = IidManager::Get ()->GetTraceSource (owner, i);
+  if (tmp.supportLevel == TypeId::SUPPORTED)
+    {
+      *info = tmp;
+      return tmp.accessor;
+    }
+  else if (tmp.supportLevel == TypeId::DEPRECATED)
+    {
+      std::cerr << "TraceSource '" << name << "' is deprecated: "
+                << tmp.supportMsg << std::endl;
+      *info = tmp;
+      return tmp.accessor;
+    }
+  else if (tmp.supportLevel == TypeId::OBSOLETE)
+    {
+      NS_FATAL_ERROR ("TraceSource '" << name
+                      << "' is obsolete, with no fallback: "
+                      << tmp.supportMsg);
+    }
   return 0;
 }
 
@@ -242,6 +242,15 @@ public:
    */
   bool HasConstructor (void) const;
 
+  /**
+   * Get the generation of the Attributes of all the TypeIds.
+   *
+   * The generation changes whenever an Attribute is added, or its
+   * initial value is set, as by Config::SetDefault().
+   *
+   * \returns The generation.
+   */
+  static uint64_t GetAttributeGeneration (void);
   /**
    * Get the number of attributes.
    *
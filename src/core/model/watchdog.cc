@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "watchdog.h"
+#include "fatal-error.h"
 #include "log.h"
 
 
@@ -34,11 +35,46 @@ NS_LOG_COMPONENT_DEFINE ("Watchdog");
 Watchdog::Watchdog ()
   : m_impl (0),
     m_event (),
+    m_useWheel (false),
     m_end (MicroSeconds (0))
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+Watchdog::Watchdog (const Watchdog &o)
+  : m_impl (o.m_impl),
+    m_event (o.m_event),
+    m_entry (o.m_entry),
+    m_useWheel (o.m_useWheel),
+    m_end (o.m_end)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (m_useWheel)
+    {
+      // the function of the wheel is bound to the Watchdog.
+      m_entry.SetFunction (MakeCallback (&Watchdog::Expire, this));
+    }
+}
+
+Watchdog &
+Watchdog::operator = (const Watchdog &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  if (this != &o)
+    {
+      m_impl = o.m_impl;
+      m_event = o.m_event;
+      m_entry = o.m_entry;
+      m_useWheel = o.m_useWheel;
+      m_end = o.m_end;
+      if (m_useWheel)
+        {
+          m_entry.SetFunction (MakeCallback (&Watchdog::Expire, this));
+        }
+    }
+  return *this;
+}
+
 Watchdog::~Watchdog ()
 {
   NS_LOG_FUNCTION (this);
@@ -50,6 +86,15 @@ Watchdog::Ping (Time delay)
 {
   NS_LOG_FUNCTION (this << delay);
   Time end = Simulator::Now () + delay;
+  if (m_useWheel)
+    {
+      if (end > m_end || !m_entry.IsRunning ())
+        {
+          m_end = std::max (m_end, end);
+          m_entry.Schedule (m_end - Now ());
+        }
+      return;
+    }
   m_end = std::max (m_end, end);
   if (m_event.IsRunning ())
     {
@@ -72,5 +117,20 @@ Watchdog::Expire (void)
     }
 }
 
+void
+Watchdog::SetUseWheel (bool useWheel)
+{
+  NS_LOG_FUNCTION (this << useWheel);
+  if (m_event.IsRunning () || m_entry.IsRunning ())
+    {
+      NS_FATAL_ERROR ("Watchdog is still running while changing the wheel.");
+    }
+  m_useWheel = useWheel;
+  if (useWheel)
+    {
+      m_entry.SetFunction (MakeCallback (&Watchdog::Expire, this));
+    }
+}
+
 } // namespace ns3
 
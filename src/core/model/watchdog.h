@@ -22,6 +22,7 @@
 
 #include "nstime.h"
 #include "event-id.h"
+#include "timer-wheel.h"
 
 /**
  * \file
@@ -58,6 +59,21 @@ class Watchdog
 public:
   /** Constructor. */
   Watchdog ();
+  /**
+   * Copy constructor: the copy invokes its own function when it uses
+   * the TimerWheel.
+   *
+   * \param [in] o The Watchdog to copy.
+   */
+  Watchdog (const Watchdog &o);
+  /**
+   * Assignment: this Watchdog invokes its own function when it uses
+   * the TimerWheel.
+   *
+   * \param [in] o The Watchdog to copy.
+   * \returns This Watchdog.
+   */
+  Watchdog & operator = (const Watchdog &o);
   /** Destructor. */
   ~Watchdog ();
 
@@ -72,6 +88,18 @@ public:
    */
   void Ping (Time delay);
 
+  /**
+   * Keep the watchdog in the TimerWheel of its context, rather than
+   * as an event of the simulator.
+   *
+   * Each Ping then moves the timer of the wheel to the new expire
+   * time, instead of waking up at the old one.  Calling SetUseWheel
+   * while the watchdog is running is an error.
+   *
+   * \param [in] useWheel Whether to use the wheel.
+   */
+  void SetUseWheel (bool useWheel);
+
   /**
    * Set the function to execute when the timer expires.
    *
@@ -178,6 +206,10 @@ private:
   TimerImpl *m_impl;
   /** The future event scheduled to expire the timer. */
   EventId m_event;
+  /** The timer of the wheel, if used. */
+  TimerWheel::Entry m_entry;
+  /** Whether the watchdog is kept in the TimerWheel. */
+  bool m_useWheel;
   /** The absolute time when the timer will expire. */
   Time m_end;
 };
@@ -0,0 +1,275 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/checkpoint.h"
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+using namespace ns3;
+
+class CheckpointTestObject : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+  CheckpointTestObject ();
+  void Start (void);
+  std::vector<double> m_values;
+  uint32_t m_ticks;
+private:
+  void Tick (void);
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual void DoDeserialize (std::istream &is);
+  virtual void DoDispose (void);
+  Ptr<UniformRandomVariable> m_random;
+  EventId m_next;
+};
+
+TypeId
+CheckpointTestObject::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CheckpointTestObject")
+    .SetParent<Object> ()
+    .SetGroupName ("Core")
+  ;
+  return tid;
+}
+
+CheckpointTestObject::CheckpointTestObject ()
+  : m_ticks (0)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (42);
+}
+
+void
+CheckpointTestObject::Start (void)
+{
+  m_next = Simulator::Schedule (Seconds (0), &CheckpointTestObject::Tick, this);
+}
+
+void
+CheckpointTestObject::Tick (void)
+{
+  m_ticks++;
+  double value = m_random->GetValue ();
+  m_values.push_back (value);
+  m_next = Simulator::Schedule (Seconds (value), &CheckpointTestObject::Tick, this);
+}
+
+void
+CheckpointTestObject::DoSerialize (std::ostream &os) const
+{
+  Object::DoSerialize (os);
+  os << m_ticks << " " << Simulator::GetDelayLeft (m_next).GetTimeStep ();
+}
+
+void
+CheckpointTestObject::DoDeserialize (std::istream &is)
+{
+  Object::DoDeserialize (is);
+  int64_t delay;
+  is >> m_ticks >> delay;
+  m_next.Cancel ();
+  m_next = Simulator::Schedule (TimeStep (delay), &CheckpointTestObject::Tick, this);
+}
+
+void
+CheckpointTestObject::DoDispose (void)
+{
+  m_next.Cancel ();
+  m_random = 0;
+  Object::DoDispose ();
+}
+
+class CheckpointRestoreTestCase : public TestCase
+{
+public:
+  CheckpointRestoreTestCase ();
+  virtual void DoRun (void);
+  std::vector<double> Replicate (std::string checkpoint, uint64_t run, uint32_t ticks);
+};
+
+CheckpointRestoreTestCase::CheckpointRestoreTestCase ()
+  : TestCase ("Check that a restored simulation continues like the original one")
+{
+}
+
+std::vector<double>
+CheckpointRestoreTestCase::Replicate (std::string checkpoint, uint64_t run, uint32_t ticks)
+{
+  uint64_t originalRun = RngSeedManager::GetRun ();
+  RngSeedManager::SetRun (run);
+  Ptr<CheckpointTestObject> object = CreateObject<CheckpointTestObject> ();
+  Checkpoint::Register (object);
+  // this event is discarded by Restore.
+  object->Start ();
+  std::istringstream is (checkpoint);
+  Checkpoint::Restore (is);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (10), "the time of the checkpoint");
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  std::vector<double> values = object->m_values;
+  NS_TEST_EXPECT_MSG_EQ (object->m_ticks, ticks + values.size (), "the state of the object should be restored");
+  Simulator::Destroy ();
+  RngSeedManager::SetRun (originalRun);
+  return values;
+}
+
+void
+CheckpointRestoreTestCase::DoRun (void)
+{
+  Ptr<CheckpointTestObject> object = CreateObject<CheckpointTestObject> ();
+  object->Start ();
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  std::vector<double> reference = object->m_values;
+  object = 0;
+  Simulator::Destroy ();
+
+  object = CreateObject<CheckpointTestObject> ();
+  Checkpoint::Register (object);
+  object->Start ();
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  std::ostringstream os;
+  Checkpoint::Save (os);
+  uint32_t ticks = object->m_ticks;
+  object = 0;
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_GT (ticks, 5, "the warm-up should have run");
+  NS_TEST_ASSERT_MSG_GT (reference.size (), ticks + 5, "the reference should run past the warm-up");
+  std::vector<double> tail (reference.begin () + ticks, reference.end ());
+
+  std::vector<double> same = Replicate (os.str (), RngSeedManager::GetRun (), ticks);
+  NS_TEST_EXPECT_MSG_EQ ((same == tail), true, "the same run should continue like the reference");
+
+  std::vector<double> other = Replicate (os.str (), RngSeedManager::GetRun () + 1, ticks);
+  NS_TEST_EXPECT_MSG_EQ ((other == tail), false, "another run should draw other values");
+}
+
+class CheckpointForkTestCase : public TestCase
+{
+public:
+  CheckpointForkTestCase ();
+  virtual void DoRun (void);
+};
+
+CheckpointForkTestCase::CheckpointForkTestCase ()
+  : TestCase ("Check that forked replications draw independent values")
+{
+}
+
+void
+CheckpointForkTestCase::DoRun (void)
+{
+  Ptr<CheckpointTestObject> object = CreateObject<CheckpointTestObject> ();
+  object->Start ();
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  uint32_t ticks = object->m_ticks;
+
+  uint32_t replication = Checkpoint::Fork (2);
+  if (replication != 0)
+    {
+      Simulator::Stop (Seconds (10));
+      Simulator::Run ();
+      std::ostringstream filename;
+      filename << "replication-" << replication;
+      std::ofstream os (CreateTempDirFilename (filename.str ()).c_str ());
+      os << object->m_ticks - ticks << " " << object->m_values.back ();
+      os.close ();
+      _exit (0);
+    }
+
+  std::string results[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      std::ostringstream filename;
+      filename << "replication-" << i + 1;
+      std::ifstream is (CreateTempDirFilename (filename.str ()).c_str ());
+      std::getline (is, results[i]);
+      NS_TEST_EXPECT_MSG_NE (results[i], "", "replication " << i + 1 << " should have run");
+    }
+  NS_TEST_EXPECT_MSG_NE (results[0], results[1], "the replications should draw independent values");
+  NS_TEST_EXPECT_MSG_EQ (object->m_ticks, ticks, "the parent should not run the replications");
+  object = 0;
+  Simulator::Destroy ();
+}
+
+class CheckpointForkConcurrencyTestCase : public TestCase
+{
+public:
+  CheckpointForkConcurrencyTestCase ();
+  virtual void DoRun (void);
+};
+
+CheckpointForkConcurrencyTestCase::CheckpointForkConcurrencyTestCase ()
+  : TestCase ("Check that Fork runs at most the given number of replications at once")
+{
+}
+
+void
+CheckpointForkConcurrencyTestCase::DoRun (void)
+{
+  // one at a time, each replication finds the result of the previous one.
+  uint32_t replication = Checkpoint::Fork (3, 1);
+  if (replication != 0)
+    {
+      bool previous = true;
+      if (replication > 1)
+        {
+          std::ostringstream filename;
+          filename << "sequential-" << replication - 1;
+          std::ifstream is (CreateTempDirFilename (filename.str ()).c_str ());
+          previous = is.is_open ();
+        }
+      std::ostringstream filename;
+      filename << "sequential-" << replication;
+      std::ofstream os (CreateTempDirFilename (filename.str ()).c_str ());
+      os << previous;
+      os.close ();
+      _exit (0);
+    }
+
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      std::ostringstream filename;
+      filename << "sequential-" << i;
+      std::ifstream is (CreateTempDirFilename (filename.str ()).c_str ());
+      std::string result;
+      std::getline (is, result);
+      NS_TEST_EXPECT_MSG_EQ (result, "1", "replication " << i << " should run after the previous one");
+    }
+}
+
+static class CheckpointTestSuite : public TestSuite
+{
+public:
+  CheckpointTestSuite ()
+    : TestSuite ("checkpoint")
+  {
+    AddTestCase (new CheckpointRestoreTestCase (), TestCase::QUICK);
+    AddTestCase (new CheckpointForkTestCase (), TestCase::QUICK);
+    AddTestCase (new CheckpointForkConcurrencyTestCase (), TestCase::QUICK);
+  }
+} g_checkpointTestSuite;
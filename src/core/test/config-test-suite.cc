@@ -721,6 +721,94 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+// ===========================================================================
+// Test that the Config path resolver finds the same objects, in the same
+// order, when it looks up the plain indices without scanning the
+// containers, and that it follows the changes of the containers and of
+// the Pointer attributes.
+// ===========================================================================
+class IndexedConfigTestCase : public TestCase
+{
+public:
+  IndexedConfigTestCase ();
+  virtual ~IndexedConfigTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+IndexedConfigTestCase::IndexedConfigTestCase ()
+  : TestCase ("Check the Config lookups through indices")
+{
+}
+
+void
+IndexedConfigTestCase::DoRun (void)
+{
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+  std::vector<Ptr<ConfigTestObject> > nodes;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ptr<ConfigTestObject> node = CreateObject<ConfigTestObject> ();
+      Ptr<ConfigTestObject> child = CreateObject<ConfigTestObject> ();
+      node->SetNodeB (child);
+      root->AddNodeA (node);
+      nodes.push_back (node);
+    }
+  Names::Add ("IndexedRoot", root);
+
+  Config::MatchContainer first = Config::LookupMatches ("/NodesA/*/NodeB");
+  Config::MatchContainer second = Config::LookupMatches ("/NodesA/*/NodeB");
+  NS_TEST_ASSERT_MSG_EQ (first.GetN (), 100, "all the objects should match");
+  NS_TEST_ASSERT_MSG_EQ (second.GetN (), first.GetN (), "the lookup should find the same objects");
+  for (uint32_t i = 0; i < first.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (second.Get (i), first.Get (i), "the lookup should keep the order");
+      NS_TEST_EXPECT_MSG_EQ (second.GetMatchedPath (i), first.GetMatchedPath (i), "the lookup should keep the paths");
+    }
+  NS_TEST_EXPECT_MSG_EQ (first.GetMatchedPath (3), "/NodesA/3/NodeB/", "the path of the fourth object");
+  Config::LookupMatches ("/Names/IndexedRoot/NodesA/*/NodeB");
+  Config::MatchContainer named = Config::LookupMatches ("/Names/IndexedRoot/NodesA/*/NodeB");
+  NS_TEST_ASSERT_MSG_EQ (named.GetN (), 100, "all the objects should match through the name");
+  NS_TEST_EXPECT_MSG_EQ (named.Get (3), first.Get (3), "the name should lead to the same objects");
+  NS_TEST_EXPECT_MSG_EQ (named.GetMatchedPath (3), "/Names/IndexedRoot/NodesA/3/NodeB/", "the path of the named object");
+
+  Config::Set ("/NodesA/*/B", IntegerValue (3));
+  Config::Set ("/NodesA/[10-19]/B", IntegerValue (4));
+  Config::Set ("/NodesA/57/B", IntegerValue (5));
+  NS_TEST_EXPECT_MSG_EQ ((int)nodes[0]->GetB (), 3, "the wildcard should match");
+  NS_TEST_EXPECT_MSG_EQ ((int)nodes[15]->GetB (), 4, "the range should match");
+  NS_TEST_EXPECT_MSG_EQ ((int)nodes[57]->GetB (), 5, "the index should match");
+
+  Config::MatchContainer one = Config::LookupMatches ("/NodesA/57/NodeB");
+  NS_TEST_ASSERT_MSG_EQ (one.GetN (), 1, "the index should match one object");
+  NS_TEST_EXPECT_MSG_EQ (one.GetMatchedPath (0), "/NodesA/57/NodeB/", "the path of the indexed object");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodesA/100").GetN (), 0, "the index is out of range");
+
+  // adding an existing object creates none.
+  root->AddNodeA (nodes[0]);
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodesA/*/NodeB").GetN (), 101, "the new entry should match");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodesA/100/NodeB").GetN (), 1, "the index should find the new entry");
+
+  // re-pointing a Pointer attribute through its setter, as SetQueue ()
+  // does, is followed by the next lookup.
+  PointerValue pointer;
+  nodes[5]->GetAttribute ("NodeB", pointer);
+  Ptr<ConfigTestObject> child = pointer.Get<ConfigTestObject> ();
+  Config::Set ("/NodesA/5/NodeB/B", IntegerValue (6));
+  Ptr<ConfigTestObject> other = CreateObject<ConfigTestObject> ();
+  nodes[5]->SetNodeB (other);
+  Config::Set ("/NodesA/5/NodeB/B", IntegerValue (7));
+  NS_TEST_EXPECT_MSG_EQ ((int)other->GetB (), 7, "the path should lead to the new object");
+  NS_TEST_EXPECT_MSG_EQ ((int)child->GetB (), 6, "the path should not lead to the old object");
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodesA/5/NodeB").Get (0), other, "the path should lead to the new object");
+
+  Names::Clear ();
+  Config::UnregisterRootNamespaceObject (root);
+  NS_TEST_EXPECT_MSG_EQ (Config::LookupMatches ("/NodesA/*/NodeB").GetN (), 0, "the root should be gone");
+}
+
 // ===========================================================================
 // The Test Suite that glues all of the Test Cases together.
 // ===========================================================================
@@ -737,6 +825,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase, TestCase::QUICK);
   AddTestCase (new ObjectVectorConfigTestCase, TestCase::QUICK);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase, TestCase::QUICK);
+  AddTestCase (new IndexedConfigTestCase, TestCase::QUICK);
 }
 
 static ConfigTestSuite configTestSuite;
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/event-pool.h"
+#include "ns3/map-scheduler.h"
+#include "ns3/list-scheduler.h"
+#include "ns3/mpsc-queue.h"
+#include "ns3/system-thread.h"
+#include <vector>
+
+using namespace ns3;
+
+class EventPoolBlocksTestCase : public TestCase
+{
+public:
+  EventPoolBlocksTestCase ();
+  virtual void DoRun (void);
+};
+
+EventPoolBlocksTestCase::EventPoolBlocksTestCase ()
+  : TestCase ("Check the alignment and reuse of the blocks")
+{
+}
+
+void
+EventPoolBlocksTestCase::DoRun (void)
+{
+  std::vector<char *> blocks;
+  for (uint32_t size = 1; size <= 1024; size += 7)
+    {
+      char *block = static_cast<char *> (EventPool::Allocate (size));
+      NS_TEST_ASSERT_MSG_EQ (reinterpret_cast<uintptr_t> (block) % sizeof (void *), 0,
+                             "misaligned block of " << size << " bytes");
+      for (uint32_t i = 0; i < size; i++)
+        {
+          block[i] = size & 0xff;
+        }
+      blocks.push_back (block);
+    }
+  uint32_t size = 1;
+  for (std::vector<char *>::iterator i = blocks.begin (); i != blocks.end (); ++i, size += 7)
+    {
+      for (uint32_t j = 0; j < size; j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((*i)[j], (char)(size & 0xff), "overlapping blocks");
+        }
+      EventPool::Deallocate (*i, size);
+    }
+
+  if (EventPool::IsEnabled ())
+    {
+      void *a = EventPool::Allocate (40);
+      EventPool::Deallocate (a, 40);
+      void *b = EventPool::Allocate (48);
+      NS_TEST_EXPECT_MSG_EQ (a, b, "a released block should be reused within its size class");
+      EventPool::Deallocate (b, 48);
+    }
+}
+
+class EventPoolSimulationTestCase : public TestCase
+{
+public:
+  EventPoolSimulationTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Tick (uint32_t left);
+  ObjectFactory m_schedulerFactory;
+};
+
+EventPoolSimulationTestCase::EventPoolSimulationTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check the event allocations with " + schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+EventPoolSimulationTestCase::Tick (uint32_t left)
+{
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &EventPoolSimulationTestCase::Tick, this, left - 1);
+    }
+}
+
+void
+EventPoolSimulationTestCase::DoRun (void)
+{
+  const uint32_t events = 100000;
+  Simulator::SetScheduler (m_schedulerFactory);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventPoolSimulationTestCase::Tick, this, events / 100);
+    }
+  EventPool::Stats before = EventPool::GetStats ();
+  Simulator::Run ();
+  EventPool::Stats after = EventPool::GetStats ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.allocations - before.allocations, events,
+                               "every event should be allocated from the pool");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.deallocations - before.deallocations, events,
+                               "every event should be released to the pool");
+  if (EventPool::IsEnabled ())
+    {
+      NS_TEST_EXPECT_MSG_LT (after.systemAllocations - before.systemAllocations, events / 1000,
+                             "the events should be recycled");
+    }
+}
+
+class EventPoolQueueTestCase : public TestCase
+{
+public:
+  EventPoolQueueTestCase ();
+  virtual void DoRun (void);
+  void Produce (void);
+  MpscQueue<uint32_t> m_queue;
+};
+
+static const uint32_t QUEUE_VALUES = 100000;
+
+EventPoolQueueTestCase::EventPoolQueueTestCase ()
+  : TestCase ("Check that the cross-thread queue recycles its nodes")
+{
+}
+
+void
+EventPoolQueueTestCase::Produce (void)
+{
+  for (uint32_t i = 0; i < QUEUE_VALUES; i++)
+    {
+      m_queue.Push (i);
+    }
+}
+
+void
+EventPoolQueueTestCase::DoRun (void)
+{
+  EventPool::Stats before = EventPool::GetStats ();
+  Ptr<SystemThread> producer = Create<SystemThread> (MakeCallback (&EventPoolQueueTestCase::Produce, this));
+  producer->Start ();
+  uint32_t expected = 0;
+  while (expected < QUEUE_VALUES)
+    {
+      uint32_t value;
+      if (m_queue.Pop (value))
+        {
+          NS_TEST_ASSERT_MSG_EQ (value, expected, "the values should be popped in order");
+          expected++;
+        }
+    }
+  producer->Join ();
+  // the counters of the producer are included once it has exited.
+  EventPool::Stats after = EventPool::GetStats ();
+
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.allocations - before.allocations, QUEUE_VALUES,
+                               "every node should be allocated from the pool");
+  if (EventPool::IsEnabled ())
+    {
+      NS_TEST_EXPECT_MSG_LT (after.systemAllocations - before.systemAllocations, QUEUE_VALUES / 1000,
+                             "the nodes released by the consumer should be recycled");
+    }
+}
+
+static class EventPoolTestSuite : public TestSuite
+{
+public:
+  EventPoolTestSuite ()
+    : TestSuite ("event-pool")
+  {
+    AddTestCase (new EventPoolBlocksTestCase (), TestCase::QUICK);
+    ObjectFactory factory;
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new EventPoolSimulationTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (ListScheduler::GetTypeId ());
+    AddTestCase (new EventPoolSimulationTestCase (factory), TestCase::QUICK);
+    AddTestCase (new EventPoolQueueTestCase (), TestCase::QUICK);
+  }
+} g_eventPoolTestSuite;
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-profiler.h"
+#include "ns3/string.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+static void
+SlowEvent (void)
+{
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now () + std::chrono::microseconds (200);
+  while (std::chrono::steady_clock::now () < end)
+    {
+    }
+}
+
+static void
+FastEvent (void)
+{
+}
+
+class EventProfilerTestCase : public TestCase
+{
+public:
+  EventProfilerTestCase ();
+  virtual void DoRun (void);
+  void MemberEvent (uint32_t value);
+  uint32_t m_sum;
+};
+
+EventProfilerTestCase::EventProfilerTestCase ()
+  : TestCase ("Check the event counts and times by function and by node")
+{
+}
+
+void
+EventProfilerTestCase::MemberEvent (uint32_t value)
+{
+  m_sum += value;
+}
+
+void
+EventProfilerTestCase::DoRun (void)
+{
+  Ptr<DefaultSimulatorImpl> impl = DynamicCast<DefaultSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl == 0)
+    {
+      return;
+    }
+  std::string file = CreateTempDirFilename ("event-profile.txt");
+  impl->SetAttribute ("ProfilerFile", StringValue (file));
+  impl->SetProfilerEnabled (true);
+  NS_TEST_ASSERT_MSG_EQ (impl->IsProfilerEnabled (), true, "the profiler should be enabled");
+
+  m_sum = 0;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::ScheduleWithContext (1, MicroSeconds (i), &SlowEvent);
+    }
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::ScheduleWithContext (2, MicroSeconds (i), &FastEvent);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i), &EventProfilerTestCase::MemberEvent, this, i);
+    }
+  EventId cancelled = Simulator::Schedule (MicroSeconds (1), &FastEvent);
+  Simulator::Cancel (cancelled);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 10, "the member events should have run");
+
+  const EventProfiler *profiler = impl->GetProfiler ();
+  NS_TEST_ASSERT_MSG_EQ (profiler->GetEventCount (), 125, "the cancelled event should not be counted");
+
+  std::vector<EventProfiler::Entry> functions = profiler->GetFunctions ();
+  NS_TEST_ASSERT_MSG_EQ (functions.size (), 3, "there should be one entry per function");
+  NS_TEST_EXPECT_MSG_EQ (functions[0].count, 20, "SlowEvent should come first");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (functions[0].total, 20 * 200e-6 * 0.9, "the SlowEvent time");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (functions[0].max, 200e-6 * 0.9, "the SlowEvent longest time");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (functions[0].max, functions[0].total, "the SlowEvent longest time");
+  uint64_t others = functions[1].count * functions[2].count;
+  NS_TEST_EXPECT_MSG_EQ (others, 500, "FastEvent and MemberEvent should come next");
+
+  std::vector<EventProfiler::Entry> nodes = profiler->GetNodes ();
+  NS_TEST_ASSERT_MSG_EQ (nodes.size (), 3, "there should be one entry per context");
+  NS_TEST_EXPECT_MSG_EQ (nodes[0].name, "1", "node 1 should come first");
+  NS_TEST_EXPECT_MSG_EQ (nodes[0].count, 20, "the events of node 1");
+  NS_TEST_EXPECT_MSG_EQ (nodes[1].count + nodes[2].count, 105, "the events of node 2 and without context");
+
+  Simulator::Destroy ();
+
+  std::ifstream is (file.c_str ());
+  std::ostringstream report;
+  report << is.rdbuf ();
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("Event profile: 125 events"), std::string::npos,
+                         "the profile should be written at Destroy");
+  NS_TEST_EXPECT_MSG_NE (report.str ().find ("By node:"), std::string::npos,
+                         "the profile should be written at Destroy");
+}
+
+static class EventProfilerTestSuite : public TestSuite
+{
+public:
+  EventProfilerTestSuite ()
+    : TestSuite ("event-profiler")
+  {
+    AddTestCase (new EventProfilerTestCase (), TestCase::QUICK);
+  }
+} g_eventProfilerTestSuite;
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef HAVE_PTHREAD_H
+#include <thread>
+#endif
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LogAsyncTestSuite");
+
+// the logging macros are empty without NS3_LOG_ENABLE.
+#ifdef NS3_LOG_ENABLE
+
+class LogAsyncOutputTestCase : public TestCase
+{
+public:
+  LogAsyncOutputTestCase ();
+  virtual void DoRun (void);
+  void Emit (int value);
+  std::string Run (bool async);
+  int Inner (void);
+};
+
+LogAsyncOutputTestCase::LogAsyncOutputTestCase ()
+  : TestCase ("Check that the asynchronous logging prints as the synchronous one")
+{
+}
+
+void
+LogAsyncOutputTestCase::Emit (int value)
+{
+  NS_LOG_FUNCTION (this << value << "text");
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_INFO ("info " << value);
+  NS_LOG_WARN ("warn " << value * 2);
+  NS_LOG_LOGIC ("logic");
+  NS_LOG_UNCOND ("uncond " << value);
+}
+
+int
+LogAsyncOutputTestCase::Inner (void)
+{
+  NS_LOG_INFO ("inner");
+  return 1;
+}
+
+std::string
+LogAsyncOutputTestCase::Run (bool async)
+{
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  LogSetAsync (async);
+  NS_TEST_EXPECT_MSG_EQ (LogIsAsync (), async, "the logging mode");
+  LogComponentEnable ("LogAsyncTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  Simulator::ScheduleWithContext (3, Seconds (1.5), &LogAsyncOutputTestCase::Emit, this, 7);
+  Simulator::Schedule (Seconds (2), &LogAsyncOutputTestCase::Emit, this, 8);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  // without the simulator stamps.
+  Emit (9);
+  LogComponentDisable ("LogAsyncTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  LogSetAsync (false);
+  std::clog.rdbuf (clog);
+  return oss.str ();
+}
+
+void
+LogAsyncOutputTestCase::DoRun (void)
+{
+  std::string sync = Run (false);
+  std::string async = Run (true);
+  NS_TEST_EXPECT_MSG_NE (sync.find ("1.5s 3 LogAsyncTestSuite:Emit(): [INFO ] info 7\n"),
+                         std::string::npos, "the prefixes of a message");
+  NS_TEST_EXPECT_MSG_EQ (async, sync, "the two modes should print the same messages");
+
+  // a message can log while it is formatted.
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  LogSetAsync (true);
+  LogComponentEnable ("LogAsyncTestSuite", LOG_LEVEL_INFO);
+  NS_LOG_INFO ("outer " << Inner ());
+  LogComponentDisable ("LogAsyncTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  LogAsyncFlush ();
+  NS_TEST_EXPECT_MSG_EQ (oss.str (), "inner\nouter 1\n", "the nested message is logged first");
+  LogSetAsync (false);
+  std::clog.rdbuf (clog);
+}
+
+#ifdef HAVE_PTHREAD_H
+class LogAsyncThreadsTestCase : public TestCase
+{
+public:
+  LogAsyncThreadsTestCase ();
+  virtual void DoRun (void);
+  static void Emit (uint32_t thread, uint32_t n);
+};
+
+LogAsyncThreadsTestCase::LogAsyncThreadsTestCase ()
+  : TestCase ("Check the asynchronous logging of several threads, beyond the size of their rings")
+{
+}
+
+void
+LogAsyncThreadsTestCase::Emit (uint32_t thread, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_LOG_INFO (thread << " " << i);
+    }
+}
+
+void
+LogAsyncThreadsTestCase::DoRun (void)
+{
+  const uint32_t threads = 4;
+  // more than a ring of 1MiB holds.
+  const uint32_t n = 20000;
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  LogSetAsync (true);
+  LogComponentEnable ("LogAsyncTestSuite", LOG_LEVEL_INFO);
+  std::vector<std::thread> emitters;
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      emitters.push_back (std::thread (&LogAsyncThreadsTestCase::Emit, t, n));
+    }
+  for (uint32_t t = 0; t < threads; t++)
+    {
+      emitters[t].join ();
+    }
+  LogComponentDisable ("LogAsyncTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+  LogSetAsync (false);
+  std::clog.rdbuf (clog);
+
+  std::vector<uint32_t> next (threads, 0);
+  std::istringstream iss (oss.str ());
+  uint32_t thread;
+  uint32_t i;
+  uint32_t lines = 0;
+  while (iss >> thread >> i)
+    {
+      lines++;
+      NS_TEST_ASSERT_MSG_LT (thread, threads, "the thread of a message");
+      NS_TEST_ASSERT_MSG_EQ (i, next[thread], "the messages of a thread should be in order");
+      next[thread]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (lines, threads * n, "all the messages should be printed");
+}
+#endif /* HAVE_PTHREAD_H */
+#endif /* NS3_LOG_ENABLE */
+
+static class LogAsyncTestSuite : public TestSuite
+{
+public:
+  LogAsyncTestSuite ()
+    : TestSuite ("log-async")
+  {
+#ifdef NS3_LOG_ENABLE
+    AddTestCase (new LogAsyncOutputTestCase (), TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+    AddTestCase (new LogAsyncThreadsTestCase (), TestCase::QUICK);
+#endif
+#endif /* NS3_LOG_ENABLE */
+  }
+} g_logAsyncTestSuite;
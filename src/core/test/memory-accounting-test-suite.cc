@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/memory-accounting.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+class Accounted : public Object
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("MemoryAccountingTest:Accounted")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .HideFromDocumentation ()
+      .AddConstructor<Accounted> ();
+    return tid;
+  }
+  char m_payload[200];
+};
+
+NS_OBJECT_ENSURE_REGISTERED (Accounted);
+
+} // unnamed namespace
+
+class MemoryAccountingObjectTestCase : public TestCase
+{
+public:
+  MemoryAccountingObjectTestCase ();
+  virtual void DoRun (void);
+  void Allocate (void);
+  std::vector<Ptr<Accounted> > m_objects;
+};
+
+MemoryAccountingObjectTestCase::MemoryAccountingObjectTestCase ()
+  : TestCase ("Check the accounting of the Objects by TypeId and by node")
+{
+}
+
+void
+MemoryAccountingObjectTestCase::Allocate (void)
+{
+  m_objects.push_back (CreateObject<Accounted> ());
+}
+
+void
+MemoryAccountingObjectTestCase::DoRun (void)
+{
+  Ptr<Accounted> before = CreateObject<Accounted> ();
+  MemoryAccounting::Enable ();
+  NS_TEST_ASSERT_MSG_EQ (MemoryAccounting::IsEnabled (), true, "the accounting should be enabled");
+
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_objects.push_back (CreateObject<Accounted> ());
+    }
+  ObjectFactory factory;
+  factory.SetTypeId (Accounted::GetTypeId ());
+  std::vector<Ptr<Object> > batch = factory.CreateN (2);
+  MemoryAccounting::Entry usage = MemoryAccounting::GetUsage (Accounted::GetTypeId ());
+  NS_TEST_EXPECT_MSG_EQ (usage.count, 5, "the Objects created since the accounting was enabled");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (usage.bytes, 5 * sizeof (Accounted), "the size of the Objects");
+  NS_TEST_EXPECT_MSG_LT (usage.bytes, 5 * (sizeof (Accounted) + 64), "the size of the Objects");
+
+  Simulator::ScheduleWithContext (7, Seconds (1), &MemoryAccountingObjectTestCase::Allocate, this);
+  Simulator::ScheduleWithContext (7, Seconds (2), &MemoryAccountingObjectTestCase::Allocate, this);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetUsage ("MemoryAccountingTest:Accounted").count, 7,
+                         "the Objects created by the events");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetNodeUsage (7).count, 2, "the Objects created by node 7");
+  std::vector<MemoryAccounting::Entry> nodes = MemoryAccounting::GetNodes ();
+  bool found = false;
+  for (uint32_t i = 0; i < nodes.size (); i++)
+    {
+      if (nodes[i].name == "7")
+        {
+          found = true;
+          NS_TEST_EXPECT_MSG_EQ (nodes[i].bytes, MemoryAccounting::GetNodeUsage (7).bytes, "the size of node 7");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "node 7 should be reported");
+
+  // an Object created at setup which is attached to a node moves
+  // under it.
+  MemoryAccounting::Entry setup = MemoryAccounting::GetNodeUsage (Simulator::NO_CONTEXT);
+  MemoryAccounting::NotifyContext (PeekPointer (m_objects[0]), 7);
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetNodeUsage (7).count, 3, "the Object attached to node 7");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetNodeUsage (Simulator::NO_CONTEXT).count, setup.count - 1,
+                         "the Object is no longer without context");
+
+  // deleted Objects are no longer accounted for, including those
+  // created before the accounting was enabled.
+  before = 0;
+  m_objects.clear ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetUsage (Accounted::GetTypeId ()).count, 2, "the remaining Objects");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetNodeUsage (7).count, 0, "the Objects of node 7 are deleted");
+
+  std::ostringstream oss;
+  MemoryAccounting::Print (oss);
+  NS_TEST_EXPECT_MSG_NE (oss.str ().find ("MemoryAccountingTest:Accounted"), std::string::npos,
+                         "the report should name the TypeId");
+
+  Simulator::Destroy ();
+  MemoryAccounting::Disable ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetTotal ().count, 0, "nothing is accounted for once disabled");
+  batch.clear ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetTotal ().count, 0, "nothing is accounted for once disabled");
+}
+
+class MemoryAccountingMonitorTestCase : public TestCase
+{
+public:
+  MemoryAccountingMonitorTestCase ();
+  virtual void DoRun (void);
+  void Report (const std::vector<MemoryAccounting::Entry> &types,
+               const std::vector<MemoryAccounting::Entry> &nodes);
+  void Allocate (void);
+  uint32_t m_reports;
+  uint64_t m_last;
+  std::vector<Ptr<Accounted> > m_objects;
+};
+
+MemoryAccountingMonitorTestCase::MemoryAccountingMonitorTestCase ()
+  : TestCase ("Check the periodic reports of the MemoryAccountingMonitor")
+{
+}
+
+void
+MemoryAccountingMonitorTestCase::Allocate (void)
+{
+  m_objects.push_back (CreateObject<Accounted> ());
+}
+
+void
+MemoryAccountingMonitorTestCase::Report (const std::vector<MemoryAccounting::Entry> &types,
+                                         const std::vector<MemoryAccounting::Entry> &nodes)
+{
+  m_reports++;
+  for (uint32_t i = 0; i < types.size (); i++)
+    {
+      if (types[i].name == "MemoryAccountingTest:Accounted")
+        {
+          NS_TEST_EXPECT_MSG_GT (types[i].count, m_last, "the Objects should grow between the reports");
+          m_last = types[i].count;
+        }
+    }
+}
+
+void
+MemoryAccountingMonitorTestCase::DoRun (void)
+{
+  m_reports = 0;
+  m_last = 0;
+  Ptr<MemoryAccountingMonitor> monitor = CreateObject<MemoryAccountingMonitor> ();
+  monitor->SetAttribute ("Interval", TimeValue (Seconds (1)));
+  monitor->TraceConnectWithoutContext ("Report", MakeCallback (&MemoryAccountingMonitorTestCase::Report, this));
+  monitor->Start ();
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Simulator::ScheduleWithContext (i, Seconds (i + 0.5), &MemoryAccountingMonitorTestCase::Allocate, this);
+    }
+  Simulator::Stop (Seconds (4.5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_reports, 4, "a report every second");
+  NS_TEST_EXPECT_MSG_EQ (m_last, 4, "the last report should count all the Objects");
+  monitor->Dispose ();
+  Simulator::Destroy ();
+  MemoryAccounting::Disable ();
+  m_objects.clear ();
+}
+
+static class MemoryAccountingTestSuite : public TestSuite
+{
+public:
+  MemoryAccountingTestSuite ()
+    : TestSuite ("memory-accounting")
+  {
+    AddTestCase (new MemoryAccountingObjectTestCase (), TestCase::QUICK);
+    AddTestCase (new MemoryAccountingMonitorTestCase (), TestCase::QUICK);
+  }
+} g_memoryAccountingTestSuite;
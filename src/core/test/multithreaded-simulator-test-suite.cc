@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * Exchange messages between a set of contexts, each of them only
+ * touching its own state, and compare the per-context history with
+ * the one produced by the default simulator: the events, including
+ * the simultaneous ones, must be executed in exactly the same order.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] threads The number of partitions.
+   * \param [in] schedulerType The scheduler used by each partition.
+   */
+  MultithreadedSimulatorTestCase (uint32_t threads, std::string schedulerType);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /** The history of the events in each context. */
+  typedef std::vector<std::vector<std::string> > History;
+
+  /**
+   * Run the scenario with a simulator implementation.
+   * \param [in] impl The simulator implementation.
+   * \return The history of each context.
+   */
+  History RunScenario (Ptr<SimulatorImpl> impl);
+  /**
+   * Check that two histories are equal.
+   * \param [in] actual The history to check.
+   * \param [in] expected The expected history.
+   */
+  void CheckHistory (History actual, History expected);
+  /**
+   * Receive a message in a context.
+   * \param [in] from The sending context.
+   * \param [in] hops The number of hops left.
+   */
+  void Receive (uint32_t from, uint32_t hops);
+  /** Record the current time from a context-less event. */
+  void Global (void);
+  /** Record the expiration of the timer of a context. */
+  void Timeout (void);
+
+  uint32_t m_threads;                          //!< The number of partitions.
+  std::string m_schedulerType;                 //!< The scheduler type.
+  History m_history;                           //!< History of each context.
+  std::vector<EventId> m_timers;               //!< Timer of each context.
+};
+
+static const uint32_t CONTEXTS = 16;
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase (uint32_t threads, std::string schedulerType)
+  : TestCase ("Check that the multithreaded simulator matches the default one with "
+              + schedulerType),
+    m_threads (threads),
+    m_schedulerType (schedulerType)
+{
+}
+
+void
+MultithreadedSimulatorTestCase::Receive (uint32_t from, uint32_t hops)
+{
+  uint32_t context = Simulator::GetContext ();
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetNanoSeconds () << ":" << from;
+  m_history[context].push_back (oss.str ());
+  if (hops == 0)
+    {
+      return;
+    }
+  // restart the timer of the context, which may have been handed over
+  // to another window.
+  EventId &timer = m_timers[context];
+  if (!timer.IsExpired ())
+    {
+      oss.str ("");
+      oss << "left:" << Simulator::GetDelayLeft (timer).GetNanoSeconds ();
+      m_history[context].push_back (oss.str ());
+      if (hops % 2)
+        {
+          Simulator::Remove (timer);
+        }
+      else
+        {
+          timer.Cancel ();
+        }
+    }
+  timer = Simulator::Schedule (MicroSeconds (hops % 4), &MultithreadedSimulatorTestCase::Timeout, this);
+  if (hops % 3 == 0)
+    {
+      Simulator::ScheduleNow (&MultithreadedSimulatorTestCase::Timeout, this);
+    }
+  // a local timer, then two messages to other contexts.
+  Simulator::Schedule (NanoSeconds (1 + (context + hops) % 7),
+                       &MultithreadedSimulatorTestCase::Receive, this, context, 0);
+  uint32_t next = (context * 5 + hops) % CONTEXTS;
+  Simulator::ScheduleWithContext (next, MicroSeconds (1) + NanoSeconds ((hops * 13 + context) % 17),
+                                  &MultithreadedSimulatorTestCase::Receive, this, context, hops - 1);
+  next = (context + 1) % CONTEXTS;
+  Simulator::ScheduleWithContext (next, MicroSeconds (2) + NanoSeconds (context),
+                                  &MultithreadedSimulatorTestCase::Receive, this, context, hops / 2);
+}
+
+void
+MultithreadedSimulatorTestCase::Global (void)
+{
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetNanoSeconds ();
+  m_history[CONTEXTS].push_back (oss.str ());
+}
+
+void
+MultithreadedSimulatorTestCase::Timeout (void)
+{
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetNanoSeconds () << ":timeout";
+  m_history[Simulator::GetContext ()].push_back (oss.str ());
+}
+
+MultithreadedSimulatorTestCase::History
+MultithreadedSimulatorTestCase::RunScenario (Ptr<SimulatorImpl> impl)
+{
+  Simulator::SetImplementation (impl);
+  ObjectFactory factory;
+  factory.SetTypeId (m_schedulerType);
+  Simulator::SetScheduler (factory);
+
+  // the last entry records the context-less events.
+  m_history.clear ();
+  m_history.resize (CONTEXTS + 1);
+  m_timers.clear ();
+  m_timers.resize (CONTEXTS);
+  for (uint32_t i = 0; i < CONTEXTS; ++i)
+    {
+      Simulator::ScheduleWithContext (i, NanoSeconds (i * 3),
+                                      &MultithreadedSimulatorTestCase::Receive, this, i, 12);
+    }
+  for (uint32_t i = 1; i < 10; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (i * 2), &MultithreadedSimulatorTestCase::Global, this);
+    }
+  Simulator::Run ();
+  Global ();
+  Simulator::Destroy ();
+  return m_history;
+}
+
+void
+MultithreadedSimulatorTestCase::CheckHistory (History actual, History expected)
+{
+  for (uint32_t i = 0; i < expected.size (); ++i)
+    {
+      std::ostringstream actualStr, expectedStr;
+      std::copy (actual[i].begin (), actual[i].end (), std::ostream_iterator<std::string> (actualStr, " "));
+      std::copy (expected[i].begin (), expected[i].end (), std::ostream_iterator<std::string> (expectedStr, " "));
+      NS_TEST_EXPECT_MSG_EQ (actualStr.str (), expectedStr.str (), "Different history in context " << i);
+    }
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  History expected = RunScenario (CreateObject<DefaultSimulatorImpl> ());
+
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (m_threads));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MicroSeconds (1)));
+  CheckHistory (RunScenario (CreateObject<MultithreadedSimulatorImpl> ()), expected);
+
+  // Without lookahead the partitions are executed in turn.
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (Seconds (0)));
+  CheckHistory (RunScenario (CreateObject<MultithreadedSimulatorImpl> ()), expected);
+}
+
+void
+MultithreadedSimulatorTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+/**
+ * Check that Simulator::Stop (delay) stops all the partitions at the
+ * same event as the default simulator and that the simulation can be
+ * resumed.
+ */
+class MultithreadedSimulatorStopTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorStopTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  /**
+   * Run until the simulator stops.
+   * \param [in] impl The simulator implementation.
+   */
+  void RunScenario (Ptr<SimulatorImpl> impl);
+  /**
+   * Count an event and schedule the next one.
+   * \param [in] n The event index.
+   */
+  void Tick (uint32_t n);
+
+  uint32_t m_ticks[4]; //!< Number of events in each context.
+};
+
+MultithreadedSimulatorStopTestCase::MultithreadedSimulatorStopTestCase ()
+  : TestCase ("Check Simulator::Stop with the multithreaded simulator")
+{
+}
+
+void
+MultithreadedSimulatorStopTestCase::Tick (uint32_t n)
+{
+  m_ticks[Simulator::GetContext ()]++;
+  if (n < 10)
+    {
+      Simulator::Schedule (MilliSeconds (1), &MultithreadedSimulatorStopTestCase::Tick, this, n + 1);
+    }
+}
+
+void
+MultithreadedSimulatorStopTestCase::RunScenario (Ptr<SimulatorImpl> impl)
+{
+  Simulator::SetImplementation (impl);
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      m_ticks[i] = 0;
+      Simulator::ScheduleWithContext (i, Seconds (0), &MultithreadedSimulatorStopTestCase::Tick, this, 0);
+    }
+  Simulator::Stop (MilliSeconds (5));
+  Simulator::Run ();
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoRun (void)
+{
+  RunScenario (CreateObject<DefaultSimulatorImpl> ());
+  uint32_t expected[4];
+  std::copy (m_ticks, m_ticks + 4, expected);
+  Time expectedNow = Simulator::Now ();
+  Simulator::Destroy ();
+
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (4));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Lookahead", TimeValue (MilliSeconds (10)));
+  RunScenario (CreateObject<MultithreadedSimulatorImpl> ());
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ticks[i], expected[i], "Context " << i << " did not stop with the default simulator");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), expectedNow, "Wrong stop time");
+
+  Simulator::Run ();
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_ticks[i], 11, "Simulation did not resume in context " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), MilliSeconds (10), "Wrong final time");
+  Simulator::Destroy ();
+}
+
+void
+MultithreadedSimulatorStopTestCase::DoTeardown (void)
+{
+  Config::Reset ();
+}
+
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ()
+    : TestSuite ("multithreaded-simulator")
+  {
+    std::string schedulerTypes[] = {
+      "ns3::ListScheduler",
+      "ns3::HeapScheduler",
+      "ns3::MapScheduler",
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler",
+      "ns3::PairingHeapScheduler",
+      "ns3::AdaptiveScheduler"
+    };
+    for (unsigned int i = 0; i < (sizeof (schedulerTypes) / sizeof (schedulerTypes[0])); ++i)
+      {
+        AddTestCase (new MultithreadedSimulatorTestCase (4, schedulerTypes[i]), TestCase::QUICK);
+      }
+    AddTestCase (new MultithreadedSimulatorStopTestCase (), TestCase::QUICK);
+  }
+} g_multithreadedSimulatorTestSuite;
@@ -16,6 +16,9 @@
 
 #include "ns3/test.h"
 #include "ns3/names.h"
+#include <sstream>
+#include <utility>
+#include <vector>
 
 using namespace ns3;
 
@@ -929,6 +932,77 @@ AlternateFindTestCase::DoRun (void)
                          "Unexpectedly able to GetObject<TestObject> on an AlternateTestObject");
 }
 
+// ===========================================================================
+// Test case to make sure that the Object Name Service can add many names at
+// once, and that the paths found after a rename are those of the new names,
+// down to the grandchildren of the renamed object.
+//
+//   Add (const std::vector<std::pair<std::string, Ptr<Object> > > &names);
+// ===========================================================================
+class BulkAddTestCase : public TestCase
+{
+public:
+  BulkAddTestCase ();
+  virtual ~BulkAddTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+};
+
+BulkAddTestCase::BulkAddTestCase ()
+  : TestCase ("Check bulk Names::Add and the paths after Names::Rename")
+{
+}
+
+BulkAddTestCase::~BulkAddTestCase ()
+{
+}
+
+void
+BulkAddTestCase::DoTeardown (void)
+{
+  Names::Clear ();
+}
+
+void
+BulkAddTestCase::DoRun (void)
+{
+  std::vector<std::pair<std::string, Ptr<Object> > > names;
+  std::vector<Ptr<TestObject> > routers;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      std::ostringstream oss;
+      oss << "Router" << i;
+      routers.push_back (CreateObject<TestObject> ());
+      names.push_back (std::make_pair (oss.str (), routers.back ()));
+    }
+  Ptr<TestObject> eth0 = CreateObject<TestObject> ();
+  Ptr<TestObject> queue = CreateObject<TestObject> ();
+  names.push_back (std::make_pair ("/Names/Router7/eth0", eth0));
+  names.push_back (std::make_pair ("Router7/eth0/Queue", queue));
+  Names::Add (names);
+
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> ("Router999"), routers[999], "Could not Names::Find a bulk added Object");
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> ("/Names/Router7/eth0/Queue"), queue,
+                         "Could not Names::Find a bulk added grandchild Object");
+  NS_TEST_ASSERT_MSG_EQ (Names::FindPath (queue), "/Names/Router7/eth0/Queue", "Unexpected path of a grandchild Object");
+  NS_TEST_ASSERT_MSG_EQ (Names::FindName (routers[42]), "Router42", "Unexpected name of a bulk added Object");
+
+  Names::Rename ("Router7", "Core");
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> ("/Names/Core/eth0/Queue"), queue,
+                         "Could not Names::Find a grandchild Object after renaming its grandparent");
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> ("Router7/eth0/Queue"), 0,
+                         "Unexpectedly found a grandchild Object under the old name");
+  NS_TEST_ASSERT_MSG_EQ (Names::FindPath (eth0), "/Names/Core/eth0", "Unexpected path after a rename");
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> (routers[7], "eth0"), eth0,
+                         "Could not Names::Find a child Object under its context after a rename");
+
+  Names::Clear ();
+  NS_TEST_ASSERT_MSG_EQ (Names::Find<TestObject> ("Router1"), 0, "Unexpectedly found an Object after Names::Clear");
+  NS_TEST_ASSERT_MSG_EQ (Names::FindPath (queue), "", "Unexpectedly found a path after Names::Clear");
+}
+
 class NamesTestSuite : public TestSuite
 {
 public:
@@ -952,6 +1026,7 @@ NamesTestSuite::NamesTestSuite ()
   AddTestCase (new FullyQualifiedFindTestCase, TestCase::QUICK);
   AddTestCase (new RelativeFindTestCase, TestCase::QUICK);
   AddTestCase (new AlternateFindTestCase, TestCase::QUICK);
+  AddTestCase (new BulkAddTestCase, TestCase::QUICK);
 }
 
 static NamesTestSuite namesTestSuite;
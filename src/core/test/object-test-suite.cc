@@ -22,6 +22,10 @@
 #include "ns3/object.h"
 #include "ns3/object-factory.h"
 #include "ns3/assert.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 namespace {
 
@@ -113,10 +117,47 @@ public:
   }
 };
 
+class Counted : public ns3::Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static ns3::TypeId GetTypeId (void)
+  {
+    static ns3::TypeId tid = ns3::TypeId ("ObjectTest:Counted")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .HideFromDocumentation ()
+      .AddConstructor<Counted> ()
+      .AddAttribute ("Value", "A value.",
+                     ns3::UintegerValue (7),
+                     ns3::MakeUintegerAccessor (&Counted::m_value),
+                     ns3::MakeUintegerChecker<uint32_t> ());
+    return tid;
+  }
+  Counted ()
+    : m_inner (ns3::CreateObject<BaseA> ())
+  {
+    g_live++;
+  }
+  virtual ~Counted ()
+  {
+    g_live--;
+  }
+  uint32_t m_value;
+  ns3::Ptr<BaseA> m_inner;
+  static uint32_t g_live;
+};
+
+uint32_t Counted::g_live = 0;
+
 NS_OBJECT_ENSURE_REGISTERED (BaseA);
 NS_OBJECT_ENSURE_REGISTERED (DerivedA);
 NS_OBJECT_ENSURE_REGISTERED (BaseB);
 NS_OBJECT_ENSURE_REGISTERED (DerivedB);
+NS_OBJECT_ENSURE_REGISTERED (Counted);
 
 } // namespace anonymous
 
@@ -431,6 +472,89 @@ ObjectFactoryTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_NE (a->GetObject<DerivedA> (), 0, "Unexpectedly able to work around C++ type system");
 }
 
+// ===========================================================================
+// Test case to make sure that an Object factory can create many Objects
+// ===========================================================================
+class ObjectFactoryCreateNTestCase : public TestCase
+{
+public:
+  ObjectFactoryCreateNTestCase ();
+  virtual ~ObjectFactoryCreateNTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ObjectFactoryCreateNTestCase::ObjectFactoryCreateNTestCase ()
+  : TestCase ("Check ObjectFactory::CreateN functionality")
+{
+}
+
+ObjectFactoryCreateNTestCase::~ObjectFactoryCreateNTestCase ()
+{
+}
+
+void
+ObjectFactoryCreateNTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (Counted::GetTypeId ());
+  std::vector<Ptr<Counted> > objects = factory.CreateN<Counted> (5);
+  NS_TEST_ASSERT_MSG_EQ (objects.size (), 5, "CreateN should create all the Objects");
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 5, "the Objects should be alive");
+  for (uint32_t i = 0; i < objects.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (objects[i]->GetInstanceTypeId (), Counted::GetTypeId (), "the TypeId of an Object");
+      NS_TEST_EXPECT_MSG_EQ (objects[i]->m_value, 7, "the initial value of the Attribute");
+      NS_TEST_EXPECT_MSG_NE (objects[i]->m_inner, 0, "the Object created by the constructor");
+    }
+  // the Objects are allocated one after the other, and those created
+  // by their constructors are not.
+  std::ptrdiff_t stride = (char *)PeekPointer (objects[1]) - (char *)PeekPointer (objects[0]);
+  for (uint32_t i = 2; i < objects.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((char *)PeekPointer (objects[i]) - (char *)PeekPointer (objects[i - 1]), stride,
+                             "the Objects should be contiguous");
+    }
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (stride, (std::ptrdiff_t)sizeof (Counted), "the Objects should not overlap");
+
+  // Attributes set on the factory, and the new initial values, are used.
+  factory.Set ("Value", UintegerValue (3));
+  NS_TEST_EXPECT_MSG_EQ (factory.Create<Counted> ()->m_value, 3, "the Attribute set on the factory");
+  factory.Set ("Value", StringValue ("4"));
+  objects = factory.CreateN<Counted> (2);
+  NS_TEST_EXPECT_MSG_EQ (objects[1]->m_value, 4, "the Attribute converted from a string");
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 2, "the previous Objects should be deleted");
+
+  ObjectFactory defaults;
+  defaults.SetTypeId (Counted::GetTypeId ());
+  NS_TEST_EXPECT_MSG_EQ (defaults.Create<Counted> ()->m_value, 7, "the initial value of the Attribute");
+  Config::SetDefault ("ObjectTest:Counted::Value", UintegerValue (9));
+  NS_TEST_EXPECT_MSG_EQ (defaults.Create<Counted> ()->m_value, 9, "the new initial value of the Attribute");
+  NS_TEST_EXPECT_MSG_EQ (defaults.CreateN<Counted> (1)[0]->m_value, 9, "the new initial value of the Attribute");
+  NS_TEST_EXPECT_MSG_EQ (CreateObject<Counted> ()->m_value, 9, "the new initial value of the Attribute");
+  Config::SetDefault ("ObjectTest:Counted::Value", UintegerValue (7));
+
+  // an Object outlives the other Objects of its arena, and the arena.
+  Ptr<Counted> last = objects[1];
+  objects.clear ();
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 1, "only the last Object should be alive");
+  NS_TEST_EXPECT_MSG_EQ (last->m_value, 4, "the last Object should be intact");
+  last = 0;
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 0, "all the Objects should be deleted");
+
+  // the Objects of an arena and of the heap are deleted together when
+  // they are aggregated.
+  objects = factory.CreateN<Counted> (3);
+  Ptr<Object> heap = CreateObject<Object> ();
+  heap->AggregateObject (objects[1]);
+  objects.clear ();
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 1, "the aggregated Object should be alive");
+  heap = 0;
+  NS_TEST_EXPECT_MSG_EQ (Counted::g_live, 0, "the aggregate should be deleted");
+  NS_TEST_EXPECT_MSG_EQ (factory.CreateN (0).size (), 0, "CreateN of no Object");
+}
+
 // ===========================================================================
 // The Test Suite that glues the Test Cases together.
 // ===========================================================================
@@ -446,6 +570,7 @@ ObjectTestSuite::ObjectTestSuite ()
   AddTestCase (new CreateObjectTestCase, TestCase::QUICK);
   AddTestCase (new AggregateObjectTestCase, TestCase::QUICK);
   AddTestCase (new ObjectFactoryTestCase, TestCase::QUICK);
+  AddTestCase (new ObjectFactoryCreateNTestCase, TestCase::QUICK);
 }
 
 static ObjectTestSuite objectTestSuite;
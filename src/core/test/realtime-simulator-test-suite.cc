@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/wall-clock-synchronizer.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+#include "ns3/type-id.h"
+#ifdef HAVE_SYS_TIMERFD_H
+#include "ns3/timerfd-synchronizer.h"
+#endif
+#include <vector>
+
+using namespace ns3;
+
+class RealtimeLatenessTestCase : public TestCase
+{
+public:
+  RealtimeLatenessTestCase (TypeId synchronizer, std::string mode);
+  virtual void DoRun (void);
+  void Event (void);
+  void Lateness (Time lateness);
+  void Histogram (const std::vector<uint64_t> &histogram);
+  TypeId m_synchronizer;
+  std::string m_mode;
+  Ptr<RealtimeSimulatorImpl> m_impl;
+  uint32_t m_events;
+  uint32_t m_early;
+  uint32_t m_lateness;
+  uint32_t m_reports;
+  uint64_t m_reported;
+};
+
+RealtimeLatenessTestCase::RealtimeLatenessTestCase (TypeId synchronizer, std::string mode)
+  : TestCase ("Check the lateness of the events with " + synchronizer.GetName () + " " + mode),
+    m_synchronizer (synchronizer),
+    m_mode (mode)
+{
+}
+
+void
+RealtimeLatenessTestCase::Event (void)
+{
+  m_events++;
+  if (m_impl->RealtimeNow () < Simulator::Now ())
+    {
+      m_early++;
+    }
+}
+
+void
+RealtimeLatenessTestCase::Lateness (Time lateness)
+{
+  m_lateness++;
+}
+
+void
+RealtimeLatenessTestCase::Histogram (const std::vector<uint64_t> &histogram)
+{
+  m_reports++;
+  for (uint32_t i = 0; i < histogram.size (); i++)
+    {
+      m_reported += histogram[i];
+    }
+}
+
+void
+RealtimeLatenessTestCase::DoRun (void)
+{
+  m_events = 0;
+  m_early = 0;
+  m_lateness = 0;
+  m_reports = 0;
+  m_reported = 0;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::SynchronizerType", TypeIdValue (m_synchronizer));
+  if (m_mode != "")
+    {
+      Config::SetDefault ("ns3::TimerFdSynchronizer::WaitMode", StringValue (m_mode));
+    }
+  m_impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (m_impl, 0, "the simulator should be a RealtimeSimulatorImpl");
+  NS_TEST_EXPECT_MSG_EQ (m_impl->GetSynchronizerType (), m_synchronizer, "the synchronizer type");
+  m_impl->SetAttribute ("LatenessReportInterval", TimeValue (MilliSeconds (10)));
+  m_impl->TraceConnectWithoutContext ("Lateness", MakeCallback (&RealtimeLatenessTestCase::Lateness, this));
+  m_impl->TraceConnectWithoutContext ("LatenessHistogram", MakeCallback (&RealtimeLatenessTestCase::Histogram, this));
+
+  for (uint32_t i = 1; i <= 50; i++)
+    {
+      Simulator::Schedule (MicroSeconds (i * 700), &RealtimeLatenessTestCase::Event, this);
+    }
+  Simulator::Stop (MilliSeconds (40));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_events, 50, "all the events should run");
+  NS_TEST_EXPECT_MSG_EQ (m_early, 0, "no event should run early");
+  // and the Stop event.
+  NS_TEST_EXPECT_MSG_EQ (m_lateness, 51, "the lateness of each event should be traced");
+  NS_TEST_EXPECT_MSG_GT (m_reports, 1, "the histogram should be reported periodically");
+  NS_TEST_EXPECT_MSG_EQ (m_reported, 51, "the reports should count each event once");
+  std::vector<uint64_t> histogram = m_impl->GetLatenessHistogram ();
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < histogram.size (); i++)
+    {
+      total += histogram[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, 51, "the histogram should count each event once");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_impl->GetMaxLateness (), Time (0), "the largest lateness");
+
+  m_impl = 0;
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::RealtimeSimulatorImpl::SynchronizerType",
+                      TypeIdValue (WallClockSynchronizer::GetTypeId ()));
+  if (m_mode != "")
+    {
+      Config::SetDefault ("ns3::TimerFdSynchronizer::WaitMode", StringValue ("SleepSpin"));
+    }
+}
+
+static class RealtimeSimulatorTestSuite : public TestSuite
+{
+public:
+  RealtimeSimulatorTestSuite ()
+    : TestSuite ("realtime-simulator")
+  {
+    AddTestCase (new RealtimeLatenessTestCase (WallClockSynchronizer::GetTypeId (), ""), TestCase::QUICK);
+#ifdef HAVE_SYS_TIMERFD_H
+    AddTestCase (new RealtimeLatenessTestCase (TimerFdSynchronizer::GetTypeId (), "SleepSpin"), TestCase::QUICK);
+    AddTestCase (new RealtimeLatenessTestCase (TimerFdSynchronizer::GetTypeId (), "Sleep"), TestCase::QUICK);
+    AddTestCase (new RealtimeLatenessTestCase (TimerFdSynchronizer::GetTypeId (), "BusyPoll"), TestCase::QUICK);
+#endif
+  }
+} g_realtimeSimulatorTestSuite;
@@ -0,0 +1,434 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/rng-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/integer.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+class PhiloxKnownAnswerTestCase : public TestCase
+{
+public:
+  PhiloxKnownAnswerTestCase ();
+  virtual void DoRun (void);
+};
+
+PhiloxKnownAnswerTestCase::PhiloxKnownAnswerTestCase ()
+  : TestCase ("Check Philox4x32-10 against its known answers")
+{
+}
+
+void
+PhiloxKnownAnswerTestCase::DoRun (void)
+{
+  // the known-answer vectors of the Random123 library.
+  uint32_t counters[3][4] = {
+    { 0, 0, 0, 0 },
+    { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+    { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }
+  };
+  uint32_t keys[3][2] = {
+    { 0, 0 },
+    { 0xffffffff, 0xffffffff },
+    { 0xa4093822, 0x299f31d0 }
+  };
+  uint32_t expected[3][4] = {
+    { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+    { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+    { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 }
+  };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint32_t out[4];
+      RngStream::Philox (counters[i], keys[i], out);
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (out[j], expected[i][j], "vector " << i << " word " << j);
+        }
+    }
+}
+
+class RngStreamBulkTestCase : public TestCase
+{
+public:
+  RngStreamBulkTestCase (RngStream::Engine engine, std::string name);
+  virtual void DoRun (void);
+  RngStream::Engine m_engine;
+};
+
+RngStreamBulkTestCase::RngStreamBulkTestCase (RngStream::Engine engine, std::string name)
+  : TestCase ("Check that the bulk " + name + " values are the scalar ones"),
+    m_engine (engine)
+{
+}
+
+void
+RngStreamBulkTestCase::DoRun (void)
+{
+  RngStream scalar (7, 42, 3, m_engine);
+  RngStream bulk (7, 42, 3, m_engine);
+  std::vector<double> values (1000);
+  uint32_t done = 0;
+  // odd sizes, to start the batches in the middle of the blocks.
+  for (uint32_t n = 1; done + n <= values.size (); n += 7)
+    {
+      bulk.RandU01 (&values[done], n);
+      done += n;
+    }
+  double sum = 0;
+  for (uint32_t i = 0; i < done; i++)
+    {
+      double expected = scalar.RandU01 ();
+      NS_TEST_ASSERT_MSG_EQ (values[i], expected, "value " << i);
+      NS_TEST_ASSERT_MSG_GT (values[i], 0, "value " << i << " out of (0, 1)");
+      NS_TEST_ASSERT_MSG_LT (values[i], 1, "value " << i << " out of (0, 1)");
+      sum += values[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (sum / done, 0.5, 0.05, "the mean of the values");
+  NS_TEST_EXPECT_MSG_EQ (bulk.RandU01 (), scalar.RandU01 (), "the streams should stay in step");
+
+  // the state of a stream restores its position, and the sub-streams
+  // of the runs are reached by jumping ahead.
+  uint32_t state[6];
+  bulk.GetState (state);
+  RngStream restored (7, 42, 3, m_engine);
+  restored.SetState (state);
+  NS_TEST_EXPECT_MSG_EQ (restored.RandU01 (), bulk.RandU01 (), "the restored stream");
+  // and so does the state taken in the middle of the prefetched values.
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      scalar.RandU01 ();
+    }
+  scalar.GetState (state);
+  restored.SetState (state);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (restored.RandU01 (), scalar.RandU01 (), "the restored stream, value " << i);
+    }
+  RngStream run5 (7, 42, 5, m_engine);
+  RngStream jumped (7, 42, 3, m_engine);
+  jumped.AdvanceSubstreams (2);
+  NS_TEST_EXPECT_MSG_EQ (jumped.RandU01 (), run5.RandU01 (), "the sub-stream of another run");
+
+  // an assigned stream is registered under its new stream number.
+  RngStream other (7, 43, 0, m_engine);
+  RngStream assigned (7, 44, 0, m_engine);
+  assigned = run5;
+  std::vector<RngStream *> streams = RngStream::GetStreams ();
+  NS_TEST_EXPECT_MSG_EQ (std::count (streams.begin (), streams.end (), &assigned), 1, "the stream should be registered once");
+  for (uint32_t i = 1; i < streams.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (streams[i - 1]->GetStream (), streams[i]->GetStream (),
+                                   "the streams should be ordered by their number");
+    }
+  NS_TEST_EXPECT_MSG_EQ (assigned.RandU01 (), run5.RandU01 (), "the assigned stream should draw the same values");
+}
+
+class PhiloxIdentityTestCase : public TestCase
+{
+public:
+  PhiloxIdentityTestCase ();
+  virtual void DoRun (void);
+};
+
+PhiloxIdentityTestCase::PhiloxIdentityTestCase ()
+  : TestCase ("Check that the Philox streams depend on the seed, run and stream only")
+{
+}
+
+void
+PhiloxIdentityTestCase::DoRun (void)
+{
+  RngSeedManager::SetEngine (RngStream::PHILOX4X32);
+  NS_TEST_EXPECT_MSG_EQ (RngSeedManager::GetEngine (), RngStream::PHILOX4X32, "the engine");
+  Ptr<UniformRandomVariable> a = CreateObject<UniformRandomVariable> ();
+  a->SetStream (12);
+  // creating other streams first does not change a stream.
+  Ptr<UniformRandomVariable> other = CreateObject<UniformRandomVariable> ();
+  other->GetValue ();
+  Ptr<UniformRandomVariable> b = CreateObject<UniformRandomVariable> ();
+  b->SetStream (12);
+  Ptr<UniformRandomVariable> c = CreateObject<UniformRandomVariable> ();
+  c->SetStream (13);
+  RngSeedManager::SetEngine (RngStream::MRG32K3A);
+
+  std::vector<double> values (100);
+  a->GetValues (&values[0], values.size ());
+  uint32_t same = 0;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (values[i], b->GetValue (), "the same stream should draw the same values");
+      same += values[i] == c->GetValue ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (same, 0, "another stream should draw other values");
+}
+
+class RandomVariableGetValuesTestCase : public TestCase
+{
+public:
+  RandomVariableGetValuesTestCase (RngStream::Engine engine, std::string name);
+  virtual void DoRun (void);
+  void Check (ObjectFactory factory, bool integers);
+  RngStream::Engine m_engine;
+};
+
+RandomVariableGetValuesTestCase::RandomVariableGetValuesTestCase (RngStream::Engine engine, std::string name)
+  : TestCase ("Check that GetValues draws the values of GetValue with " + name),
+    m_engine (engine)
+{
+}
+
+void
+RandomVariableGetValuesTestCase::Check (ObjectFactory factory, bool integers)
+{
+  for (uint32_t antithetic = 0; antithetic < 2; antithetic++)
+    {
+      factory.Set ("Antithetic", BooleanValue (antithetic));
+      factory.Set ("Stream", IntegerValue (5 + antithetic));
+      RngSeedManager::SetEngine (m_engine);
+      Ptr<RandomVariableStream> bulk = factory.Create<RandomVariableStream> ();
+      Ptr<RandomVariableStream> scalar = factory.Create<RandomVariableStream> ();
+      RngSeedManager::SetEngine (RngStream::MRG32K3A);
+      std::string name = factory.GetTypeId ().GetName () + (antithetic ? " antithetic" : "");
+
+      // odd sizes, and scalar calls in between, which share the state
+      // of the bulk calls.
+      std::vector<double> values (200);
+      for (uint32_t n = 1; n < values.size (); n += 13)
+        {
+          bulk->GetValues (&values[0], n);
+          for (uint32_t i = 0; i < n; i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (values[i], scalar->GetValue (), name << " value " << i << " of " << n);
+            }
+          NS_TEST_ASSERT_MSG_EQ (bulk->GetValue (), scalar->GetValue (), name << " value after " << n);
+        }
+      if (!integers)
+        {
+          continue;
+        }
+      std::vector<uint32_t> ints (200);
+      for (uint32_t n = 1; n < ints.size (); n += 13)
+        {
+          bulk->GetIntegers (&ints[0], n);
+          for (uint32_t i = 0; i < n; i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (ints[i], scalar->GetInteger (), name << " integer " << i << " of " << n);
+            }
+        }
+    }
+}
+
+void
+RandomVariableGetValuesTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::UniformRandomVariable");
+  factory.Set ("Min", DoubleValue (3));
+  factory.Set ("Max", DoubleValue (50));
+  Check (factory, true);
+  factory.Set ("Min", DoubleValue (-3));
+  factory.Set ("Max", DoubleValue (5));
+  Check (factory, false);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::ExponentialRandomVariable");
+  factory.Set ("Mean", DoubleValue (20));
+  Check (factory, true);
+  factory.Set ("Bound", DoubleValue (30));
+  Check (factory, true);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::ParetoRandomVariable");
+  factory.Set ("Scale", DoubleValue (2));
+  factory.Set ("Shape", DoubleValue (1.5));
+  Check (factory, true);
+  factory.Set ("Bound", DoubleValue (10));
+  Check (factory, true);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::WeibullRandomVariable");
+  factory.Set ("Scale", DoubleValue (20));
+  factory.Set ("Shape", DoubleValue (1.5));
+  Check (factory, true);
+  factory.Set ("Bound", DoubleValue (25));
+  Check (factory, true);
+
+  factory = ObjectFactory ();
+  factory.SetTypeId ("ns3::LogNormalRandomVariable");
+  factory.Set ("Mu", DoubleValue (2));
+  factory.Set ("Sigma", DoubleValue (0.5));
+  Check (factory, true);
+
+  for (uint32_t ziggurat = 0; ziggurat < 2; ziggurat++)
+    {
+      factory = ObjectFactory ();
+      factory.SetTypeId ("ns3::NormalRandomVariable");
+      factory.Set ("Algorithm", StringValue (ziggurat ? "Ziggurat" : "Polar"));
+      factory.Set ("Mean", DoubleValue (100));
+      factory.Set ("Variance", DoubleValue (25));
+      Check (factory, true);
+      // a bound which rejects the values of either side of the pairs.
+      factory.Set ("Bound", DoubleValue (5));
+      Check (factory, true);
+    }
+}
+
+class NormalZigguratTestCase : public TestCase
+{
+public:
+  NormalZigguratTestCase ();
+  virtual void DoRun (void);
+};
+
+NormalZigguratTestCase::NormalZigguratTestCase ()
+  : TestCase ("Check the moments of the ziggurat normal values")
+{
+}
+
+void
+NormalZigguratTestCase::DoRun (void)
+{
+  Ptr<NormalRandomVariable> x = CreateObject<NormalRandomVariable> ();
+  x->SetStream (9);
+  x->SetAttribute ("Algorithm", StringValue ("Ziggurat"));
+  x->SetAttribute ("Mean", DoubleValue (5));
+  x->SetAttribute ("Variance", DoubleValue (4));
+  std::vector<double> values (200000);
+  x->GetValues (&values[0], values.size ());
+  double sum = 0;
+  double tail = 0;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      sum += values[i];
+      tail += values[i] > 5 + 2 * 3;
+    }
+  double mean = sum / values.size ();
+  double squares = 0;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      squares += (values[i] - mean) * (values[i] - mean);
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (mean, 5, 0.02, "the mean");
+  NS_TEST_EXPECT_MSG_EQ_TOL (squares / (values.size () - 1), 4, 0.05, "the variance");
+  // P(Z > 3) = 0.00135
+  NS_TEST_EXPECT_MSG_EQ_TOL (tail / values.size (), 0.00135, 0.0003, "the tail");
+}
+
+class EmpiricalTableTestCase : public TestCase
+{
+public:
+  EmpiricalTableTestCase ();
+  virtual void DoRun (void);
+  Ptr<EmpiricalRandomVariable> Create (bool interpolate, std::string sampling);
+};
+
+EmpiricalTableTestCase::EmpiricalTableTestCase ()
+  : TestCase ("Check the tables of the empirical random variable")
+{
+}
+
+Ptr<EmpiricalRandomVariable>
+EmpiricalTableTestCase::Create (bool interpolate, std::string sampling)
+{
+  Ptr<EmpiricalRandomVariable> x = CreateObject<EmpiricalRandomVariable> ();
+  x->SetStream (3);
+  x->SetAttribute ("Interpolate", BooleanValue (interpolate));
+  x->SetAttribute ("Sampling", StringValue (sampling));
+  return x;
+}
+
+void
+EmpiricalTableTestCase::DoRun (void)
+{
+  // a heavy-tailed CDF of many points, with flat steps and points
+  // crowded in a few cells of the grid.
+  Ptr<EmpiricalRandomVariable> search = Create (true, "Search");
+  Ptr<EmpiricalRandomVariable> table = Create (true, "Table");
+  double cdf = 0;
+  for (uint32_t i = 0; i < 3000; i++)
+    {
+      double value = 100 + i * i;
+      if (i % 10 != 0)
+        {
+          cdf += i < 1000 ? 1e-6 : 1.0 / 2000;
+        }
+      cdf = std::min (cdf, 0.999);
+      search->CDF (value, cdf);
+      table->CDF (value, cdf);
+    }
+  search->CDF (1e7, 1.0);
+  table->CDF (1e7, 1.0);
+  std::vector<double> values (5000);
+  table->GetValues (&values[0], values.size ());
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (values[i], search->GetValue (), "the grid should give the values of the search, value " << i);
+    }
+
+  // the discrete distribution draws the values of the points, with the
+  // probabilities of their steps.
+  double points[4][2] = { { 1, 0.1 }, { 2, 0.1 }, { 5, 0.6 }, { 9, 0.9 } };
+  for (uint32_t t = 0; t < 2; t++)
+    {
+      Ptr<EmpiricalRandomVariable> x = Create (false, t ? "Table" : "Search");
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          x->CDF (points[i][0], points[i][1]);
+        }
+      std::vector<double> draws (100000);
+      x->GetValues (&draws[0], draws.size ());
+      std::map<double, uint32_t> counts;
+      for (uint32_t i = 0; i < draws.size (); i++)
+        {
+          counts[draws[i]]++;
+        }
+      std::string name = t ? "alias table" : "search";
+      NS_TEST_EXPECT_MSG_EQ (counts.size (), 3, name << ": the values of the points with a step");
+      NS_TEST_EXPECT_MSG_EQ (counts[2], 0, name << ": a flat step should have no value");
+      // the last point also takes the values above the last CDF.
+      NS_TEST_EXPECT_MSG_EQ_TOL (counts[1] / 1e5, 0.1, 0.005, name << ": the probability of 1");
+      NS_TEST_EXPECT_MSG_EQ_TOL (counts[5] / 1e5, 0.5, 0.005, name << ": the probability of 5");
+      NS_TEST_EXPECT_MSG_EQ_TOL (counts[9] / 1e5, 0.4, 0.005, name << ": the probability of 9");
+    }
+}
+
+static class RngStreamTestSuite : public TestSuite
+{
+public:
+  RngStreamTestSuite ()
+    : TestSuite ("rng-stream", UNIT)
+  {
+    AddTestCase (new PhiloxKnownAnswerTestCase (), TestCase::QUICK);
+    AddTestCase (new RngStreamBulkTestCase (RngStream::MRG32K3A, "MRG32k3a"), TestCase::QUICK);
+    AddTestCase (new RngStreamBulkTestCase (RngStream::PHILOX4X32, "Philox4x32"), TestCase::QUICK);
+    AddTestCase (new PhiloxIdentityTestCase (), TestCase::QUICK);
+    AddTestCase (new RandomVariableGetValuesTestCase (RngStream::MRG32K3A, "MRG32k3a"), TestCase::QUICK);
+    AddTestCase (new RandomVariableGetValuesTestCase (RngStream::PHILOX4X32, "Philox4x32"), TestCase::QUICK);
+    AddTestCase (new NormalZigguratTestCase (), TestCase::QUICK);
+    AddTestCase (new EmpiricalTableTestCase (), TestCase::QUICK);
+  }
+} g_rngStreamTestSuite;
@@ -19,10 +19,18 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/pairing-heap-scheduler.h"
+#include "ns3/adaptive-scheduler.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +467,214 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class SchedulerRandomTestCase : public TestCase
+{
+public:
+  SchedulerRandomTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint32_t Random (void);
+  Ptr<Scheduler> m_scheduler;
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_seed;
+};
+
+SchedulerRandomTestCase::SchedulerRandomTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check random insertions and removals with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerRandomTestCase::Random (void)
+{
+  // a deterministic LCG, to keep the sequence independent of the RNG
+  m_seed = m_seed * 1103515245 + 12345;
+  return m_seed >> 8;
+}
+
+void
+SchedulerRandomTestCase::DoRun (void)
+{
+  m_scheduler = m_schedulerFactory.Create<Scheduler> ();
+  std::set<Scheduler::EventKey> expected;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  for (uint32_t i = 0; i < 200000; i++)
+    {
+      uint32_t op = Random () % 16;
+      // grow the queue during the first half, then drain it.
+      bool grow = i < 100000;
+      if ((grow && op < 9) || (!grow && op < 5) || expected.empty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_context = 0;
+          ev.key.m_uid = uid++;
+          // mix near-future timestamps, ties and far-future outliers
+          switch (Random () % 4)
+            {
+            case 0:
+              ev.key.m_ts = now;
+              break;
+            case 1:
+              ev.key.m_ts = now + Random () % 100;
+              break;
+            case 2:
+              ev.key.m_ts = now + Random () % 100000;
+              break;
+            default:
+              ev.key.m_ts = now + (uint64_t)Random () * 1000;
+              break;
+            }
+          m_scheduler->Insert (ev);
+          expected.insert (ev.key);
+        }
+      else if (op < 13)
+        {
+          Scheduler::Event next = m_scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->m_uid, "wrong next event");
+          now = next.key.m_ts;
+          expected.erase (expected.begin ());
+        }
+      else
+        {
+          // remove an arbitrary pending event
+          std::set<Scheduler::EventKey>::iterator j = expected.begin ();
+          std::advance (j, Random () % std::min<uint32_t> (expected.size (), 64));
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key = *j;
+          m_scheduler->Remove (ev);
+          expected.erase (j);
+        }
+      NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), expected.empty (), "wrong emptiness");
+      if (!expected.empty ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_scheduler->PeekNext ().key.m_uid, expected.begin ()->m_uid,
+                                 "wrong earliest event");
+        }
+    }
+  while (!expected.empty ())
+    {
+      Scheduler::Event next = m_scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.begin ()->m_uid, "wrong next event");
+      expected.erase (expected.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_scheduler->IsEmpty (), true, "scheduler should be empty");
+  Ptr<AdaptiveScheduler> adaptive = DynamicCast<AdaptiveScheduler> (m_scheduler);
+  if (adaptive != 0)
+    {
+      NS_TEST_EXPECT_MSG_GT (adaptive->GetMigrations (), 0, "the scheduler should have changed");
+    }
+  m_scheduler = 0;
+}
+
+class SchedulerTiesTestCase : public TestCase
+{
+public:
+  SchedulerTiesTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerTiesTestCase::SchedulerTiesTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check bursts of simultaneous events with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerTiesTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  const uint32_t n = 200000;
+  // three timestamps, in turn, mostly by increasing uid.
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key.m_context = 0;
+      ev.key.m_uid = i % 100 == 99 ? n + i : i;
+      ev.key.m_ts = 10 + i % 3;
+      scheduler->Insert (ev);
+    }
+  Scheduler::EventKey last = scheduler->RemoveNext ().key;
+  for (uint32_t i = 1; i < n; i++)
+    {
+      Scheduler::EventKey next = scheduler->RemoveNext ().key;
+      NS_TEST_ASSERT_MSG_EQ ((last < next), true, "wrong order at event " << i);
+      last = next;
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "scheduler should be empty");
+}
+
+class SimulatorCompactionTestCase : public TestCase
+{
+public:
+  SimulatorCompactionTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  void Event (uint32_t index);
+  ObjectFactory m_schedulerFactory;
+  std::vector<uint32_t> m_fired;
+};
+
+SimulatorCompactionTestCase::SimulatorCompactionTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check that cancelled events are compacted with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SimulatorCompactionTestCase::Event (uint32_t index)
+{
+  m_fired.push_back (index);
+}
+
+void
+SimulatorCompactionTestCase::DoRun (void)
+{
+  Simulator::SetScheduler (m_schedulerFactory);
+  Ptr<SimulatorImpl> impl = Simulator::GetImplementation ();
+  const uint32_t n = 5000;
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds ((i * 7919) % n + 1), &SimulatorCompactionTestCase::Event, this, i));
+    }
+  uint32_t live = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (i % 5 == 0)
+        {
+          live++;
+          continue;
+        }
+      ids[i].Cancel ();
+      NS_TEST_EXPECT_MSG_EQ (ids[i].IsRunning (), false, "the event should be cancelled");
+    }
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLiveEventCount (), live, "wrong number of live events");
+  NS_TEST_EXPECT_MSG_GT (impl->GetCompactionCount (), 0, "the events should have been compacted");
+  NS_TEST_EXPECT_MSG_GT (impl->GetCompactedEventCount (), n / 2, "the cancelled events should have been removed");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (impl->GetCancelledEventCount () * 2, impl->GetCancelledEventCount () + live,
+                               "too many cancelled events left");
+  UintegerValue compactions;
+  impl->GetAttribute ("Compactions", compactions);
+  NS_TEST_EXPECT_MSG_EQ (compactions.Get (), impl->GetCompactionCount (), "the attribute should match the counter");
+
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_fired.size (), live, "only the live events should run");
+  for (uint32_t i = 1; i < m_fired.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_LT ((m_fired[i - 1] * 7919) % n, (m_fired[i] * 7919) % n, "the events ran out of order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (impl->GetCancelledEventCount (), 0, "the cancelled events should be gone");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -469,11 +685,29 @@ public:
     factory.SetTypeId (ListScheduler::GetTypeId ());
 
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (MapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (HeapScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorCompactionTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerTiesTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (PairingHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (AdaptiveScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.Set ("SamplingPeriod", UintegerValue (1000));
+    factory.Set ("LargeQueueSize", UintegerValue (5000));
+    factory.Set ("RemoveRatio", DoubleValue (0.5));
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
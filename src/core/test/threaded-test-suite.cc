@@ -19,6 +19,7 @@
  */
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/simulator-impl.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
@@ -26,6 +27,7 @@
 #include "ns3/config.h"
 #include "ns3/string.h"
 #include "ns3/system-thread.h"
+#include "ns3/uinteger.h"
 
 #include <ctime>
 #include <list>
@@ -225,6 +227,75 @@ ThreadedSimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_a, m_d, "Bad scheduling");
 }
 
+class CrossThreadCountersTestCase : public TestCase
+{
+public:
+  CrossThreadCountersTestCase (std::string simulatorType);
+  virtual void DoRun (void);
+  void Producer (void);
+  void Event (void);
+  std::string m_simulatorType;
+  uint32_t m_events;
+};
+
+CrossThreadCountersTestCase::CrossThreadCountersTestCase (std::string simulatorType)
+  : TestCase ("Check the cross-thread event counters of " + simulatorType),
+    m_simulatorType (simulatorType)
+{
+}
+
+void
+CrossThreadCountersTestCase::Producer (void)
+{
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (i), &CrossThreadCountersTestCase::Event, this);
+    }
+}
+
+void
+CrossThreadCountersTestCase::Event (void)
+{
+  m_events++;
+}
+
+void
+CrossThreadCountersTestCase::DoRun (void)
+{
+  m_events = 0;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (m_simulatorType));
+  Ptr<SimulatorImpl> impl = Simulator::GetImplementation ();
+
+  Ptr<SystemThread> threads[4];
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      threads[i] = Create<SystemThread> (MakeCallback (&CrossThreadCountersTestCase::Producer, this));
+      threads[i]->Start ();
+    }
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      threads[i]->Join ();
+    }
+
+  UintegerValue value;
+  impl->GetAttribute ("CrossThreadEvents", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), 4000, "all the events should be counted");
+  impl->GetAttribute ("CrossThreadQueueDepth", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), 4000, "the events should wait in the queue");
+
+  Simulator::Stop (MilliSeconds (10));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_events, 4000, "all the events should run");
+  impl->GetAttribute ("CrossThreadQueueDepth", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), 0, "the queue should be empty");
+  impl->GetAttribute ("MaxCrossThreadQueueDepth", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get (), 4000, "the events should have been moved at once");
+
+  Simulator::Destroy ();
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
 class ThreadedSimulatorTestSuite : public TestSuite
 {
 public:
@@ -235,13 +306,17 @@ public:
 #ifdef HAVE_RT
       "ns3::RealtimeSimulatorImpl",
 #endif
-      "ns3::DefaultSimulatorImpl"
+      "ns3::DefaultSimulatorImpl",
+      "ns3::MultithreadedSimulatorImpl"
     };
     std::string schedulerTypes[] = {
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler",
+      "ns3::PairingHeapScheduler",
+      "ns3::AdaptiveScheduler"
     };
     unsigned int threadcounts[] = {
       0,
@@ -262,5 +337,9 @@ public:
               }
           }
       }
+#ifdef HAVE_RT
+    AddTestCase (new CrossThreadCountersTestCase ("ns3::RealtimeSimulatorImpl"), TestCase::QUICK);
+#endif
+    AddTestCase (new CrossThreadCountersTestCase ("ns3::DefaultSimulatorImpl"), TestCase::QUICK);
   }
 } g_threadedSimulatorTestSuite;
@@ -0,0 +1,312 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/timer-wheel.h"
+#include "ns3/timer.h"
+#include "ns3/watchdog.h"
+#include <vector>
+
+using namespace ns3;
+
+class TimerWheelOrderTestCase : public TestCase
+{
+public:
+  TimerWheelOrderTestCase ();
+  virtual void DoRun (void);
+  void Expire (uint32_t index);
+  void Rearm (uint32_t index, Time delay);
+  std::vector<TimerWheel::Entry> m_entries;
+  std::vector<Time> m_expected;
+  std::vector<uint32_t> m_fired;
+};
+
+TimerWheelOrderTestCase::TimerWheelOrderTestCase ()
+  : TestCase ("Check that the timers of the wheel expire at their time, in order")
+{
+}
+
+void
+TimerWheelOrderTestCase::Expire (uint32_t index)
+{
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), m_expected[index], "timer " << index << " expired at the wrong time");
+  if (!m_fired.empty ())
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (m_expected[m_fired.back ()], m_expected[index], "timer " << index << " expired out of order");
+    }
+  m_fired.push_back (index);
+}
+
+void
+TimerWheelOrderTestCase::Rearm (uint32_t index, Time delay)
+{
+  m_entries[index].Schedule (delay);
+  m_expected[index] = Simulator::Now () + delay;
+}
+
+void
+TimerWheelOrderTestCase::DoRun (void)
+{
+  const uint32_t n = 2000;
+  m_entries.resize (n);
+  m_expected.resize (n);
+  uint64_t events = TimerWheel::GetEventCount ();
+  uint64_t arms = TimerWheel::GetArmCount ();
+  uint32_t state = 12345;
+  uint32_t cancelled = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_entries[i].SetFunction (MakeCallback (&TimerWheelOrderTestCase::Expire, this).Bind (i));
+      state = state * 1103515245 + 12345;
+      // from microseconds to hours, with many equal times.
+      Time delay;
+      switch (i % 4)
+        {
+        case 0:
+          delay = MicroSeconds (200 + state % 5000);
+          break;
+        case 1:
+          delay = MilliSeconds (1 + state % 300);
+          break;
+        case 2:
+          delay = Seconds (1 + state % 1000);
+          break;
+        default:
+          delay = Hours (1 + state % 10);
+          break;
+        }
+      Rearm (i, delay);
+      // re-arm later, as a retransmission timer would.
+      for (uint32_t j = 1; j <= 10; j++)
+        {
+          Simulator::Schedule (MicroSeconds (j * 10), &TimerWheelOrderTestCase::Rearm, this, i, delay);
+        }
+      if (i % 7 == 0)
+        {
+          Simulator::Schedule (MicroSeconds (200), &TimerWheel::Entry::Cancel, &m_entries[i]);
+          cancelled++;
+        }
+    }
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_fired.size (), n - cancelled, "all the timers but the cancelled ones should expire");
+  for (uint32_t i = 1; i < m_fired.size (); i++)
+    {
+      if (m_expected[m_fired[i - 1]] == m_expected[m_fired[i]])
+        {
+          NS_TEST_EXPECT_MSG_LT (m_fired[i - 1], m_fired[i], "equal times should expire in arming order");
+        }
+    }
+  events = TimerWheel::GetEventCount () - events;
+  arms = TimerWheel::GetArmCount () - arms;
+  NS_TEST_EXPECT_MSG_EQ (arms, 11 * n, "the timers should be armed in the wheel");
+  NS_TEST_EXPECT_MSG_LT (events * 4, arms, "the wheel should schedule few events");
+  Simulator::Destroy ();
+}
+
+class TimerWheelContextTestCase : public TestCase
+{
+public:
+  TimerWheelContextTestCase ();
+  virtual void DoRun (void);
+  void Arm (uint32_t index);
+  void Expire (uint32_t index);
+  TimerWheel::Entry m_entries[3];
+  uint32_t m_contexts[3];
+};
+
+TimerWheelContextTestCase::TimerWheelContextTestCase ()
+  : TestCase ("Check that the timers expire in the context in which they were armed")
+{
+}
+
+void
+TimerWheelContextTestCase::Arm (uint32_t index)
+{
+  m_entries[index].SetFunction (MakeCallback (&TimerWheelContextTestCase::Expire, this).Bind (index));
+  m_entries[index].Schedule (MilliSeconds (10));
+}
+
+void
+TimerWheelContextTestCase::Expire (uint32_t index)
+{
+  m_contexts[index] = Simulator::GetContext ();
+}
+
+void
+TimerWheelContextTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      m_contexts[i] = 0;
+      Simulator::ScheduleWithContext (i + 7, Seconds (1), &TimerWheelContextTestCase::Arm, this, i);
+    }
+  Simulator::Run ();
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_contexts[i], i + 7, "the timer expired in the wrong context");
+    }
+
+  // the wheels stop their timers at Destroy.
+  Arm (0);
+  NS_TEST_EXPECT_MSG_EQ (m_entries[0].IsRunning (), true, "the timer should run");
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_entries[0].IsRunning (), false, "Destroy should stop the timers");
+}
+
+class TimerWheelUsersTestCase : public TestCase
+{
+public:
+  TimerWheelUsersTestCase ();
+  virtual void DoRun (void);
+  void TimerExpire (int value);
+  void WatchdogExpire (void);
+  void Rearm (Timer *timer);
+  std::vector<Time> m_timerTimes;
+  std::vector<Time> m_watchdogTimes;
+};
+
+TimerWheelUsersTestCase::TimerWheelUsersTestCase ()
+  : TestCase ("Check the Timer and the Watchdog in the wheel")
+{
+}
+
+void
+TimerWheelUsersTestCase::TimerExpire (int value)
+{
+  NS_TEST_EXPECT_MSG_EQ (value, 42, "the arguments of the Timer");
+  m_timerTimes.push_back (Simulator::Now ());
+}
+
+void
+TimerWheelUsersTestCase::WatchdogExpire (void)
+{
+  m_watchdogTimes.push_back (Simulator::Now ());
+}
+
+void
+TimerWheelUsersTestCase::Rearm (Timer *timer)
+{
+  timer->Cancel ();
+  timer->Schedule ();
+}
+
+void
+TimerWheelUsersTestCase::DoRun (void)
+{
+  Timer timer (Timer::CANCEL_ON_DESTROY);
+  timer.SetUseWheel (true);
+  NS_TEST_EXPECT_MSG_EQ (timer.IsUsingWheel (), true, "the Timer should use the wheel");
+  timer.SetFunction (&TimerWheelUsersTestCase::TimerExpire, this);
+  timer.SetArguments (42);
+  timer.SetDelay (MilliSeconds (200));
+  timer.Schedule ();
+  NS_TEST_EXPECT_MSG_EQ (timer.GetState (), Timer::RUNNING, "the Timer should run");
+  for (uint32_t i = 1; i <= 100; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &TimerWheelUsersTestCase::Rearm, this, &timer);
+    }
+  Simulator::Schedule (MilliSeconds (150), &Timer::Suspend, &timer);
+  Simulator::Schedule (MilliSeconds (170), &Timer::Resume, &timer);
+
+  Watchdog watchdog;
+  watchdog.SetUseWheel (true);
+  watchdog.SetFunction (&TimerWheelUsersTestCase::WatchdogExpire, this);
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i * 3), &Watchdog::Ping, &watchdog, MilliSeconds (50));
+    }
+  // a shorter delay does not shorten the watchdog.
+  Simulator::Schedule (MilliSeconds (148), &Watchdog::Ping, &watchdog, MilliSeconds (1));
+
+  uint64_t arms = TimerWheel::GetArmCount ();
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_timerTimes.size (), 1, "the Timer should expire once");
+  // last re-armed at 100ms, suspended at 150ms for 20ms.
+  NS_TEST_EXPECT_MSG_EQ (m_timerTimes[0], MilliSeconds (320), "the Timer expired at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (timer.IsExpired (), true, "the Timer should be expired");
+  NS_TEST_ASSERT_MSG_EQ (m_watchdogTimes.size (), 1, "the Watchdog should expire once");
+  NS_TEST_EXPECT_MSG_EQ (m_watchdogTimes[0], MilliSeconds (147 + 50), "the Watchdog expired at the wrong time");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (TimerWheel::GetArmCount () - arms, 100, "the timers should be armed in the wheel");
+  Simulator::Destroy ();
+}
+
+class TimerWheelCopyTestCase : public TestCase
+{
+public:
+  TimerWheelCopyTestCase ();
+  virtual void DoRun (void);
+  void Expire (int which);
+  std::vector<int> m_fired;
+};
+
+TimerWheelCopyTestCase::TimerWheelCopyTestCase ()
+  : TestCase ("Check that the copies of the Timer and the Watchdog expire on their own")
+{
+}
+
+void
+TimerWheelCopyTestCase::Expire (int which)
+{
+  m_fired.push_back (which);
+}
+
+void
+TimerWheelCopyTestCase::DoRun (void)
+{
+  // the originals are gone when the copies expire.
+  Timer *original = new Timer (Timer::CANCEL_ON_DESTROY);
+  original->SetUseWheel (true);
+  Timer copy (*original);
+  Timer assigned (Timer::CANCEL_ON_DESTROY);
+  assigned = *original;
+  delete original;
+  Watchdog *originalWatchdog = new Watchdog ();
+  originalWatchdog->SetUseWheel (true);
+  Watchdog watchdog (*originalWatchdog);
+  delete originalWatchdog;
+
+  NS_TEST_EXPECT_MSG_EQ (copy.IsUsingWheel (), true, "the copy should use the wheel");
+  NS_TEST_EXPECT_MSG_EQ (assigned.IsUsingWheel (), true, "the assigned Timer should use the wheel");
+  copy.SetFunction (&TimerWheelCopyTestCase::Expire, this);
+  copy.SetArguments (1);
+  copy.Schedule (MilliSeconds (10));
+  assigned.SetFunction (&TimerWheelCopyTestCase::Expire, this);
+  assigned.SetArguments (2);
+  assigned.Schedule (MilliSeconds (20));
+  watchdog.SetFunction (&TimerWheelCopyTestCase::Expire, this);
+  watchdog.SetArguments (3);
+  watchdog.Ping (MilliSeconds (30));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_fired.size (), 3, "each copy should expire once");
+  NS_TEST_EXPECT_MSG_EQ (m_fired[0], 1, "the copied Timer");
+  NS_TEST_EXPECT_MSG_EQ (m_fired[1], 2, "the assigned Timer");
+  NS_TEST_EXPECT_MSG_EQ (m_fired[2], 3, "the copied Watchdog");
+  Simulator::Destroy ();
+}
+
+static class TimerWheelTestSuite : public TestSuite
+{
+public:
+  TimerWheelTestSuite ()
+    : TestSuite ("timer-wheel")
+  {
+    AddTestCase (new TimerWheelOrderTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelContextTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelUsersTestCase (), TestCase::QUICK);
+    AddTestCase (new TimerWheelCopyTestCase (), TestCase::QUICK);
+  }
+} g_timerWheelTestSuite;
@@ -108,6 +108,144 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+class ReentrantTracedCallbackTestCase : public TestCase
+{
+public:
+  ReentrantTracedCallbackTestCase ();
+  virtual ~ReentrantTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void Grow (uint32_t a);
+  void Count (uint32_t a);
+
+  TracedCallback<uint32_t> m_trace;
+  uint32_t m_count;
+};
+
+ReentrantTracedCallbackTestCase::ReentrantTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallbacks connected while the chain is invoked")
+{
+}
+
+void
+ReentrantTracedCallbackTestCase::Grow (uint32_t a)
+{
+  // enough to move the chain elsewhere in memory.
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::Count, this));
+    }
+}
+
+void
+ReentrantTracedCallbackTestCase::Count (uint32_t a)
+{
+  m_count += a;
+}
+
+void
+ReentrantTracedCallbackTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "nothing connected yet");
+  m_count = 0;
+  m_trace (1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 0, "nothing should be called");
+
+  m_trace.ConnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::Grow, this));
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), false, "one Callback connected");
+
+  // the Callbacks connected during the invocation are called too.
+  m_trace (1);
+  NS_TEST_ASSERT_MSG_EQ (m_count, 100, "the new Callbacks should be called once");
+
+  m_trace.DisconnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::Grow, this));
+  m_trace.DisconnectWithoutContext (MakeCallback (&ReentrantTracedCallbackTestCase::Count, this));
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "all the Callbacks disconnected");
+}
+
+class DisconnectingTracedCallbackTestCase : public TestCase
+{
+public:
+  DisconnectingTracedCallbackTestCase ();
+  virtual ~DisconnectingTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void First (uint32_t a);
+  void Second (uint32_t a);
+  void Third (uint32_t a);
+  void Fourth (uint32_t a);
+
+  TracedCallback<uint32_t> m_trace;
+  uint32_t m_calls[4];
+};
+
+DisconnectingTracedCallbackTestCase::DisconnectingTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallbacks disconnected while the chain is invoked")
+{
+}
+
+void
+DisconnectingTracedCallbackTestCase::First (uint32_t a)
+{
+  m_calls[0]++;
+}
+
+void
+DisconnectingTracedCallbackTestCase::Second (uint32_t a)
+{
+  m_calls[1]++;
+  // itself, a Callback already called, and one not called yet.
+  m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Second, this));
+  m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::First, this));
+  m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Fourth, this));
+  // a nested invocation does not remove them under the outer one.
+  m_trace (a);
+}
+
+void
+DisconnectingTracedCallbackTestCase::Third (uint32_t a)
+{
+  m_calls[2]++;
+}
+
+void
+DisconnectingTracedCallbackTestCase::Fourth (uint32_t a)
+{
+  m_calls[3]++;
+}
+
+void
+DisconnectingTracedCallbackTestCase::DoRun (void)
+{
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_calls[i] = 0;
+    }
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::First, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Second, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Third, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Fourth, this));
+
+  m_trace (1);
+  NS_TEST_EXPECT_MSG_EQ (m_calls[0], 1, "the first Callback was called before it was disconnected");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[1], 1, "the second Callback should be called once");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[2], 2, "the third Callback should not be skipped");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[3], 0, "the fourth Callback was disconnected before its turn");
+
+  m_trace (1);
+  NS_TEST_EXPECT_MSG_EQ (m_calls[0], 1, "the first Callback is disconnected");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[1], 1, "the second Callback is disconnected");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[2], 3, "the third Callback is still connected");
+  NS_TEST_EXPECT_MSG_EQ (m_calls[3], 0, "the fourth Callback is disconnected");
+
+  m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectingTracedCallbackTestCase::Third, this));
+  NS_TEST_EXPECT_MSG_EQ (m_trace.IsEmpty (), true, "all the Callbacks disconnected");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -118,6 +256,8 @@ TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new ReentrantTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new DisconnectingTracedCallbackTestCase, TestCase::QUICK);
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
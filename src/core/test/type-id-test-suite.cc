@@ -325,6 +325,79 @@ DeprecatedAttributeTestCase::DoRun (void)
        << endl;
 }
 
+
+//----------------------------
+//
+// Inherited Attribute test
+
+class InheritedLookupTestCase : public TestCase
+{
+public:
+  InheritedLookupTestCase ();
+  virtual ~InheritedLookupTestCase ();
+private:
+  virtual void DoRun (void);
+
+};
+
+InheritedLookupTestCase::InheritedLookupTestCase ()
+  : TestCase ("Check lookups of inherited Attributes and TraceSources")
+{
+}
+
+InheritedLookupTestCase::~InheritedLookupTestCase ()
+{
+}
+
+void
+InheritedLookupTestCase::DoRun (void)
+{
+  TypeId base = TypeId ("InheritedLookupBase")
+    .SetParent<Object> ()
+    .AddAttribute ("shared", "the base attribute",
+                   EmptyAttributeValue (),
+                   MakeEmptyAttributeAccessor (),
+                   MakeEmptyAttributeChecker ())
+    .AddTraceSource ("baseTrace", "the base trace source",
+                     MakeEmptyTraceSourceAccessor (),
+                     "ns3::TracedValueCallback::Void")
+    ;
+  TypeId derived = TypeId ("InheritedLookupDerived")
+    .SetParent (base)
+    .AddAttribute ("own", "the derived attribute",
+                   EmptyAttributeValue (),
+                   MakeEmptyAttributeAccessor (),
+                   MakeEmptyAttributeChecker ())
+    ;
+
+  struct TypeId::AttributeInformation ainfo;
+  NS_TEST_ASSERT_MSG_EQ (derived.LookupAttributeByName ("own", &ainfo), true,
+                         "lookup own attribute");
+  NS_TEST_EXPECT_MSG_EQ (ainfo.help, "the derived attribute", "own attribute information");
+  NS_TEST_ASSERT_MSG_EQ (derived.LookupAttributeByName ("shared", &ainfo), true,
+                         "lookup inherited attribute");
+  NS_TEST_EXPECT_MSG_EQ (ainfo.help, "the base attribute", "inherited attribute information");
+  NS_TEST_EXPECT_MSG_EQ (base.LookupAttributeByName ("own", &ainfo), false,
+                         "the base has no derived attribute");
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupAttributeByName ("missing", &ainfo), false,
+                         "lookup missing attribute");
+
+  struct TypeId::TraceSourceInformation tinfo;
+  derived.LookupTraceSourceByName ("baseTrace", &tinfo);
+  NS_TEST_EXPECT_MSG_EQ (tinfo.help, "the base trace source", "lookup inherited trace source");
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupTraceSourceByName ("missing"), 0,
+                         "lookup missing trace source");
+
+  // the attributes added after a lookup are found too.
+  base.AddAttribute ("late", "the late attribute",
+                     EmptyAttributeValue (),
+                     MakeEmptyAttributeAccessor (),
+                     MakeEmptyAttributeChecker ());
+  NS_TEST_EXPECT_MSG_EQ (derived.LookupAttributeByName ("late", &ainfo), true,
+                         "lookup late inherited attribute");
+  NS_TEST_EXPECT_MSG_EQ (ainfo.help, "the late attribute", "late attribute information");
+}
+
   
 //----------------------------
 //
@@ -383,6 +456,19 @@ LookupTimeTestCase::DoRun (void)
   }
   stop = clock ();
   Report ("hash", stop - start);
+
+  start = clock ();
+  for (uint32_t j = 0; j < REPETITIONS; ++j)
+    {
+      for (uint32_t i = 0; i < nids; ++i)
+        {
+          const TypeId tid = TypeId::GetRegistered (i);
+          struct TypeId::AttributeInformation info;
+          tid.LookupAttributeByName ("missing", &info);
+        }
+  }
+  stop = clock ();
+  Report ("attribute name", stop - start);
   
 }
 
@@ -437,6 +523,7 @@ TypeIdTestSuite::TypeIdTestSuite ()
   AddTestCase (new UniqueTypeIdTestCase, QUICK);
   AddTestCase (new CollisionTestCase, QUICK);
   AddTestCase (new DeprecatedAttributeTestCase, QUICK);
+  AddTestCase (new InheritedLookupTestCase, QUICK);
 }
 
 static TypeIdTestSuite g_TypeIdTestSuite;  
@@ -266,9 +266,14 @@ CsmaHelper::Install (const NodeContainer &c, Ptr<CsmaChannel> channel) const
 {
   NetDeviceContainer devs;
 
-  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++)
+  // the constructors of the devices and of the queues draw no random
+  // stream, so they are created in batches, each from one arena.
+  std::vector<Ptr<CsmaNetDevice> > devices = m_deviceFactory.CreateN<CsmaNetDevice> (c.GetN ());
+  std::vector<Ptr<Queue> > queues = m_queueFactory.CreateN<Queue> (c.GetN ());
+  uint32_t j = 0;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++, j++)
     {
-      devs.Add (InstallPriv (*i, channel));
+      devs.Add (InstallPriv (*i, channel, devices[j], queues[j]));
     }
 
   return devs;
@@ -301,10 +306,16 @@ CsmaHelper::AssignStreams (NetDeviceContainer c, int64_t stream)
 Ptr<NetDevice>
 CsmaHelper::InstallPriv (Ptr<Node> node, Ptr<CsmaChannel> channel) const
 {
-  Ptr<CsmaNetDevice> device = m_deviceFactory.Create<CsmaNetDevice> ();
+  return InstallPriv (node, channel, m_deviceFactory.Create<CsmaNetDevice> (),
+                      m_queueFactory.Create<Queue> ());
+}
+
+Ptr<NetDevice>
+CsmaHelper::InstallPriv (Ptr<Node> node, Ptr<CsmaChannel> channel,
+                         Ptr<CsmaNetDevice> device, Ptr<Queue> queue) const
+{
   device->SetAddress (Mac48Address::Allocate ());
   node->AddDevice (device);
-  Ptr<Queue> queue = m_queueFactory.Create<Queue> ();
   device->SetQueue (queue);
   device->Attach (channel);
 
@@ -32,6 +32,8 @@
 namespace ns3 {
 
 class Packet;
+class CsmaNetDevice;
+class Queue;
 
 /**
  * \ingroup csma
@@ -218,6 +220,20 @@ private:
    */
   Ptr<NetDevice> InstallPriv (Ptr<Node> node, Ptr<CsmaChannel> channel) const;
 
+  /**
+   * This method adds a device created beforehand to the node, gives
+   * it a queue created beforehand and attaches the provided channel
+   * to the device.
+   *
+   * \param node The node to install the device in
+   * \param channel The channel to attach to the device.
+   * \param device The device.
+   * \param queue The queue of the device.
+   * \returns The net device.
+   */
+  Ptr<NetDevice> InstallPriv (Ptr<Node> node, Ptr<CsmaChannel> channel,
+                              Ptr<CsmaNetDevice> device, Ptr<Queue> queue) const;
+
   /**
    * \brief Enable pcap output on the indicated net device.
    *
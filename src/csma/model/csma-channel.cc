@@ -341,6 +341,12 @@ CsmaChannel::GetDevice (uint32_t i) const
   return GetCsmaDevice (i);
 }
 
+Time
+CsmaChannel::GetLookahead (void) const
+{
+  return Seconds (0);
+}
+
 CsmaDeviceRec::CsmaDeviceRec ()
 {
   active = false;
@@ -267,6 +267,13 @@ public:
    */
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
 
+  /**
+   * \return Zero: the devices sense the state of the channel at once,
+   * so a channel between partitions of a MultithreadedSimulatorImpl
+   * makes them run in turn.
+   */
+  virtual Time GetLookahead (void) const;
+
   /**
    * \return Get a CsmaNetDevice pointer to a connected network device.
    *
@@ -47,6 +47,7 @@
 #include "ns3/icmpv6-l4-protocol.h"
 #include "ns3/global-router-interface.h"
 #include "ns3/traffic-control-layer.h"
+#include <algorithm>
 #include <limits>
 #include <map>
 
@@ -143,6 +144,7 @@ InternetStackHelper::InternetStackHelper (const InternetStackHelper &o)
   m_tcpFactory = o.m_tcpFactory;
   m_ipv4ArpJitterEnabled = o.m_ipv4ArpJitterEnabled;
   m_ipv6NsRsJitterEnabled = o.m_ipv6NsRsJitterEnabled;
+  m_protocolFactories = o.m_protocolFactories;
 }
 
 InternetStackHelper &
@@ -154,6 +156,7 @@ InternetStackHelper::operator = (const InternetStackHelper &o)
     }
   m_routing = o.m_routing->Copy ();
   m_routingv6 = o.m_routingv6->Copy ();
+  m_protocolFactories = o.m_protocolFactories;
   return *this;
 }
 
@@ -267,9 +270,28 @@ InternetStackHelper::SetTcp (std::string tid, std::string n0, const AttributeVal
 void 
 InternetStackHelper::Install (NodeContainer c) const
 {
+  // the protocols whose constructors draw no random stream are created
+  // in batches, each from one arena.  ARP, ICMPv6 and TCP are still
+  // created node by node, so that their random streams are assigned in
+  // the same order as when the nodes are installed one by one.
+  Batches batches;
+  if (m_ipv4Enabled)
+    {
+      CreateBatch (&batches, "ns3::Ipv4L3Protocol", c.GetN ());
+      CreateBatch (&batches, "ns3::Icmpv4L4Protocol", c.GetN ());
+    }
+  if (m_ipv6Enabled)
+    {
+      CreateBatch (&batches, "ns3::Ipv6L3Protocol", c.GetN ());
+    }
+  if (m_ipv4Enabled || m_ipv6Enabled)
+    {
+      CreateBatch (&batches, "ns3::TrafficControlLayer", c.GetN ());
+      CreateBatch (&batches, "ns3::UdpL4Protocol", c.GetN ());
+    }
   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
     {
-      Install (*i);
+      InstallPriv (*i, &batches);
     }
 }
 
@@ -279,17 +301,57 @@ InternetStackHelper::InstallAll (void) const
   Install (NodeContainer::GetGlobal ());
 }
 
+ObjectFactory &
+InternetStackHelper::GetProtocolFactory (const std::string typeId) const
+{
+  // keep a factory per protocol, so that their attributes are only
+  // resolved again when the defaults change.
+  std::map<std::string, ObjectFactory>::iterator i = m_protocolFactories.find (typeId);
+  if (i == m_protocolFactories.end ())
+    {
+      i = m_protocolFactories.insert (std::make_pair (typeId, ObjectFactory (typeId))).first;
+    }
+  return i->second;
+}
+
 void
-InternetStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId)
+InternetStackHelper::CreateBatch (Batches *batches, const std::string typeId, uint32_t n) const
 {
-  ObjectFactory factory;
-  factory.SetTypeId (typeId);
-  Ptr<Object> protocol = factory.Create <Object> ();
+  std::vector<Ptr<Object> > &batch = (*batches)[typeId];
+  batch = GetProtocolFactory (typeId).CreateN (n);
+  // the nodes take the protocols from the back, in order.
+  std::reverse (batch.begin (), batch.end ());
+}
+
+void
+InternetStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId,
+                                                         Batches *batches) const
+{
+  Ptr<Object> protocol;
+  if (batches != 0)
+    {
+      Batches::iterator batch = batches->find (typeId);
+      if (batch != batches->end () && !batch->second.empty ())
+        {
+          protocol = batch->second.back ();
+          batch->second.pop_back ();
+        }
+    }
+  if (protocol == 0)
+    {
+      protocol = GetProtocolFactory (typeId).Create <Object> ();
+    }
   node->AggregateObject (protocol);
 }
 
 void
 InternetStackHelper::Install (Ptr<Node> node) const
+{
+  InstallPriv (node, 0);
+}
+
+void
+InternetStackHelper::InstallPriv (Ptr<Node> node, Batches *batches) const
 {
   if (m_ipv4Enabled)
     {
@@ -300,9 +362,9 @@ InternetStackHelper::Install (Ptr<Node> node) const
           return;
         }
 
-      CreateAndAggregateObjectFromTypeId (node, "ns3::ArpL3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv4L3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv4L4Protocol");
+      CreateAndAggregateObjectFromTypeId (node, "ns3::ArpL3Protocol", batches);
+      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv4L3Protocol", batches);
+      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv4L4Protocol", batches);
       if (m_ipv4ArpJitterEnabled == false)
         {
           Ptr<ArpL3Protocol> arp = node->GetObject<ArpL3Protocol> ();
@@ -325,8 +387,8 @@ InternetStackHelper::Install (Ptr<Node> node) const
           return;
         }
 
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv6L3Protocol");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv6L4Protocol");
+      CreateAndAggregateObjectFromTypeId (node, "ns3::Ipv6L3Protocol", batches);
+      CreateAndAggregateObjectFromTypeId (node, "ns3::Icmpv6L4Protocol", batches);
       if (m_ipv6NsRsJitterEnabled == false)
         {
           Ptr<Icmpv6L4Protocol> icmpv6l4 = node->GetObject<Icmpv6L4Protocol> ();
@@ -345,8 +407,8 @@ InternetStackHelper::Install (Ptr<Node> node) const
 
   if (m_ipv4Enabled || m_ipv6Enabled)
     {
-      CreateAndAggregateObjectFromTypeId (node, "ns3::TrafficControlLayer");
-      CreateAndAggregateObjectFromTypeId (node, "ns3::UdpL4Protocol");
+      CreateAndAggregateObjectFromTypeId (node, "ns3::TrafficControlLayer", batches);
+      CreateAndAggregateObjectFromTypeId (node, "ns3::UdpL4Protocol", batches);
       node->AggregateObject (m_tcpFactory.Create<Object> ());
       Ptr<PacketSocketFactory> factory = CreateObject<PacketSocketFactory> ();
       node->AggregateObject (factory);
@@ -30,6 +30,10 @@
 #include "ns3/ipv6-l3-protocol.h"
 #include "internet-trace-helper.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace ns3 {
 
 class Node;
@@ -312,12 +316,42 @@ private:
    */
   const Ipv6RoutingHelper *m_routingv6;
 
+  /**
+   * \brief The protocols created beforehand for the nodes, by TypeId name.
+   */
+  typedef std::map<std::string, std::vector<Ptr<Object> > > Batches;
+
+  /**
+   * \brief aggregate the stack to the node
+   * \param node the node
+   * \param batches the protocols created beforehand, or 0
+   */
+  void InstallPriv (Ptr<Node> node, Batches *batches) const;
+
+  /**
+   * \brief get the factory of a protocol
+   * \param typeId the protocol TypeId
+   * \returns the factory
+   */
+  ObjectFactory & GetProtocolFactory (const std::string typeId) const;
+
+  /**
+   * \brief create a protocol for each node, from one arena
+   * \param batches where to add the protocols
+   * \param typeId the protocol TypeId
+   * \param n the number of nodes
+   */
+  void CreateBatch (Batches *batches, const std::string typeId, uint32_t n) const;
+
   /**
    * \brief create an object from its TypeId and aggregates it to the node
    * \param node the node
    * \param typeId the object TypeId
+   * \param batches the protocols created beforehand, if any, from which
+   *        the object is taken
    */
-  static void CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId);
+  void CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const std::string typeId,
+                                           Batches *batches = 0) const;
 
   /**
    * \brief checks if there is an hook to a Pcap wrapper
@@ -366,6 +400,11 @@ private:
    * \brief IPv6 IPv6 NS and RS Jitter state (enabled/disabled) ?
    */
   bool m_ipv6NsRsJitterEnabled;
+
+  /**
+   * \brief The factories of the protocols, by TypeId name.
+   */
+  mutable std::map<std::string, ObjectFactory> m_protocolFactories;
 };
 
 } // namespace ns3
@@ -20,8 +20,8 @@
 
 #define NS_LOG_APPEND_CONTEXT                                   \
   if (m_ipv4 && m_ipv4->GetObject<Node> ()) { \
-      std::clog << Simulator::Now ().GetSeconds () \
-                << " [node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
+      NS_LOG_STREAM << Simulator::Now ().GetSeconds () \
+                    << " [node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
 
 #include <iomanip>
 #include "ns3/log.h"
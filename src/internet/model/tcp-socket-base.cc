@@ -20,7 +20,7 @@
  */
 
 #define NS_LOG_APPEND_CONTEXT \
-  if (m_node) { std::clog << " [node " << m_node->GetId () << "] "; }
+  if (m_node) { NS_LOG_STREAM << " [node " << m_node->GetId () << "] "; }
 
 #include "ns3/abort.h"
 #include "ns3/node.h"
@@ -129,6 +129,12 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("UseTimerWheel",
+                   "Keep the retransmission and delayed ACK timers in the "
+                   "TimerWheel, where re-arming them leaves no cancelled event",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_useTimerWheel),
+                   MakeBooleanChecker ())
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -269,6 +275,7 @@ TcpSocketBase::TcpSocketBase (void)
     m_delAckEvent (),
     m_persistEvent (),
     m_timewaitEvent (),
+    m_useTimerWheel (false),
     m_dupAckCount (0),
     m_delAckCount (0),
     m_delAckMaxCount (0),
@@ -321,6 +328,8 @@ TcpSocketBase::TcpSocketBase (void)
     m_isFirstPartialAck (true)
 {
   NS_LOG_FUNCTION (this);
+  m_retxTimer.SetFunction (MakeCallback (&TcpSocketBase::ReTxTimeout, this));
+  m_delAckTimer.SetFunction (MakeCallback (&TcpSocketBase::DelAckTimeout, this));
   m_rxBuffer = CreateObject<TcpRxBuffer> ();
   m_txBuffer = CreateObject<TcpTxBuffer> ();
   m_tcb      = CreateObject<TcpSocketState> ();
@@ -351,6 +360,7 @@ TcpSocketBase::TcpSocketBase (void)
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   : TcpSocket (sock),
     //copy object::m_tid and socket::callbacks
+    m_useTimerWheel (sock.m_useTimerWheel),
     m_dupAckCount (sock.m_dupAckCount),
     m_delAckCount (0),
     m_delAckMaxCount (sock.m_delAckMaxCount),
@@ -399,6 +409,8 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
+  m_retxTimer.SetFunction (MakeCallback (&TcpSocketBase::ReTxTimeout, this));
+  m_delAckTimer.SetFunction (MakeCallback (&TcpSocketBase::DelAckTimeout, this));
   // Copy the rtt estimator if it is set
   if (sock.m_rtt)
     {
@@ -1294,8 +1306,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << " Enter zerowindow persist state");
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
-      m_retxEvent.Cancel ();
+                    (Simulator::Now () + GetReTxDelayLeft ()).GetSeconds ());
+      CancelReTxTimer ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_persistTimeout).GetSeconds ());
@@ -1772,7 +1784,7 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
-      m_retxEvent.Cancel ();
+      CancelReTxTimer ();
       m_delAckCount = m_delAckMaxCount;
       ReceivedData (packet, tcpHeader);
       Simulator::ScheduleNow (&TcpSocketBase::ConnectionSucceeded, this);
@@ -1795,7 +1807,7 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
-      m_retxEvent.Cancel ();
+      CancelReTxTimer ();
       m_rxBuffer->SetNextRxSequence (tcpHeader.GetSequenceNumber () + SequenceNumber32 (1));
       m_tcb->m_highTxMark = ++m_tcb->m_nextTxSequence;
       m_txBuffer->SetHeadSequence (m_tcb->m_nextTxSequence);
@@ -1838,7 +1850,7 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
       m_congestionControl->CongestionStateSet (m_tcb, TcpSocketState::CA_OPEN);
       m_state = ESTABLISHED;
       m_connected = true;
-      m_retxEvent.Cancel ();
+      CancelReTxTimer ();
       m_tcb->m_highTxMark = ++m_tcb->m_nextTxSequence;
       m_txBuffer->SetHeadSequence (m_tcb->m_nextTxSequence);
       if (m_endPoint)
@@ -1872,7 +1884,7 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
       if (tcpHeader.GetSequenceNumber () == m_rxBuffer->NextRxSequence ())
         { // In-sequence FIN before connection complete. Set up connection and close.
           m_connected = true;
-          m_retxEvent.Cancel ();
+          CancelReTxTimer ();
           m_tcb->m_highTxMark = ++m_tcb->m_nextTxSequence;
           m_txBuffer->SetHeadSequence (m_tcb->m_nextTxSequence);
           if (m_endPoint)
@@ -2137,7 +2149,7 @@ TcpSocketBase::Destroy (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + GetReTxDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2153,7 +2165,7 @@ TcpSocketBase::Destroy6 (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + GetReTxDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2293,14 +2305,14 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
 
   if (flags & TcpHeader::ACK)
     { // If sending an ACK, cancel the delay ACK as well
-      m_delAckEvent.Cancel ();
+      CancelDelAckTimer ();
       m_delAckCount = 0;
       if (m_highTxAck < header.GetAckNumber ())
         {
           m_highTxAck = header.GetAckNumber ();
         }
     }
-  if (m_retxEvent.IsExpired () && (hasSyn || hasFin) && !isAck )
+  if (IsReTxTimerExpired () && (hasSyn || hasFin) && !isAck )
     { // Retransmit SYN / SYN+ACK / FIN / FIN+ACK to guard against lost
       NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                     << Simulator::Now ().GetSeconds () << " to expire at time "
@@ -2474,7 +2486,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   if (withAck)
     {
-      m_delAckEvent.Cancel ();
+      CancelDelAckTimer ();
       m_delAckCount = 0;
     }
 
@@ -2551,7 +2563,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
   header.SetWindowSize (AdvertisedWindowSize ());
   AddOptions (header);
 
-  if (m_retxEvent.IsExpired ())
+  if (IsReTxTimerExpired ())
     {
       // Schedules retransmit timeout. If this is a retransmission, double the timer
 
@@ -2565,7 +2577,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      ScheduleReTxTimer ();
     }
 
   m_txTrace (p, header, this);
@@ -2787,11 +2799,17 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     { // In-sequence packet: ACK if delayed ack count allows
       if (++m_delAckCount >= m_delAckMaxCount)
         {
-          m_delAckEvent.Cancel ();
+          CancelDelAckTimer ();
           m_delAckCount = 0;
           SendEmptyPacket (TcpHeader::ACK);
         }
-      else if (m_delAckEvent.IsExpired ())
+      else if (m_useTimerWheel && m_delAckTimer.IsExpired ())
+        {
+          m_delAckTimer.Schedule (m_delAckTimeout);
+          NS_LOG_LOGIC (this << " scheduled delayed ACK at " <<
+                        (Simulator::Now () + m_delAckTimer.GetDelayLeft ()).GetSeconds ());
+        }
+      else if (!m_useTimerWheel && m_delAckEvent.IsExpired ())
         {
           m_delAckEvent = Simulator::Schedule (m_delAckTimeout,
                                                &TcpSocketBase::DelAckTimeout, this);
@@ -2886,8 +2904,8 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_state != SYN_RCVD && resetRTO)
     { // Set RTO unless the ACK is received in SYN_RCVD state
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
-      m_retxEvent.Cancel ();
+                    (Simulator::Now () + GetReTxDelayLeft ()).GetSeconds ());
+      CancelReTxTimer ();
       // On receiving a "New" ack we restart retransmission timer .. RFC 6298
       // RFC 6298, clause 2.4
       m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4), m_minRto);
@@ -2895,7 +2913,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
       NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      ScheduleReTxTimer ();
     }
 
   // Note the highest ACK and tell app to send more
@@ -2913,8 +2931,8 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_txBuffer->Size () == 0 && m_state != FIN_WAIT_1 && m_state != CLOSING)
     { // No retransmit timer if no data to retransmit
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
-      m_retxEvent.Cancel ();
+                    (Simulator::Now () + GetReTxDelayLeft ()).GetSeconds ());
+      CancelReTxTimer ();
     }
 }
 
@@ -3117,12 +3135,55 @@ TcpSocketBase::DoRetransmit ()
   NS_LOG_DEBUG ("retxing seq " << m_txBuffer->HeadSequence ());
 }
 
+bool
+TcpSocketBase::IsReTxTimerExpired (void) const
+{
+  return m_retxEvent.IsExpired () && m_retxTimer.IsExpired ();
+}
+
+Time
+TcpSocketBase::GetReTxDelayLeft (void) const
+{
+  if (m_retxTimer.IsRunning ())
+    {
+      return m_retxTimer.GetDelayLeft ();
+    }
+  return Simulator::GetDelayLeft (m_retxEvent);
+}
+
 void
-TcpSocketBase::CancelAllTimers ()
+TcpSocketBase::CancelReTxTimer (void)
 {
   m_retxEvent.Cancel ();
-  m_persistEvent.Cancel ();
+  m_retxTimer.Cancel ();
+}
+
+void
+TcpSocketBase::ScheduleReTxTimer (void)
+{
+  if (m_useTimerWheel)
+    {
+      m_retxTimer.Schedule (m_rto);
+    }
+  else
+    {
+      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+    }
+}
+
+void
+TcpSocketBase::CancelDelAckTimer (void)
+{
   m_delAckEvent.Cancel ();
+  m_delAckTimer.Cancel ();
+}
+
+void
+TcpSocketBase::CancelAllTimers ()
+{
+  CancelReTxTimer ();
+  m_persistEvent.Cancel ();
+  CancelDelAckTimer ();
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
@@ -33,6 +33,7 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/timer-wheel.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -693,6 +694,36 @@ protected:
    */
   void CancelAllTimers (void);
 
+  /**
+   * \brief Check if the retransmission timer is not running
+   * \returns true if neither the retransmission event nor the
+   * retransmission timer of the wheel is running
+   */
+  bool IsReTxTimerExpired (void) const;
+
+  /**
+   * \brief Get the time left before the retransmission timeout
+   * \returns the delay left, or zero if the timer is not running
+   */
+  Time GetReTxDelayLeft (void) const;
+
+  /**
+   * \brief Cancel the retransmission timer, event or timer of the wheel
+   */
+  void CancelReTxTimer (void);
+
+  /**
+   * \brief Schedule ReTxTimeout after the current RTO
+   *
+   * The timer is kept in the TimerWheel if UseTimerWheel is set.
+   */
+  void ScheduleReTxTimer (void);
+
+  /**
+   * \brief Cancel the delayed ACK timer, event or timer of the wheel
+   */
+  void CancelDelAckTimer (void);
+
   /**
    * \brief Move from CLOSING or FIN_WAIT_2 to TIME_WAIT state
    */
@@ -981,6 +1012,9 @@ protected:
   EventId           m_delAckEvent;     //!< Delayed ACK timeout event
   EventId           m_persistEvent;    //!< Persist event: Send 1 byte to probe for a non-zero Rx window
   EventId           m_timewaitEvent;   //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  TimerWheel::Entry m_retxTimer;       //!< Retransmission timer, in the TimerWheel
+  TimerWheel::Entry m_delAckTimer;     //!< Delayed ACK timer, in the TimerWheel
+  bool              m_useTimerWheel;   //!< Use m_retxTimer and m_delAckTimer rather than events
   uint32_t          m_dupAckCount;     //!< Dupack counter
   uint32_t          m_delAckCount;     //!< Delayed ACK counter
   uint32_t          m_delAckMaxCount;  //!< Number of packet to fire an ACK before delay timeout
@@ -36,7 +36,7 @@
 
 #undef NS_LOG_APPEND_CONTEXT
 #define NS_LOG_APPEND_CONTEXT                                   \
-  std::clog << "[address " << m_shortAddress << "] ";
+  NS_LOG_STREAM << "[address " << m_shortAddress << "] ";
 
 namespace ns3 {
 
@@ -20,6 +20,7 @@
 #include "node-container.h"
 #include "ns3/node-list.h"
 #include "ns3/names.h"
+#include "ns3/object-factory.h"
 
 namespace ns3 {
 
@@ -92,10 +93,10 @@ NodeContainer::Get (uint32_t i) const
 void 
 NodeContainer::Create (uint32_t n)
 {
-  for (uint32_t i = 0; i < n; i++)
-    {
-      m_nodes.push_back (CreateObject<Node> ());
-    }
+  ObjectFactory factory;
+  factory.SetTypeId (Node::GetTypeId ());
+  std::vector<Ptr<Node> > nodes = factory.CreateN<Node> (n);
+  m_nodes.insert (m_nodes.end (), nodes.begin (), nodes.end ());
 }
 void 
 NodeContainer::Create (uint32_t n, uint32_t systemId)
@@ -118,9 +118,14 @@ SimpleNetDeviceHelper::Install (const NodeContainer &c, Ptr<SimpleChannel> chann
 {
   NetDeviceContainer devs;
 
-  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++)
+  // the constructors of the devices and of the queues draw no random
+  // stream, so they are created in batches, each from one arena.
+  std::vector<Ptr<SimpleNetDevice> > devices = m_deviceFactory.CreateN<SimpleNetDevice> (c.GetN ());
+  std::vector<Ptr<Queue> > queues = m_queueFactory.CreateN<Queue> (c.GetN ());
+  uint32_t j = 0;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++, j++)
     {
-      devs.Add (InstallPriv (*i, channel));
+      devs.Add (InstallPriv (*i, channel, devices[j], queues[j]));
     }
 
   return devs;
@@ -129,12 +134,18 @@ SimpleNetDeviceHelper::Install (const NodeContainer &c, Ptr<SimpleChannel> chann
 Ptr<NetDevice>
 SimpleNetDeviceHelper::InstallPriv (Ptr<Node> node, Ptr<SimpleChannel> channel) const
 {
-  Ptr<SimpleNetDevice> device = m_deviceFactory.Create<SimpleNetDevice> ();
+  return InstallPriv (node, channel, m_deviceFactory.Create<SimpleNetDevice> (),
+                      m_queueFactory.Create<Queue> ());
+}
+
+Ptr<NetDevice>
+SimpleNetDeviceHelper::InstallPriv (Ptr<Node> node, Ptr<SimpleChannel> channel,
+                                    Ptr<SimpleNetDevice> device, Ptr<Queue> queue) const
+{
   device->SetAttribute ("PointToPointMode", BooleanValue (m_pointToPointMode));
   device->SetAddress (Mac48Address::Allocate ());
   node->AddDevice (device);
   device->SetChannel (channel);
-  Ptr<Queue> queue = m_queueFactory.Create<Queue> ();
   device->SetQueue (queue);
   NS_ASSERT_MSG (!m_pointToPointMode || (channel->GetNDevices () <= 2), "Device set to PointToPoint and more than 2 devices on the channel.");
   return device;
@@ -27,6 +27,8 @@
 #include "ns3/net-device-container.h"
 #include "ns3/node-container.h"
 #include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/queue.h"
 
 namespace ns3 {
 
@@ -177,6 +179,19 @@ private:
    * \returns The new net device.
    */
   Ptr<NetDevice> InstallPriv (Ptr<Node> node, Ptr<SimpleChannel> channel) const;
+  /**
+   * This method adds a device created beforehand to the node, gives
+   * it a queue created beforehand and attaches the provided channel
+   * to the device.
+   *
+   * \param node The node to install the device in
+   * \param channel The channel to attach to the device.
+   * \param device The device.
+   * \param queue The queue of the device.
+   * \returns The net device.
+   */
+  Ptr<NetDevice> InstallPriv (Ptr<Node> node, Ptr<SimpleChannel> channel,
+                              Ptr<SimpleNetDevice> device, Ptr<Queue> queue) const;
 
   ObjectFactory m_queueFactory; //!< Queue factory
   ObjectFactory m_deviceFactory; //!< NetDevice factory
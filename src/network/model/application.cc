@@ -101,6 +101,43 @@ Application::DoInitialize (void)
   Object::DoInitialize ();
 }
 
+void
+Application::DoSerialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  Object::DoSerialize (os);
+  // the time left before the start and stop events, or -1.
+  int64_t start = m_startEvent.IsRunning () ? Simulator::GetDelayLeft (m_startEvent).GetTimeStep () : -1;
+  int64_t stop = m_stopEvent.IsRunning () ? Simulator::GetDelayLeft (m_stopEvent).GetTimeStep () : -1;
+  bool running = IsInitialized () && start < 0 && (m_stopTime == TimeStep (0) || stop >= 0);
+  os << start << " " << stop << " " << running;
+}
+
+void
+Application::DoDeserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+  Object::DoDeserialize (is);
+  int64_t start = -1;
+  int64_t stop = -1;
+  bool running = false;
+  is >> start >> stop >> running;
+  m_startEvent.Cancel ();
+  m_stopEvent.Cancel ();
+  if (start >= 0)
+    {
+      m_startEvent = Simulator::Schedule (TimeStep (start), &Application::StartApplication, this);
+    }
+  if (stop >= 0)
+    {
+      m_stopEvent = Simulator::Schedule (TimeStep (stop), &Application::StopApplication, this);
+    }
+  if (running)
+    {
+      StartApplication ();
+    }
+}
+
 Ptr<Node> Application::GetNode () const
 {
   NS_LOG_FUNCTION (this);
@@ -51,6 +51,12 @@ class Node;
  *
  * The main purpose of the base class application public API is to
  * provide a uniform way to start and stop applications.
+ *
+ * An application takes part in a Checkpoint through the Node it is
+ * installed on: the base class saves its pending start and stop
+ * events, and whether it is running, so that Checkpoint::Restore()
+ * starts it again; the subclasses which support Restore() save the
+ * rest of their state, and schedule again their own events.
  */
 
 /**
@@ -125,6 +131,8 @@ private:
 protected:
   virtual void DoDispose (void);
   virtual void DoInitialize (void);
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual void DoDeserialize (std::istream &is);
 
   Ptr<Node>       m_node;   //!< The node that this application is installed on
   Time m_startTime;         //!< The simulation time that the application will start
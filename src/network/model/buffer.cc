@@ -20,6 +20,9 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/memory-accounting.h"
+#include "packet-pool.h"
+#include <algorithm>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -43,6 +46,22 @@ static struct Zeroes
   const uint32_t size;  //!< buffer size
 } g_zeroes; //!< Zero-filled buffer
 
+/**
+ * \ingroup packet
+ * The number of bytes from which the real bytes of buffers are shared
+ * as slices rather than copied when they are appended, or grown while
+ * their BufferData is shared.
+ */
+static const uint32_t g_minSliceSize = 256;
+/**
+ * \ingroup packet
+ * The number of slices beyond which the real bytes of a chain and its
+ * zero slices smaller than g_minSliceSize are copied together, so that
+ * appending many small buffers to a large one does not make its chain
+ * ever longer.  The larger zero slices are never copied.
+ */
+static const uint32_t g_maxSlices = 64;
+
 }
 
 namespace ns3 {
@@ -50,99 +69,8 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+thread_local uint32_t Buffer::g_recommendedStart = 0;
 
-void
-Buffer::Recycle (struct Buffer::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
-}
-
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
-{
-  NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
-}
-#else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -157,7 +85,6 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -169,10 +96,16 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
-  struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  void *b = PacketPool::Allocate (PacketPool::BUFFER, size);
+  struct Buffer::Data *data = static_cast<struct Buffer::Data*>(b);
+  // the pool may round the block up: use all of it.
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
+  if (MemoryAccounting::IsEnabled ())
+    {
+      static uint32_t category = MemoryAccounting::GetCategory ("ns3::Buffer");
+      MemoryAccounting::NotifyAllocate (data, category, size);
+    }
   return data;
 }
 
@@ -181,8 +114,8 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  MemoryAccounting::NotifyRelease (data);
+  PacketPool::Release (PacketPool::BUFFER, data, data->m_size - 1 + sizeof (struct Buffer::Data));
 }
 
 Buffer::Buffer ()
@@ -198,6 +131,8 @@ Buffer::Buffer (uint32_t dataSize)
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_chain (0),
+    m_chainStart (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -245,6 +180,8 @@ Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
   m_data = Buffer::Create (0);
+  m_chain = 0;
+  m_chainStart = 0;
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -270,6 +207,16 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
+  if (m_chain != o.m_chain)
+    {
+      if (o.m_chain != 0)
+        {
+          o.m_chain->m_count++;
+        }
+      ReleaseChain ();
+      m_chain = o.m_chain;
+    }
+  m_chainStart = o.m_chainStart;
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
@@ -290,6 +237,311 @@ Buffer::~Buffer ()
     {
       Recycle (m_data);
     }
+  ReleaseChain ();
+}
+
+void
+Buffer::ReleaseChain (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_chain == 0)
+    {
+      return;
+    }
+  m_chain->m_count--;
+  if (m_chain->m_count == 0)
+    {
+      for (const struct Slice *i = m_chain->m_slices; i != m_chain->m_slices + m_chain->m_nSlices; i++)
+        {
+          if (i->m_data != 0)
+            {
+              i->m_data->m_count--;
+              if (i->m_data->m_count == 0)
+                {
+                  Recycle (i->m_data);
+                }
+            }
+        }
+      PacketPool::Release (PacketPool::BUFFER, m_chain, m_chain->m_size);
+    }
+  m_chain = 0;
+}
+
+void
+Buffer::AppendSlice (std::vector<struct Slice> &slices, const struct Slice &slice)
+{
+  NS_LOG_FUNCTION (&slices << slice.m_data << slice.m_offset << slice.m_length);
+  if (!slices.empty ())
+    {
+      struct Slice &last = slices.back ();
+      if (last.m_data == slice.m_data &&
+          (slice.m_data == 0 || last.m_offset + last.m_length == slice.m_offset))
+        {
+          /* the slices are adjacent: zeroes followed by zeroes, or
+           * consecutive bytes of the same BufferData.
+           */
+          last.m_length += slice.m_length;
+          return;
+        }
+    }
+  struct Slice tmp = slice;
+  tmp.m_position = slices.empty () ? 0 : slices.back ().m_position + slices.back ().m_length;
+  slices.push_back (tmp);
+}
+
+void
+Buffer::GetSlices (std::vector<struct Slice> &slices) const
+{
+  NS_LOG_FUNCTION (this << &slices);
+  struct Slice slice;
+  slice.m_position = 0;
+  uint32_t headSize = m_zeroAreaStart - m_start;
+  if (headSize > 0)
+    {
+      slice.m_data = m_data;
+      slice.m_offset = m_start;
+      slice.m_length = headSize;
+      AppendSlice (slices, slice);
+    }
+  uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+  if (zeroSize > 0 && m_chain == 0)
+    {
+      slice.m_data = 0;
+      slice.m_offset = 0;
+      slice.m_length = zeroSize;
+      AppendSlice (slices, slice);
+    }
+  else if (zeroSize > 0)
+    {
+      uint32_t start = m_chainStart;
+      uint32_t end = m_chainStart + zeroSize;
+      for (uint32_t i = FindSlice (m_chain, start); i < m_chain->m_nSlices; i++)
+        {
+          const struct Slice &part = m_chain->m_slices[i];
+          if (part.m_position >= end)
+            {
+              break;
+            }
+          uint32_t from = std::max (start, part.m_position);
+          uint32_t to = std::min (end, part.m_position + part.m_length);
+          slice.m_data = part.m_data;
+          slice.m_offset = part.m_offset + (from - part.m_position);
+          slice.m_length = to - from;
+          AppendSlice (slices, slice);
+        }
+    }
+  uint32_t tailSize = m_end - m_zeroAreaEnd;
+  if (tailSize > 0)
+    {
+      slice.m_data = m_data;
+      slice.m_offset = m_zeroAreaStart;
+      slice.m_length = tailSize;
+      AppendSlice (slices, slice);
+    }
+}
+
+void
+Buffer::SetSlices (const std::vector<struct Slice> &slices)
+{
+  NS_LOG_FUNCTION (this << &slices);
+  uint32_t size = 0;
+  for (std::vector<struct Slice>::const_iterator i = slices.begin (); i != slices.end (); i++)
+    {
+      size += i->m_length;
+    }
+  Buffer tmp (size);
+  if (slices.size () > 1 || (slices.size () == 1 && slices[0].m_data != 0))
+    {
+      uint32_t chainSize = sizeof (struct Chain) + (slices.size () - 1) * sizeof (struct Slice);
+      tmp.m_chain = static_cast<struct Chain *> (PacketPool::Allocate (PacketPool::BUFFER, chainSize));
+      tmp.m_chain->m_count = 1;
+      tmp.m_chain->m_size = chainSize;
+      tmp.m_chain->m_nSlices = slices.size ();
+      std::copy (slices.begin (), slices.end (), tmp.m_chain->m_slices);
+      for (std::vector<struct Slice>::const_iterator i = slices.begin (); i != slices.end (); i++)
+        {
+          if (i->m_data != 0)
+            {
+              i->m_data->m_count++;
+            }
+        }
+    }
+  *this = tmp;
+}
+
+void
+Buffer::CompactSlices (std::vector<struct Slice> &slices, std::vector<Buffer> &runs)
+{
+  NS_LOG_FUNCTION (&slices << &runs);
+  /* nothing to merge when each run between two large zero slices
+   * is a single slice: leave the list alone rather than copy it.
+   */
+  bool merge = false;
+  for (uint32_t k = 1; k < slices.size () && !merge; k++)
+    {
+      merge = (slices[k - 1].m_data != 0 || slices[k - 1].m_length < g_minSliceSize) &&
+        (slices[k].m_data != 0 || slices[k].m_length < g_minSliceSize);
+    }
+  if (!merge)
+    {
+      return;
+    }
+  std::vector<struct Slice> compact;
+  uint32_t i = 0;
+  while (i < slices.size ())
+    {
+      /* the runs of real bytes and small zero slices between two
+       * large zero slices are copied into a BufferData each, while
+       * the large zero slices stay virtual.
+       */
+      uint32_t j = i;
+      uint32_t size = 0;
+      while (j < slices.size () &&
+             (slices[j].m_data != 0 || slices[j].m_length < g_minSliceSize))
+        {
+          size += slices[j].m_length;
+          j++;
+        }
+      if (j == i)
+        {
+          AppendSlice (compact, slices[i]);
+          i++;
+          continue;
+        }
+      if (j - i == 1)
+        {
+          AppendSlice (compact, slices[i]);
+          i = j;
+          continue;
+        }
+      Buffer run;
+      run.AddAtStart (size);
+      uint8_t *buffer = run.m_data->m_data + run.m_start;
+      for (; i < j; i++)
+        {
+          if (slices[i].m_data != 0)
+            {
+              memcpy (buffer, slices[i].m_data->m_data + slices[i].m_offset, slices[i].m_length);
+            }
+          else
+            {
+              memset (buffer, 0, slices[i].m_length);
+            }
+          buffer += slices[i].m_length;
+        }
+      struct Slice slice;
+      slice.m_data = run.m_data;
+      slice.m_offset = run.m_start;
+      slice.m_length = size;
+      AppendSlice (compact, slice);
+      runs.push_back (run);
+    }
+  slices.swap (compact);
+}
+
+void
+Buffer::MoveIntoChain (void)
+{
+  NS_LOG_FUNCTION (this);
+  // a scratch list of this thread, to not allocate one each time.
+  static thread_local std::vector<struct Slice> slices;
+  slices.clear ();
+  GetSlices (slices);
+  SetSlices (slices);
+}
+
+uint32_t
+Buffer::FindSlice (const struct Chain *chain, uint32_t position)
+{
+  NS_LOG_FUNCTION (chain << position);
+  uint32_t low = 0;
+  uint32_t high = chain->m_nSlices;
+  while (high - low > 1)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (chain->m_slices[middle].m_position <= position)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  NS_ASSERT (position >= chain->m_slices[low].m_position &&
+             position < chain->m_slices[low].m_position + chain->m_slices[low].m_length);
+  return low;
+}
+
+void
+Buffer::CopyChainData (const struct Chain *chain, uint32_t position, uint8_t *buffer, uint32_t size)
+{
+  NS_LOG_FUNCTION (chain << position << &buffer << size);
+  if (chain == 0)
+    {
+      memset (buffer, 0, size);
+      return;
+    }
+  if (size == 0)
+    {
+      return;
+    }
+  for (uint32_t i = FindSlice (chain, position); size > 0; i++)
+    {
+      const struct Slice &slice = chain->m_slices[i];
+      uint32_t offset = position - slice.m_position;
+      uint32_t toCopy = std::min (size, slice.m_length - offset);
+      if (slice.m_data == 0)
+        {
+          memset (buffer, 0, toCopy);
+        }
+      else
+        {
+          memcpy (buffer, slice.m_data->m_data + slice.m_offset + offset, toCopy);
+        }
+      buffer += toCopy;
+      position += toCopy;
+      size -= toCopy;
+    }
+}
+
+void
+Buffer::CopyChainData (const struct Chain *chain, uint32_t position, std::ostream *os, uint32_t size)
+{
+  NS_LOG_FUNCTION (chain << position << &os << size);
+  uint32_t i = (chain != 0 && size > 0) ? FindSlice (chain, position) : 0;
+  while (size > 0)
+    {
+      uint32_t toCopy = size;
+      const uint8_t *from = 0;
+      if (chain != 0)
+        {
+          const struct Slice &slice = chain->m_slices[i];
+          uint32_t offset = position - slice.m_position;
+          toCopy = std::min (size, slice.m_length - offset);
+          if (slice.m_data != 0)
+            {
+              from = slice.m_data->m_data + slice.m_offset + offset;
+            }
+          i++;
+        }
+      if (from != 0)
+        {
+          os->write ((const char*)from, toCopy);
+        }
+      else
+        {
+          uint32_t left = toCopy;
+          while (left > 0)
+            {
+              uint32_t toWrite = std::min (left, g_zeroes.size);
+              os->write (g_zeroes.buffer, toWrite);
+              left -= toWrite;
+            }
+        }
+      position += toCopy;
+      size -= toCopy;
+    }
 }
 
 uint32_t
@@ -323,6 +575,15 @@ Buffer::AddAtStart (uint32_t start)
       // update dirty area
       m_data->m_dirtyStart = m_start;
     } 
+  else if (m_data->m_count > 1 && GetInternalSize () >= g_minSliceSize)
+    {
+      /* the data is shared: share the real bytes of the buffer
+       * rather than copy them, and grow the new, empty, BufferData.
+       */
+      MoveIntoChain ();
+      AddAtStart (start);
+      return;
+    }
   else
     {
       uint32_t newSize = GetInternalSize () + start;
@@ -368,6 +629,12 @@ Buffer::AddAtEnd (uint32_t end)
       // update dirty area.
       m_data->m_dirtyEnd = m_end;
     } 
+  else if (m_data->m_count > 1 && GetInternalSize () >= g_minSliceSize)
+    {
+      MoveIntoChain ();
+      AddAtEnd (end);
+      return;
+    }
   else
     {
       uint32_t newSize = GetInternalSize () + end;
@@ -400,7 +667,14 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (&o == this)
+    {
+      Buffer copy = o;
+      AddAtEnd (copy);
+      return;
+    }
+  if (m_chain == 0 && o.m_chain == 0 &&
+      m_data->m_count == 1 &&
       m_end == m_zeroAreaEnd &&
       m_end == m_data->m_dirtyEnd &&
       o.m_start == o.m_zeroAreaStart &&
@@ -426,14 +700,35 @@ Buffer::AddAtEnd (const Buffer &o)
       return;
     }
 
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
+  if (o.m_chain == 0 && o.GetSize () < g_minSliceSize && m_data != o.m_data)
+    {
+      /* copy a small buffer at the end of this one. */
+      uint32_t size = o.GetSize ();
+      AddAtEnd (size);
+      Buffer::Iterator dst = End ();
+      dst.Prev (size);
+      dst.Write (o.Begin (), o.End ());
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
 
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
-  *this = dst;
+  /* share the bytes of both buffers in a chain of slices. This is
+   * also how two fragments of the same BufferData are joined.
+   */
+  static thread_local std::vector<struct Slice> slices;
+  slices.clear ();
+  GetSlices (slices);
+  o.GetSlices (slices);
+  if (slices.size () > g_maxSlices)
+    {
+      std::vector<Buffer> runs;
+      CompactSlices (slices, runs);
+      SetSlices (slices);
+    }
+  else
+    {
+      SetSlices (slices);
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -457,6 +752,7 @@ Buffer::RemoveAtStart (uint32_t start)
       m_start = m_zeroAreaStart;
       m_zeroAreaEnd -= delta;
       m_end -= delta;
+      m_chainStart += delta;
     } 
   else if (newStart <= m_end)
     {
@@ -478,6 +774,10 @@ Buffer::RemoveAtStart (uint32_t start)
       m_zeroAreaEnd = m_end;
       m_zeroAreaStart = m_end;
     }
+  if (m_zeroAreaEnd == m_zeroAreaStart)
+    {
+      ReleaseChain ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem start=" << start << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -513,6 +813,10 @@ Buffer::RemoveAtEnd (uint32_t end)
       m_zeroAreaEnd = m_start;
       m_zeroAreaStart = m_start;
     }
+  if (m_zeroAreaEnd == m_zeroAreaStart)
+    {
+      ReleaseChain ();
+    }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("rem end=" << end << ", ");
   NS_ASSERT (CheckInternalState ());
@@ -539,7 +843,7 @@ Buffer::CreateFullCopy (void) const
     {
       Buffer tmp;
       tmp.AddAtStart (m_zeroAreaEnd - m_zeroAreaStart);
-      tmp.Begin ().WriteU8 (0, m_zeroAreaEnd - m_zeroAreaStart);
+      CopyChainData (m_chain, m_chainStart, tmp.m_data->m_data + tmp.m_start, m_zeroAreaEnd - m_zeroAreaStart);
       uint32_t dataStart = m_zeroAreaStart - m_start;
       tmp.AddAtStart (dataStart);
       tmp.Begin ().Write (m_data->m_data+m_start, dataStart);
@@ -559,6 +863,30 @@ uint32_t
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_chain != 0)
+    {
+      /* the zero slices are serialized as their length only, and
+       * each run of real bytes as its length and its bytes.
+       */
+      std::vector<struct Slice> slices;
+      GetSlices (slices);
+      uint32_t sz = sizeof (uint32_t);
+      uint32_t length = 0;
+      for (std::vector<struct Slice>::const_iterator i = slices.begin (); i != slices.end (); i++)
+        {
+          if (i->m_data == 0)
+            {
+              sz += sizeof (uint32_t) + ((length + 3) & (~0x3)) + sizeof (uint32_t);
+              length = 0;
+            }
+          else
+            {
+              length += i->m_length;
+            }
+        }
+      sz += sizeof (uint32_t) + ((length + 3) & (~0x3));
+      return sz;
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,10 +907,15 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_chain != 0)
+    {
+      return SerializeSlices (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
   // Add the zero data length
+  NS_ASSERT ((m_zeroAreaEnd - m_zeroAreaStart) < 0x80000000);
   if (size + 4 <= maxSize)
     {
       size += 4;
@@ -655,6 +988,10 @@ Buffer::Deserialize (const uint8_t *buffer, uint32_t size)
   NS_ASSERT (sizeCheck >= 4);
   uint32_t zeroDataLength = *p++;
   sizeCheck -= 4;
+  if (zeroDataLength & 0x80000000)
+    {
+      return DeserializeSlices (p, sizeCheck, zeroDataLength & 0x7fffffff);
+    }
 
   // Create zero bytes
   Initialize (zeroDataLength);
@@ -689,6 +1026,130 @@ Buffer::Deserialize (const uint8_t *buffer, uint32_t size)
   return (sizeCheck != 0) ? 0 : 1;
 }
 
+uint32_t
+Buffer::SerializeSlices (uint8_t* buffer, uint32_t maxSize) const
+{
+  NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (GetSerializedSize () > maxSize)
+    {
+      return 0;
+    }
+  std::vector<struct Slice> slices;
+  GetSlices (slices);
+  uint32_t zeroSlices = 0;
+  for (std::vector<struct Slice>::const_iterator i = slices.begin (); i != slices.end (); i++)
+    {
+      if (i->m_data == 0)
+        {
+          zeroSlices++;
+        }
+    }
+  uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
+
+  // Add the number of zero slices, flagged by the high bit
+  *p++ = 0x80000000 | zeroSlices;
+
+  uint32_t i = 0;
+  while (true)
+    {
+      // Add the length of the real bytes which precede the next zero
+      // slice, and the actual data
+      uint32_t length = 0;
+      for (uint32_t j = i; j < slices.size () && slices[j].m_data != 0; j++)
+        {
+          length += slices[j].m_length;
+        }
+      *p++ = length;
+      uint8_t *data = reinterpret_cast<uint8_t *> (p);
+      for (; i < slices.size () && slices[i].m_data != 0; i++)
+        {
+          memcpy (data, slices[i].m_data->m_data + slices[i].m_offset, slices[i].m_length);
+          data += slices[i].m_length;
+        }
+      p += (((length + 3) & (~3))/4); // Advance p, insuring 4 byte boundary
+      if (i == slices.size ())
+        {
+          break;
+        }
+      // Add the length of the zero slice
+      *p++ = slices[i].m_length;
+      i++;
+    }
+
+  // Serialzed everything successfully
+  return 1;
+}
+
+uint32_t
+Buffer::DeserializeSlices (const uint32_t *p, uint32_t sizeCheck, uint32_t zeroSlices)
+{
+  NS_LOG_FUNCTION (this << p << sizeCheck << zeroSlices);
+  // Check the runs of real bytes and count them
+  const uint32_t *q = p;
+  uint32_t total = 0;
+  for (uint32_t k = 0; k <= zeroSlices; k++)
+    {
+      if (sizeCheck < 4)
+        {
+          return 0;
+        }
+      uint32_t length = *q++;
+      sizeCheck -= 4;
+      if (sizeCheck < ((length + 3) & (~3)))
+        {
+          return 0;
+        }
+      total += length;
+      q += (((length + 3) & (~3))/4);
+      sizeCheck -= ((length + 3) & (~3));
+      if (k < zeroSlices)
+        {
+          if (sizeCheck < 4)
+            {
+              return 0;
+            }
+          q++;
+          sizeCheck -= 4;
+        }
+    }
+  NS_ASSERT (sizeCheck == 0);
+  if (sizeCheck != 0)
+    {
+      return 0;
+    }
+
+  // Copy the real bytes into a single BufferData, and create the zero
+  // slices between them.
+  Initialize (0);
+  Buffer bytes;
+  bytes.AddAtStart (total);
+  uint32_t offset = bytes.m_start;
+  std::vector<struct Slice> slices;
+  struct Slice slice;
+  for (uint32_t k = 0; k <= zeroSlices; k++)
+    {
+      uint32_t length = *p++;
+      if (length > 0)
+        {
+          memcpy (bytes.m_data->m_data + offset, p, length);
+          slice.m_data = bytes.m_data;
+          slice.m_offset = offset;
+          slice.m_length = length;
+          AppendSlice (slices, slice);
+          offset += length;
+        }
+      p += (((length + 3) & (~3))/4); // Advance p, insuring 4 byte boundary
+      if (k < zeroSlices)
+        {
+          slice.m_data = 0;
+          slice.m_offset = 0;
+          slice.m_length = *p++;
+          AppendSlice (slices, slice);
+        }
+    }
+  SetSlices (slices);
+  return 1;
+}
 
 void
 Buffer::TransformIntoRealBuffer (void) const
@@ -723,13 +1184,7 @@ Buffer::CopyData (std::ostream *os, uint32_t size) const
         { 
           size -= m_zeroAreaStart-m_start;
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              os->write (g_zeroes.buffer, toWrite);
-              left -= toWrite;
-            }
+          CopyChainData (m_chain, m_chainStart, os, tmpsize);
           if (size > tmpsize)
             {
               size -= tmpsize;
@@ -754,14 +1209,8 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
       if (size > 0) 
         { 
           tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              memcpy (buffer, g_zeroes.buffer, toWrite);
-              left -= toWrite;
-              buffer += toWrite;
-            }
+          CopyChainData (m_chain, m_chainStart, buffer, tmpsize);
+          buffer += tmpsize;
           size -= tmpsize;
           if (size > 0)
             {
@@ -843,27 +1292,39 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  uint8_t *to;
+  if (m_current <= m_zeroStart)
+    {
+      to = &m_data[m_current];
+    }
+  else
+    {
+      to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
+  m_current += size;
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (to, &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      if (toCopy > 0)
+        {
+          CopyChainData (start.m_chain, start.m_chainStart + (start.m_current - start.m_zeroStart),
+                         to, toCopy);
+        }
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
   memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
@@ -968,6 +1429,24 @@ Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
   m_current += size;
 }
 
+uint8_t
+Buffer::Iterator::PeekChainU8 (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t position = m_chainStart + (m_current - m_zeroStart);
+  const struct Slice *slice = &m_chain->m_slices[m_slice];
+  if (position < slice->m_position || position >= slice->m_position + slice->m_length)
+    {
+      m_slice = FindSlice (m_chain, position);
+      slice = &m_chain->m_slices[m_slice];
+    }
+  if (slice->m_data == 0)
+    {
+      return 0;
+    }
+  return slice->m_data->m_data[slice->m_offset + (position - slice->m_position)];
+}
+
 uint32_t 
 Buffer::Iterator::ReadU32 (void)
 {
@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define BUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -88,9 +86,27 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * The virtual zero area can also hold real payload bytes which are
+ * shared with other buffers rather than copied: it is then described
+ * by a chain of read-only slices, each of which is either a range of
+ * virtual zero bytes or a range of the bytes of another BufferData,
+ * which the slice holds a reference to. Appending a large Buffer to
+ * another one, and adding bytes to a large Buffer whose BufferData is
+ * shared and would otherwise have to be copied, move the real bytes
+ * of the buffers into such a chain rather than copy them, so that
+ * concatenation, fragmentation and segmentation do not depend on the
+ * size of the payload. The Buffer::Iterator reads across the slices
+ * transparently, and the bytes of the chain, as those of the virtual
+ * zero area, cannot be written to.
+ *
+ * The zero slices of 256 bytes or more are never allocated, whether
+ * the chain is compacted, copied to a stream or serialized: only the
+ * real bytes and the smaller zero slices are.
  */
 class Buffer 
 {
+  struct Chain;
 public:
   /**
    * \brief iterator in a Buffer instance
@@ -450,6 +466,11 @@ private:
      * \returns the error message
      */
     std::string GetWriteErrorMessage (void) const;
+    /**
+     * \returns the byte of the chain of slices at the current position,
+     *          which must be in the "virtual zero area".
+     */
+    uint8_t PeekChainU8 (void);
 
     /**
      * offset in virtual bytes from the start of the data buffer to the
@@ -481,6 +502,19 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * the chain of slices which holds the bytes of the "virtual zero
+     * area", or zero if they are all zeroes.
+     */
+    const struct Chain *m_chain;
+    /**
+     * offset in the chain of the first byte of the "virtual zero area".
+     */
+    uint32_t m_chainStart;
+    /**
+     * index of the slice of the chain which was read last.
+     */
+    uint32_t m_slice;
   };
 
   /**
@@ -523,7 +557,9 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer. Unless the buffers are
+   * small, their real bytes are shared rather than copied, so the
+   * cost of this method does not depend on their size.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -579,7 +615,9 @@ private:
    * This buffer's contents are serialized into the raw 
    * character buffer parameter. Note: The zero length 
    * data is not copied entirely. Only the length of 
-   * zero byte data is serialized.
+   * zero byte data is serialized, including that of
+   * the zero slices of a buffer made of several
+   * concatenated ones.
    */
   uint32_t Serialize (uint8_t* buffer, uint32_t maxSize) const;
 
@@ -684,6 +722,60 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * A read-only range of bytes of the "virtual zero area".
+   */
+  struct Slice
+  {
+    /**
+     * The BufferData which holds the bytes of the slice, or zero
+     * if they are zeroes.
+     */
+    struct Data *m_data;
+    /**
+     * offset from the start of m_data->m_data to the first byte of
+     * the slice.
+     */
+    uint32_t m_offset;
+    /**
+     * the number of bytes of the slice.
+     */
+    uint32_t m_length;
+    /**
+     * offset of the first byte of the slice from the start of the chain.
+     */
+    uint32_t m_position;
+  };
+
+  /**
+   * The immutable chain of slices which holds the bytes of the
+   * "virtual zero area". It is shared by all the Buffer instances
+   * created from the same one, and each slice holds a count of the
+   * BufferData it refers to, so that these are never written to
+   * where the slices refer to them.
+   */
+  struct Chain
+  {
+    /**
+     * The reference count of an instance of this data structure.
+     * Each buffer which references an instance holds a count.
+     */
+    uint32_t m_count;
+    /**
+     * The size of the block of PacketPool which holds the chain.
+     */
+    uint32_t m_size;
+    /**
+     * The number of slices.
+     */
+    uint32_t m_nSlices;
+    /**
+     * The slices, in order.  The array is allocated with the chain,
+     * and holds m_nSlices slices.
+     */
+    struct Slice m_slices[1];
+  };
+
   /**
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
@@ -748,7 +840,92 @@ private:
    */
   static void Deallocate (struct Buffer::Data *data);
 
+  /**
+   * \brief Append the slices of the content of this buffer to a list,
+   * merging adjacent slices.
+   * \param slices the list of slices
+   */
+  void GetSlices (std::vector<struct Slice> &slices) const;
+  /**
+   * \brief Append a slice to a list, merging it with the last one if
+   * they are adjacent.
+   * \param slices the list of slices
+   * \param slice the slice to append
+   */
+  static void AppendSlice (std::vector<struct Slice> &slices, const struct Slice &slice);
+  /**
+   * \brief Replace the content of this buffer by a chain of slices.
+   * \param slices the slices
+   */
+  void SetSlices (const std::vector<struct Slice> &slices);
+  /**
+   * \brief Copy the real bytes and the small zero slices which lie
+   * between two large zero slices into a BufferData each.  The list is
+   * left as it is if no two adjacent slices can be merged.
+   * \param slices the list of slices, replaced by the compact one
+   * \param runs the buffers which hold the copies, to keep until the
+   *        compact slices are set
+   */
+  static void CompactSlices (std::vector<struct Slice> &slices, std::vector<Buffer> &runs);
+  /**
+   * \brief Serialize a buffer which holds a chain of slices, without
+   * copying its zero slices.
+   * \param buffer points to serialization buffer
+   * \param maxSize max number of bytes to write
+   * \returns zero if buffer not large enough
+   */
+  uint32_t SerializeSlices (uint8_t* buffer, uint32_t maxSize) const;
+  /**
+   * \brief Deserialize a buffer serialized by SerializeSlices.
+   * \param p points to the first run of real bytes
+   * \param sizeCheck number of bytes left to deserialize
+   * \param zeroSlices the number of zero slices
+   * \returns zero if a complete buffer is not deserialized
+   */
+  uint32_t DeserializeSlices (const uint32_t *p, uint32_t sizeCheck, uint32_t zeroSlices);
+  /**
+   * \brief Move the real bytes of this buffer into a chain of slices,
+   * so that it can grow without copying them.
+   */
+  void MoveIntoChain (void);
+  /**
+   * \brief Release the chain of this buffer, if any.
+   */
+  void ReleaseChain (void);
+  /**
+   * \brief Copy bytes of a chain of slices
+   * \param chain the chain
+   * \param position the offset of the first byte to copy in the chain
+   * \param buffer the output buffer
+   * \param size the number of bytes to copy
+   */
+  static void CopyChainData (const struct Chain *chain, uint32_t position, uint8_t *buffer, uint32_t size);
+  /**
+   * \brief Copy bytes of a chain of slices to a stream
+   * \param chain the chain, or zero for zeroes
+   * \param position the offset of the first byte to copy in the chain
+   * \param os the output stream
+   * \param size the number of bytes to copy
+   */
+  static void CopyChainData (const struct Chain *chain, uint32_t position, std::ostream *os, uint32_t size);
+  /**
+   * \brief Find the slice of a chain which holds a byte
+   * \param chain the chain
+   * \param position the offset of the byte in the chain
+   * \returns the index of the slice
+   */
+  static uint32_t FindSlice (const struct Chain *chain, uint32_t position);
+
   struct Data *m_data; //!< the buffer data storage
+  /**
+   * the chain of slices which holds the bytes of the virtual zero
+   * area, or zero if they are all zeroes.
+   */
+  struct Chain *m_chain;
+  /**
+   * offset in the chain of the first byte of the virtual zero area.
+   */
+  uint32_t m_chainStart;
 
   /**
    * keep track of the maximum value of m_zeroAreaStart across
@@ -764,9 +941,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value.  Each thread learns its own.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -789,18 +966,6 @@ private:
    */
   uint32_t m_end;
 
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -816,7 +981,10 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_chain (0),
+    m_chainStart (0),
+    m_slice (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -838,6 +1006,9 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_chain = buffer->m_chain;
+  m_chainStart = buffer->m_chainStart;
+  m_slice = 0;
 }
 
 void 
@@ -1007,7 +1178,11 @@ Buffer::Iterator::PeekU8 (void)
     }
   else if (m_current < m_zeroEnd)
     {
-      return 0;
+      if (m_chain == 0)
+        {
+          return 0;
+        }
+      return PeekChainU8 ();
     }
   else
     {
@@ -1048,6 +1223,8 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
 
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
+    m_chain (o.m_chain),
+    m_chainStart (o.m_chainStart),
     m_maxZeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
@@ -1055,6 +1232,10 @@ Buffer::Buffer (Buffer const&o)
     m_end (o.m_end)
 {
   m_data->m_count++;
+  if (m_chain != 0)
+    {
+      m_chain->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -48,6 +48,9 @@ struct ByteTagListData;
  *   - The struct ByteTagListData structure which contains the tag byte buffer
  *     is shared and, thus, reference-counted. This data structure is unshared
  *     as-needed to emulate COW semantics.
+ *   - As long as the tags fit in INLINE_SIZE bytes, they are stored in the
+ *     ByteTagList itself rather than in a ByteTagListData, and copied with
+ *     it, so that tagging a packet with a few small tags allocates nothing.
  *
  *   - Each tag tags a unique set of bytes identified by the pair of offsets
  *     (start,end). These offsets are relative to the start of the packet
@@ -139,6 +142,15 @@ private:
     int32_t m_nextEnd;      //!< End of the next tag
   };
 
+  /**
+   * The size of the inline buffer, in bytes, which holds the tags until
+   * they no longer fit.
+   */
+  enum InlineSize_e
+  {
+    INLINE_SIZE = 48
+  };
+
   ByteTagList ();
   
   /**
@@ -250,7 +262,8 @@ private:
   int32_t m_maxEnd; //!< maximal end offset
   int32_t m_adjustment; //!< adjustment to byte tag offsets
   uint32_t m_used; //!< the number of used bytes in the buffer
-  struct ByteTagListData *m_data; //!< the ByteTagListData structure
+  struct ByteTagListData *m_data; //!< the ByteTagListData structure, or zero if the tags are inline
+  uint8_t m_inline[INLINE_SIZE]; //!< the inline buffer
 };
 
 void
@@ -21,8 +21,11 @@
 #include "ns3/config.h"
 #include "ns3/log.h"
 #include "ns3/assert.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "channel-list.h"
 #include "channel.h"
+#include "net-device.h"
+#include "node.h"
 
 namespace ns3 {
 
@@ -245,4 +248,49 @@ ChannelList::GetNChannels (void)
   return ChannelListPriv::Get ()->GetNChannels ();
 }
 
+Time
+ChannelList::GetPartitionLookahead (const MultithreadedSimulatorImpl *simulator)
+{
+  NS_LOG_FUNCTION (simulator);
+  Time lookahead = Time::Max ();
+  for (Iterator i = Begin (); i != End (); i++)
+    {
+      Ptr<Channel> channel = *i;
+      bool crosses = false;
+      uint32_t first = 0;
+      bool found = false;
+      for (uint32_t j = 0; j < channel->GetNDevices () && !crosses; j++)
+        {
+          Ptr<Node> node = channel->GetDevice (j)->GetNode ();
+          if (node == 0)
+            {
+              continue;
+            }
+          uint32_t partition = simulator->GetPartitionIndex (node->GetId ());
+          crosses = found && partition != first;
+          first = found ? first : partition;
+          found = true;
+        }
+      if (crosses)
+        {
+          NS_LOG_LOGIC ("channel " << channel->GetId () << " crosses the partitions");
+          lookahead = Min (lookahead, channel->GetLookahead ());
+        }
+    }
+  return lookahead;
+}
+
+/**
+ * \ingroup network
+ * Set the lookahead finder of MultithreadedSimulatorImpl when the
+ * network module is loaded.
+ */
+static struct ChannelListLookaheadFinder
+{
+  ChannelListLookaheadFinder ()
+  {
+    MultithreadedSimulatorImpl::SetLookaheadFinder (MakeCallback (&ChannelList::GetPartitionLookahead));
+  }
+} g_channelListLookaheadFinder; //!< The lookahead finder setter.
+
 } // namespace ns3
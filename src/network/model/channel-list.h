@@ -21,11 +21,13 @@
 
 #include <vector>
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
 class Channel;
 class CallbackBase;
+class MultithreadedSimulatorImpl;
 
 
 /**
@@ -68,6 +70,16 @@ public:
    * \returns the number of channels currently in the list.
    */
   static uint32_t GetNChannels (void);
+  /**
+   * \param simulator the simulator whose partitions are considered.
+   * \returns the minimum Channel::GetLookahead of the channels between
+   *          nodes of different partitions, or Time::Max () if there
+   *          is none.
+   *
+   * This is the LookaheadFinder of MultithreadedSimulatorImpl, which
+   * is set when the network module is loaded.
+   */
+  static Time GetPartitionLookahead (const MultithreadedSimulatorImpl *simulator);
 };
 
 } // namespace ns3
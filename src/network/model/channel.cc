@@ -62,4 +62,16 @@ Channel::GetId (void) const
   return m_id;
 }
 
+Time
+Channel::GetLookahead (void) const
+{
+  NS_LOG_FUNCTION (this);
+  TimeValue delay;
+  if (GetAttributeFailSafe ("Delay", delay))
+    {
+      return delay.Get ();
+    }
+  return Seconds (0);
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -74,6 +75,17 @@ public:
    */
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const = 0;
 
+  /**
+   * \returns the minimum delay between a transmission on this Channel
+   * and its effect on the other NetDevices connected to it.
+   *
+   * This is the lookahead this Channel allows between the partitions
+   * of a MultithreadedSimulatorImpl.  The default implementation
+   * returns the "Delay" attribute of the Channel, or zero if it has
+   * none.
+   */
+  virtual Time GetLookahead (void) const;
+
 private:
   uint32_t m_id; //!< Channel id for this channel
 };
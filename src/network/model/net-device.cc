@@ -25,6 +25,7 @@
 #include "ns3/queue-limits.h"
 #include "net-device.h"
 #include "packet.h"
+#include "packet-pool.h"
 
 namespace ns3 {
 
@@ -41,6 +42,19 @@ QueueItem::~QueueItem()
   m_packet = 0;
 }
 
+void *
+QueueItem::operator new (size_t size)
+{
+  uint32_t blockSize = size;
+  return PacketPool::Allocate (PacketPool::QUEUE_ITEM, blockSize);
+}
+
+void
+QueueItem::operator delete (void *p, size_t size)
+{
+  PacketPool::Release (PacketPool::QUEUE_ITEM, p, size);
+}
+
 Ptr<Packet>
 QueueItem::GetPacket (void) const
 {
@@ -64,6 +64,19 @@ public:
 
   virtual ~QueueItem ();
 
+  /**
+   * \brief Allocate a queue item from the PacketPool.
+   * \param size the size of the queue item
+   * \returns the memory of the queue item
+   */
+  static void *operator new (size_t size);
+  /**
+   * \brief Release a queue item to the PacketPool.
+   * \param p the memory of the queue item
+   * \param size the size of the queue item
+   */
+  static void operator delete (void *p, size_t size);
+
   /**
    * \return the packet included in this item.
    */
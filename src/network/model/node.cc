@@ -28,8 +28,10 @@
 #include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include "ns3/assert.h"
+#include "ns3/abort.h"
 #include "ns3/global-value.h"
 #include "ns3/boolean.h"
+#include "ns3/memory-accounting.h"
 #include "ns3/simulator.h"
 
 namespace ns3 {
@@ -96,6 +98,7 @@ Node::Construct (void)
 {
   NS_LOG_FUNCTION (this);
   m_id = NodeList::Add (this);
+  MemoryAccounting::NotifyContext (this, m_id);
 }
 
 Node::~Node ()
@@ -130,6 +133,7 @@ Node::AddDevice (Ptr<NetDevice> device)
   NS_LOG_FUNCTION (this << device);
   uint32_t index = m_devices.size ();
   m_devices.push_back (device);
+  MemoryAccounting::NotifyContext (PeekPointer (device), m_id);
   device->SetNode (this);
   device->SetIfIndex (index);
   device->SetReceiveCallback (MakeCallback (&Node::NonPromiscReceiveFromDevice, this));
@@ -159,6 +163,7 @@ Node::AddApplication (Ptr<Application> application)
   NS_LOG_FUNCTION (this << application);
   uint32_t index = m_applications.size ();
   m_applications.push_back (application);
+  MemoryAccounting::NotifyContext (PeekPointer (application), m_id);
   application->SetNode (this);
   Simulator::ScheduleWithContext (GetId (), Seconds (0.0), 
                                   &Application::Initialize, application);
@@ -223,6 +228,53 @@ Node::DoInitialize (void)
   Object::DoInitialize ();
 }
 
+void
+Node::DoSerialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  Object::DoSerialize (os);
+  os << m_applications.size () << std::endl;
+  for (std::vector<Ptr<Application> >::const_iterator i = m_applications.begin ();
+       i != m_applications.end (); i++)
+    {
+      (*i)->Serialize (os);
+    }
+}
+
+void
+Node::DoDeserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+  Object::DoDeserialize (is);
+  uint32_t n = 0;
+  is >> n;
+  NS_ABORT_MSG_UNLESS (is && n == m_applications.size (),
+                       "Node::DoDeserialize(): saved " << n << " applications, "
+                       << m_applications.size () << " installed");
+  for (std::vector<Ptr<Application> >::iterator i = m_applications.begin ();
+       i != m_applications.end (); i++)
+    {
+      (*i)->Deserialize (is);
+    }
+}
+
+void
+Node::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (MemoryAccounting::IsEnabled ())
+    {
+      // the Objects aggregated to the node, such as the protocol
+      // stacks, are usually created at setup, without context.
+      Object::AggregateIterator iterator = GetAggregateIterator ();
+      while (iterator.HasNext ())
+        {
+          MemoryAccounting::NotifyContext (PeekPointer (iterator.Next ()), m_id);
+        }
+    }
+  Object::NotifyNewAggregate ();
+}
+
 void
 Node::RegisterProtocolHandler (ProtocolHandler handler, 
                                uint16_t protocolType,
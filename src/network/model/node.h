@@ -218,6 +218,22 @@ protected:
    */
   virtual void DoDispose (void);
   virtual void DoInitialize (void);
+  virtual void NotifyNewAggregate (void);
+  /**
+   * Save the state of the applications of this node.
+   *
+   * \param [in,out] os The output stream.
+   * \sa Checkpoint
+   */
+  virtual void DoSerialize (std::ostream &os) const;
+  /**
+   * Restore the state of the applications of this node, which must be
+   * installed in the same order as when it was saved.
+   *
+   * \param [in,out] is The input stream.
+   * \sa Checkpoint
+   */
+  virtual void DoDeserialize (std::istream &is);
 private:
 
   /**
@@ -19,10 +19,14 @@
  */
 #include <utility>
 #include <list>
+#include <algorithm>
+#include <mutex>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/memory-accounting.h"
 #include "packet-metadata.h"
+#include "packet-pool.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -33,20 +37,23 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
-bool PacketMetadata::m_metadataSkipped = false;
-uint32_t PacketMetadata::m_maxSize = 0;
-uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+std::atomic<bool> PacketMetadata::m_metadataSkipped (false);
+std::atomic<uint16_t> PacketMetadata::m_chunkUid (0);
+struct PacketMetadata::Node *PacketMetadata::m_blocks[PacketMetadata::MAX_BLOCKS];
+uint32_t PacketMetadata::m_nBlocks = 0;
+uint32_t PacketMetadata::m_sharedFreeNodes = PacketMetadata::NONE;
+uint32_t PacketMetadata::m_sharedUsedNodes = 0;
+struct PacketMetadata::ArenaDestructor PacketMetadata::m_arenaDestructor;
+thread_local uint32_t PacketMetadata::m_freeNodes = PacketMetadata::NONE;
+thread_local uint32_t PacketMetadata::m_usedNodes = 0;
+thread_local struct PacketMetadata::ThreadArena PacketMetadata::m_threadArena;
 
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
+namespace {
+
+/** Protects the blocks and the shared nodes of the arena. */
+std::mutex g_arenaMutex;
+
+} // anonymous namespace
 
 void 
 PacketMetadata::Enable (void)
@@ -70,577 +77,293 @@ PacketMetadata::EnableChecking (void)
   m_enableChecking = true;
 }
 
-void
-PacketMetadata::ReserveCopy (uint32_t size)
-{
-  NS_LOG_FUNCTION (this << size);
-  struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
-  memcpy (newData->m_data, m_data->m_data, m_used);
-  newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
-    {
-      PacketMetadata::Recycle (m_data);
-    }
-  m_data = newData;
-  if (m_head != 0xffff)
-    {
-      uint8_t *start;
-      NS_ASSERT (m_tail != 0xffff);
-      // clear the next field of the tail
-      start = &m_data->m_data[m_tail];
-      Append16 (0xffff, start);
-      // clear the prev field of the head
-      start = &m_data->m_data[m_head] + 2;
-      Append16 (0xffff, start);
-    }
-}
-void
-PacketMetadata::Reserve (uint32_t size)
-{
-  NS_LOG_FUNCTION (this << size);
-  NS_ASSERT (m_data != 0);
-  if (m_data->m_size >= m_used + size &&
-      (m_head == 0xffff ||
-       m_data->m_count == 1 ||
-       m_data->m_dirtyEnd == m_used))
-    {
-      /* enough room, not dirty. */
-    }
-  else 
-    {
-      /* (enough room and dirty) or (not enough room) */
-      ReserveCopy (size);
-    }
-}
-
-bool
-PacketMetadata::IsSharedPointerOk (uint16_t pointer) const
-{
-  NS_LOG_FUNCTION (this << pointer);
-  bool ok = pointer == 0xffff || pointer <= m_data->m_size;
-  return ok;
-}
-bool
-PacketMetadata::IsPointerOk (uint16_t pointer) const
+uint32_t
+PacketMetadata::GetUsedNodes (void)
 {
-  NS_LOG_FUNCTION (this << pointer);
-  bool ok = pointer == 0xffff || pointer <= m_used;
-  return ok;
+  NS_LOG_FUNCTION_NOARGS ();
+  return m_usedNodes;
 }
 
-bool
-PacketMetadata::IsStateOk (void) const
+PacketMetadata::ThreadArena::~ThreadArena ()
 {
   NS_LOG_FUNCTION (this);
-  bool ok = m_used <= m_data->m_size;
-  ok &= IsPointerOk (m_head);
-  ok &= IsPointerOk (m_tail);
-  uint16_t current = m_head;
-  while (ok && current != 0xffff)
+  std::lock_guard<std::mutex> lock (g_arenaMutex);
+  if (m_freeNodes != NONE)
     {
-      struct PacketMetadata::SmallItem item;
-      PacketMetadata::ExtraItem extraItem;
-      ReadItems (current, &item, &extraItem);
-      ok &= IsSharedPointerOk (item.next);
-      ok &= IsSharedPointerOk (item.prev);
-      if (current != m_head)
+      uint32_t last = m_freeNodes;
+      while (GetNode (last)->next != NONE)
         {
-          ok &= IsPointerOk (item.prev);
+          last = GetNode (last)->next;
         }
-      if (current != m_tail)
-        {
-          ok &= IsPointerOk (item.next);
-        }
-      if (current == m_tail)
-        {
-          break;
-        }
-      current = item.next;
+      GetNode (last)->next = m_sharedFreeNodes;
+      m_sharedFreeNodes = m_freeNodes;
+      m_freeNodes = NONE;
     }
-  return ok;
+  m_sharedUsedNodes += m_usedNodes;
+  m_usedNodes = 0;
 }
 
-uint32_t 
-PacketMetadata::GetUleb128Size (uint32_t value) const
+PacketMetadata::ArenaDestructor::~ArenaDestructor ()
 {
-  NS_LOG_FUNCTION (this << value);
-  if (value < 0x80)
-    {
-      return 1;
-    }
-  if (value < 0x4000)
-    {
-      return 2;
-    }
-  if (value < 0x200000)
+  NS_LOG_FUNCTION (this);
+  // The threads, the main one included, have exited.
+  if (m_sharedUsedNodes != 0)
     {
-      return 3;
+      // some packets outlive this destructor: keep their nodes.
+      return;
     }
-  if (value < 0x10000000)
+  for (uint32_t i = 0; i < m_nBlocks; i++)
     {
-      return 4;
+      MemoryAccounting::NotifyRelease (m_blocks[i]);
+      PacketPool::Release (PacketPool::METADATA, m_blocks[i], NODES_PER_BLOCK * sizeof (struct Node));
+      m_blocks[i] = 0;
     }
-  return 5;
+  m_nBlocks = 0;
+  m_sharedFreeNodes = NONE;
 }
-uint32_t
-PacketMetadata::ReadUleb128 (const uint8_t **pBuffer) const
+
+void
+PacketMetadata::AllocateNodes (void)
 {
-  NS_LOG_FUNCTION (this << &pBuffer);
-  const uint8_t *buffer = *pBuffer;
-  uint32_t result = 0;
-  uint8_t byte;
-  result = 0;
-  byte = buffer[0];
-  result = (byte & (~0x80));
-  if (!(byte & 0x80))
-    {
-      *pBuffer = buffer + 1;
-      return result;
-    }
-  byte = buffer[1];
-  result |= (byte & (~0x80)) << 7;
-  if (!(byte & 0x80))
+  NS_LOG_FUNCTION_NOARGS ();
+  // construct the handover of the free nodes of this thread.
+  (void) &m_threadArena;
+  std::lock_guard<std::mutex> lock (g_arenaMutex);
+  if (m_sharedFreeNodes != NONE)
     {
-      *pBuffer = buffer + 2;
-      return result;
+      m_freeNodes = m_sharedFreeNodes;
+      m_sharedFreeNodes = NONE;
+      return;
     }
-  byte = buffer[2];
-  result |= (byte & (~0x80)) << 14;
-  if (!(byte & 0x80))
+  NS_ASSERT (m_nBlocks < MAX_BLOCKS);
+  uint32_t size = NODES_PER_BLOCK * sizeof (struct Node);
+  struct Node *block = static_cast<struct Node *> (PacketPool::Allocate (PacketPool::METADATA, size));
+  if (MemoryAccounting::IsEnabled ())
     {
-      *pBuffer = buffer + 3;
-      return result;
+      static uint32_t category = MemoryAccounting::GetCategory ("ns3::PacketMetadata");
+      MemoryAccounting::NotifyAllocate (block, category, size);
     }
-  byte = buffer[3];
-  result |= (byte & (~0x80)) << 21;
-  if (!(byte & 0x80))
+  uint32_t first = m_nBlocks * NODES_PER_BLOCK;
+  for (uint32_t i = 0; i < NODES_PER_BLOCK; i++)
     {
-      *pBuffer = buffer + 4;
-      return result;
+      block[i].next = (i + 1 < NODES_PER_BLOCK) ? first + i + 1 : NONE;
+      block[i].count = 0;
     }
-  byte = buffer[4];
-  result |= (byte & (~0x80)) << 28;
-  if (!(byte & 0x80))
+  // The other threads only see the indexes of this block once they
+  // are handed over to them, after this.
+  m_blocks[m_nBlocks] = block;
+  m_nBlocks++;
+  m_freeNodes = first;
+}
+
+uint32_t
+PacketMetadata::AllocateNode (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_freeNodes == NONE)
     {
-      *pBuffer = buffer + 5;
-      return result;
+      AllocateNodes ();
     }
-  /* This means that the LEB128 number was not valid.
-   * ie: the last (5th) byte did not have the high-order bit zeroed.
-   */
-  NS_ASSERT (false);
-  return 0;
+  uint32_t index = m_freeNodes;
+  m_freeNodes = GetNode (index)->next;
+  m_usedNodes++;
+  return index;
 }
 
 void
-PacketMetadata::Append16 (uint16_t value, uint8_t *buffer)
+PacketMetadata::Release (uint32_t index)
 {
-  NS_LOG_FUNCTION (this << value << &buffer);
-  buffer[0] = value & 0xff;
-  value >>= 8;
-  buffer[1] = value;
+  NS_LOG_FUNCTION (index);
+  while (index != NONE)
+    {
+      struct Node *node = GetNode (index);
+      NS_ASSERT (node->count == 0);
+      uint32_t next = node->next;
+      if (m_freeNodes == NONE)
+        {
+          // construct the handover of the free nodes of this thread.
+          (void) &m_threadArena;
+        }
+      node->next = m_freeNodes;
+      m_freeNodes = index;
+      m_usedNodes--;
+      // release the rest of the chain, up to a node still referenced.
+      index = NONE;
+      if (next != NONE)
+        {
+          struct Node *nextNode = GetNode (next);
+          NS_ASSERT (nextNode->count > 0);
+          nextNode->count--;
+          if (nextNode->count == 0)
+            {
+              index = next;
+            }
+        }
+    }
 }
+
 void
-PacketMetadata::Append32 (uint32_t value,  uint8_t *buffer)
+PacketMetadata::PushFront (const struct PacketMetadata::Node &item)
 {
-  NS_LOG_FUNCTION (this << value << &buffer);
-  buffer[0] = value & 0xff;
-  buffer[1] = (value >> 8) & 0xff;
-  buffer[2] = (value >> 16) & 0xff;
-  buffer[3] = (value >> 24) & 0xff;
+  NS_LOG_FUNCTION (this << item.typeUid << item.size << item.chunkUid);
+  uint32_t index = AllocateNode ();
+  struct Node *node = GetNode (index);
+  *node = item;
+  // the new node takes over the reference of this packet to m_front.
+  node->next = m_front;
+  node->count = 1;
+  m_front = index;
 }
 
 void
-PacketMetadata::AppendValueExtra (uint32_t value, uint8_t *buffer)
+PacketMetadata::PushBack (const struct PacketMetadata::Node &item)
 {
-  NS_LOG_FUNCTION (this << value << &buffer);
-  if (value < 0x200000)
-    {
-      uint8_t byte = value & (~0x80);
-      buffer[0] = 0x80 | byte;
-      value >>= 7;
-      byte = value & (~0x80);
-      buffer[1] = 0x80 | byte;
-      value >>= 7;
-      byte = value & (~0x80);
-      buffer[2] = value;
-      return;
-    }
-  if (value < 0x10000000)
-    {
-      uint8_t byte = value & (~0x80);
-      buffer[0] = 0x80 | byte;
-      value >>= 7;
-      byte = value & (~0x80);
-      buffer[1] = 0x80 | byte;
-      value >>= 7;
-      byte = value & (~0x80);
-      buffer[2] = 0x80 | byte;
-      value >>= 7;
-      buffer[3] = value;
-      return;
-    }
-  {
-    uint8_t byte = value & (~0x80);
-    buffer[0] = 0x80 | byte;
-    value >>= 7;
-    byte = value & (~0x80);
-    buffer[1] = 0x80 | byte;
-    value >>= 7;
-    byte = value & (~0x80);
-    buffer[2] = 0x80 | byte;
-    value >>= 7;
-    byte = value & (~0x80);
-    buffer[3] = 0x80 | byte;
-    value >>= 7;
-    buffer[4] = value;
-  }
+  NS_LOG_FUNCTION (this << item.typeUid << item.size << item.chunkUid);
+  uint32_t index = AllocateNode ();
+  struct Node *node = GetNode (index);
+  *node = item;
+  node->next = m_back;
+  node->count = 1;
+  m_back = index;
 }
 
 void
-PacketMetadata::AppendValue (uint32_t value, uint8_t *buffer)
+PacketMetadata::PopFront (void)
 {
-  NS_LOG_FUNCTION (this << value << &buffer);
-  if (value < 0x80)
-    {
-      buffer[0] = value;
-      return;
-    }
-  if (value < 0x4000)
-    {
-      uint8_t byte = value & (~0x80);
-      buffer[0] = 0x80 | byte;
-      value >>= 7;
-      buffer[1] = value;
-      return;
-    }
-  AppendValueExtra (value, buffer);
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_front != NONE);
+  uint32_t index = m_front;
+  m_front = GetNode (index)->next;
+  Ref (m_front);
+  Unref (index);
 }
 
 void
-PacketMetadata::UpdateTail (uint16_t written)
+PacketMetadata::PopBack (void)
 {
-  NS_LOG_FUNCTION (this << written);
-  if (m_head == 0xffff)
-    {
-      NS_ASSERT (m_tail == 0xffff);
-      m_head = m_used;
-      m_tail = m_used;
-    } 
-  else
-    {
-      NS_ASSERT (m_tail != 0xffff);
-      // overwrite the next field of the previous tail of the list.
-      uint8_t *previousTail = &m_data->m_data[m_tail];
-      Append16 (m_used, previousTail);
-      // update the tail of the list to the new node.
-      m_tail = m_used;
-    }
-  NS_ASSERT (m_tail != 0xffff);
-  NS_ASSERT (m_head != 0xffff);
-  NS_ASSERT (written >= 8);
-  m_used += written;
-  m_data->m_dirtyEnd = m_used;
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_back != NONE);
+  uint32_t index = m_back;
+  m_back = GetNode (index)->next;
+  Ref (m_back);
+  Unref (index);
 }
 
-
-void
-PacketMetadata::UpdateHead (uint16_t written)
+uint32_t
+PacketMetadata::GetFront (void)
 {
-  NS_LOG_FUNCTION (this << written);
-  if (m_head == 0xffff)
-    {
-      NS_ASSERT (m_tail == 0xffff);
-      m_head = m_used;
-      m_tail = m_used;
-    } 
-  else
+  NS_LOG_FUNCTION (this);
+  if (m_front == NONE && m_back != NONE)
     {
-      NS_ASSERT (m_head != 0xffff);
-      // overwrite the prev field of the previous head of the list.
-      uint8_t *previousHead = &m_data->m_data[m_head + 2];
-      Append16 (m_used, previousHead);
-      // update the head of list to the new node.
-      m_head = m_used;
+      Balance (true);
     }
-  NS_ASSERT (m_tail != 0xffff);
-  NS_ASSERT (m_head != 0xffff);
-  NS_ASSERT (written >= 8);
-  m_used += written;
-  m_data->m_dirtyEnd = m_used;
+  return m_front;
 }
 
-uint16_t
-PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
+uint32_t
+PacketMetadata::GetBack (void)
 {
-  NS_LOG_FUNCTION (this << item->next << item->prev << item->typeUid << item->size << item->chunkUid);
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_used != item->prev && m_used != item->next);
-  uint32_t typeUidSize = GetUleb128Size (item->typeUid);
-  uint32_t sizeSize = GetUleb128Size (item->size);
-  uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  NS_LOG_FUNCTION (this);
+  if (m_back == NONE && m_front != NONE)
     {
-      ReserveCopy (n);
+      Balance (false);
     }
-  uint8_t *buffer = &m_data->m_data[m_used];
-  Append16 (item->next, buffer);
-  buffer += 2;
-  Append16 (item->prev, buffer);
-  buffer += 2;
-  AppendValue (item->typeUid, buffer);
-  buffer += typeUidSize;
-  AppendValue (item->size, buffer);
-  buffer += sizeSize;
-  Append16 (item->chunkUid, buffer);
-  return n;
+  return m_back;
 }
 
-uint16_t
-PacketMetadata::AddBig (uint32_t next, uint32_t prev, 
-                        const PacketMetadata::SmallItem *item,
-                        const PacketMetadata::ExtraItem *extraItem)
+void
+PacketMetadata::Balance (bool front)
 {
-  NS_LOG_FUNCTION (this << next << prev <<
-                   item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
-                   extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid);
-  NS_ASSERT (m_data != 0);
-  uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
-  NS_ASSERT (m_used != prev && m_used != next);
-
-  uint32_t typeUidSize = GetUleb128Size (typeUid);
-  uint32_t sizeSize = GetUleb128Size (item->size);
-  uint32_t fragStartSize = GetUleb128Size (extraItem->fragmentStart);
-  uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
-  uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
+  NS_LOG_FUNCTION (this << front);
+  std::vector<uint32_t> items;
+  GetItems (items);
+  uint32_t n = items.size ();
+  // the empty chain gets half of the items, and at least one.
+  uint32_t split = front ? (n + 1) / 2 : n / 2;
+  uint32_t oldFront = m_front;
+  uint32_t oldBack = m_back;
+  m_front = NONE;
+  m_back = NONE;
+  for (uint32_t i = split; i > 0; i--)
+    {
+      PushFront (*GetNode (items[i - 1]));
+    }
+  for (uint32_t i = split; i < n; i++)
+    {
+      PushBack (*GetNode (items[i]));
+    }
+  Unref (oldFront);
+  Unref (oldBack);
+}
 
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+PacketMetadata
+PacketMetadata::CreateFullCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketMetadata copy (m_packetUid, 0);
+  std::vector<uint32_t> items;
+  GetItems (items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); i++)
     {
-      ReserveCopy (n);
+      copy.PushBack (*GetNode (*i));
     }
-
-  uint8_t *buffer = &m_data->m_data[m_used];
-
-  Append16 (next, buffer);
-  buffer += 2;
-  Append16 (prev, buffer);
-  buffer += 2;
-  AppendValue (typeUid, buffer);
-  buffer += typeUidSize;
-  AppendValue (item->size, buffer);
-  buffer += sizeSize;
-  Append16 (item->chunkUid, buffer);
-  buffer += 2;
-  AppendValue (extraItem->fragmentStart, buffer);
-  buffer += fragStartSize;
-  AppendValue (extraItem->fragmentEnd, buffer);
-  buffer += fragEndSize;
-  Append32 (extraItem->packetUid, buffer);
-
-  return n;
+  return copy;
 }
 
 void
-PacketMetadata::ReplaceTail (PacketMetadata::SmallItem *item, 
-                             PacketMetadata::ExtraItem *extraItem,
-                             uint32_t available)
+PacketMetadata::GetItems (std::vector<uint32_t> &items) const
 {
-  NS_LOG_FUNCTION (this <<
-                   item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
-                   extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid <<
-                   available);
-
-  NS_ASSERT (m_data != 0);
-  /* If the tail we want to replace is located at the end of the data array,
-   * and if there is extra room at the end of this array, then, 
-   * we can try to use that extra space to avoid falling in the slow
-   * path below.
-   */
-  if (m_tail + available == m_used &&
-      m_used == m_data->m_dirtyEnd)
+  NS_LOG_FUNCTION (this << &items);
+  for (uint32_t current = m_front; current != NONE; current = GetNode (current)->next)
     {
-      available = m_data->m_size - m_tail;
+      items.push_back (current);
     }
-
-  uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
-  uint32_t typeUidSize = GetUleb128Size (typeUid);
-  uint32_t sizeSize = GetUleb128Size (item->size);
-  uint32_t fragStartSize = GetUleb128Size (extraItem->fragmentStart);
-  uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
-  uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
-
-  if (available >= n &&
-      m_data->m_count == 1)
-    {
-      uint8_t *buffer = &m_data->m_data[m_tail];
-      Append16 (item->next, buffer);
-      buffer += 2;
-      Append16 (item->prev, buffer);
-      buffer += 2;
-      AppendValue (typeUid, buffer);
-      buffer += typeUidSize;
-      AppendValue (item->size, buffer);
-      buffer += sizeSize;
-      Append16 (item->chunkUid, buffer);
-      buffer += 2;
-      AppendValue (extraItem->fragmentStart, buffer);
-      buffer += fragStartSize;
-      AppendValue (extraItem->fragmentEnd, buffer);
-      buffer += fragEndSize;
-      Append32 (extraItem->packetUid, buffer);
-      m_used = std::max (m_used, (uint16_t)(buffer - &m_data->m_data[0]));
-      m_data->m_dirtyEnd = m_used;
-      return;
-    }
-
-  /* Below is the slow path which is hit if the new tail we want 
-   * to append is bigger than the previous tail.
-   */
-
-  // create a copy of the packet without its tail.
-  PacketMetadata h (m_packetUid, 0);
-  uint16_t current = m_head;
-  while (current != 0xffff && current != m_tail)
+  uint32_t middle = items.size ();
+  for (uint32_t current = m_back; current != NONE; current = GetNode (current)->next)
     {
-      struct PacketMetadata::SmallItem tmpItem;
-      PacketMetadata::ExtraItem tmpExtraItem;
-      ReadItems (current, &tmpItem, &tmpExtraItem);
-      uint16_t written = h.AddBig (0xffff, h.m_tail, 
-                                   &tmpItem, &tmpExtraItem);
-      h.UpdateTail (written);
-      current = tmpItem.next;
+      items.push_back (current);
     }
-  // append new tail.
-  uint16_t written = h.AddBig (0xffff, h.m_tail, item, extraItem);
-  h.UpdateTail (written);
-
-  *this = h;
+  std::reverse (items.begin () + middle, items.end ());
 }
 
-
-uint32_t
-PacketMetadata::ReadItems (uint16_t current, 
-                           struct PacketMetadata::SmallItem *item,
-                           struct PacketMetadata::ExtraItem *extraItem) const
+uint64_t
+PacketMetadata::GetPacketUid (const struct PacketMetadata::Node &item) const
 {
-  NS_LOG_FUNCTION (this << current << item->chunkUid << item->prev << item->next << item->size <<
-                        item->typeUid << extraItem->fragmentEnd << extraItem->fragmentStart <<
-                        extraItem->packetUid);
-  NS_ASSERT (current <= m_data->m_size);
-  const uint8_t *buffer = &m_data->m_data[current];
-  item->next = buffer[0];
-  item->next |= (buffer[1]) << 8;
-  item->prev = buffer[2];
-  item->prev |= (buffer[3]) << 8;
-  buffer += 4;
-  item->typeUid = ReadUleb128 (&buffer);
-  item->size = ReadUleb128 (&buffer);
-  item->chunkUid = buffer[0];
-  item->chunkUid |= (buffer[1]) << 8;
-  buffer += 2;
-
-  bool isExtra = (item->typeUid & 0x1) == 0x1;
-  if (isExtra)
-    {
-      extraItem->fragmentStart = ReadUleb128 (&buffer);
-      extraItem->fragmentEnd = ReadUleb128 (&buffer);
-      extraItem->packetUid = buffer[0];
-      extraItem->packetUid |= buffer[1] << 8;
-      extraItem->packetUid |= buffer[2] << 16;
-      extraItem->packetUid |= buffer[3] << 24;
-      buffer += 4;
-    }
-  else
+  NS_LOG_FUNCTION (this << item.typeUid);
+  if ((item.typeUid & 0x1) == 0x1)
     {
-      extraItem->fragmentStart = 0;
-      extraItem->fragmentEnd = item->size;
-      extraItem->packetUid = m_packetUid;
+      return item.packetUid;
     }
-  NS_ASSERT (buffer <= &m_data->m_data[m_data->m_size]);
-  return buffer - &m_data->m_data[current];
+  return m_packetUid;
 }
 
-struct PacketMetadata::Data *
-PacketMetadata::Create (uint32_t size)
+struct PacketMetadata::Node
+PacketMetadata::MakeBig (struct PacketMetadata::Node item, uint64_t packetUid)
 {
-  NS_LOG_FUNCTION (size);
-  NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
-  if (size > m_maxSize)
-    {
-      m_maxSize = size;
-    }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
-  return PacketMetadata::Allocate (m_maxSize);
+  NS_LOG_FUNCTION (item.typeUid << packetUid);
+  item.typeUid |= 0x1;
+  item.packetUid = packetUid;
+  return item;
 }
 
-void
-PacketMetadata::Recycle (struct PacketMetadata::Data *data)
+bool
+PacketMetadata::IsStateOk (void) const
 {
-  NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
-  NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
+  NS_LOG_FUNCTION (this);
+  bool ok = true;
+  if (m_front != NONE)
     {
-      m_freeList.push_back (data);
+      ok &= m_front / NODES_PER_BLOCK < MAX_BLOCKS && m_blocks[m_front / NODES_PER_BLOCK] != 0;
+      ok &= ok && GetNode (m_front)->count > 0;
     }
-}
-
-struct PacketMetadata::Data *
-PacketMetadata::Allocate (uint32_t n)
-{
-  NS_LOG_FUNCTION (n);
-  uint32_t size = sizeof (struct Data);
-  if (n <= PACKET_METADATA_DATA_M_DATA_SIZE)
+  if (m_back != NONE)
     {
-      n = PACKET_METADATA_DATA_M_DATA_SIZE;
+      ok &= m_back / NODES_PER_BLOCK < MAX_BLOCKS && m_blocks[m_back / NODES_PER_BLOCK] != 0;
+      ok &= ok && GetNode (m_back)->count > 0;
     }
-  size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
-  struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
-  data->m_count = 1;
-  data->m_dirtyEnd = 0;
-  return data;
-}
-void 
-PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
-{
-  NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  return ok;
 }
 
-
 PacketMetadata 
 PacketMetadata::CreateFragment (uint32_t start, uint32_t end) const
 {
@@ -670,15 +393,14 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       return;
     }
 
-  struct PacketMetadata::SmallItem item;
-  item.next = m_head;
-  item.prev = 0xffff;
+  struct PacketMetadata::Node item;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
-  uint16_t written = AddSmall (&item);
-  UpdateHead (written);
+  item.fragmentStart = 0;
+  item.fragmentEnd = size;
+  item.packetUid = 0;
+  item.chunkUid = m_chunkUid.fetch_add (1, std::memory_order_relaxed);
+  PushFront (item);
 }
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
@@ -691,11 +413,10 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-  struct PacketMetadata::SmallItem item;
-  struct PacketMetadata::ExtraItem extraItem;
-  uint32_t read = ReadItems (m_head, &item, &extraItem);
-  if ((item.typeUid & 0xfffffffe) != uid ||
-      item.size != size)
+  uint32_t front = GetFront ();
+  if (front == NONE ||
+      (GetNode (front)->typeUid & 0xfffffffe) != uid ||
+      GetNode (front)->size != size)
     {
       if (m_enableChecking)
         {
@@ -703,9 +424,10 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
         }
       return;
     }
-  else if (item.typeUid != uid &&
-           (extraItem.fragmentStart != 0 ||
-            extraItem.fragmentEnd != size))
+  const struct Node *item = GetNode (front);
+  if (item->typeUid != uid &&
+      (item->fragmentStart != 0 ||
+       item->fragmentEnd != size))
     {
       if (m_enableChecking)
         {
@@ -713,19 +435,7 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
         }
       return;
     }
-  if (m_head + read == m_used)
-    {
-      m_used = m_head;
-    }
-  if (m_head == m_tail)
-    {
-      m_head = 0xffff;
-      m_tail = 0xffff;
-    }
-  else
-    {
-      m_head = item.next;
-    }
+  PopFront ();
   NS_ASSERT (IsStateOk ());
 }
 void 
@@ -739,15 +449,14 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-  struct PacketMetadata::SmallItem item;
-  item.next = 0xffff;
-  item.prev = m_tail;
+  struct PacketMetadata::Node item;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
-  uint16_t written = AddSmall (&item);
-  UpdateTail (written);
+  item.fragmentStart = 0;
+  item.fragmentEnd = size;
+  item.packetUid = 0;
+  item.chunkUid = m_chunkUid.fetch_add (1, std::memory_order_relaxed);
+  PushBack (item);
   NS_ASSERT (IsStateOk ());
 }
 void 
@@ -761,11 +470,10 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
-  struct PacketMetadata::SmallItem item;
-  struct PacketMetadata::ExtraItem extraItem;
-  uint32_t read = ReadItems (m_tail, &item, &extraItem);
-  if ((item.typeUid & 0xfffffffe) != uid ||
-      item.size != size)
+  uint32_t back = GetBack ();
+  if (back == NONE ||
+      (GetNode (back)->typeUid & 0xfffffffe) != uid ||
+      GetNode (back)->size != size)
     {
       if (m_enableChecking)
         {
@@ -773,9 +481,10 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
         }
       return;
     }
-  else if (item.typeUid != uid &&
-           (extraItem.fragmentStart != 0 ||
-            extraItem.fragmentEnd != size))
+  const struct Node *item = GetNode (back);
+  if (item->typeUid != uid &&
+      (item->fragmentStart != 0 ||
+       item->fragmentEnd != size))
     {
       if (m_enableChecking)
         {
@@ -783,19 +492,7 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
         }
       return;
     }
-  if (m_tail + read == m_used)
-    {
-      m_used = m_tail;
-    }
-  if (m_head == m_tail)
-    {
-      m_head = 0xffff;
-      m_tail = 0xffff;
-    }
-  else
-    {
-      m_tail = item.prev;
-    }
+  PopBack ();
   NS_ASSERT (IsStateOk ());
 }
 void
@@ -808,7 +505,7 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
-  if (m_tail == 0xffff)
+  if (m_front == NONE && m_back == NONE)
     {
       // We have no items so 'AddAtEnd' is 
       // equivalent to self-assignment.
@@ -816,63 +513,45 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       NS_ASSERT (IsStateOk ());
       return;
     }
-  if (o.m_head == 0xffff)
+  if (o.m_front == NONE && o.m_back == NONE)
     {
-      NS_ASSERT (o.m_tail == 0xffff);
       // we have nothing to append.
       return;
     }
-  NS_ASSERT (m_head != 0xffff && m_tail != 0xffff);
+  // hold the items to append, in case o is this packet.
+  PacketMetadata other = o;
+  std::vector<uint32_t> items;
+  other.GetItems (items);
 
   // We read the current tail because we are going to append
   // after this item.
-  struct PacketMetadata::SmallItem tailItem;
-  PacketMetadata::ExtraItem tailExtraItem;
-  uint32_t tailSize = ReadItems (m_tail, &tailItem, &tailExtraItem);
-
-  uint16_t current;
-  struct PacketMetadata::SmallItem item;
-  PacketMetadata::ExtraItem extraItem;
-  o.ReadItems (o.m_head, &item, &extraItem);
-  if (extraItem.packetUid == tailExtraItem.packetUid &&
-      item.typeUid == tailItem.typeUid &&
-      item.chunkUid == tailItem.chunkUid &&
-      item.size == tailItem.size &&
-      extraItem.fragmentStart == tailExtraItem.fragmentEnd)
+  struct PacketMetadata::Node tail = *GetNode (GetBack ());
+  const struct PacketMetadata::Node *item = GetNode (items[0]);
+  uint32_t i = 0;
+  if (other.GetPacketUid (*item) == GetPacketUid (tail) &&
+      item->typeUid == tail.typeUid &&
+      item->chunkUid == tail.chunkUid &&
+      item->size == tail.size &&
+      item->fragmentStart == tail.fragmentEnd)
     {
       /* If the previous tail came from the same header as
-       * the next item we want to append to our array, then, 
-       * we merge them and attempt to reuse the previous tail's
-       * location.
+       * the next item we want to append to our list, then, 
+       * we merge them.
        */
-      tailExtraItem.fragmentEnd = extraItem.fragmentEnd;
-      ReplaceTail (&tailItem, &tailExtraItem, tailSize);
-      if (o.m_head == o.m_tail)
-        {
-          // there is only one item to append to self from other.
-          return;
-        }
-      current = item.next;
-    }
-  else
-    {
-      current = o.m_head;
+      tail.fragmentEnd = item->fragmentEnd;
+      PopBack ();
+      PushBack (MakeBig (tail, GetPacketUid (tail)));
+      i++;
     }
 
   /* Now that we have merged our current tail with the head of the
    * next packet, we just append all items from the next packet
    * to the current packet.
    */
-  while (current != 0xffff)
+  for (; i < items.size (); i++)
     {
-      o.ReadItems (current, &item, &extraItem);
-      uint16_t written = AddBig (0xffff, m_tail, &item, &extraItem);
-      UpdateTail (written);
-      if (current == o.m_tail)
-        {
-          break;
-        }
-      current = item.next;
+      item = GetNode (items[i]);
+      PushBack (MakeBig (*item, other.GetPacketUid (*item)));
     }
   NS_ASSERT (IsStateOk ());
 }
@@ -896,55 +575,30 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
   uint32_t leftToRemove = start;
-  uint16_t current = m_head;
-  while (current != 0xffff && leftToRemove > 0)
+  while (leftToRemove > 0)
     {
-      struct PacketMetadata::SmallItem item;
-      PacketMetadata::ExtraItem extraItem;
-      ReadItems (current, &item, &extraItem);
-      uint32_t itemRealSize = extraItem.fragmentEnd - extraItem.fragmentStart;
+      uint32_t front = GetFront ();
+      if (front == NONE)
+        {
+          break;
+        }
+      struct PacketMetadata::Node item = *GetNode (front);
+      uint32_t itemRealSize = item.fragmentEnd - item.fragmentStart;
+      PopFront ();
       if (itemRealSize <= leftToRemove)
         {
-          // remove from list.
-          if (m_head == m_tail)
-            {
-              m_head = 0xffff;
-              m_tail = 0xffff;
-            }
-          else
-            {
-              m_head = item.next;
-            }
           leftToRemove -= itemRealSize;
         }
       else
         {
-          // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
-          extraItem.fragmentStart += leftToRemove;
+          // fragment the item.
+          item.fragmentStart += leftToRemove;
           leftToRemove = 0;
-          uint16_t written = fragment.AddBig (0xffff, fragment.m_tail,
-                                              &item, &extraItem);
-          fragment.UpdateTail (written);
-          while (current != 0xffff && current != m_tail)
-            {
-              current = item.next;
-              ReadItems (current, &item, &extraItem);
-              written = fragment.AddBig (0xffff, fragment.m_tail,
-                                         &item, &extraItem);
-              fragment.UpdateTail (written);
-            }
-          *this = fragment;
+          PushFront (MakeBig (item, GetPacketUid (item)));
         }
-      NS_ASSERT (item.size >= extraItem.fragmentEnd - extraItem.fragmentStart &&
-                 extraItem.fragmentStart <= extraItem.fragmentEnd);
-      if (current == m_tail)
-        {
-          break;
-        }
-      current = item.next;
+      NS_ASSERT (item.size >= item.fragmentEnd - item.fragmentStart &&
+                 item.fragmentStart <= item.fragmentEnd);
     }
   NS_ASSERT (leftToRemove == 0);
   NS_ASSERT (IsStateOk ());
@@ -959,57 +613,31 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       m_metadataSkipped = true;
       return;
     }
-  NS_ASSERT (m_data != 0);
-
   uint32_t leftToRemove = end;
-  uint16_t current = m_tail;
-  while (current != 0xffff && leftToRemove > 0)
+  while (leftToRemove > 0)
     {
-      struct PacketMetadata::SmallItem item;
-      PacketMetadata::ExtraItem extraItem;
-      ReadItems (current, &item, &extraItem);
-      uint32_t itemRealSize = extraItem.fragmentEnd - extraItem.fragmentStart;
+      uint32_t back = GetBack ();
+      if (back == NONE)
+        {
+          break;
+        }
+      struct PacketMetadata::Node item = *GetNode (back);
+      uint32_t itemRealSize = item.fragmentEnd - item.fragmentStart;
+      PopBack ();
       if (itemRealSize <= leftToRemove)
         {
-          // remove from list.
-          if (m_head == m_tail)
-            {
-              m_head = 0xffff;
-              m_tail = 0xffff;
-            }
-          else
-            {
-              m_tail = item.prev;
-            }
           leftToRemove -= itemRealSize;
         }
       else
         {
-          // fragment the list item.
-          PacketMetadata fragment (m_packetUid, 0);
-          NS_ASSERT (extraItem.fragmentEnd > leftToRemove);
-          extraItem.fragmentEnd -= leftToRemove;
+          // fragment the item.
+          NS_ASSERT (item.fragmentEnd > leftToRemove);
+          item.fragmentEnd -= leftToRemove;
           leftToRemove = 0;
-          uint16_t written = fragment.AddBig (fragment.m_head, 0xffff,
-                                              &item, &extraItem);
-          fragment.UpdateHead (written);
-          while (current != 0xffff && current != m_head)
-            {
-              current = item.prev;
-              ReadItems (current, &item, &extraItem);
-              written = fragment.AddBig (fragment.m_head, 0xffff,
-                                         &item, &extraItem);
-              fragment.UpdateHead (written);
-            }
-          *this = fragment;
+          PushBack (MakeBig (item, GetPacketUid (item)));
         }
-      NS_ASSERT (item.size >= extraItem.fragmentEnd - extraItem.fragmentStart &&
-                 extraItem.fragmentStart <= extraItem.fragmentEnd);
-      if (current == m_head)
-        {
-          break;
-        }
-      current = item.prev;
+      NS_ASSERT (item.size >= item.fragmentEnd - item.fragmentStart &&
+                 item.fragmentStart <= item.fragmentEnd);
     }
   NS_ASSERT (leftToRemove == 0);
   NS_ASSERT (IsStateOk ());
@@ -1019,20 +647,12 @@ PacketMetadata::GetTotalSize (void) const
 {
   NS_LOG_FUNCTION (this);
   uint32_t totalSize = 0;
-  uint16_t current = m_head;
-  uint16_t tail = m_tail;
-  while (current != 0xffff)
+  std::vector<uint32_t> items;
+  GetItems (items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); i++)
     {
-      struct PacketMetadata::SmallItem item;
-      PacketMetadata::ExtraItem extraItem;
-      ReadItems (current, &item, &extraItem);
-      totalSize += extraItem.fragmentEnd - extraItem.fragmentStart;
-      if (current == tail)
-        {
-          break;
-        }
-      NS_ASSERT (current != item.next);
-      current = item.next;
+      const struct Node *item = GetNode (*i);
+      totalSize += item->fragmentEnd - item->fragmentStart;
     }
   return totalSize;
 }
@@ -1052,45 +672,32 @@ PacketMetadata::BeginItem (Buffer buffer) const
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
   : m_metadata (metadata),
     m_buffer (buffer),
-    m_current (metadata->m_head),
-    m_offset (0),
-    m_hasReadTail (false)
+    m_current (0),
+    m_offset (0)
 {
   NS_LOG_FUNCTION (this << metadata << &buffer);
+  metadata->GetItems (m_items);
 }
 bool
 PacketMetadata::ItemIterator::HasNext (void) const
 {
   NS_LOG_FUNCTION (this);
-  if (m_current == 0xffff)
-    {
-      return false;
-    }
-  if (m_hasReadTail)
-    {
-      return false;
-    }
-  return true;
+  return m_current < m_items.size ();
 }
 PacketMetadata::Item
 PacketMetadata::ItemIterator::Next (void)
 {
   NS_LOG_FUNCTION (this);
+  NS_ASSERT (HasNext ());
   struct PacketMetadata::Item item;
-  struct PacketMetadata::SmallItem smallItem;
-  struct PacketMetadata::ExtraItem extraItem;
-  m_metadata->ReadItems (m_current, &smallItem, &extraItem);
-  if (m_current == m_metadata->m_tail)
-    {
-      m_hasReadTail = true;
-    }
-  m_current = smallItem.next;
-  uint32_t uid = (smallItem.typeUid & 0xfffffffe) >> 1;
+  const struct PacketMetadata::Node *node = PacketMetadata::GetNode (m_items[m_current]);
+  m_current++;
+  uint32_t uid = (node->typeUid & 0xfffffffe) >> 1;
   item.tid.SetUid (uid);
-  item.currentTrimedFromStart = extraItem.fragmentStart;
-  item.currentTrimedFromEnd = extraItem.fragmentEnd - smallItem.size;
-  item.currentSize = extraItem.fragmentEnd - extraItem.fragmentStart;
-  if (extraItem.fragmentStart != 0 || extraItem.fragmentEnd != smallItem.size)
+  item.currentTrimedFromStart = node->fragmentStart;
+  item.currentTrimedFromEnd = node->fragmentEnd - node->size;
+  item.currentSize = node->fragmentEnd - node->fragmentStart;
+  if (node->fragmentStart != 0 || node->fragmentEnd != node->size)
     {
       item.isFragment = true;
     }
@@ -1119,14 +726,14 @@ PacketMetadata::ItemIterator::Next (void)
       if (!item.isFragment)
         {
           item.current = m_buffer.End ();
-          item.current.Prev (m_buffer.GetSize () - (m_offset + smallItem.size));
+          item.current.Prev (m_buffer.GetSize () - (m_offset + node->size));
         }
     }
   else 
     {
       NS_ASSERT (false);
     }
-  m_offset += extraItem.fragmentEnd - extraItem.fragmentStart;
+  m_offset += node->fragmentEnd - node->fragmentStart;
   return item;
 }
 
@@ -1147,13 +754,12 @@ PacketMetadata::GetSerializedSize (void) const
       return totalSize;
     }
 
-  struct PacketMetadata::SmallItem item;
-  struct PacketMetadata::ExtraItem extraItem;
-  uint32_t current = m_head;
-  while (current != 0xffff)
+  std::vector<uint32_t> items;
+  GetItems (items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); i++)
     {
-      ReadItems (current, &item, &extraItem);
-      uint32_t uid = (item.typeUid & 0xfffffffe) >> 1;
+      const struct Node *item = GetNode (*i);
+      uint32_t uid = (item->typeUid & 0xfffffffe) >> 1;
       if (uid == 0)
         {
           totalSize += 4;
@@ -1165,12 +771,6 @@ PacketMetadata::GetSerializedSize (void) const
           totalSize += 4 + tid.GetName ().size ();
         }
       totalSize += 1 + 4 + 2 + 4 + 4 + 8;
-      if (current == m_tail)
-        {
-          break;
-        }
-      NS_ASSERT (current != item.next);
-      current = item.next;
     }
   return totalSize;
 }
@@ -1187,18 +787,18 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
       return 0;
     }
 
-  struct PacketMetadata::SmallItem item;
-  struct PacketMetadata::ExtraItem extraItem;
-  uint32_t current = m_head;
-  while (current != 0xffff)
+  std::vector<uint32_t> items;
+  GetItems (items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); i++)
     {
-      ReadItems (current, &item, &extraItem);
+      const struct Node *item = GetNode (*i);
+      uint64_t packetUid = GetPacketUid (*item);
       NS_LOG_LOGIC ("bytesWritten=" << static_cast<uint32_t> (buffer - start) << ", typeUid="<<
-                    item.typeUid << ", size="<<item.size<<", chunkUid="<<item.chunkUid<<
-                    ", fragmentStart="<<extraItem.fragmentStart<<", fragmentEnd="<<
-                    extraItem.fragmentEnd<< ", packetUid="<<extraItem.packetUid);
+                    item->typeUid << ", size="<<item->size<<", chunkUid="<<item->chunkUid<<
+                    ", fragmentStart="<<item->fragmentStart<<", fragmentEnd="<<
+                    item->fragmentEnd<< ", packetUid="<<packetUid);
 
-      uint32_t uid = (item.typeUid & 0xfffffffe) >> 1;
+      uint32_t uid = (item->typeUid & 0xfffffffe) >> 1;
       if (uid != 0)
         {
           TypeId tid;
@@ -1226,50 +826,42 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
             }
         }
 
-      uint8_t isBig = item.typeUid & 0x1;
+      uint8_t isBig = item->typeUid & 0x1;
       buffer = AddToRawU8 (isBig, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
 
-      buffer = AddToRawU32 (item.size, start, buffer, maxSize);
+      buffer = AddToRawU32 (item->size, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
 
-      buffer = AddToRawU16 (item.chunkUid, start, buffer, maxSize);
+      buffer = AddToRawU16 (item->chunkUid, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
 
-      buffer = AddToRawU32 (extraItem.fragmentStart, start, buffer, maxSize);
+      buffer = AddToRawU32 (item->fragmentStart, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
 
-      buffer = AddToRawU32 (extraItem.fragmentEnd, start, buffer, maxSize);
+      buffer = AddToRawU32 (item->fragmentEnd, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
 
-      buffer = AddToRawU64 (extraItem.packetUid, start, buffer, maxSize);
+      buffer = AddToRawU64 (packetUid, start, buffer, maxSize);
       if (buffer == 0) 
         {
           return 0;
         }
-
-      if (current == m_tail)
-        {
-          break;
-        }
-
-      NS_ASSERT (current != item.next);
-      current = item.next;
     }
 
   NS_ASSERT (static_cast<uint32_t> (buffer - start) == maxSize);
@@ -1286,8 +878,7 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
   buffer = ReadFromRawU64 (m_packetUid, start, buffer, size);
   desSize -= 8;
 
-  struct PacketMetadata::SmallItem item = {0};
-  struct PacketMetadata::ExtraItem extraItem = {0};
+  struct PacketMetadata::Node item = {0};
   while (desSize > 0)
     {
       uint32_t uidStringSize = 0;
@@ -1320,18 +911,18 @@ PacketMetadata::Deserialize (const uint8_t* buffer, uint32_t size)
       desSize -= 4;
       buffer = ReadFromRawU16 (item.chunkUid, start, buffer, size);
       desSize -= 2;
-      buffer = ReadFromRawU32 (extraItem.fragmentStart, start, buffer, size);
+      buffer = ReadFromRawU32 (item.fragmentStart, start, buffer, size);
       desSize -= 4;
-      buffer = ReadFromRawU32 (extraItem.fragmentEnd, start, buffer, size);
+      buffer = ReadFromRawU32 (item.fragmentEnd, start, buffer, size);
       desSize -= 4;
-      buffer = ReadFromRawU64 (extraItem.packetUid, start, buffer, size);
+      uint64_t packetUid = 0;
+      buffer = ReadFromRawU64 (packetUid, start, buffer, size);
       desSize -= 8;
       NS_LOG_LOGIC ("size=" << size << ", typeUid="<<item.typeUid <<
                     ", size="<<item.size<<", chunkUid="<<item.chunkUid<<
-                    ", fragmentStart="<<extraItem.fragmentStart<<", fragmentEnd="<<
-                    extraItem.fragmentEnd<< ", packetUid="<<extraItem.packetUid);
-      uint32_t tmp = AddBig (0xffff, m_tail, &item, &extraItem);
-      UpdateTail (tmp);
+                    ", fragmentStart="<<item.fragmentStart<<", fragmentEnd="<<
+                    item.fragmentEnd<< ", packetUid="<<packetUid);
+      PushBack (MakeBig (item, packetUid));
     }
   NS_ASSERT (desSize == 0);
   return (desSize !=0) ? 0 : 1;
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#include <atomic>
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
@@ -44,14 +45,11 @@ class Trailer;
  * an implementation of the Packet::Print methods which uses
  * the metadata to analyse the content of the packet's buffer.
  *
- * To achieve this, this class maintains a linked list of so-called
+ * To achieve this, this class maintains a list of so-called
  * "items", each of which represents a header or a trailer, or 
- * payload, or a fragment of any of these. Each item contains a "next"
- * and a "prev" field which point to the next and previous entries
- * in the linked list. The PacketMetadata class maintains a pair
- * of pointers to the head and the tail of the linked list.
+ * payload, or a fragment of any of these.
  *
- * Each entry in the list also maintains:
+ * Each item in the list maintains:
  *   - its native size (the size it had when it was first added
  *     to the packet)
  *   - its type: identifies what kind of header, what kind of trailer,
@@ -60,20 +58,27 @@ class Trailer;
  *   - the start and end of the area represented by a fragment
  *     if it is one.
  *
- * This linked list is flattened in a byte buffer stored in
- * struct PacketMetadata::Data. Each entry of the linked list is
- * identified by an offset which identifies the first byte of the
- * entry from the start of the data buffer. The size of this data
- * buffer is 2^16-1 bytes maximum which somewhat limits the number
- * of entries which can be stored in this linked list but it is
- * quite unlikely to hit this limit in practice.
+ * The items are immutable nodes of an arena, identified by
+ * their 32-bit index in it and reference counted.  The list of a
+ * packet is made of two chains of nodes: the front chain, whose first
+ * node is the first item of the list and which is extended by
+ * AddHeader, and the back chain, whose first node is the last item of
+ * the list and which is extended by AddTrailer and AddAtEnd.  Each
+ * node links to the next node of its chain, towards the middle of the
+ * list, so that the copies of a packet share all of their nodes, and
+ * each copy adds or removes items at either end by linking a new node
+ * to the nodes it shares, or by moving to the next node of a chain,
+ * without ever copying the items of the other copies.  When one of
+ * the chains is empty and an item must be removed at its end, the
+ * items are split evenly between two new chains.
  *
- * Each item of the linked list is a variable-sized byte buffer
- * made of a number of fields. Some of these fields are stored
- * as fixed-size 32 bit integers, others as fixed-size 16 bit 
- * integers, and some others as variable-size 32-bit integers.
- * The variable-size 32 bit integers are stored using the uleb128
- * encoding.
+ * The arena grows by blocks of PacketPool memory, and keeps the
+ * released nodes for the next items.  The blocks are shared by the
+ * threads, but each thread keeps its own free nodes, so the threads
+ * of a multithreaded simulation add items without a lock.  The
+ * reference counts of the nodes are not atomic: the copies of a packet
+ * must stay in one thread, and Packet::CreateFullCopy makes a packet
+ * whose nodes can be handed over to another thread.
  */
 class PacketMetadata 
 {
@@ -146,9 +151,9 @@ public:
 private:
     const PacketMetadata *m_metadata; //!< pointer to the metadata
     Buffer m_buffer; //!< buffer the metadata refers to
-    uint16_t m_current; //!< current position
+    std::vector<uint32_t> m_items; //!< the nodes of the items, in order
+    uint32_t m_current; //!< index of the next item in m_items
     uint32_t m_offset; //!< offset
-    bool m_hasReadTail; //!< true if the metadata tail has been read
   };
 
   /**
@@ -159,6 +164,16 @@ private:
    * \brief Enable the packet metadata checking
    */
   static void EnableChecking (void);
+  /**
+   * \brief Get the number of items held by the packets
+   *
+   * The items shared by several packets are counted once.  The nodes
+   * of the arena are shared by the threads, so this is the number of
+   * nodes allocated minus the number of nodes released by this thread.
+   *
+   * \returns the number of nodes in use for this thread
+   */
+  static uint32_t GetUsedNodes (void);
 
   /**
    * \brief Constructor
@@ -179,6 +194,13 @@ private:
   inline PacketMetadata &operator = (PacketMetadata const& o);
   inline ~PacketMetadata ();
 
+  /**
+   * \brief Create a copy of the metadata which shares no node with it
+   *
+   * \returns the copy
+   */
+  PacketMetadata CreateFullCopy (void) const;
+
   /**
    * \brief Add an header
    * \param header header to add
@@ -400,60 +422,38 @@ private:
                                   uint32_t maxSize);
 
   /**
-   * the size of PacketMetadata::Data::m_data such that the total size
-   * of PacketMetadata::Data is 16 bytes
-   */ 
-#define PACKET_METADATA_DATA_M_DATA_SIZE 8
-  
-  /**
-   * Data structure
-   */
-  struct Data {
-    /** number of references to this struct Data instance. */
-    uint32_t m_count;
-    /** size (in bytes) of m_data buffer below */
-    uint16_t m_size;
-    /** max of the m_used field over all objects which
-     * reference this struct Data instance */
-    uint16_t m_dirtyEnd;
-    /** variable-sized buffer of bytes */
-    uint8_t m_data[PACKET_METADATA_DATA_M_DATA_SIZE]; 
-  };
-  /* Note that since the next and prev fields are 16 bit integers
-     and since the value 0xffff is reserved to identify the 
-     fact that the end or the start of the list is reached,
-     only a limited number of elements can be stored in 
-     a m_data byte buffer.
-   */
-  /**
-   * \brief SmallItem structure
-   */
-  struct SmallItem {
-    /** offset (in bytes) from start of m_data buffer
-       to next element in linked list. value is 0xffff 
-       if next element does not exist.
-       stored as a fixed-size 16 bit integer.
-    */
-    uint16_t next;
-    /** offset (in bytes) from start of m_data buffer
-       to previous element in linked list. value is 0xffff 
-       if previous element does not exist.
-       stored as a fixed-size 16 bit integer.
-     */
-    uint16_t prev;
+   * \brief An item of the list, in the arena.
+   */
+  struct Node {
+    /** the index of the next node of the chain, or NONE. */
+    uint32_t next;
+    /** number of references to this node: the packets whose chain
+       starts with it, and the nodes which link to it. */
+    uint32_t count;
     /** the high 31 bits of this field identify the
        type of the header or trailer represented by 
        this item: the value zero represents payload.
-       If the low bit of this uid is one, an ExtraItem
-       structure follows this SmallItem structure.
-       stored as a variable-size 32 bit integer.
+       If the low bit of this uid is one, the item was
+       fragmented or added by AddAtEnd, and packetUid is set.
      */
     uint32_t typeUid;
     /** the size (in bytes) of the header or trailer represented
        by this element.
-       stored as a variable-size 32 bit integer.
      */
     uint32_t size;
+    /** offset (in bytes) from start of original header to
+       the start of the fragment still present.
+     */
+    uint32_t fragmentStart;
+    /** offset (in bytes) from start of original header to
+       the end of the fragment still present.
+     */
+    uint32_t fragmentEnd;
+    /** the low 32 bits of the packetUid of the packet in which this
+       header or trailer was first added, if the low bit of typeUid is
+       one. Otherwise, it is the packetUid of the packet.
+     */
+    uint32_t packetUid;
     /** this field tries to uniquely identify each header or
        trailer _instance_ while the typeUid field uniquely
        identifies each header or trailer _type_. This field
@@ -464,199 +464,147 @@ private:
        share the same chunkUid _and_ typeUid is very small 
        unless they are really representations of the same header
        instance.
-       stored as a fixed-size 16 bit integer.
      */
     uint16_t chunkUid;
   };
 
+  /** The arena constants. */
+  enum Arena_e {
+    NONE = 0xffffffff,        //!< the index of no node
+    NODES_PER_BLOCK = 2048,   //!< the number of nodes of a block of the arena
+    MAX_BLOCKS = 1 << 16      //!< the maximum number of blocks of the arena
+  };
+
   /**
-   * \brief ExtraItem structure
+   * \brief Give the free nodes of a thread to the other threads when
+   * it exits.
    */
-  struct ExtraItem {
-    /** offset (in bytes) from start of original header to
-       the start of the fragment still present.
-       stored as a variable-size 32 bit integer.
-     */
-    uint32_t fragmentStart;
-    /** offset (in bytes) from start of original header to
-       the end of the fragment still present.
-       stored as a variable-size 32 bit integer.
-     */
-    uint32_t fragmentEnd;
-    /** the packetUid of the packet in which this header or trailer
-       was first added. It could be different from the m_packetUid
-       field if the user has aggregated multiple packets into one.
-       stored as a fixed-size 64 bit integer.
-     */
-    uint64_t packetUid;
+  struct ThreadArena
+  {
+    ~ThreadArena ();
   };
-
   /**
-   * \brief Class to hold all the metadata
+   * \brief Release the blocks of the arena at the end of the program,
+   * if no node is used anymore.
    */
-  class DataFreeList : public std::vector<struct Data *>
+  struct ArenaDestructor
   {
-public:
-    ~DataFreeList ();
+    ~ArenaDestructor ();
   };
 
-  friend DataFreeList::~DataFreeList ();
   friend class ItemIterator;
 
   PacketMetadata ();
 
   /**
-   * \brief Add a SmallItem
-   * \param item the SmallItem to add
-   * \return added size
-   */
-  inline uint16_t AddSmall (const PacketMetadata::SmallItem *item);
-  /**
-   * \brief Add a "Big" Item (a SmallItem plus an ExtraItem)
-   * \param head the head
-   * \param tail the tail
-   * \param item the SmallItem to add
-   * \param extraItem the ExtraItem to add
-   * \return added size
-   */
-  uint16_t AddBig (uint32_t head, uint32_t tail,
-                   const PacketMetadata::SmallItem *item, 
-                   const PacketMetadata::ExtraItem *extraItem);
-  /**
-   * \brief Replace the tail
-   * \param item the item data to write
-   * \param extraItem the extra item data to write
-   * \param available the number of bytes which can
-   *        be written without having to rewrite the buffer entirely.
-   */
-  void ReplaceTail (PacketMetadata::SmallItem *item, 
-                    PacketMetadata::ExtraItem *extraItem,
-                    uint32_t available);
-  /**
-   * \brief Update the head
-   * \param written the used bytes
+   * \brief Add an header
+   * \param uid header's uid to add
+   * \param size header serialized size
    */
-  inline void UpdateHead (uint16_t written);
+  void DoAddHeader (uint32_t uid, uint32_t size);
   /**
-   * \brief Update the tail
-   * \param written the used bytes
+   * \brief Check if the metadata state is ok
+   * \returns true if the internal state is ok
    */
-  inline void UpdateTail (uint16_t written);
+  bool IsStateOk (void) const;
 
   /**
-   * \brief Get the ULEB128 (Unsigned Little Endian Base 128) size
-   * \param value the value
-   * \returns the value's ULEB128 size
+   * \brief Get a node of the arena
+   * \param index the index of the node
+   * \returns the node
    */
-  inline uint32_t GetUleb128Size (uint32_t value) const;
+  static inline struct Node *GetNode (uint32_t index);
   /**
-   * \brief Read a ULEB128 (Unsigned Little Endian Base 128) coded number
-   * \param pBuffer the buffer to read from
-   * \returns the value
+   * \brief Allocate a node of the arena
+   * \returns the index of the node
    */
-  uint32_t ReadUleb128 (const uint8_t **pBuffer) const;
+  static uint32_t AllocateNode (void);
   /**
-   * \brief Append a 16-bit value to the buffer
-   * \param value the value to add
-   * \param buffer the buffer to write to
+   * \brief Refill the free nodes of this thread, from the nodes left
+   * by the threads which exited or from a new block
    */
-  inline void Append16 (uint16_t value, uint8_t *buffer);
+  static void AllocateNodes (void);
   /**
-   * \brief Append a 32-bit value to the buffer
-   * \param value the value to add
-   * \param buffer the buffer to write to
+   * \brief Add a reference to a node
+   * \param index the index of the node, or NONE
    */
-  inline void Append32 (uint32_t value, uint8_t *buffer);
+  static inline void Ref (uint32_t index);
   /**
-   * \brief Append a value to the buffer
-   * \param value the value to add
-   * \param buffer the buffer to write to
+   * \brief Remove a reference to a node, and release it and the nodes
+   * it links to which are no longer referenced
+   * \param index the index of the node, or NONE
    */
-  inline void AppendValue (uint32_t value, uint8_t *buffer);
+  static inline void Unref (uint32_t index);
   /**
-   * \brief Append a value to the buffer - extra
-   *
-   * This function is called by AppendValue
-   *
-   * \param value the value to add
-   * \param buffer the buffer to write to
+   * \brief Release a node which is no longer referenced, and the nodes
+   * it links to which are no longer referenced
+   * \param index the index of the node
    */
-  void AppendValueExtra (uint32_t value, uint8_t *buffer);
+  static void Release (uint32_t index);
 
   /**
-   * \brief Reserve space
-   * \param n space to reserve
+   * \brief Add an item at the start of the list
+   * \param item the item to add
    */
-  inline void Reserve (uint32_t n);
+  void PushFront (const struct Node &item);
   /**
-   * \brief Reserve space and make a metadata copy
-   * \param n space to reserve
+   * \brief Add an item at the end of the list
+   * \param item the item to add
    */
-  void ReserveCopy (uint32_t n);
-
-  /**
-   * \brief Get the total size used by the metadata
-   */
-  uint32_t GetTotalSize (void) const;
-
+  void PushBack (const struct Node &item);
   /**
-   * \brief Read items
-   * \param current the offset we should start reading the data from
-   * \param item pointer to where we should store the data to return to the caller
-   * \param extraItem pointer to where we should store the data to return to the caller
-   * \returns the number of bytes read.
+   * \brief Remove the first item of the list, which must be the
+   * first node of the front chain
    */
-  uint32_t ReadItems (uint16_t current, 
-                      struct PacketMetadata::SmallItem *item,
-                      struct PacketMetadata::ExtraItem *extraItem) const;
+  void PopFront (void);
   /**
-   * \brief Add an header
-   * \param uid header's uid to add
-   * \param size header serialized size
+   * \brief Remove the last item of the list, which must be the
+   * first node of the back chain
    */
-  void DoAddHeader (uint32_t uid, uint32_t size);
+  void PopBack (void);
   /**
-   * \brief Check if the metadata state is ok
-   * \returns true if the internal state is ok
+   * \brief Get the first item of the list, moving items to the front
+   * chain if it is empty
+   * \returns the index of the node of the first item, or NONE
    */
-  bool IsStateOk (void) const;
+  uint32_t GetFront (void);
   /**
-   * \brief Check if the position is valid
-   * \param pointer the position to check
-   * \returns true if the position is valid
+   * \brief Get the last item of the list, moving items to the back
+   * chain if it is empty
+   * \returns the index of the node of the last item, or NONE
    */
-  bool IsPointerOk (uint16_t pointer) const;
+  uint32_t GetBack (void);
   /**
-   * \brief Check if the position is valid
-   * \param pointer the position to check
-   * \returns true if the position is valid
+   * \brief Split the items evenly between two new chains
+   * \param front true if the front chain is empty, false if the
+   *        back chain is
    */
-  bool IsSharedPointerOk (uint16_t pointer) const;
-
+  void Balance (bool front);
   /**
-   * \brief Recycle the buffer memory
-   * \param data the buffer data storage
+   * \brief Get the nodes of the items of the list, in order
+   * \param items the list of nodes to append to
    */
-  static void Recycle (struct PacketMetadata::Data *data);
+  void GetItems (std::vector<uint32_t> &items) const;
   /**
-   * \brief Create a buffer data storage
-   * \param size the storage size to create
-   * \returns a pointer to the created buffer storage
+   * \brief Get the uid of the packet an item was first added to
+   * \param item the item
+   * \returns the packet uid
    */
-  static struct PacketMetadata::Data *Create (uint32_t size);
+  uint64_t GetPacketUid (const struct Node &item) const;
   /**
-   * \brief Allocate a buffer data storage
-   * \param n the storage size to create
-   * \returns a pointer to the allocated buffer storage
+   * \brief Get a copy of an item which records its packet uid and
+   * fragment
+   * \param item the item
+   * \param packetUid the uid of the packet the item was first added to
+   * \returns the copy
    */
-  static struct PacketMetadata::Data *Allocate (uint32_t n);
+  static struct Node MakeBig (struct Node item, uint64_t packetUid);
+
   /**
-   * \brief Deallocate the buffer memory
-   * \param data the buffer data storage
+   * \brief Get the total size used by the metadata
    */
-  static void Deallocate (struct PacketMetadata::Data *data);
+  uint32_t GetTotalSize (void) const;
 
-  static DataFreeList m_freeList; //!< the metadata data storage
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -665,20 +613,24 @@ public:
    * m_enable is false; used to detect enabling of metadata in the
    * middle of a simulation, which isn't allowed.
    */
-  static bool m_metadataSkipped;
+  static std::atomic<bool> m_metadataSkipped;
+
+  static std::atomic<uint16_t> m_chunkUid; //!< Chunk Uid
 
-  static uint32_t m_maxSize; //!< maximum metadata size
-  static uint16_t m_chunkUid; //!< Chunk Uid
+  static struct Node *m_blocks[MAX_BLOCKS]; //!< the blocks of the arena, shared by the threads
+  static uint32_t m_nBlocks; //!< the number of blocks of the arena
+  static uint32_t m_sharedFreeNodes; //!< the free nodes left by the threads which exited
+  static uint32_t m_sharedUsedNodes; //!< the nodes used by the threads which exited
+  static struct ArenaDestructor m_arenaDestructor; //!< the arena destructor
+  static thread_local uint32_t m_freeNodes; //!< the first free node of this thread, linked by next
+  static thread_local uint32_t m_usedNodes; //!< the nodes allocated minus the nodes released by this thread
+  static thread_local struct ThreadArena m_threadArena; //!< the handover of the free nodes of this thread
 
-  struct Data *m_data; //!< Metadata storage
   /*
-     head -(next)-> tail
-       ^             |
-        \---(prev)---|
+     front -(next)-> ... -(next)-> payload <-(next)- ... <-(next)- back
    */
-  uint16_t m_head; //!< list head
-  uint16_t m_tail; //!< list tail
-  uint16_t m_used; //!< used portion
+  uint32_t m_front; //!< the first node of the front chain
+  uint32_t m_back; //!< the first node of the back chain
   uint64_t m_packetUid; //!< packet Uid
 };
 
@@ -686,60 +638,71 @@ public:
 
 namespace ns3 {
 
+PacketMetadata::Node *
+PacketMetadata::GetNode (uint32_t index)
+{
+  NS_ASSERT (index / NODES_PER_BLOCK < MAX_BLOCKS && m_blocks[index / NODES_PER_BLOCK] != 0);
+  return &m_blocks[index / NODES_PER_BLOCK][index % NODES_PER_BLOCK];
+}
+void
+PacketMetadata::Ref (uint32_t index)
+{
+  if (index != NONE)
+    {
+      struct Node *node = GetNode (index);
+      NS_ASSERT (node->count < std::numeric_limits<uint32_t>::max ());
+      node->count++;
+    }
+}
+void
+PacketMetadata::Unref (uint32_t index)
+{
+  if (index != NONE)
+    {
+      struct Node *node = GetNode (index);
+      NS_ASSERT (node->count > 0);
+      node->count--;
+      if (node->count == 0)
+        {
+          Release (index);
+        }
+    }
+}
+
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
-    m_head (0xffff),
-    m_tail (0xffff),
-    m_used (0),
+  : m_front (NONE),
+    m_back (NONE),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
   if (size > 0)
     {
       DoAddHeader (0, size);
     }
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
-  : m_data (o.m_data),
-    m_head (o.m_head),
-    m_tail (o.m_tail),
-    m_used (o.m_used),
+  : m_front (o.m_front),
+    m_back (o.m_back),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  Ref (m_front);
+  Ref (m_back);
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
 {
-  if (m_data != o.m_data) 
-    {
-      // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
-        {
-          PacketMetadata::Recycle (m_data);
-        }
-      m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
-    }
-  m_head = o.m_head;
-  m_tail = o.m_tail;
-  m_used = o.m_used;
+  Ref (o.m_front);
+  Ref (o.m_back);
+  Unref (m_front);
+  Unref (m_back);
+  m_front = o.m_front;
+  m_back = o.m_back;
   m_packetUid = o.m_packetUid;
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
-    {
-      PacketMetadata::Recycle (m_data);
-    }
+  Unref (m_front);
+  Unref (m_back);
 }
 
 } // namespace ns3
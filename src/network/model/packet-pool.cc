@@ -0,0 +1,475 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-pool.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketPool implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketPool");
+
+namespace {
+
+/** The log2 of the smallest size class. */
+const uint32_t g_minShift = 4;
+/** The log2 of the largest size class. */
+const uint32_t g_maxShift = 16;
+/**
+ * The number of size classes: the powers of two, and the sizes half
+ * way between them, so that a block is at most a third larger than
+ * requested.
+ */
+const uint32_t g_nClasses = 2 * (g_maxShift - g_minShift) + 1;
+
+/** A free block, linked to the next free block of its class. */
+struct FreeBlock
+{
+  FreeBlock *m_next;  //!< The next free block.
+};
+
+/**
+ * The free lists and counters of a thread.
+ *
+ * This is a plain structure, so that the shared pool is usable, and
+ * zero, before any constructor of this file has run, and after the
+ * destructor of g_destructor has run.
+ */
+struct Pool
+{
+  FreeBlock *free[g_nClasses];                      //!< The free blocks of each size class.
+  uint64_t nFree[g_nClasses];                       //!< The number of free blocks of each size class.
+  PacketPool::Counters counters[PacketPool::PARTS]; //!< The counters of each part.
+};
+
+/** The pool of the threads which have exited, protected by g_mutex. */
+Pool g_shared;
+/** The number of free blocks of g_shared, read without g_mutex. */
+std::atomic<uint64_t> g_nShared (0);
+/** Protects g_shared. */
+std::mutex g_mutex;
+/** The bytes of free blocks kept by each class, plus one; zero for the default. */
+std::atomic<uint64_t> g_capacity (0);
+/** Whether the pool is destroyed, at the end of the program. */
+std::atomic<bool> g_destroyed (false);
+
+/** The bytes of free blocks kept by each class by default. */
+const uint64_t g_defaultCapacity = 4 * 1024 * 1024;
+
+/**
+ * \param [in] index The size class.
+ * \returns The size of the blocks of the class.
+ */
+uint32_t
+GetClassSize (uint32_t index)
+{
+  uint32_t shift = g_minShift + index / 2;
+  if (index % 2 == 0)
+    {
+      return 1U << shift;
+    }
+  return 3U << (shift - 1);
+}
+
+/**
+ * \param [in] size The size of a block.
+ * \returns The smallest size class which holds the block, or
+ *          g_nClasses if it is too large to be pooled.
+ */
+uint32_t
+GetClass (uint32_t size)
+{
+  if (size <= (1U << g_minShift))
+    {
+      return 0;
+    }
+  if (size > (1U << g_maxShift))
+    {
+      return g_nClasses;
+    }
+  uint32_t shift = g_minShift;
+  while ((1U << (shift + 1)) < size)
+    {
+      shift++;
+    }
+  // 2^shift < size <= 2^(shift+1)
+  uint32_t index = 2 * (shift - g_minShift);
+  return size <= (3U << (shift - 1)) ? index + 1 : index + 2;
+}
+
+/**
+ * \param [in] index The size class.
+ * \returns The number of free blocks the class keeps.
+ */
+uint64_t
+GetMaxFree (uint32_t index)
+{
+  return PacketPool::GetCapacity () / GetClassSize (index);
+}
+
+/**
+ * Return the free blocks of a size class to the heap, down to a count.
+ *
+ * \param [in,out] pool The pool.
+ * \param [in] index The size class.
+ * \param [in] count The number of free blocks to keep.
+ * \returns The number of blocks returned to the heap.
+ */
+uint64_t
+Trim (Pool &pool, uint32_t index, uint64_t count)
+{
+  uint64_t trimmed = 0;
+  while (pool.nFree[index] > count)
+    {
+      FreeBlock *block = pool.free[index];
+      pool.free[index] = block->m_next;
+      pool.nFree[index]--;
+      ::operator delete (block);
+      trimmed++;
+    }
+  return trimmed;
+}
+
+/**
+ * Add the counters of a pool to other counters.
+ *
+ * \param [in,out] to The counters added to.
+ * \param [in] from The counters added.
+ */
+void
+AddCounters (PacketPool::Counters &to, const PacketPool::Counters &from)
+{
+  to.hits += from.hits;
+  to.misses += from.misses;
+  to.releases += from.releases;
+  to.frees += from.frees;
+}
+
+/** The pool of a thread, handed over to g_shared when it exits. */
+struct ThreadPool : public Pool
+{
+  ThreadPool ();
+  ~ThreadPool ();
+};
+
+/** Set once the pool of this thread has been destroyed. */
+thread_local bool t_exited = false;
+/** The pool of this thread. */
+thread_local ThreadPool t_pool;
+
+ThreadPool::ThreadPool ()
+{
+  std::memset (static_cast<Pool *> (this), 0, sizeof (Pool));
+}
+
+ThreadPool::~ThreadPool ()
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (uint32_t i = 0; i < g_nClasses; i++)
+    {
+      if (g_destroyed)
+        {
+          Trim (*this, i, 0);
+          continue;
+        }
+      // keep no more than the capacity of the class in g_shared
+      Trim (*this, i, GetMaxFree (i) - std::min (GetMaxFree (i), g_shared.nFree[i]));
+      FreeBlock *last = free[i];
+      if (last == 0)
+        {
+          continue;
+        }
+      while (last->m_next != 0)
+        {
+          last = last->m_next;
+        }
+      last->m_next = g_shared.free[i];
+      g_shared.free[i] = free[i];
+      g_shared.nFree[i] += nFree[i];
+      g_nShared += nFree[i];
+    }
+  for (uint32_t i = 0; i < PacketPool::PARTS; i++)
+    {
+      AddCounters (g_shared.counters[i], counters[i]);
+    }
+  t_exited = true;
+}
+
+/**
+ * Take the free blocks of a size class of g_shared, left by the
+ * threads which have exited.
+ *
+ * \param [in,out] pool The pool of this thread.
+ * \param [in] index The size class.
+ */
+void
+TakeShared (Pool &pool, uint32_t index)
+{
+  std::lock_guard<std::mutex> lock (g_mutex);
+  pool.free[index] = g_shared.free[index];
+  pool.nFree[index] = g_shared.nFree[index];
+  g_nShared -= g_shared.nFree[index];
+  g_shared.free[index] = 0;
+  g_shared.nFree[index] = 0;
+}
+
+/**
+ * Allocate a block from a pool.
+ *
+ * \param [in,out] pool The pool.
+ * \param [in] shared \c true if the pool is g_shared, and g_mutex is held.
+ * \param [in] part The part of the packet the block is for.
+ * \param [in,out] size The size requested, set to the size of the block.
+ * \returns The block.
+ */
+void *
+AllocateFrom (Pool &pool, bool shared, enum PacketPool::Part part, uint32_t &size)
+{
+  uint32_t index = GetClass (size);
+  if (index < g_nClasses)
+    {
+      size = GetClassSize (index);
+      if (pool.free[index] == 0 && !shared && g_nShared.load (std::memory_order_relaxed) != 0)
+        {
+          TakeShared (pool, index);
+        }
+      FreeBlock *block = pool.free[index];
+      if (block != 0)
+        {
+          pool.free[index] = block->m_next;
+          pool.nFree[index]--;
+          if (shared)
+            {
+              g_nShared--;
+            }
+          pool.counters[part].hits++;
+          return block;
+        }
+    }
+  pool.counters[part].misses++;
+  return ::operator new (size);
+}
+
+/**
+ * Release a block to a pool.
+ *
+ * \param [in,out] pool The pool.
+ * \param [in] shared \c true if the pool is g_shared, and g_mutex is held.
+ * \param [in] part The part of the packet the block was for.
+ * \param [in] block The block.
+ * \param [in] size The size of the block.
+ */
+void
+ReleaseTo (Pool &pool, bool shared, enum PacketPool::Part part, void *block, uint32_t size)
+{
+  uint32_t index = GetClass (size);
+  if (index < g_nClasses && !g_destroyed.load (std::memory_order_relaxed)
+      && pool.nFree[index] < GetMaxFree (index))
+    {
+      FreeBlock *free = static_cast<FreeBlock *> (block);
+      free->m_next = pool.free[index];
+      pool.free[index] = free;
+      pool.nFree[index]++;
+      if (shared)
+        {
+          g_nShared++;
+        }
+      pool.counters[part].releases++;
+      return;
+    }
+  pool.counters[part].frees++;
+  ::operator delete (block);
+}
+
+/** Return all the free blocks to the heap at the end of the program. */
+struct PoolDestructor
+{
+  ~PoolDestructor ()
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    for (uint32_t i = 0; i < g_nClasses; i++)
+      {
+        Trim (g_shared, i, 0);
+      }
+    g_nShared = 0;
+    g_destroyed = true;
+  }
+} g_destructor; //!< The destructor of the pool.
+
+} // unnamed namespace
+
+void *
+PacketPool::Allocate (enum Part part, uint32_t &size)
+{
+  NS_ASSERT (part < PARTS);
+  if (!t_exited)
+    {
+      return AllocateFrom (t_pool, false, part, size);
+    }
+  std::lock_guard<std::mutex> lock (g_mutex);
+  return AllocateFrom (g_shared, true, part, size);
+}
+
+void
+PacketPool::Release (enum Part part, void *block, uint32_t size)
+{
+  NS_ASSERT (part < PARTS);
+  if (block == 0)
+    {
+      return;
+    }
+  if (!t_exited)
+    {
+      ReleaseTo (t_pool, false, part, block, size);
+      return;
+    }
+  std::lock_guard<std::mutex> lock (g_mutex);
+  ReleaseTo (g_shared, true, part, block, size);
+}
+
+PacketPool::Counters
+PacketPool::GetCounters (enum Part part)
+{
+  NS_ASSERT (part < PARTS);
+  Counters counters;
+  {
+    std::lock_guard<std::mutex> lock (g_mutex);
+    counters = g_shared.counters[part];
+  }
+  if (!t_exited)
+    {
+      AddCounters (counters, t_pool.counters[part]);
+    }
+  return counters;
+}
+
+double
+PacketPool::GetHitRate (enum Part part)
+{
+  NS_ASSERT (part < PARTS);
+  Counters counters = GetCounters (part);
+  uint64_t requests = counters.hits + counters.misses;
+  if (requests == 0)
+    {
+      return 1.0;
+    }
+  return static_cast<double> (counters.hits) / requests;
+}
+
+void
+PacketPool::ResetCounters (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (uint32_t i = 0; i < PARTS; i++)
+    {
+      g_shared.counters[i] = Counters ();
+      if (!t_exited)
+        {
+          t_pool.counters[i] = Counters ();
+        }
+    }
+}
+
+uint64_t
+PacketPool::GetFreeBytes (void)
+{
+  uint64_t bytes = 0;
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (uint32_t i = 0; i < g_nClasses; i++)
+    {
+      uint64_t nFree = g_shared.nFree[i];
+      if (!t_exited)
+        {
+          nFree += t_pool.nFree[i];
+        }
+      bytes += nFree * GetClassSize (i);
+    }
+  return bytes;
+}
+
+void
+PacketPool::SetCapacity (uint64_t bytes)
+{
+  NS_LOG_FUNCTION (bytes);
+  g_capacity = bytes + 1;
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (uint32_t i = 0; i < g_nClasses; i++)
+    {
+      g_nShared -= Trim (g_shared, i, GetMaxFree (i));
+      if (!t_exited)
+        {
+          Trim (t_pool, i, GetMaxFree (i));
+        }
+    }
+}
+
+uint64_t
+PacketPool::GetCapacity (void)
+{
+  uint64_t capacity = g_capacity.load (std::memory_order_relaxed);
+  if (capacity == 0)
+    {
+      return g_defaultCapacity;
+    }
+  return capacity - 1;
+}
+
+void
+PacketPool::Clear (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::lock_guard<std::mutex> lock (g_mutex);
+  for (uint32_t i = 0; i < g_nClasses; i++)
+    {
+      g_nShared -= Trim (g_shared, i, 0);
+      if (!t_exited)
+        {
+          Trim (t_pool, i, 0);
+        }
+    }
+}
+
+void
+PacketPool::Print (std::ostream &os)
+{
+  static const char *names[PARTS] = { "Packet", "Buffer", "PacketMetadata", "Tags", "QueueItem" };
+  for (uint32_t i = 0; i < PARTS; i++)
+    {
+      Counters counters = GetCounters (static_cast<enum Part> (i));
+      os << names[i]
+         << " hits=" << counters.hits
+         << " misses=" << counters.misses
+         << " releases=" << counters.releases
+         << " frees=" << counters.frees
+         << " hit-rate=" << GetHitRate (static_cast<enum Part> (i))
+         << std::endl;
+    }
+  os << "free bytes=" << GetFreeBytes () << std::endl;
+}
+
+} // namespace ns3
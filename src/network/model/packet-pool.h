@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <stdint.h>
+#include <ostream>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketPool declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief The pool which recycles the memory of the packets.
+ *
+ * All the memory of a packet is allocated from this pool: the Packet
+ * itself, the BufferData and chains of slices of its Buffer, the data
+ * of its PacketMetadata, the storage of its tags which does not fit
+ * in the packet itself, and the QueueItem which holds it in a queue.  Each request is rounded up to a size
+ * class, a power of two or the size half way between two powers of
+ * two, from 16 bytes to 64 KiB, and a released block is kept in the free
+ * list of its class, to serve the next request of the same class, so
+ * that a simulation whose packets come and go at a steady rate stops
+ * allocating memory for them once the pool has warmed up.
+ *
+ * Each class keeps at most GetCapacity() bytes of free blocks; the
+ * blocks released beyond that, and those larger than the largest
+ * class, are returned to the heap.
+ *
+ * Each thread has its own free lists and counters, so that the
+ * threads of a multithreaded simulation allocate and release blocks
+ * without a lock.  The free blocks of a thread which exits are handed
+ * over to a shared pool, from which the other threads take them when
+ * their own free list of a class is empty.
+ *
+ * The requests and releases are counted by the part of the packet
+ * they are for, so that the hit rate of the pool, the fraction of the
+ * requests served without a heap allocation, can be checked.  The
+ * counters and free bytes reported are those of the calling thread,
+ * plus those of the threads which have exited.
+ */
+class PacketPool
+{
+public:
+  /** The part of a packet a block is for. */
+  enum Part
+  {
+    PACKET = 0,   //!< The Packet itself.
+    BUFFER,       //!< The BufferData and chains of slices of a Buffer.
+    METADATA,     //!< The data of a PacketMetadata.
+    TAGS,         //!< The storage of the packet and byte tags.
+    QUEUE_ITEM,   //!< The QueueItem holding a queued packet.
+    PARTS         //!< The number of parts.
+  };
+
+  /** The counters of the requests and releases of a part. */
+  struct Counters
+  {
+    uint64_t hits;      //!< The requests served from a free list.
+    uint64_t misses;    //!< The requests served by a heap allocation.
+    uint64_t releases;  //!< The blocks kept in a free list when released.
+    uint64_t frees;     //!< The blocks returned to the heap when released.
+  };
+
+  /**
+   * Allocate a block.
+   *
+   * \param [in] part The part of the packet the block is for.
+   * \param [in,out] size The size requested, set to the size of the
+   *        block, which may be larger.
+   * \returns The block.
+   */
+  static void *Allocate (enum Part part, uint32_t &size);
+  /**
+   * Release a block.
+   *
+   * \param [in] part The part of the packet the block was for.
+   * \param [in] block The block.
+   * \param [in] size The size of the block: the size requested from
+   *        Allocate, or the size it set.
+   */
+  static void Release (enum Part part, void *block, uint32_t size);
+
+  /**
+   * \param [in] part The part of the packet.
+   * \returns The counters of the part.
+   */
+  static Counters GetCounters (enum Part part);
+  /**
+   * \param [in] part The part of the packet.
+   * \returns The fraction of the requests of the part served from a
+   *          free list, or 1 if there were none.
+   */
+  static double GetHitRate (enum Part part);
+  /**
+   * Reset the counters of all the parts, of the calling thread and
+   * of the threads which have exited.
+   */
+  static void ResetCounters (void);
+  /**
+   * \returns The number of bytes of the free blocks of the pool.
+   */
+  static uint64_t GetFreeBytes (void);
+
+  /**
+   * Set the number of bytes of free blocks each size class of each
+   * thread keeps, returning the blocks of the calling thread beyond it
+   * to the heap.  Zero disables the pool.
+   *
+   * \param [in] bytes The number of bytes.
+   */
+  static void SetCapacity (uint64_t bytes);
+  /**
+   * \returns The number of bytes of free blocks each size class keeps.
+   */
+  static uint64_t GetCapacity (void);
+  /**
+   * Return the free blocks of the calling thread, and those of the
+   * threads which have exited, to the heap.
+   */
+  static void Clear (void);
+
+  /**
+   * Print the counters and hit rate of each part.
+   *
+   * \param [in,out] os The output stream.
+   */
+  static void Print (std::ostream &os);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_H */
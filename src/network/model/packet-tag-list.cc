@@ -24,16 +24,118 @@
 */
 
 #include "packet-tag-list.h"
+#include "packet-pool.h"
 #include "tag-buffer.h"
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <atomic>
 #include <cstring>
+#include <mutex>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+namespace {
+
+/**
+ * \ingroup packet
+ * The slot of each tag TypeId, indexed by uid, plus one, or zero if
+ * the TypeId has no slot yet.
+ *
+ * The slots are shared by all the threads, since the slot bits of a
+ * packet must mean the same TypeId in each thread, so the table has
+ * room for every uid and is read without a lock; the slots are given
+ * under g_slotsMutex.
+ */
+std::atomic<uint8_t> g_slots[1 << 16];
+/**
+ * \ingroup packet
+ * The number of slots given so far, protected by g_slotsMutex.
+ */
+uint8_t g_nSlots = 0;
+/**
+ * \ingroup packet
+ * Protects the assignment of the slots.
+ */
+std::mutex g_slotsMutex;
+/**
+ * \ingroup packet
+ * The number of bytes of the header of an inline tag: the uid of its
+ * TypeId and its size.
+ */
+const uint32_t g_inlineHeader = 3;
+
+} // unnamed namespace
+
+void *
+PacketTagList::TagData::operator new (size_t size)
+{
+  NS_ASSERT (size == sizeof (struct TagData));
+  uint32_t blockSize = size;
+  return PacketPool::Allocate (PacketPool::TAGS, blockSize);
+}
+
+void
+PacketTagList::TagData::operator delete (void *p)
+{
+  PacketPool::Release (PacketPool::TAGS, p, sizeof (struct TagData));
+}
+
+uint64_t
+PacketTagList::GetSlot (TypeId tid)
+{
+  uint16_t uid = tid.GetUid ();
+  uint8_t slot = g_slots[uid].load (std::memory_order_relaxed);
+  if (slot == 0)
+    {
+      std::lock_guard<std::mutex> lock (g_slotsMutex);
+      slot = g_slots[uid].load (std::memory_order_relaxed);
+      if (slot == 0)
+        {
+          // the last slot is shared by all the TypeIds past the 63rd.
+          g_nSlots = std::min (g_nSlots + 1, 64);
+          slot = g_nSlots;
+          g_slots[uid].store (slot, std::memory_order_relaxed);
+          NS_LOG_LOGIC ("slot " << (uint32_t)slot - 1 << " for " << tid);
+        }
+    }
+  return ((uint64_t)1) << (slot - 1);
+}
+
+uint8_t *
+PacketTagList::FindInline (TypeId tid) const
+{
+  uint16_t uid = tid.GetUid ();
+  for (uint32_t i = 0; i < m_inlineUsed; i += g_inlineHeader + m_inline[i + 2])
+    {
+      if ((m_inline[i] | (m_inline[i + 1] << 8)) == uid)
+        {
+          return const_cast<uint8_t *> (&m_inline[i]);
+        }
+    }
+  return 0;
+}
+
+void
+PacketTagList::RemoveInline (uint8_t *current)
+{
+  uint32_t size = g_inlineHeader + current[2];
+  uint32_t offset = current - m_inline;
+  std::memmove (current, current + size, m_inlineUsed - offset - size);
+  m_inlineUsed -= size;
+}
+
+const uint8_t *
+PacketTagList::ReadInline (const uint8_t *current, TypeId &tid, uint32_t &size)
+{
+  tid.SetUid (current[0] | (current[1] << 8));
+  size = current[2];
+  return current + g_inlineHeader;
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -157,7 +259,30 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint64_t slot = GetSlot (tid);
+  if ((m_slots & slot) == 0)
+    {
+      return false;
+    }
+  bool found;
+  uint8_t *current = FindInline (tid);
+  if (current != 0)
+    {
+      tag.Deserialize (TagBuffer (current + g_inlineHeader,
+                                  current + g_inlineHeader + current[2]));
+      RemoveInline (current);
+      found = true;
+    }
+  else
+    {
+      found = COWTraverse (tag, &PacketTagList::RemoveWriter);
+    }
+  if (found && slot != (((uint64_t)1) << 63))
+    {
+      m_slots &= ~slot;
+    }
+  return found;
 }
 
 // COWWriter implementing Remove
@@ -196,6 +321,27 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+  TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_slots & GetSlot (tid)) == 0)
+    {
+      Add (tag);
+      return false;
+    }
+  uint8_t *current = FindInline (tid);
+  if (current != 0)
+    {
+      if (current[2] == tag.GetSerializedSize ())
+        {
+          tag.Serialize (TagBuffer (current + g_inlineHeader,
+                                    current + g_inlineHeader + current[2]));
+        }
+      else
+        {
+          RemoveInline (current);
+          Add (tag);
+        }
+      return true;
+    }
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
@@ -244,20 +390,59 @@ void
 PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
   // ensure this id was not yet added
+  NS_ASSERT_MSG (FindInline (tid) == 0, "Error: cannot add the same kind of tag twice.");
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
+      NS_ASSERT_MSG (cur->tid != tid, "Error: cannot add the same kind of tag twice.");
+    }
+  PacketTagList *list = const_cast<PacketTagList *> (this);
+  list->m_slots |= GetSlot (tid);
+  uint32_t size = tag.GetSerializedSize ();
+  NS_ASSERT (size <= TagData::MAX_SIZE);
+  if (m_next == 0 && m_inlineUsed + g_inlineHeader + size <= INLINE_SIZE)
+    {
+      // store the tag inline, before the older ones.
+      std::memmove (list->m_inline + g_inlineHeader + size, m_inline, m_inlineUsed);
+      list->m_inline[0] = tid.GetUid () & 0xff;
+      list->m_inline[1] = tid.GetUid () >> 8;
+      list->m_inline[2] = size;
+      tag.Serialize (TagBuffer (list->m_inline + g_inlineHeader,
+                                list->m_inline + g_inlineHeader + size));
+      list->m_inlineUsed += g_inlineHeader + size;
+      return;
     }
   struct TagData * head = new struct TagData ();
   head->count = 1;
   head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
+  head->tid = tid;
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
+  tag.Serialize (TagBuffer (head->data, head->data + size));
+
+  list->m_next = head;
+}
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+PacketTagList
+PacketTagList::CreateFullCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  PacketTagList copy;
+  copy.m_slots = m_slots;
+  copy.m_inlineUsed = m_inlineUsed;
+  std::memcpy (copy.m_inline, m_inline, m_inlineUsed);
+  struct TagData **prevNext = &copy.m_next;
+  for (const struct TagData *cur = m_next; cur != 0; cur = cur->next)
+    {
+      struct TagData *data = new struct TagData ();
+      std::memcpy (data->data, cur->data, TagData::MAX_SIZE);
+      data->tid = cur->tid;
+      data->count = 1;
+      data->next = 0;
+      *prevNext = data;
+      prevNext = &data->next;
+    }
+  return copy;
 }
 
 bool
@@ -265,6 +450,17 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_slots & GetSlot (tid)) == 0)
+    {
+      return false;
+    }
+  uint8_t *current = FindInline (tid);
+  if (current != 0)
+    {
+      tag.Deserialize (TagBuffer (current + g_inlineHeader,
+                                  current + g_inlineHeader + current[2]));
+      return true;
+    }
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
@@ -284,5 +480,17 @@ PacketTagList::Head (void) const
   return m_next;
 }
 
+const uint8_t *
+PacketTagList::InlineBegin (void) const
+{
+  return m_inline;
+}
+
+const uint8_t *
+PacketTagList::InlineEnd (void) const
+{
+  return m_inline + m_inlineUsed;
+}
+
 } /* namespace ns3 */
 
@@ -26,6 +26,7 @@
 */
 
 #include <stdint.h>
+#include <cstring>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -124,6 +125,25 @@ class Tag;
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
  *
+ * \par <b> Inline tags: </b>
+ * \n
+ * The first tags added to a list, up to INLINE_SIZE bytes, are not
+ * stored in the tree at all, but in the list itself, so that adding
+ * them allocates nothing: each is stored as the uid of its TypeId
+ * (two bytes), its serialized size (one byte) and its serialized
+ * bytes, the most recent first.  They are copied with the list.  Once
+ * a tag does not fit, it and the following ones are added to the tree,
+ * so that the tags of the tree are always more recent than the inline
+ * ones.
+ *
+ * \par <b> Slots: </b>
+ * \n
+ * Each tag TypeId is given a slot, a bit of a 64-bit mask, when it is
+ * first added to a list; past the 63rd TypeId, the others share the
+ * last slot.  Each list holds the mask of the slots of its tags, so
+ * that #Peek, #Remove and #Replace of a tag which is not in the list,
+ * the most frequent case, return without a search.
+ *
  * This documentation entitles the original author to a free beer.
  */
 class PacketTagList 
@@ -165,8 +185,29 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocate a TagData from the PacketPool.
+     * \param [in] size The size of the TagData.
+     * \returns The memory of the TagData.
+     */
+    static void *operator new (size_t size);
+    /**
+     * Release a TagData to the PacketPool.
+     * \param [in] p The memory of the TagData.
+     */
+    static void operator delete (void *p);
   };  /* struct TagData */
 
+  /**
+   * The size of the inline area, in bytes, which holds the first tags
+   * of the list.
+   */
+  enum InlineSize_e
+  {
+    INLINE_SIZE = 48
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -233,12 +274,58 @@ public:
    * Remove all tags from this list (up to the first merge).
    */
   inline void RemoveAll (void);
+  /**
+   * Create a copy of this list which shares no TagData with it.
+   *
+   * \returns The copy.
+   */
+  PacketTagList CreateFullCopy (void) const;
   /**
    * \returns pointer to head of tag list
    */
   const struct PacketTagList::TagData *Head (void) const;
+  /**
+   * \returns pointer to the first inline tag, which is older than the
+   *          tags of the tree.
+   */
+  const uint8_t *InlineBegin (void) const;
+  /**
+   * \returns pointer past the last inline tag.
+   */
+  const uint8_t *InlineEnd (void) const;
+  /**
+   * Read the header of an inline tag.
+   *
+   * \param [in] current Pointer to the inline tag.
+   * \param [out] tid The type of the tag.
+   * \param [out] size The size of the serialized tag.
+   * \returns Pointer to the serialized tag, which is followed by the
+   *          next inline tag.
+   */
+  static const uint8_t *ReadInline (const uint8_t *current, TypeId &tid, uint32_t &size);
 
 private:
+  /**
+   * Get the slot of a tag type, assigning it on first use.
+   *
+   * \param [in] tid The tag type.
+   * \returns The bit of the mask of the slot.
+   */
+  static uint64_t GetSlot (TypeId tid);
+  /**
+   * Find an inline tag.
+   *
+   * \param [in] tid The tag type to find.
+   * \returns Pointer to the inline tag, or zero if not found.
+   */
+  uint8_t *FindInline (TypeId tid) const;
+  /**
+   * Remove an inline tag.
+   *
+   * \param [in] current Pointer to the inline tag.
+   */
+  void RemoveInline (uint8_t *current);
+
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -291,6 +378,18 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+  /**
+   * The slots of the tags of the list
+   */
+  uint64_t m_slots;
+  /**
+   * The number of bytes of the inline tags
+   */
+  uint8_t m_inlineUsed;
+  /**
+   * The inline tags
+   */
+  uint8_t m_inline[INLINE_SIZE];
 };
 
 } // namespace ns3
@@ -302,13 +401,18 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_next (),
+    m_slots (0),
+    m_inlineUsed (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_next (o.m_next),
+    m_slots (o.m_slots),
+    m_inlineUsed (o.m_inlineUsed)
 {
+  std::memcpy (m_inline, o.m_inline, m_inlineUsed);
   if (m_next != 0)
     {
       m_next->count++;
@@ -319,16 +423,22 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
-  RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  if (m_next != o.m_next)
     {
-      m_next->count++;
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0) 
+        {
+          m_next->count++;
+        }
     }
+  m_slots = o.m_slots;
+  m_inlineUsed = o.m_inlineUsed;
+  std::memcpy (m_inline, o.m_inline, m_inlineUsed);
   return *this;
 }
 
@@ -359,6 +469,8 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+  m_slots = 0;
+  m_inlineUsed = 0;
 }
 
 } // namespace ns3
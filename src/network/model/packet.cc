@@ -18,9 +18,12 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "packet.h"
+#include "packet-pool.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/memory-accounting.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include <string>
 #include <cstdarg>
 
@@ -28,7 +31,10 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+std::atomic<uint32_t> Packet::m_globalUid (0);
+
+/** The number of packet uids taken at once by a thread. */
+static const uint32_t g_uidBlock = 1024;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -81,43 +87,70 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const PacketTagList &list)
+  : m_current (list.Head ()),
+    m_inline (list.InlineBegin ()),
+    m_inlineEnd (list.InlineEnd ())
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != 0 || m_inline != m_inlineEnd;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  if (m_current != 0)
+    {
+      const struct PacketTagList::TagData *prev = m_current;
+      m_current = m_current->next;
+      return PacketTagIterator::Item (prev->tid, prev->data, PacketTagList::TagData::MAX_SIZE);
+    }
+  TypeId tid;
+  uint32_t size;
+  const uint8_t *data = PacketTagList::ReadInline (m_inline, tid, size);
+  m_inline = data + size;
+  return PacketTagIterator::Item (tid, data, size);
 }
 
-PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
-  : m_data (data)
+PacketTagIterator::Item::Item (TypeId tid, const uint8_t *data, uint32_t size)
+  : m_tid (tid),
+    m_data (data),
+    m_size (size)
 {
 }
 TypeId
 PacketTagIterator::Item::GetTypeId (void) const
 {
-  return m_data->tid;
+  return m_tid;
 }
 void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
-  NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data
-                              + PacketTagList::TagData::MAX_SIZE));
+  NS_ASSERT (tag.GetInstanceTypeId () == m_tid);
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data,
+                              (uint8_t*)m_data + m_size));
 }
 
 
+/**
+ * \ingroup packet
+ * Account for a new packet in the MemoryAccounting, if enabled.
+ *
+ * \param [in] packet The packet.
+ */
+static void
+NotifyAllocate (const Packet *packet)
+{
+  if (MemoryAccounting::IsEnabled ())
+    {
+      static uint32_t category = MemoryAccounting::GetCategory ("ns3::Packet");
+      MemoryAccounting::NotifyAllocate (packet, category, sizeof (Packet));
+    }
+}
+
 Ptr<Packet> 
 Packet::Copy (void) const
 {
@@ -127,6 +160,48 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+uint32_t
+Packet::AllocateUid (void)
+{
+  static thread_local uint32_t next = 0;
+  static thread_local uint32_t end = 0;
+  if (next == end)
+    {
+      next = m_globalUid.fetch_add (g_uidBlock, std::memory_order_relaxed);
+      end = next + g_uidBlock;
+    }
+  return next++;
+}
+
+Ptr<Packet>
+Packet::CreateFullCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer buffer;
+  buffer.AddAtStart (m_buffer.GetSize ());
+  buffer.Begin ().Write (m_buffer.Begin (), m_buffer.End ());
+  ByteTagList byteTagList;
+  byteTagList.Add (m_byteTagList);
+  Ptr<Packet> copy = Ptr<Packet> (new Packet (buffer, byteTagList,
+                                              m_packetTagList.CreateFullCopy (),
+                                              m_metadata.CreateFullCopy ()), false);
+  if (m_nixVector)
+    {
+      copy->m_nixVector = m_nixVector->Copy ();
+    }
+  return copy;
+}
+
+Ptr<Packet>
+Packet::CopyForContext (uint32_t context) const
+{
+  if (MultithreadedSimulatorImpl::IsOtherPartition (context))
+    {
+      return CreateFullCopy ();
+    }
+  return Copy ();
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -137,10 +212,10 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
+  NotifyAllocate (this);
 }
 
 Packet::Packet (const Packet &o)
@@ -151,6 +226,26 @@ Packet::Packet (const Packet &o)
 {
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
+  NotifyAllocate (this);
+}
+
+Packet::~Packet ()
+{
+  MemoryAccounting::NotifyRelease (this);
+}
+
+void *
+Packet::operator new (size_t size)
+{
+  NS_ASSERT (size == sizeof (Packet));
+  uint32_t blockSize = size;
+  return PacketPool::Allocate (PacketPool::PACKET, blockSize);
+}
+
+void
+Packet::operator delete (void *p)
+{
+  PacketPool::Release (PacketPool::PACKET, p, sizeof (Packet));
 }
 
 Packet &
@@ -179,10 +274,10 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
+  NotifyAllocate (this);
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -193,6 +288,7 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
 {
   NS_ASSERT (magic);
   Deserialize (buffer, size);
+  NotifyAllocate (this);
 }
 
 Packet::Packet (uint8_t const*buffer, uint32_t size)
@@ -205,10 +301,10 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
+  NotifyAllocate (this);
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -222,6 +318,7 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_metadata (metadata),
     m_nixVector (0)
 {
+  NotifyAllocate (this);
 }
 
 Ptr<Packet>
@@ -881,7 +978,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList);
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -21,6 +21,7 @@
 #define PACKET_H
 
 #include <stdint.h>
+#include <atomic>
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -152,10 +153,14 @@ private:
     friend class PacketTagIterator;
     /**
      * Constructor
-     * \param data the data to copy.
+     * \param tid the type of the tag.
+     * \param data the serialized tag.
+     * \param size the size of the serialized tag.
      */
-    Item (const struct PacketTagList::TagData *data);
-    const struct PacketTagList::TagData *m_data; //!< the tag data
+    Item (TypeId tid, const uint8_t *data, uint32_t size);
+    TypeId m_tid;           //!< the type of the tag
+    const uint8_t *m_data;  //!< the serialized tag
+    uint32_t m_size;        //!< the size of the serialized tag
   };
   /**
    * \returns true if calling Next is safe, false otherwise.
@@ -169,10 +174,12 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the tags of the packet
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList &list);
+  const struct PacketTagList::TagData *m_current;  //!< actual position over the tree of tags in a packet
+  const uint8_t *m_inline;     //!< actual position over the inline tags, once the tree is done
+  const uint8_t *m_inlineEnd;  //!< the end of the inline tags
 };
 
 /**
@@ -238,12 +245,27 @@ public:
    * \param o object to copy
    */
   Packet (const Packet &o);
+  /**
+   * \brief Destructor
+   */
+  ~Packet ();
   /**
    * \brief Basic assignment
    * \param o object to copy
    * \return the copied object
    */
   Packet &operator = (const Packet &o);
+  /**
+   * \brief Allocate a packet from the PacketPool.
+   * \param size the size of the packet
+   * \returns the memory of the packet
+   */
+  static void *operator new (size_t size);
+  /**
+   * \brief Release a packet to the PacketPool.
+   * \param p the memory of the packet
+   */
+  static void operator delete (void *p);
   /**
    * \brief Create a packet with a zero-filled payload.
    *
@@ -424,6 +446,31 @@ public:
    */
   Ptr<Packet> Copy (void) const;
 
+  /**
+   * \brief performs a full copy of the packet.
+   *
+   * \returns a copy of the packet which shares no buffer, tag or
+   * metadata with the original packet.
+   *
+   * The copies made by Copy share reference counts which are not
+   * atomic, so they must stay in the same thread.  A full copy can be
+   * handed over to another thread.
+   */
+  Ptr<Packet> CreateFullCopy (void) const;
+
+  /**
+   * \brief copy the packet for an event of another context.
+   *
+   * \param [in] context the context of the event which gets the copy.
+   * \returns a full copy of the packet if the context belongs to
+   * another partition of a MultithreadedSimulatorImpl running in
+   * parallel, and a COW copy otherwise.
+   *
+   * The channels hand their packets over to the receiving devices
+   * with this method.
+   */
+  Ptr<Packet> CopyForContext (uint32_t context) const;
+
   /**
    * \brief Returns the packet's Uid.
    *
@@ -727,7 +774,17 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * \brief Allocate a packet uid.
+   *
+   * The threads take the uids in blocks, so that they rarely share the
+   * global counter.
+   *
+   * \returns the uid
+   */
+  static uint32_t AllocateUid (void);
+
+  static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
 };
 
 /**
@@ -21,7 +21,13 @@
 #include "ns3/buffer.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
+#include "ns3/memory-accounting.h"
 #include "ns3/test.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -361,6 +367,270 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+class BufferMemoryAccountingTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferMemoryAccountingTest ();
+};
+
+BufferMemoryAccountingTest::BufferMemoryAccountingTest ()
+  : TestCase ("Buffer memory accounting") {
+}
+
+void
+BufferMemoryAccountingTest::DoRun (void)
+{
+  MemoryAccounting::Enable ();
+  MemoryAccounting::Entry before = MemoryAccounting::GetUsage ("ns3::Buffer");
+  {
+    // larger than any buffer of the free list.
+    Buffer buffer;
+    buffer.AddAtStart (1 << 22);
+    MemoryAccounting::Entry usage = MemoryAccounting::GetUsage ("ns3::Buffer");
+    NS_TEST_EXPECT_MSG_EQ (usage.count, before.count + 1, "the data of the buffer should be accounted for");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ (usage.bytes, before.bytes + (1 << 22), "the size of the data");
+  }
+  MemoryAccounting::Disable ();
+}
+//-----------------------------------------------------------------------------
+class BufferSliceTest : public TestCase {
+private:
+  Buffer Fill (uint32_t size, uint8_t seed, std::vector<uint8_t> &model);
+  void Check (const Buffer &buffer, const std::vector<uint8_t> &model, std::string msg);
+public:
+  virtual void DoRun (void);
+  BufferSliceTest ();
+};
+
+BufferSliceTest::BufferSliceTest ()
+  : TestCase ("Buffer payload shared as slices") {
+}
+
+Buffer
+BufferSliceTest::Fill (uint32_t size, uint8_t seed, std::vector<uint8_t> &model)
+{
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < size; j++)
+    {
+      uint8_t byte = seed + j * 7;
+      i.WriteU8 (byte);
+      model.push_back (byte);
+    }
+  return buffer;
+}
+
+void
+BufferSliceTest::Check (const Buffer &buffer, const std::vector<uint8_t> &model, std::string msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), model.size (), msg << ": size");
+  Buffer::Iterator i = buffer.Begin ();
+  for (uint32_t j = 0; j < model.size (); j++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t)i.ReadU8 (), (uint32_t)model[j], msg << ": byte " << j);
+    }
+  i = buffer.Begin ();
+  for (uint32_t j = 0; j + 4 <= model.size (); j += 4)
+    {
+      uint32_t expected = (model[j] << 24) | (model[j + 1] << 16) | (model[j + 2] << 8) | model[j + 3];
+      NS_TEST_ASSERT_MSG_EQ (i.ReadNtohU32 (), expected, msg << ": word " << j);
+    }
+  std::vector<uint8_t> copy (model.size () + 1);
+  NS_TEST_ASSERT_MSG_EQ (buffer.CopyData (&copy[0], model.size ()), model.size (), msg << ": CopyData size");
+  NS_TEST_ASSERT_MSG_EQ (memcmp (&copy[0], &model[0], model.size ()), 0, msg << ": CopyData");
+  std::ostringstream oss;
+  buffer.CopyData (&oss, model.size ());
+  NS_TEST_ASSERT_MSG_EQ ((oss.str () == std::string (model.begin (), model.end ())), true, msg << ": CopyData to a stream");
+  Buffer other;
+  other.AddAtStart (model.size ());
+  other.Begin ().Write (buffer.Begin (), buffer.End ());
+  NS_TEST_ASSERT_MSG_EQ (memcmp (other.PeekData (), &model[0], model.size ()), 0, msg << ": Iterator::Write");
+  // the serialized form is made of the size of the zero area, then of
+  // the sizes and bytes of the data before and after it, or, flagged
+  // by the high bit, of the number of zero slices, then of the size
+  // and bytes of each run of data, separated by the sizes of the zero
+  // slices.
+  uint32_t serializedSize = buffer.GetSerializedSize ();
+  std::vector<uint32_t> serialized ((serializedSize + 3) / 4);
+  NS_TEST_ASSERT_MSG_EQ (buffer.Serialize (reinterpret_cast<uint8_t *> (&serialized[0]), serializedSize), 1,
+                         msg << ": Serialize");
+  std::string bytes;
+  const uint32_t *p = &serialized[0];
+  uint32_t zeroes = *p++;
+  bool sliced = (zeroes & 0x80000000) != 0;
+  uint32_t runs = sliced ? (zeroes & 0x7fffffff) + 1 : 2;
+  for (uint32_t j = 0; j < runs; j++)
+    {
+      uint32_t length = *p++;
+      bytes += std::string ((const char *)p, length);
+      p += (length + 3) / 4;
+      if (!sliced && j == 0)
+        {
+          bytes += std::string (zeroes, 0);
+        }
+      else if (sliced && j + 1 < runs)
+        {
+          bytes += std::string (*p++, 0);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ ((p - &serialized[0]) * 4, serializedSize, msg << ": serialized size");
+  NS_TEST_ASSERT_MSG_EQ ((bytes == std::string (model.begin (), model.end ())), true, msg << ": serialized bytes");
+  // the size to deserialize includes that of the size of the buffer.
+  Buffer deserialized (0, false);
+  NS_TEST_ASSERT_MSG_EQ (deserialized.Deserialize (reinterpret_cast<uint8_t *> (&serialized[0]), serializedSize + 4), 1,
+                         msg << ": Deserialize");
+  NS_TEST_ASSERT_MSG_EQ (deserialized.GetSize (), model.size (), msg << ": deserialized size");
+  std::vector<uint8_t> restored (model.size () + 1);
+  deserialized.CopyData (&restored[0], model.size ());
+  NS_TEST_ASSERT_MSG_EQ (memcmp (&restored[0], &model[0], model.size ()), 0, msg << ": deserialized bytes");
+  Buffer flat = buffer;
+  NS_TEST_ASSERT_MSG_EQ (memcmp (flat.PeekData (), &model[0], model.size ()), 0, msg << ": PeekData");
+}
+
+void
+BufferSliceTest::DoRun (void)
+{
+  // concatenation across the slices, with headers and trailers.
+  std::vector<uint8_t> model;
+  Buffer buffer = Fill (1000, 1, model);
+  std::vector<uint8_t> tail;
+  Buffer other = Fill (1501, 2, tail);
+  buffer.AddAtEnd (other);
+  model.insert (model.end (), tail.begin (), tail.end ());
+  Check (buffer, model, "concatenation");
+  tail.clear ();
+  Buffer zeroes (700);
+  zeroes.AddAtStart (3);
+  zeroes.Begin ().WriteU8 (0x55, 3);
+  buffer.AddAtEnd (zeroes);
+  model.insert (model.end (), 3, 0x55);
+  model.insert (model.end (), 700, 0);
+  Check (buffer, model, "virtual zeroes");
+  buffer.AddAtStart (20);
+  buffer.Begin ().WriteU8 (0x11, 20);
+  model.insert (model.begin (), 20, 0x11);
+  buffer.AddAtEnd (4);
+  Buffer::Iterator i = buffer.End ();
+  i.Prev (4);
+  i.WriteHtonU32 (0xdeadbeef);
+  model.push_back (0xde);
+  model.push_back (0xad);
+  model.push_back (0xbe);
+  model.push_back (0xef);
+  Check (buffer, model, "header and trailer");
+  buffer.RemoveAtStart (1100);
+  model.erase (model.begin (), model.begin () + 1100);
+  buffer.RemoveAtEnd (750);
+  model.erase (model.end () - 750, model.end ());
+  Check (buffer, model, "removal");
+
+  // fragments of a shared buffer get their own headers without
+  // copying the payload, nor changing the original.
+  std::vector<uint8_t> whole;
+  Buffer packet = Fill (9000, 3, whole);
+  for (uint32_t offset = 0; offset < 9000; offset += 1480)
+    {
+      uint32_t length = std::min (1480u, 9000 - offset);
+      Buffer fragment = packet.CreateFragment (offset, length);
+      fragment.AddAtStart (20);
+      fragment.Begin ().WriteU8 (0x45, 20);
+      std::vector<uint8_t> expected (20, 0x45);
+      expected.insert (expected.end (), whole.begin () + offset, whole.begin () + offset + length);
+      Check (fragment, expected, "fragment");
+    }
+  Check (packet, whole, "fragmented buffer");
+
+  // many small buffers appended to a large one.
+  model.clear ();
+  buffer = Fill (2000, 4, model);
+  for (uint32_t j = 0; j < 200; j++)
+    {
+      Buffer small = Fill (300, j, model);
+      buffer.AddAtEnd (small);
+    }
+  Check (buffer, model, "many appends");
+
+  // the payload is shared rather than copied: no buffer as large as
+  // the result is allocated.
+  MemoryAccounting::Enable ();
+  {
+    Buffer a;
+    a.AddAtStart (1 << 21);
+    Buffer b;
+    b.AddAtStart (1 << 21);
+    MemoryAccounting::Entry before = MemoryAccounting::GetUsage ("ns3::Buffer");
+    a.AddAtEnd (b);
+    a.AddAtStart (20);
+    a.AddAtEnd (20);
+    MemoryAccounting::Entry after = MemoryAccounting::GetUsage ("ns3::Buffer");
+    NS_TEST_EXPECT_MSG_EQ (a.GetSize (), (1 << 22) + 40, "the size of the concatenation");
+    NS_TEST_EXPECT_MSG_LT (after.bytes, before.bytes + (1 << 20), "the payload should not be copied");
+  }
+  MemoryAccounting::Disable ();
+}
+//-----------------------------------------------------------------------------
+class BufferVirtualPayloadTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferVirtualPayloadTest ();
+};
+
+BufferVirtualPayloadTest::BufferVirtualPayloadTest ()
+  : TestCase ("Buffer zero payloads never allocated") {
+}
+
+void
+BufferVirtualPayloadTest::DoRun (void)
+{
+  MemoryAccounting::Enable ();
+  MemoryAccounting::Entry before = MemoryAccounting::GetUsage ("ns3::Buffer");
+  {
+    // segments of 1MB of zeroes with headers, concatenated beyond the
+    // compaction of the chain, and fragmented.
+    Buffer stream;
+    for (uint32_t j = 0; j < 100; j++)
+      {
+        Buffer segment (1 << 20);
+        segment.AddAtStart (40);
+        segment.Begin ().WriteU8 (j, 40);
+        stream.AddAtEnd (segment);
+        Buffer pad (3);
+        stream.AddAtEnd (pad);
+      }
+    NS_TEST_EXPECT_MSG_EQ (stream.GetSize (), 100 * ((1 << 20) + 43), "the size of the stream");
+    Buffer fragment = stream.CreateFragment (1000, 5 << 20);
+    fragment.AddAtStart (20);
+    fragment.Begin ().WriteU8 (0x45, 20);
+    Buffer::Iterator i = fragment.Begin ();
+    i.Next (20 + (1 << 20) + 43 - 1000);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)i.ReadU8 (), 1, "the header of the second segment");
+
+    // streamed as by the pcap writers.
+    std::ostringstream oss;
+    fragment.CopyData (&oss, fragment.GetSize ());
+    NS_TEST_EXPECT_MSG_EQ (oss.str ().size (), fragment.GetSize (), "the streamed size");
+
+    // serialized as by the distributed simulations.
+    uint32_t serializedSize = stream.GetSerializedSize ();
+    NS_TEST_EXPECT_MSG_LT (serializedSize, 100 * 64, "the zero slices are serialized as their size");
+    std::vector<uint32_t> serialized ((serializedSize + 3) / 4);
+    NS_TEST_EXPECT_MSG_EQ (stream.Serialize (reinterpret_cast<uint8_t *> (&serialized[0]), serializedSize), 1,
+                           "Serialize");
+    Buffer deserialized (0, false);
+    NS_TEST_EXPECT_MSG_EQ (deserialized.Deserialize (reinterpret_cast<uint8_t *> (&serialized[0]), serializedSize + 4), 1,
+                           "Deserialize");
+    NS_TEST_EXPECT_MSG_EQ (deserialized.GetSize (), stream.GetSize (), "the deserialized size");
+    i = deserialized.Begin ();
+    i.Next (99 * ((1 << 20) + 43));
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)i.ReadU8 (), 99, "the header of the last segment");
+
+    MemoryAccounting::Entry usage = MemoryAccounting::GetUsage ("ns3::Buffer");
+    NS_TEST_EXPECT_MSG_LT (usage.bytes, before.bytes + (1 << 20), "the zeroes should never be allocated");
+  }
+  MemoryAccounting::Disable ();
+}
+//-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +641,9 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferMemoryAccountingTest, TestCase::QUICK);
+  AddTestCase (new BufferSliceTest, TestCase::QUICK);
+  AddTestCase (new BufferVirtualPayloadTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -19,6 +19,7 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -75,6 +76,31 @@ DropTailQueueTestCase::DoRun (void)
 
   item = queue->Dequeue ();
   NS_TEST_EXPECT_MSG_EQ ((item == 0), true, "There are really no packets in there");
+
+  // the items keep their order as the ring wraps around and grows.
+  queue->SetAttribute ("MaxPackets", UintegerValue (100));
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      packets.push_back (Create<Packet> ());
+    }
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      queue->Enqueue (Create<QueueItem> (packets[i]));
+      if (i % 3 == 2)
+        {
+          item = queue->Dequeue ();
+          NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), packets[next++]->GetUid (), "The packets should stay in order");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->Peek ()->GetPacket ()->GetUid (), packets[next]->GetUid (), "The first packet should be peeked");
+  while (next < 40)
+    {
+      item = queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (item->GetPacket ()->GetUid (), packets[next++]->GetUid (), "The packets should stay in order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "There should be no packets in there");
 }
 
 static class DropTailQueueTestSuite : public TestSuite
@@ -821,6 +821,79 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // copies share their items until they diverge.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_TRAILER (p, 2);
+  p1 = p->Copy ();
+  ADD_HEADER (p1, 3);
+  REM_TRAILER (p1, 2);
+  ADD_TRAILER (p1, 4);
+  REM_HEADER (p, 1);
+  ADD_TRAILER (p, 5);
+  CHECK_HISTORY (p, 3, 10, 2, 5);
+  CHECK_HISTORY (p1, 4, 3, 1, 10, 4);
+  p2 = p1->Copy ();
+  REM_HEADER (p2, 3);
+  REM_HEADER (p2, 1);
+  REM_TRAILER (p2, 4);
+  ADD_HEADER (p2, 6);
+  ADD_TRAILER (p2, 7);
+  CHECK_HISTORY (p2, 3, 6, 10, 7);
+  CHECK_HISTORY (p1, 4, 3, 1, 10, 4);
+  CHECK_HISTORY (p, 3, 10, 2, 5);
+
+  // RemoveAtEnd splits the items of a packet without back chain.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  ADD_HEADER (p, 3);
+  p1 = p->Copy ();
+  p->RemoveAtEnd (4);
+  CHECK_HISTORY (p, 4, 3, 2, 1, 6);
+  CHECK_HISTORY (p1, 4, 3, 2, 1, 10);
+  p->RemoveAtEnd (7);
+  CHECK_HISTORY (p, 2, 3, 2);
+  p->RemoveAtEnd (2);
+  CHECK_HISTORY (p, 1, 3);
+  CHECK_HISTORY (p1, 4, 3, 2, 1, 10);
+
+  // and so does RemoveTrailer, when the trailer is in the front chain.
+  p = Create<Packet> (10);
+  ADD_TRAILER (p, 4);
+  ADD_TRAILER (p, 5);
+  uint32_t size = p->GetSerializedSize ();
+  buf = new uint8_t[size];
+  p->Serialize (buf, size);
+  // all the items of a deserialized packet are in its back chain.
+  p1 = Create<Packet> (buf, size, true);
+  delete [] buf;
+  p1->RemoveAtStart (2);
+  CHECK_HISTORY (p1, 3, 8, 4, 5);
+  REM_TRAILER (p1, 5);
+  CHECK_HISTORY (p1, 2, 8, 4);
+  REM_TRAILER (p1, 4);
+  CHECK_HISTORY (p1, 1, 8);
+  CHECK_HISTORY (p, 3, 10, 4, 5);
+
+  // the items are released with the last packet which holds them.
+  p = 0;
+  p1 = 0;
+  p2 = 0;
+  p3 = 0;
+  uint32_t used = PacketMetadata::GetUsedNodes ();
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_TRAILER (p, 2);
+  p1 = p->Copy ();
+  ADD_HEADER (p1, 3);
+  p1->RemoveAtEnd (1);
+  NS_TEST_EXPECT_MSG_EQ (PacketMetadata::GetUsedNodes (), used + 5, "the copies should share the items they have in common");
+  p = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketMetadata::GetUsedNodes (), used + 4, "the copy should keep the items it shares");
+  p1 = 0;
+  NS_TEST_EXPECT_MSG_EQ (PacketMetadata::GetUsedNodes (), used, "the items should be released with the last copy");
 }
 //-----------------------------------------------------------------------------
 class PacketMetadataTestSuite : public TestSuite
@@ -0,0 +1,305 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/packet-pool.h"
+#include "ns3/header.h"
+#include "ns3/tag.h"
+#include <deque>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+class ForwardingHeader : public Header
+{
+public:
+  ForwardingHeader () : m_ttl (64) {}
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("PacketPoolTest:ForwardingHeader")
+      .SetParent<Header> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<ForwardingHeader> ();
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 20;
+  }
+  virtual void Serialize (Buffer::Iterator i) const
+  {
+    i.WriteU8 (m_ttl);
+    for (uint32_t j = 1; j < 20; j++)
+      {
+        i.WriteU8 (j);
+      }
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator i)
+  {
+    m_ttl = i.ReadU8 ();
+    i.Next (19);
+    return 20;
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "ttl=" << (uint32_t)m_ttl;
+  }
+  uint8_t m_ttl;
+};
+
+template <int N>
+class ForwardingTag : public Tag
+{
+public:
+  ForwardingTag () : m_data (0) {}
+  static TypeId GetTypeId (void)
+  {
+    std::ostringstream oss;
+    oss << "PacketPoolTest:ForwardingTag<" << N << ">";
+    static TypeId tid = TypeId (oss.str ().c_str ())
+      .SetParent<Tag> ()
+      .SetGroupName ("Network")
+      .HideFromDocumentation ()
+      .AddConstructor<ForwardingTag<N> > ();
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 20;
+  }
+  virtual void Serialize (TagBuffer buf) const
+  {
+    buf.WriteU32 (m_data);
+    for (uint32_t i = 4; i < 20; i++)
+      {
+        buf.WriteU8 (N);
+      }
+  }
+  virtual void Deserialize (TagBuffer buf)
+  {
+    m_data = buf.ReadU32 ();
+    for (uint32_t i = 4; i < 20; i++)
+      {
+        buf.ReadU8 ();
+      }
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << m_data;
+  }
+  uint32_t m_data;
+};
+
+} // unnamed namespace
+
+class PacketPoolForwardingTest : public TestCase
+{
+public:
+  PacketPoolForwardingTest ();
+  virtual void DoRun (void);
+  void Forward (uint32_t packets);
+  std::deque<Ptr<Packet> > m_queue;
+  uint32_t m_sent;
+  uint32_t m_errors;
+};
+
+PacketPoolForwardingTest::PacketPoolForwardingTest ()
+  : TestCase ("Check that the packets of a forwarding path stop allocating once the pool is warm")
+{
+}
+
+void
+PacketPoolForwardingTest::Forward (uint32_t packets)
+{
+  for (uint32_t i = 0; i < packets; i++)
+    {
+      // a source creates a packet and tags it.
+      Ptr<Packet> p = Create<Packet> (1000 + i % 3 * 200);
+      ForwardingHeader header;
+      p->AddHeader (header);
+      ForwardingTag<1> t1;
+      ForwardingTag<2> t2;
+      ForwardingTag<3> t3;
+      t1.m_data = m_sent++;
+      p->AddPacketTag (t1);
+      p->AddPacketTag (t2);
+      p->AddPacketTag (t3);
+      p->AddByteTag (t1);
+      p->AddByteTag (t2);
+      p->AddByteTag (t3);
+      m_queue.push_back (p);
+
+      // a router forwards the oldest queued packet: it is copied as
+      // by a trace, and its header is rewritten.
+      if (m_queue.size () > 50)
+        {
+          Ptr<Packet> q = m_queue.front ();
+          m_queue.pop_front ();
+          Ptr<Packet> copy = q->Copy ();
+          copy->RemoveHeader (header);
+          header.m_ttl--;
+          copy->AddHeader (header);
+          ForwardingTag<1> tag;
+          if (!copy->RemovePacketTag (tag) || tag.m_data + m_queue.size () + 1 != m_sent)
+            {
+              m_errors++;
+            }
+          tag.m_data++;
+          copy->AddPacketTag (tag);
+          Ptr<Packet> fragment = copy->CreateFragment (0, 500);
+          fragment->AddAtEnd (copy->CreateFragment (500, copy->GetSize () - 500));
+          if (fragment->GetSize () != q->GetSize ())
+            {
+              m_errors++;
+            }
+        }
+    }
+}
+
+void
+PacketPoolForwardingTest::DoRun (void)
+{
+  m_sent = 0;
+  m_errors = 0;
+  Forward (1000);
+  PacketPool::ResetCounters ();
+  Forward (1000);
+  NS_TEST_EXPECT_MSG_EQ (m_errors, 0, "the packets should be forwarded unchanged");
+
+  static const char *names[] = { "Packet", "Buffer", "PacketMetadata", "Tags", "QueueItem" };
+  for (uint32_t i = 0; i < PacketPool::PARTS; i++)
+    {
+      enum PacketPool::Part part = static_cast<enum PacketPool::Part> (i);
+      PacketPool::Counters counters = PacketPool::GetCounters (part);
+      if (part != PacketPool::METADATA && part != PacketPool::QUEUE_ITEM)
+        {
+          // the metadata is disabled, and its nodes are allocated by
+          // blocks; the packets are not held by a Queue.
+          NS_TEST_EXPECT_MSG_GT_OR_EQ (counters.hits, 1000, "the " << names[i] << " should be allocated from the pool");
+        }
+      NS_TEST_EXPECT_MSG_EQ (counters.misses, 0, "the " << names[i] << " should not allocate once the pool is warm");
+      NS_TEST_EXPECT_MSG_EQ (counters.frees, 0, "the " << names[i] << " should not free once the pool is warm");
+      NS_TEST_EXPECT_MSG_EQ (PacketPool::GetHitRate (part), 1.0, "the hit rate of the " << names[i]);
+    }
+  std::ostringstream oss;
+  PacketPool::Print (oss);
+  NS_TEST_EXPECT_MSG_NE (oss.str ().find ("PacketMetadata hits="), std::string::npos,
+                         "the report should name the parts");
+
+  // without capacity, the pool does not keep any block.
+  uint64_t capacity = PacketPool::GetCapacity ();
+  PacketPool::SetCapacity (0);
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetFreeBytes (), 0, "the free blocks should be returned to the heap");
+  PacketPool::ResetCounters ();
+  Forward (100);
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetCounters (PacketPool::PACKET).hits, 0, "the pool is disabled");
+  NS_TEST_EXPECT_MSG_GT (PacketPool::GetCounters (PacketPool::PACKET).frees, 0, "the pool is disabled");
+  PacketPool::SetCapacity (capacity);
+  m_queue.clear ();
+  NS_TEST_EXPECT_MSG_GT (PacketPool::GetFreeBytes (), 0, "the released blocks should be kept again");
+}
+
+/**
+ * Create and release packets, in a thread of its own.
+ */
+struct CreatePackets
+{
+  /**
+   * \param [in] n The number of packets.
+   * \param [out] hits The hits of the pool of the thread.
+   */
+  CreatePackets (uint32_t n, uint64_t *hits)
+    : m_n (n),
+      m_hits (hits)
+  {
+  }
+  /** Create and release the packets. */
+  void operator () (void)
+  {
+    std::vector<Ptr<Packet> > packets;
+    for (uint32_t i = 0; i < m_n; i++)
+      {
+        packets.push_back (Create<Packet> (100));
+      }
+    packets.clear ();
+    *m_hits = PacketPool::GetCounters (PacketPool::PACKET).hits;
+  }
+  uint32_t m_n;     //!< The number of packets.
+  uint64_t *m_hits; //!< The hits of the pool of the thread.
+};
+
+/**
+ * Check that each thread has its own pool, and that the free blocks
+ * of a thread which exits are taken by the others.
+ */
+class PacketPoolThreadTest : public TestCase
+{
+public:
+  PacketPoolThreadTest ();
+private:
+  virtual void DoRun (void);
+};
+
+PacketPoolThreadTest::PacketPoolThreadTest ()
+  : TestCase ("Check the pools of the threads")
+{
+}
+
+void
+PacketPoolThreadTest::DoRun (void)
+{
+  PacketPool::Clear ();
+  PacketPool::ResetCounters ();
+  uint64_t hits = 1;
+  std::thread thread (CreatePackets (100, &hits));
+  thread.join ();
+  NS_TEST_EXPECT_MSG_EQ (hits, 0, "the thread should start with an empty pool");
+  NS_TEST_EXPECT_MSG_GT (PacketPool::GetFreeBytes (), 0, "the thread should leave its free blocks");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (PacketPool::GetCounters (PacketPool::PACKET).misses, 100,
+                               "the counters of the thread should be kept");
+
+  PacketPool::ResetCounters ();
+  Ptr<Packet> p = Create<Packet> (100);
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetCounters (PacketPool::PACKET).hits, 1,
+                         "the packet should reuse a block left by the thread");
+  NS_TEST_EXPECT_MSG_EQ (PacketPool::GetCounters (PacketPool::PACKET).misses, 0,
+                         "the packet should reuse a block left by the thread");
+}
+
+static class PacketPoolTestSuite : public TestSuite
+{
+public:
+  PacketPoolTestSuite ()
+    : TestSuite ("packet-pool", UNIT)
+  {
+    AddTestCase (new PacketPoolForwardingTest (), TestCase::QUICK);
+    AddTestCase (new PacketPoolThreadTest (), TestCase::QUICK);
+  }
+} g_packetPoolTestSuite;
@@ -28,6 +28,12 @@
 #include "ns3/packet-socket-server.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simple-channel.h"
+#include "ns3/checkpoint.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
@@ -114,6 +120,232 @@ PacketSocketAppsTest::DoRun (void)
 }
 
 
+class PacketSocketAppsCheckpointTest : public TestCase
+{
+  uint32_t m_receivedPacketNumber;
+  Time m_lastReceived;
+
+public:
+  virtual void DoRun (void);
+  PacketSocketAppsCheckpointTest ();
+
+  NodeContainer Build (void);
+  void ReceivePkt (Ptr<const Packet> packet, const Address &from);
+};
+
+PacketSocketAppsCheckpointTest::PacketSocketAppsCheckpointTest ()
+  : TestCase ("Packet Socket Apps checkpoint test")
+{
+  m_receivedPacketNumber = 0;
+}
+
+void PacketSocketAppsCheckpointTest::ReceivePkt (Ptr<const Packet> packet, const Address &from)
+{
+  m_receivedPacketNumber++;
+  m_lastReceived = Simulator::Now ();
+}
+
+NodeContainer
+PacketSocketAppsCheckpointTest::Build (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PacketSocketHelper packetSocket;
+  packetSocket.Install (nodes);
+
+  Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+  nodes.Get (0)->AddDevice (txDev);
+  Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+  nodes.Get (1)->AddDevice (rxDev);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (10)));
+  txDev->SetChannel (channel);
+  rxDev->SetChannel (channel);
+
+  PacketSocketAddress socketAddr;
+  socketAddr.SetSingleDevice (txDev->GetIfIndex ());
+  socketAddr.SetPhysicalAddress (rxDev->GetAddress ());
+  socketAddr.SetProtocol (1);
+
+  Ptr<PacketSocketClient> client = CreateObject<PacketSocketClient> ();
+  client->SetRemote (socketAddr);
+  client->SetAttribute ("PacketSize", UintegerValue (1000));
+  client->SetAttribute ("MaxPackets", UintegerValue (20));
+  client->SetAttribute ("Interval", TimeValue (Seconds (1)));
+  client->SetStartTime (Seconds (1));
+  client->SetStopTime (Seconds (15));
+  nodes.Get (0)->AddApplication (client);
+
+  Ptr<PacketSocketServer> server = CreateObject<PacketSocketServer> ();
+  server->TraceConnectWithoutContext ("Rx", MakeCallback (&PacketSocketAppsCheckpointTest::ReceivePkt, this));
+  server->SetLocal (socketAddr);
+  nodes.Get (1)->AddApplication (server);
+  return nodes;
+}
+
+void
+PacketSocketAppsCheckpointTest::DoRun (void)
+{
+  // the reference: the client sends from 1 to 14 s, and stops at 15 s.
+  Build ();
+  Simulator::Run ();
+  Simulator::Destroy ();
+  uint32_t reference = m_receivedPacketNumber;
+  Time referenceLast = m_lastReceived;
+  NS_TEST_ASSERT_MSG_EQ (reference, 14, "Number of packet received");
+
+  // the warm-up, saved while no packet is in flight.
+  m_receivedPacketNumber = 0;
+  NodeContainer nodes = Build ();
+  Checkpoint::Register (nodes.Get (0));
+  Checkpoint::Register (nodes.Get (1));
+  Simulator::Stop (Seconds (6.5));
+  Simulator::Run ();
+  std::ostringstream os;
+  Checkpoint::Save (os);
+  uint32_t warmUp = m_receivedPacketNumber;
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ (warmUp, 6, "Number of packet received in the warm-up");
+
+  // the replication: the same topology, built again and restored.
+  m_receivedPacketNumber = 0;
+  nodes = Build ();
+  Checkpoint::Register (nodes.Get (0));
+  Checkpoint::Register (nodes.Get (1));
+  std::istringstream is (os.str ());
+  Checkpoint::Restore (is);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (6.5), "the time of the checkpoint");
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (warmUp + m_receivedPacketNumber, reference, "the client should resume where it was saved");
+  NS_TEST_EXPECT_MSG_EQ (m_lastReceived, referenceLast, "the client should stop at the same time");
+  Simulator::Destroy ();
+}
+
+
+class PacketSocketAppsMultithreadedTest : public TestCase
+{
+  /** The receptions of each server, as "time:size". */
+  std::vector<std::vector<std::string> > m_received;
+
+public:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  PacketSocketAppsMultithreadedTest ();
+
+  /**
+   * Run pairs of a client and a server, each on its own channel.
+   * \param simulatorType The SimulatorImplementationType.
+   * \param firstDelay The delay of the channel of the first pair.
+   */
+  void RunPairs (std::string simulatorType, Time firstDelay);
+  static void ReceivePkt (PacketSocketAppsMultithreadedTest *test, uint32_t server,
+                          Ptr<const Packet> packet, const Address &from);
+};
+
+PacketSocketAppsMultithreadedTest::PacketSocketAppsMultithreadedTest ()
+  : TestCase ("Packet Socket Apps in a multithreaded simulation")
+{
+}
+
+void PacketSocketAppsMultithreadedTest::ReceivePkt (PacketSocketAppsMultithreadedTest *test, uint32_t server,
+                                                    Ptr<const Packet> packet, const Address &from)
+{
+  // each server runs in the thread of its node, and has its own history.
+  std::ostringstream oss;
+  oss << Simulator::Now ().GetNanoSeconds () << ":" << packet->GetSize ();
+  test->m_received[server].push_back (oss.str ());
+}
+
+void
+PacketSocketAppsMultithreadedTest::RunPairs (std::string simulatorType, Time firstDelay)
+{
+  const uint32_t pairs = 4;
+  Config::SetGlobal ("SimulatorImplementationType", StringValue (simulatorType));
+  m_received.clear ();
+  m_received.resize (pairs);
+
+  // the clients are on the even nodes and the servers on the odd ones,
+  // so that each channel connects two partitions.
+  NodeContainer nodes;
+  nodes.Create (2 * pairs);
+  PacketSocketHelper packetSocket;
+  packetSocket.Install (nodes);
+  for (uint32_t i = 0; i < pairs; i++)
+    {
+      Ptr<SimpleNetDevice> txDev = CreateObject<SimpleNetDevice> ();
+      nodes.Get (2 * i)->AddDevice (txDev);
+      Ptr<SimpleNetDevice> rxDev = CreateObject<SimpleNetDevice> ();
+      nodes.Get (2 * i + 1)->AddDevice (rxDev);
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (i == 0 ? firstDelay : MilliSeconds (i + 1)));
+      txDev->SetChannel (channel);
+      rxDev->SetChannel (channel);
+
+      PacketSocketAddress socketAddr;
+      socketAddr.SetSingleDevice (txDev->GetIfIndex ());
+      socketAddr.SetPhysicalAddress (rxDev->GetAddress ());
+      socketAddr.SetProtocol (1);
+
+      Ptr<PacketSocketClient> client = CreateObject<PacketSocketClient> ();
+      client->SetRemote (socketAddr);
+      client->SetAttribute ("PacketSize", UintegerValue (100 + i));
+      client->SetAttribute ("MaxPackets", UintegerValue (200));
+      client->SetAttribute ("Interval", TimeValue (MicroSeconds (300 + 50 * i)));
+      client->SetStartTime (MilliSeconds (i));
+      nodes.Get (2 * i)->AddApplication (client);
+
+      Ptr<PacketSocketServer> server = CreateObject<PacketSocketServer> ();
+      server->TraceConnectWithoutContext ("Rx", MakeBoundCallback (&PacketSocketAppsMultithreadedTest::ReceivePkt, this, i));
+      server->SetLocal (socketAddr);
+      nodes.Get (2 * i + 1)->AddApplication (server);
+    }
+
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+}
+
+void
+PacketSocketAppsMultithreadedTest::DoRun (void)
+{
+  RunPairs ("ns3::DefaultSimulatorImpl", MilliSeconds (1));
+  Simulator::Destroy ();
+  std::vector<std::vector<std::string> > expected = m_received;
+  NS_TEST_ASSERT_MSG_EQ (expected[0].size (), 200, "Number of packet received");
+
+  // The partitions run in parallel, with the delay of the fastest channel.
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::ThreadCount", UintegerValue (2));
+  RunPairs ("ns3::MultithreadedSimulatorImpl", MilliSeconds (1));
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "the simulator should be created by name");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), 2, "the number of partitions");
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MilliSeconds (1), "the lookahead of the channels");
+  Simulator::Destroy ();
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_received[i] == expected[i]), true, "Different receptions of server " << i);
+    }
+
+  // A channel without delay makes the partitions run in turn.
+  RunPairs ("ns3::MultithreadedSimulatorImpl", Seconds (0));
+  impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), Seconds (0), "the lookahead of the channels");
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_received[0].size (), 200, "Number of packet received");
+  for (uint32_t i = 1; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((m_received[i] == expected[i]), true, "Different receptions of server " << i);
+    }
+}
+
+void
+PacketSocketAppsMultithreadedTest::DoTeardown (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 class PacketSocketAppsTestSuite : public TestSuite
@@ -122,5 +354,7 @@ public:
   PacketSocketAppsTestSuite () : TestSuite ("packet-socket-apps", UNIT)
   {
     AddTestCase (new PacketSocketAppsTest, TestCase::QUICK);
+    AddTestCase (new PacketSocketAppsCheckpointTest, TestCase::QUICK);
+    AddTestCase (new PacketSocketAppsMultithreadedTest, TestCase::QUICK);
   }
 } g_packetSocketAppsTestSuite;
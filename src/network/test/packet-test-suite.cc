@@ -20,9 +20,13 @@
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
 #include "ns3/test.h"
+#include "ns3/memory-accounting.h"
 #include "ns3/unused.h"
 #include <limits>     // std:numeric_limits
 #include <string>
+#include <cstring>
+#include <sstream>
+#include <vector>
 #include <cstdarg>
 #include <iostream>
 #include <iomanip>
@@ -493,6 +497,34 @@ PacketTest::DoRun (void)
     NS_TEST_EXPECT_MSG_EQ (p.PeekPacketTag (b), false, "trivial");
   }
 
+  {
+    // A full copy shares nothing with the original.
+    Ptr<Packet> p = Create<Packet> (1000);
+    p->AddByteTag (ATestTag<20> ());
+    p->AddHeader (ATestHeader<2> ());
+    ATestTag<17> a (1);
+    p->AddPacketTag (a);
+    ATestTag<18> b (2);
+    p->AddPacketTag (b);
+    ATestTag<19> c (3);
+    p->AddPacketTag (c);
+    Ptr<Packet> copy = p->CreateFullCopy ();
+    NS_TEST_EXPECT_MSG_EQ (copy->GetUid (), p->GetUid (), "full copy keeps the uid");
+    CHECK (copy, 1, E (20, 2, 1002));
+    ATestHeader<2> h;
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekHeader (h), 2, "full copy keeps the metadata");
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (a), true, "full copy keeps the packet tags");
+    NS_TEST_EXPECT_MSG_EQ ((int)a.GetData (), 1, "full copy keeps the packet tags");
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (c), true, "full copy keeps the packet tags");
+    NS_TEST_EXPECT_MSG_EQ ((int)c.GetData (), 3, "full copy keeps the packet tags");
+    copy->RemovePacketTag (b);
+    copy->RemoveAtStart (2);
+    NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (b), false, "trivial");
+    NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (b), true, "original keeps its packet tags");
+    CHECK (p, 1, E (20, 2, 1002));
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 1002, "original keeps its bytes");
+  }
+
   {
     /// \internal
     /// See \bugid{572}
@@ -847,6 +879,148 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class PacketTagInlineTest : public TestCase
+{
+public:
+  PacketTagInlineTest ();
+  virtual void DoRun (void);
+  std::string GetTags (Ptr<const Packet> p);
+};
+
+PacketTagInlineTest::PacketTagInlineTest ()
+  : TestCase ("Packet tags stored inline and in the tree") {
+}
+
+std::string
+PacketTagInlineTest::GetTags (Ptr<const Packet> p)
+{
+  std::ostringstream oss;
+  PacketTagIterator i = p->GetPacketTagIterator ();
+  while (i.HasNext ())
+    {
+      PacketTagIterator::Item item = i.Next ();
+      ATestTagBase *tag = dynamic_cast<ATestTagBase *> (item.GetTypeId ().GetConstructor () ());
+      item.GetTag (*tag);
+      oss << item.GetTypeId ().GetName () << "=" << tag->GetData () << " ";
+      NS_TEST_EXPECT_MSG_EQ (tag->m_error, false, "the tag should be deserialized");
+      delete tag;
+    }
+  return oss.str ();
+}
+
+void
+PacketTagInlineTest::DoRun (void)
+{
+  // the first tags are inline, the last ones in the tree.
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddPacketTag (ATestTag<1> (1));
+  p->AddPacketTag (ATestTag<2> (2));
+  p->AddPacketTag (ATestTag<10> (10));
+  p->AddPacketTag (ATestTag<20> (20));
+  p->AddPacketTag (ATestTag<3> (3));
+  NS_TEST_EXPECT_MSG_EQ (GetTags (p),
+                         "anon::ATestTag<3>=3 anon::ATestTag<20>=20 anon::ATestTag<10>=10 "
+                         "anon::ATestTag<2>=2 anon::ATestTag<1>=1 ", "the most recent tags first");
+
+  // the inline tags are copied with the packet.
+  Ptr<Packet> copy = p->Copy ();
+  ATestTag<2> t2;
+  NS_TEST_EXPECT_MSG_EQ (copy->RemovePacketTag (t2), true, "remove an inline tag");
+  NS_TEST_EXPECT_MSG_EQ (t2.GetData (), 2, "the removed tag");
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (t2), false, "the tag is removed");
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (t2), true, "the original keeps its tag");
+  ATestTag<1> t1 (7);
+  copy->ReplacePacketTag (t1);
+  copy->AddPacketTag (ATestTag<4> (4));
+  NS_TEST_EXPECT_MSG_EQ (GetTags (copy),
+                         "anon::ATestTag<4>=4 anon::ATestTag<3>=3 anon::ATestTag<20>=20 "
+                         "anon::ATestTag<10>=10 anon::ATestTag<1>=7 ", "the tags of the copy");
+  NS_TEST_EXPECT_MSG_EQ (GetTags (p),
+                         "anon::ATestTag<3>=3 anon::ATestTag<20>=20 anon::ATestTag<10>=10 "
+                         "anon::ATestTag<2>=2 anon::ATestTag<1>=1 ", "the tags of the original");
+
+  // the tags can be added again once removed.
+  copy->RemoveAllPacketTags ();
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (t2), false, "no tags left");
+  copy->AddPacketTag (ATestTag<2> (5));
+  NS_TEST_EXPECT_MSG_EQ (GetTags (copy), "anon::ATestTag<2>=5 ", "the tag added again");
+}
+
+//-----------------------------------------------------------------------------
+class PacketMemoryAccountingTest : public TestCase
+{
+public:
+  PacketMemoryAccountingTest ();
+  virtual void DoRun (void);
+};
+
+PacketMemoryAccountingTest::PacketMemoryAccountingTest ()
+  : TestCase ("Packet memory accounting") {
+}
+
+void
+PacketMemoryAccountingTest::DoRun (void)
+{
+  MemoryAccounting::Enable ();
+  uint64_t before = MemoryAccounting::GetUsage ("ns3::Packet").count;
+  Ptr<Packet> packet = Create<Packet> (100);
+  Ptr<Packet> copy = packet->Copy ();
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetUsage ("ns3::Packet").count, before + 2, "the packets should be accounted for");
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetUsage ("ns3::Packet").bytes, (before + 2) * sizeof (Packet), "the size of the packets");
+  packet = 0;
+  copy = 0;
+  NS_TEST_EXPECT_MSG_EQ (MemoryAccounting::GetUsage ("ns3::Packet").count, before, "the deleted packets should be released");
+  MemoryAccounting::Disable ();
+}
+
+//-----------------------------------------------------------------------------
+class PacketVirtualPayloadTest : public TestCase
+{
+public:
+  PacketVirtualPayloadTest ();
+  virtual void DoRun (void);
+};
+
+PacketVirtualPayloadTest::PacketVirtualPayloadTest ()
+  : TestCase ("Packet zero payloads never allocated") {
+}
+
+void
+PacketVirtualPayloadTest::DoRun (void)
+{
+  MemoryAccounting::Enable ();
+  uint64_t before = MemoryAccounting::GetUsage ("ns3::Buffer").bytes;
+  {
+    uint8_t header[40];
+    memset (header, 0x45, sizeof (header));
+    Ptr<Packet> stream = Create<Packet> ();
+    for (uint32_t i = 0; i < 10; i++)
+      {
+        Ptr<Packet> segment = Create<Packet> (header, sizeof (header));
+        segment->AddAtEnd (Create<Packet> (1 << 20));
+        stream->AddAtEnd (segment);
+      }
+    Ptr<Packet> fragment = stream->CreateFragment (1000, 3 << 20);
+    fragment->AddAtEnd (stream->CreateFragment (8 << 20, 1 << 20));
+
+    // serialized as by the distributed simulations.
+    uint32_t size = fragment->GetSerializedSize ();
+    NS_TEST_EXPECT_MSG_LT (size, 4096, "the zero payload is serialized as its size");
+    std::vector<uint32_t> serialized ((size + 3) / 4);
+    NS_TEST_EXPECT_MSG_EQ (fragment->Serialize (reinterpret_cast<uint8_t *> (&serialized[0]), size), 1,
+                           "the packet should be serialized");
+    Ptr<Packet> received = Create<Packet> (reinterpret_cast<uint8_t *> (&serialized[0]), size, true);
+    NS_TEST_EXPECT_MSG_EQ (received->GetSize (), fragment->GetSize (), "the deserialized size");
+    uint8_t byte;
+    received->CopyData (&byte, 1);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)byte, 0, "the payload of the first segment");
+    NS_TEST_EXPECT_MSG_LT (MemoryAccounting::GetUsage ("ns3::Buffer").bytes, before + (1 << 20),
+                           "the zeroes should never be allocated");
+  }
+  MemoryAccounting::Disable ();
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +1033,9 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new PacketTagInlineTest, TestCase::QUICK);
+  AddTestCase (new PacketMemoryAccountingTest, TestCase::QUICK);
+  AddTestCase (new PacketVirtualPayloadTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
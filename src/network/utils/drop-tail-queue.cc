@@ -18,6 +18,7 @@
 
 #include "ns3/log.h"
 #include "drop-tail-queue.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -37,7 +38,9 @@ TypeId DropTailQueue::GetTypeId (void)
 
 DropTailQueue::DropTailQueue () :
   Queue (),
-  m_packets ()
+  m_packets (),
+  m_head (0),
+  m_count (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -47,13 +50,31 @@ DropTailQueue::~DropTailQueue ()
   NS_LOG_FUNCTION (this);
 }
 
+void
+DropTailQueue::Grow (void)
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ptr<QueueItem> > packets (std::max<uint32_t> (16, 2 * m_packets.size ()));
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      packets[i] = m_packets[(m_head + i) & (m_packets.size () - 1)];
+    }
+  m_packets.swap (packets);
+  m_head = 0;
+}
+
 bool 
 DropTailQueue::DoEnqueue (Ptr<QueueItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  m_packets.push (item);
+  if (m_count == m_packets.size ())
+    {
+      Grow ();
+    }
+  m_packets[(m_head + m_count) & (m_packets.size () - 1)] = item;
+  m_count++;
 
   return true;
 }
@@ -62,10 +83,12 @@ Ptr<QueueItem>
 DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  Ptr<QueueItem> item = m_packets[m_head];
+  m_packets[m_head] = 0;
+  m_head = (m_head + 1) & (m_packets.size () - 1);
+  m_count--;
 
   NS_LOG_LOGIC ("Popped " << item);
 
@@ -76,10 +99,12 @@ Ptr<QueueItem>
 DropTailQueue::DoRemove (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  Ptr<QueueItem> item = m_packets[m_head];
+  m_packets[m_head] = 0;
+  m_head = (m_head + 1) & (m_packets.size () - 1);
+  m_count--;
 
   NS_LOG_LOGIC ("Removed " << item);
 
@@ -90,9 +115,9 @@ Ptr<const QueueItem>
 DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_count == GetNPackets ());
 
-  return m_packets.front ();
+  return m_packets[m_head];
 }
 
 } // namespace ns3
@@ -19,7 +19,7 @@
 #ifndef DROPTAIL_H
 #define DROPTAIL_H
 
-#include <queue>
+#include <vector>
 #include "ns3/queue.h"
 
 namespace ns3 {
@@ -52,7 +52,19 @@ private:
   virtual Ptr<QueueItem> DoRemove (void);
   virtual Ptr<const QueueItem> DoPeek (void) const;
 
-  std::queue<Ptr<QueueItem> > m_packets; //!< the items in the queue
+  /**
+   * \brief Grow the ring of the items to twice its size.
+   */
+  void Grow (void);
+
+  /**
+   * The items in the queue, in a ring whose size is a power of two,
+   * so that a queue which has reached its size does not allocate
+   * memory anymore as items come and go.
+   */
+  std::vector<Ptr<QueueItem> > m_packets;
+  uint32_t m_head;  //!< the index of the first item in the ring
+  uint32_t m_count; //!< the number of items in the ring
 };
 
 } // namespace ns3
@@ -102,6 +102,29 @@ PacketSocketClient::DoDispose (void)
   Application::DoDispose ();
 }
 
+void
+PacketSocketClient::DoSerialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  Application::DoSerialize (os);
+  int64_t send = m_sendEvent.IsRunning () ? Simulator::GetDelayLeft (m_sendEvent).GetTimeStep () : -1;
+  os << " " << m_sent << " " << send;
+}
+
+void
+PacketSocketClient::DoDeserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+  Application::DoDeserialize (is);
+  int64_t send = -1;
+  is >> m_sent >> send;
+  m_sendEvent.Cancel ();
+  if (send >= 0)
+    {
+      m_sendEvent = Simulator::Schedule (TimeStep (send), &PacketSocketClient::Send, this);
+    }
+}
+
 void
 PacketSocketClient::SetPriority (uint8_t priority)
 {
@@ -43,6 +43,9 @@ class Packet;
  * what concerns the underlying NetDevice and the Address scheme.
  * It is meant to be used in ns-3 tests.
  *
+ * It supports Checkpoint::Restore(): it saves the number of packets
+ * sent and the time left before the next one.
+ *
  * The application will send `MaxPackets' packets, one every `Interval'
  * time. Packet size (`PacketSize') can be configured.
  * Provides a "Tx" Traced Callback (transmitted packets, source address).
@@ -76,6 +79,8 @@ public:
 
 protected:
   virtual void DoDispose (void);
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual void DoDeserialize (std::istream &is);
 
 private:
 
@@ -74,6 +74,22 @@ PacketSocketServer::DoDispose (void)
   Application::DoDispose ();
 }
 
+void
+PacketSocketServer::DoSerialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  Application::DoSerialize (os);
+  os << " " << m_pktRx << " " << m_bytesRx;
+}
+
+void
+PacketSocketServer::DoDeserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this << &is);
+  Application::DoDeserialize (is);
+  is >> m_pktRx >> m_bytesRx;
+}
+
 void
 PacketSocketServer::StartApplication (void)
 {
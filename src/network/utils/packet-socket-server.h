@@ -41,6 +41,9 @@ class Packet;
  * what concerns the underlying NetDevice and the Address scheme.
  * It is meant to be used in ns-3 tests.
  *
+ * It supports Checkpoint::Restore(): it saves the number of packets
+ * and bytes received.
+ *
  * Provides a "Rx" Traced Callback (received packets, source address)
  */
 class PacketSocketServer : public Application
@@ -64,6 +67,8 @@ public:
 
 protected:
   virtual void DoDispose (void);
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual void DoDeserialize (std::istream &is);
 
 private:
 
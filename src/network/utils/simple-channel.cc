@@ -57,9 +57,11 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
                      Ptr<SimpleNetDevice> sender)
 {
   NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
-  for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = m_devices.begin (); i != m_devices.end (); ++i)
+  for (uint32_t i = 0; i < m_devices.size (); ++i)
     {
-      Ptr<SimpleNetDevice> tmp = *i;
+      // The receiving device may run in another thread: only its
+      // reference held by m_devices is used, and its context is known.
+      const Ptr<SimpleNetDevice> &tmp = m_devices[i];
       if (tmp == sender)
         {
           continue;
@@ -72,8 +74,14 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
               continue;
             }
         }
-      Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), m_delay,
-                                      &SimpleNetDevice::Receive, tmp, p->Copy (), protocol, to, from);
+      uint32_t context = m_contexts[i];
+      if (context == Simulator::NO_CONTEXT)
+        {
+          context = tmp->GetNode ()->GetId ();
+        }
+      Simulator::ScheduleWithContext (context, m_delay,
+                                      &SimpleNetDevice::Receive, PeekPointer (tmp),
+                                      p->CopyForContext (context), protocol, to, from);
     }
 }
 
@@ -82,6 +90,8 @@ SimpleChannel::Add (Ptr<SimpleNetDevice> device)
 {
   NS_LOG_FUNCTION (this << device);
   m_devices.push_back (device);
+  Ptr<Node> node = device->GetNode ();
+  m_contexts.push_back (node != 0 ? node->GetId () : Simulator::NO_CONTEXT);
 }
 
 uint32_t
@@ -42,6 +42,12 @@ class Packet;
  * are using 48-bit MAC addresses.
  *
  * This channel is meant to be used by ns3::SimpleNetDevices.
+ *
+ * The channel can connect the partitions of a MultithreadedSimulatorImpl:
+ * it hands over to each receiving device a Packet::CopyForContext of
+ * the packet, and it only keeps the contexts of the receiving devices,
+ * known when they are added, so the devices must be added to their
+ * nodes first.
  */
 class SimpleChannel : public Channel
 {
@@ -100,6 +106,7 @@ public:
 private:
   Time m_delay; //!< The assigned speed-of-light delay of the channel
   std::vector<Ptr<SimpleNetDevice> > m_devices; //!< devices connected by the channel
+  std::vector<uint32_t> m_contexts; //!< the node ids of the devices, or Simulator::NO_CONTEXT if unknown
   std::map<Ptr<SimpleNetDevice>, std::vector<Ptr<SimpleNetDevice> > > m_blackListedDevices; //!< devices blocked on a device
 };
 
@@ -21,6 +21,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -78,6 +79,11 @@ PointToPointChannel::Attach (Ptr<PointToPointNetDevice> device)
     {
       m_link[0].m_dst = m_link[1].m_src;
       m_link[1].m_dst = m_link[0].m_src;
+      for (uint32_t i = 0; i < N_DEVICES; i++)
+        {
+          Ptr<Node> node = m_link[i].m_dst->GetNode ();
+          m_link[i].m_dstContext = node != 0 ? node->GetId () : Simulator::NO_CONTEXT;
+        }
       m_link[0].m_state = IDLE;
       m_link[1].m_state = IDLE;
     }
@@ -97,12 +103,23 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
-  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+  // The receiving device may run in another thread: it gets a full
+  // copy of the packet, and its reference count is left alone.
+  uint32_t context = m_link[wire].m_dstContext;
+  if (context == Simulator::NO_CONTEXT)
+    {
+      context = m_link[wire].m_dst->GetNode ()->GetId ();
+    }
+  Ptr<Packet> packet = MultithreadedSimulatorImpl::IsOtherPartition (context) ? p->CreateFullCopy () : p;
+  Simulator::ScheduleWithContext (context,
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
-                                  m_link[wire].m_dst, p);
+                                  PeekPointer (m_link[wire].m_dst), packet);
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  if (!m_txrxPointToPoint.IsEmpty ())
+    {
+      m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+    }
   return true;
 }
 
@@ -44,6 +44,13 @@ class Packet;
  * [0] wire to transmit on.  The second device gets the [1] wire.  There is a
  * state (IDLE, TRANSMITTING) associated with each wire.
  *
+ * The channel can connect the partitions of a MultithreadedSimulatorImpl:
+ * it hands over to the receiving device a full copy of the packet, and
+ * it only keeps the context of the receiving device, known when it is
+ * attached, so the devices must be added to their nodes first.  The
+ * TxRxPointToPoint trace source passes the receiving device, so it must
+ * not be connected on a channel between partitions.
+ *
  * \see Attach
  * \see TransmitStart
  */
@@ -194,11 +201,12 @@ public:
     /** \brief Create the link, it will be in INITIALIZING state
      *
      */
-    Link() : m_state (INITIALIZING), m_src (0), m_dst (0) {}
+    Link() : m_state (INITIALIZING), m_src (0), m_dst (0), m_dstContext (0) {}
 
     WireState                  m_state; //!< State of the link
     Ptr<PointToPointNetDevice> m_src;   //!< First NetDevice
     Ptr<PointToPointNetDevice> m_dst;   //!< Second NetDevice
+    uint32_t                   m_dstContext; //!< Node id of the second NetDevice, or Simulator::NO_CONTEXT if unknown
   };
 
   Link    m_link[N_DEVICES]; //!< Link model
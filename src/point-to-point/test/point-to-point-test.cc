@@ -21,8 +21,12 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/event-pool.h"
+#include "ns3/packet-pool.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/data-rate.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +104,154 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test the memory of the packets forwarded by a chain of routers
+ *
+ * A source sends packets through a chain of routers, each of which
+ * forwards the packets received on one PointToPointNetDevice to the
+ * next.  Once the pools are warm, forwarding a packet should not
+ * allocate any memory from the heap: the Packet, its Buffer and tags,
+ * the QueueItem holding it in the DropTailQueue of each device, and
+ * the events which carry it are all recycled.
+ */
+class PointToPointRouterChainTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointRouterChainTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets from a device, one every 100 microseconds
+   *
+   * \param device NetDevice to send from
+   * \param n the number of packets left to send
+   */
+  void Send (Ptr<NetDevice> device, uint32_t n);
+  /**
+   * \brief Forward a packet received by a router to its next device
+   *
+   * \param device the device which received the packet
+   * \param packet the packet
+   * \param protocol the protocol number of the packet
+   * \param from the address of the sender
+   * \returns true if the packet was sent
+   */
+  bool Forward (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  /**
+   * \brief Count a packet received by the sink
+   *
+   * \param device the device which received the packet
+   * \param packet the packet
+   * \param protocol the protocol number of the packet
+   * \param from the address of the sender
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  uint32_t m_received; //!< the number of packets received by the sink
+};
+
+PointToPointRouterChainTest::PointToPointRouterChainTest ()
+  : TestCase ("PointToPoint router chain allocates no memory per packet"),
+    m_received (0)
+{
+}
+
+void
+PointToPointRouterChainTest::Send (Ptr<NetDevice> device, uint32_t n)
+{
+  device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+  if (n > 1)
+    {
+      Simulator::Schedule (MicroSeconds (100), &PointToPointRouterChainTest::Send, this, device, n - 1);
+    }
+}
+
+bool
+PointToPointRouterChainTest::Forward (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  // the devices of a router: 0 towards the source, 1 towards the sink.
+  Ptr<NetDevice> next = device->GetNode ()->GetDevice (1);
+  return next->Send (packet->Copy (), next->GetBroadcast (), protocol);
+}
+
+bool
+PointToPointRouterChainTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+PointToPointRouterChainTest::DoRun (void)
+{
+  const uint32_t nNodes = 5;
+  const uint32_t nPackets = 1000;
+  std::vector<Ptr<Node> > nodes;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      nodes.push_back (CreateObject<Node> ());
+    }
+  for (uint32_t i = 0; i + 1 < nNodes; i++)
+    {
+      Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (500)));
+      for (uint32_t j = i; j <= i + 1; j++)
+        {
+          Ptr<PointToPointNetDevice> device = CreateObject<PointToPointNetDevice> ();
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetDataRate (DataRate ("100Mbps"));
+          device->SetQueue (CreateObject<DropTailQueue> ());
+          device->Attach (channel);
+          nodes[j]->AddDevice (device);
+          if (j == nNodes - 1)
+            {
+              device->SetReceiveCallback (MakeCallback (&PointToPointRouterChainTest::Receive, this));
+            }
+          else if (j == i + 1)
+            {
+              device->SetReceiveCallback (MakeCallback (&PointToPointRouterChainTest::Forward, this));
+            }
+        }
+    }
+  Ptr<NetDevice> source = nodes[0]->GetDevice (0);
+
+  // warm the pools up.
+  Simulator::Schedule (Seconds (1.0), &PointToPointRouterChainTest::Send, this, source, nPackets);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received, nPackets, "the packets should go through the chain");
+
+  PacketPool::ResetCounters ();
+  EventPool::Stats events = EventPool::GetStats ();
+  Simulator::Schedule (Seconds (1.0), &PointToPointRouterChainTest::Send, this, source, nPackets);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_received, 2 * nPackets, "the packets should go through the chain");
+
+  static const char *names[] = { "Packet", "Buffer", "PacketMetadata", "Tags", "QueueItem" };
+  for (uint32_t i = 0; i < PacketPool::PARTS; i++)
+    {
+      PacketPool::Counters counters = PacketPool::GetCounters (static_cast<enum PacketPool::Part> (i));
+      NS_TEST_EXPECT_MSG_EQ (counters.misses, 0, "the " << names[i] << " should not be allocated from the heap");
+      NS_TEST_EXPECT_MSG_EQ (counters.frees, 0, "the " << names[i] << " should not be freed to the heap");
+    }
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (PacketPool::GetCounters (PacketPool::PACKET).hits, (nNodes - 1) * nPackets,
+                               "each hop should reuse a Packet");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (PacketPool::GetCounters (PacketPool::QUEUE_ITEM).hits, (nNodes - 1) * nPackets,
+                               "each hop should reuse a QueueItem");
+  NS_TEST_EXPECT_MSG_EQ (EventPool::GetStats ().systemAllocations, events.systemAllocations,
+                         "the events should not be allocated from the heap");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +268,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointRouterChainTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
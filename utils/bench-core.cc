@@ -0,0 +1,737 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Micro-benchmarks of the simulator core, with a JSON report.
+ *
+ * Each benchmark runs a fixed number of operations --iterations times,
+ * and reports the fastest run as ns/op and ops/s (events/s for the
+ * schedulers).  Each benchmark runs in a child process forked from the
+ * driver, so that its peak resident set size is not hidden by the
+ * peaks of the benchmarks run before it.
+ *
+ *   ./waf --run "bench-core --output=core.json"
+ *   ./waf --run "bench-core --filter=scheduler/ --scale=0.1"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("BenchCore");
+
+namespace {
+
+/** The result of one benchmark. */
+struct Result
+{
+  std::string name;      //!< Benchmark name.
+  std::string unit;      //!< What an operation is: "op" or "event".
+  uint64_t ops;          //!< Number of operations per run.
+  double seconds;        //!< Duration of the fastest run.
+  uint64_t peakRssKb;    //!< Peak resident set size of the benchmark process.
+};
+
+/** All the results. */
+std::vector<Result> g_results;
+/** Only run the benchmarks whose name contains this string. */
+std::string g_filter;
+/** Number of runs of each benchmark. */
+uint32_t g_iterations = 3;
+/** Scale factor applied to the number of operations. */
+double g_scale = 1.0;
+
+/** Keep the compiler from optimizing the benchmarked code away. */
+volatile uint64_t g_sink;
+
+/**
+ * \returns The peak resident set size of the process, in KiB.
+ */
+uint64_t
+GetPeakRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/** What a benchmark process reports to the driver. */
+struct Report
+{
+  double seconds;        //!< Duration of the fastest run.
+  uint64_t peakRssKb;    //!< Peak resident set size.
+};
+
+/**
+ * Run a benchmark and record its fastest run.
+ *
+ * \param [in] name The benchmark name.
+ * \param [in] unit The kind of operation.
+ * \param [in] ops The number of operations, before scaling.
+ * \param [in] bench The benchmark, which takes the number of operations.
+ */
+void
+Run (std::string name, std::string unit, uint64_t ops, Callback<void, uint64_t> bench)
+{
+  if (name.find (g_filter) == std::string::npos)
+    {
+      return;
+    }
+  ops = std::max<uint64_t> (1, ops * g_scale);
+  int fds[2];
+  if (pipe (fds) != 0)
+    {
+      NS_FATAL_ERROR ("pipe failed for " << name);
+    }
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("fork failed for " << name);
+    }
+  if (pid == 0)
+    {
+      // the child starts with the peak of the driver, which only
+      // holds the setup of the benchmarks.
+      close (fds[0]);
+      Report report;
+      report.seconds = std::numeric_limits<double>::max ();
+      for (uint32_t i = 0; i < g_iterations; i++)
+        {
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+          bench (ops);
+          std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+          report.seconds = std::min (report.seconds, elapsed.count ());
+        }
+      report.peakRssKb = GetPeakRssKb ();
+      ssize_t written = write (fds[1], &report, sizeof (report));
+      _exit (written == sizeof (report) ? 0 : 1);
+    }
+  close (fds[1]);
+  Report report;
+  ssize_t size = read (fds[0], &report, sizeof (report));
+  close (fds[0]);
+  int status;
+  waitpid (pid, &status, 0);
+  if (size != sizeof (report) || !WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      NS_FATAL_ERROR ("benchmark " << name << " failed");
+    }
+  Result result;
+  result.name = name;
+  result.unit = unit;
+  result.ops = ops;
+  result.seconds = report.seconds;
+  result.peakRssKb = report.peakRssKb;
+  g_results.push_back (result);
+  std::cerr << std::left << std::setw (40) << name
+            << std::right << std::setw (12) << std::fixed << std::setprecision (1)
+            << report.seconds * 1e9 / ops << " ns/" << unit << std::endl;
+}
+
+/**
+ * Write the results as JSON.
+ *
+ * \param [in] os The output stream.
+ */
+void
+WriteJson (std::ostream &os)
+{
+  os << std::fixed;
+  os << "{" << std::endl;
+  os << "  \"iterations\": " << g_iterations << "," << std::endl;
+  os << "  \"scale\": " << std::setprecision (3) << g_scale << "," << std::endl;
+  os << "  \"peak-rss-kb\": " << GetPeakRssKb () << "," << std::endl;
+  os << "  \"benchmarks\": [" << std::endl;
+  for (std::vector<Result>::const_iterator i = g_results.begin (); i != g_results.end (); ++i)
+    {
+      double nsPerOp = i->seconds * 1e9 / i->ops;
+      double perSec = i->ops / i->seconds;
+      os << "    {"
+         << "\"name\": \"" << i->name << "\", "
+         << "\"unit\": \"" << i->unit << "\", "
+         << "\"ops\": " << i->ops << ", "
+         << "\"seconds\": " << std::setprecision (9) << i->seconds << ", "
+         << "\"ns-per-op\": " << std::setprecision (3) << nsPerOp << ", "
+         << "\"" << i->unit << "s-per-sec\": " << std::setprecision (1) << perSec << ", "
+         << "\"peak-rss-kb\": " << i->peakRssKb
+         << "}" << (i + 1 != g_results.end () ? "," : "") << std::endl;
+    }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+
+/*
+ * Schedulers.
+ */
+
+/** Pre-computed exponential delays, in ns, so that the RNG is not measured. */
+std::vector<uint64_t> g_delays;
+/** Index of the next delay. */
+uint32_t g_nextDelay;
+/** Number of events left to schedule. */
+uint64_t g_eventsLeft;
+
+/**
+ * \returns The next delay.
+ */
+Time
+NextDelay (void)
+{
+  g_nextDelay = (g_nextDelay + 1) % g_delays.size ();
+  return NanoSeconds (g_delays[g_nextDelay]);
+}
+
+/** Hold model: each event schedules one event. */
+void
+HoldEvent (void)
+{
+  if (g_eventsLeft > 0)
+    {
+      g_eventsLeft--;
+      Simulator::Schedule (NextDelay (), &HoldEvent);
+    }
+}
+
+/** An event which does nothing. */
+void
+EmptyEvent (void)
+{
+}
+
+/**
+ * Bursty model: each event schedules a burst of simultaneous events
+ * and the next burst.
+ *
+ * \param [in] burst The number of events in a burst.
+ */
+void
+BurstEvent (uint32_t burst)
+{
+  if (g_eventsLeft == 0)
+    {
+      return;
+    }
+  Time delay = NextDelay ();
+  for (uint32_t i = 0; i < burst && g_eventsLeft > 0; i++)
+    {
+      g_eventsLeft--;
+      Simulator::Schedule (delay, &EmptyEvent);
+    }
+  if (g_eventsLeft > 0)
+    {
+      g_eventsLeft--;
+      Simulator::Schedule (NextDelay (), &BurstEvent, burst);
+    }
+}
+
+/**
+ * Run a simulation of a scheduler.
+ *
+ * \param [in] scheduler The scheduler TypeId name.
+ * \param [in] population The number of pending events.
+ * \param [in] burst The size of the bursts, or 0 for the hold model.
+ * \param [in] events The number of events to run.
+ */
+void
+BenchScheduler (std::string scheduler, uint32_t population, uint32_t burst, uint64_t events)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (scheduler);
+  Simulator::SetScheduler (factory);
+  g_nextDelay = 0;
+  g_eventsLeft = events;
+  for (uint32_t i = 0; i < population && g_eventsLeft > 0; i++)
+    {
+      g_eventsLeft--;
+      if (burst == 0)
+        {
+          Simulator::Schedule (NextDelay (), &HoldEvent);
+        }
+      else
+        {
+          Simulator::Schedule (NextDelay (), &BurstEvent, burst);
+        }
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+
+/*
+ * Callbacks.
+ */
+
+/** A callback target. */
+class Target
+{
+public:
+  /**
+   * Accumulate a value.
+   * \param [in] v The value.
+   */
+  void Add (uint64_t v)
+  {
+    m_sum += v;
+  }
+  uint64_t m_sum; //!< The sum.
+};
+
+/**
+ * Accumulate a value in a target.
+ * \param [in] target The target.
+ * \param [in] v The value.
+ */
+void
+AddTo (Target *target, uint64_t v)
+{
+  target->m_sum += v;
+}
+
+/**
+ * Invoke a callback bound to a member function.
+ * \param [in] n The number of invocations.
+ */
+void
+BenchCallbackMember (uint64_t n)
+{
+  Target target;
+  target.m_sum = 0;
+  Callback<void, uint64_t> cb = MakeCallback (&Target::Add, &target);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      cb (i);
+    }
+  g_sink = target.m_sum;
+}
+
+/**
+ * Invoke a callback with a bound argument.
+ * \param [in] n The number of invocations.
+ */
+void
+BenchCallbackBound (uint64_t n)
+{
+  Target target;
+  target.m_sum = 0;
+  Callback<void, uint64_t> cb = MakeBoundCallback (&AddTo, &target);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      cb (i);
+    }
+  g_sink = target.m_sum;
+}
+
+/**
+ * Invoke a TracedCallback.
+ * \param [in] sinks The number of connected callbacks.
+ * \param [in] n The number of invocations.
+ */
+void
+BenchTracedCallback (uint32_t sinks, uint64_t n)
+{
+  std::vector<Target> targets (std::max<uint32_t> (sinks, 1));
+  TracedCallback<uint64_t> trace;
+  for (uint32_t i = 0; i < sinks; i++)
+    {
+      targets[i].m_sum = 0;
+      trace.ConnectWithoutContext (MakeCallback (&Target::Add, &targets[i]));
+    }
+  for (uint64_t i = 0; i < n; i++)
+    {
+      trace (i);
+    }
+  g_sink = targets[0].m_sum;
+}
+
+
+/*
+ * Packets.
+ */
+
+/**
+ * A header of N bytes.
+ * \tparam N \explicit The size of the header.
+ */
+template <int N>
+class BenchHeader : public Header
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (GetName ().c_str ())
+      .SetParent<Header> ()
+      .SetGroupName ("Utils")
+      .HideFromDocumentation ()
+      .AddConstructor<BenchHeader <N> > ()
+    ;
+    return tid;
+  }
+  /**
+   * \returns The name of this type.
+   */
+  static std::string GetName (void)
+  {
+    std::ostringstream oss;
+    oss << "ns3::BenchCoreHeader<" << N << ">";
+    return oss.str ();
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "N=" << N;
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return N;
+  }
+  virtual void Serialize (Buffer::Iterator start) const
+  {
+    start.WriteU8 (N, N);
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator start)
+  {
+    start.Next (N);
+    return N;
+  }
+};
+
+/**
+ * Create packets.
+ * \param [in] n The number of packets.
+ */
+void
+BenchPacketCreate (uint64_t n)
+{
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1500);
+      g_sink = p->GetSize ();
+    }
+}
+
+/**
+ * Copy packets.
+ * \param [in] n The number of copies.
+ */
+void
+BenchPacketCopy (uint64_t n)
+{
+  Ptr<Packet> p = Create<Packet> (1500);
+  p->AddHeader (BenchHeader<20> ());
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> copy = p->Copy ();
+      g_sink = copy->GetSize ();
+    }
+}
+
+/**
+ * Add and remove headers.
+ * \param [in] n The number of packets.
+ */
+void
+BenchPacketHeaders (uint64_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchHeader<8> udp;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1500);
+      p->AddHeader (udp);
+      p->AddHeader (ipv4);
+      p->RemoveHeader (ipv4);
+      p->RemoveHeader (udp);
+      g_sink = p->GetSize ();
+    }
+}
+
+/**
+ * Fragment and reassemble packets.
+ * \param [in] n The number of packets.
+ */
+void
+BenchPacketFragment (uint64_t n)
+{
+  BenchHeader<20> ipv4;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (2000);
+      p->AddHeader (ipv4);
+      Ptr<Packet> whole = p->CreateFragment (0, 500);
+      for (uint32_t offset = 500; offset < p->GetSize (); offset += 500)
+        {
+          whole->AddAtEnd (p->CreateFragment (offset, std::min<uint32_t> (500, p->GetSize () - offset)));
+        }
+      whole->RemoveHeader (ipv4);
+      g_sink = whole->GetSize ();
+    }
+}
+
+
+/*
+ * Objects and configuration.
+ */
+
+/**
+ * An object which can be aggregated and connected to.
+ * \tparam N \explicit Distinguishes the types.
+ */
+template <int N>
+class BenchObject : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (GetName ().c_str ())
+      .SetParent<Object> ()
+      .SetGroupName ("Utils")
+      .HideFromDocumentation ()
+      .AddConstructor<BenchObject<N> > ()
+      .AddAttribute ("Children", "The child objects.",
+                     ObjectVectorValue (),
+                     MakeObjectVectorAccessor (&BenchObject<N>::m_children),
+                     MakeObjectVectorChecker<Object> ())
+      .AddTraceSource ("Trace", "A trace source.",
+                       MakeTraceSourceAccessor (&BenchObject<N>::m_trace),
+                       "ns3::TracedValueCallback::Uint64")
+    ;
+    return tid;
+  }
+  /**
+   * \returns The name of this type.
+   */
+  static std::string GetName (void)
+  {
+    std::ostringstream oss;
+    oss << "ns3::BenchCoreObject<" << N << ">";
+    return oss.str ();
+  }
+  /** The child objects. */
+  std::vector<Ptr<Object> > m_children;
+  /** The trace source. */
+  TracedCallback<uint64_t> m_trace;
+};
+
+/**
+ * Look up aggregated objects.
+ * \param [in] n The number of lookups.
+ */
+void
+BenchGetObject (uint64_t n)
+{
+  Ptr<Object> object = CreateObject<BenchObject<0> > ();
+  object->AggregateObject (CreateObject<BenchObject<1> > ());
+  object->AggregateObject (CreateObject<BenchObject<2> > ());
+  object->AggregateObject (CreateObject<BenchObject<3> > ());
+  object->AggregateObject (CreateObject<BenchObject<4> > ());
+  object->AggregateObject (CreateObject<BenchObject<5> > ());
+  for (uint64_t i = 0; i < n; i++)
+    {
+      g_sink = (i & 1) ? PeekPointer (object->GetObject<BenchObject<5> > ()) != 0
+        : PeekPointer (object->GetObject<BenchObject<2> > ()) != 0;
+    }
+  object->Dispose ();
+}
+
+/** A trace sink. */
+void
+TraceSink (std::string context, uint64_t v)
+{
+  g_sink = v;
+}
+
+/**
+ * Connect and disconnect to trace sources through Config paths.
+ * \param [in] n The number of Connect calls.
+ */
+void
+BenchConfigConnect (uint64_t n)
+{
+  // a two-level tree of 16 x 16 objects
+  Ptr<BenchObject<0> > root = CreateObject<BenchObject<0> > ();
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      Ptr<BenchObject<0> > child = CreateObject<BenchObject<0> > ();
+      for (uint32_t j = 0; j < 16; j++)
+        {
+          child->m_children.push_back (CreateObject<BenchObject<0> > ());
+        }
+      root->m_children.push_back (child);
+    }
+  Config::RegisterRootNamespaceObject (root);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      std::ostringstream oss;
+      oss << "/Children/" << (i % 16) << "/Children/" << ((i / 16) % 16) << "/Trace";
+      Config::Connect (oss.str (), MakeCallback (&TraceSink));
+      Config::Disconnect (oss.str (), MakeCallback (&TraceSink));
+    }
+  Config::UnregisterRootNamespaceObject (root);
+  root->Dispose ();
+}
+
+/**
+ * Time arithmetic.
+ * \param [in] n The number of operations.
+ */
+void
+BenchTime (uint64_t n)
+{
+  Time t = Seconds (0);
+  Time step = NanoSeconds (3);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      t = t + step * 2 - step;
+      if (t > Seconds (1))
+        {
+          t = t / 2;
+        }
+    }
+  g_sink = t.GetTimeStep ();
+}
+
+/**
+ * int64x64_t arithmetic.
+ * \param [in] n The number of operations.
+ */
+void
+BenchInt64x64 (uint64_t n)
+{
+  int64x64_t a = 1.5;
+  int64x64_t b = 0.75;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      a = a * b / int64x64_t (0.75) + b;
+      if (a > int64x64_t (1000))
+        {
+          a = 1.5;
+        }
+    }
+  g_sink = a.GetHigh ();
+}
+
+} // unnamed namespace
+
+
+int main (int argc, char *argv[])
+{
+  std::string output = "-";
+  uint32_t population = 10000;
+  uint64_t events = 1000000;
+  uint32_t burst = 64;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the simulator core, and write the results as JSON.");
+  cmd.AddValue ("output", "JSON output file, or - for stdout", output);
+  cmd.AddValue ("filter", "only run the benchmarks whose name contains this string", g_filter);
+  cmd.AddValue ("iterations", "number of runs of each benchmark", g_iterations);
+  cmd.AddValue ("scale", "scale factor applied to the number of operations", g_scale);
+  cmd.AddValue ("population", "number of pending events in the scheduler benchmarks", population);
+  cmd.AddValue ("events", "number of events in the scheduler benchmarks", events);
+  cmd.AddValue ("burst", "number of simultaneous events in the bursty workload", burst);
+  cmd.Parse (argc, argv);
+
+  Ptr<ExponentialRandomVariable> rng = CreateObject<ExponentialRandomVariable> ();
+  rng->SetAttribute ("Mean", DoubleValue (100000));
+  g_delays.resize (1 << 16);
+  for (std::vector<uint64_t>::iterator i = g_delays.begin (); i != g_delays.end (); ++i)
+    {
+      *i = rng->GetInteger ();
+    }
+
+  std::string schedulers[] = {
+    "ns3::ListScheduler",
+    "ns3::HeapScheduler",
+    "ns3::MapScheduler",
+    "ns3::CalendarScheduler",
+    "ns3::LadderScheduler",
+    "ns3::PairingHeapScheduler",
+    "ns3::AdaptiveScheduler"
+  };
+  for (uint32_t i = 0; i < sizeof (schedulers) / sizeof (schedulers[0]); i++)
+    {
+      std::string name = schedulers[i].substr (5);
+      // the list scheduler inserts in linear time: keep it small.
+      uint32_t pop = name == "ListScheduler" ? population / 10 : population;
+      Run ("scheduler/" + name + "/hold", "event", events,
+           MakeBoundCallback (&BenchScheduler, schedulers[i], pop, 0));
+      Run ("scheduler/" + name + "/bursty", "event", events,
+           MakeBoundCallback (&BenchScheduler, schedulers[i], pop / burst + 1, burst));
+    }
+
+  Run ("callback/member", "op", 10000000, MakeCallback (&BenchCallbackMember));
+  Run ("callback/bound", "op", 10000000, MakeCallback (&BenchCallbackBound));
+  Run ("traced-callback/0", "op", 10000000, MakeBoundCallback (&BenchTracedCallback, 0));
+  Run ("traced-callback/1", "op", 10000000, MakeBoundCallback (&BenchTracedCallback, 1));
+  Run ("traced-callback/4", "op", 5000000, MakeBoundCallback (&BenchTracedCallback, 4));
+  Run ("traced-callback/16", "op", 1000000, MakeBoundCallback (&BenchTracedCallback, 16));
+
+  Run ("packet/create", "op", 1000000, MakeCallback (&BenchPacketCreate));
+  Run ("packet/copy", "op", 1000000, MakeCallback (&BenchPacketCopy));
+  Run ("packet/add-remove-header", "op", 1000000, MakeCallback (&BenchPacketHeaders));
+  Run ("packet/fragment", "op", 200000, MakeCallback (&BenchPacketFragment));
+
+  Run ("object/get-object", "op", 10000000, MakeCallback (&BenchGetObject));
+  Run ("config/connect", "op", 20000, MakeCallback (&BenchConfigConnect));
+
+  Run ("time/arithmetic", "op", 10000000, MakeCallback (&BenchTime));
+  Run ("int64x64/arithmetic", "op", 10000000, MakeCallback (&BenchInt64x64));
+
+  if (output == "-")
+    {
+      WriteJson (std::cout);
+    }
+  else
+    {
+      std::ofstream os (output.c_str ());
+      if (!os.good ())
+        {
+          NS_FATAL_ERROR ("cannot open " << output);
+        }
+      WriteJson (os);
+    }
+  return 0;
+}
@@ -186,6 +186,9 @@ int main (int argc, char *argv[])
   bool schedCal  = false;
   bool schedHeap = false;
   bool schedList = false;
+  bool schedLadder = false;
+  bool schedPairingHeap = false;
+  bool schedAuto = false;
   bool schedMap  = true;
 
   uint32_t pop   =  100000;
@@ -205,6 +208,9 @@ int main (int argc, char *argv[])
   cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
   cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
   cmd.AddValue ("list",  "use ListSheduler",              schedList);
+  cmd.AddValue ("ladder", "use LadderScheduler",          schedLadder);
+  cmd.AddValue ("pheap", "use PairingHeapScheduler",      schedPairingHeap);
+  cmd.AddValue ("auto",  "use AdaptiveScheduler",         schedAuto);
   cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
@@ -229,6 +235,18 @@ int main (int argc, char *argv[])
     {
       factory.SetTypeId ("ns3::ListScheduler");
     }
+  if (schedLadder)
+    {
+      factory.SetTypeId ("ns3::LadderScheduler");
+    }
+  if (schedPairingHeap)
+    {
+      factory.SetTypeId ("ns3::PairingHeapScheduler");
+    }
+  if (schedAuto)
+    {
+      factory.SetTypeId ("ns3::AdaptiveScheduler");
+    }
   Simulator::SetScheduler (factory);
 
   LOGME (std::setprecision (g_fwidth - 6));